@@ -9,6 +9,8 @@ Application::Application(HINSTANCE hInstance) : hInstance(hInstance)
 {
     windowManager = std::make_unique<WindowManager>();
     timer = std::make_unique<Timer>();
+    jobSystem = std::make_unique<JobSystem>();
+    systemScheduler = std::make_unique<SystemScheduler>(*jobSystem);
 }
 
 Application::~Application()
@@ -27,12 +29,16 @@ bool Application::Initialize()
     windowManager->SetMessageCallback([this](UINT message, WPARAM wParam, LPARAM lParam)
                                       { this->ProcessMessage(message, wParam, lParam); });
 
+    if (!jobSystem->Initialize())
+        return false;
+
     if (!InitializeSystems())
         return false;
 
     currentScene = std::make_unique<Scene>(registry, "Main Scene");
     currentScene->Initialize(renderSystem->GetMeshManager(), renderSystem->GetResourceManager());
     CreateScene();
+    spatialIndexSystem->SetIndexType(currentScene->GetSpatialIndexType());
 
     timer->Reset();
     timer->Start();
@@ -54,6 +60,30 @@ bool Application::InitializeSystems()
     if (!inputSystem->Initialize())
         return false;
 
+    transformSystem = std::make_unique<TransformSystem>(registry, *jobSystem);
+    if (!transformSystem->Initialize())
+        return false;
+
+    spatialIndexSystem = std::make_unique<SpatialIndexSystem>(registry, *transformSystem);
+    if (!spatialIndexSystem->Initialize())
+        return false;
+
+    renderSystem->SetCommandBuffer(&commandBuffer);
+    inputSystem->SetCommandBuffer(&commandBuffer);
+    transformSystem->SetCommandBuffer(&commandBuffer);
+    spatialIndexSystem->SetCommandBuffer(&commandBuffer);
+
+    renderSystem->GetGUIManager()->SetTransformSystem(transformSystem.get());
+    renderSystem->GetGUIManager()->SetCommandBuffer(&commandBuffer);
+    renderSystem->SetSpatialIndex(spatialIndexSystem.get());
+    renderSystem->SetJobSystem(jobSystem.get());
+
+    // registration order is update order for systems that conflict
+    systemScheduler->AddSystem(inputSystem.get());
+    systemScheduler->AddSystem(transformSystem.get());
+    systemScheduler->AddSystem(spatialIndexSystem.get());
+    systemScheduler->AddSystem(renderSystem.get());
+
     return true;
 }
 
@@ -66,7 +96,7 @@ void Application::CreateScene()
         {-0.298f, -0.144f, 0.944f}  // look direction
     );
 
-    // maybe some instancing or something would be better here
+    // these share their MeshData, so the render system draws them instanced
     currentScene->CreateCube(
         {-1.8f, 2.3f, 4.1f}, // position
         {1.0f, 1.0f, 1.0f}   // scale
@@ -152,8 +182,11 @@ void Application::Run()
         timer->Tick();
         float deltaTime = timer->GetDeltaTime();
 
-        inputSystem->Update(deltaTime);
-        renderSystem->Update(deltaTime);
+        // runs systems with non-conflicting component access in parallel on the job system
+        systemScheduler->Update(deltaTime);
+
+        // sync point: apply everything the systems recorded before rendering
+        commandBuffer.Playback(registry);
 
         renderSystem->Render();
     }
@@ -161,7 +194,9 @@ void Application::Run()
 
 void Application::Shutdown()
 {
-    // default
+    // workers have to be joined before the systems they might be running go away
+    if (jobSystem)
+        jobSystem->Shutdown();
 }
 
 void Application::OnResize(UINT width, UINT height)
@@ -1,11 +1,16 @@
 #pragma once
 
 #include "../ECS/Registry.h"
+#include "../ECS/EntityCommandBuffer.h"
+#include "../ECS/SystemScheduler.h"
 #include "../ECS/Systems/InputSystem.h"
 #include "../ECS/Systems/RenderSystem.h"
+#include "../ECS/Systems/TransformSystem.h"
+#include "../ECS/Systems/SpatialIndexSystem.h"
 #include "../Scene/Scene.h"
 #include "WindowManager.h"
 #include "Timer.h"
+#include "JobSystem.h"
 #include <windows.h>
 #include <string>
 #include <memory>
@@ -30,9 +35,14 @@ private:
     HINSTANCE hInstance;
     std::unique_ptr<WindowManager> windowManager;
     std::unique_ptr<Timer> timer;
+    std::unique_ptr<JobSystem> jobSystem;
+    std::unique_ptr<SystemScheduler> systemScheduler;
 
     Registry registry;
+    EntityCommandBuffer commandBuffer; // structural changes recorded by systems, played back once per frame
     std::unique_ptr<RenderSystem> renderSystem;
+    std::unique_ptr<TransformSystem> transformSystem;
+    std::unique_ptr<SpatialIndexSystem> spatialIndexSystem;
     std::unique_ptr<InputSystem> inputSystem;
     std::unique_ptr<Scene> currentScene;
 
@@ -0,0 +1,188 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace
+{
+    // which job system (and which of its queues) the current thread belongs to
+    thread_local const JobSystem *currentJobSystem = nullptr;
+    thread_local unsigned int currentQueueIndex = 0;
+}
+
+JobSystem::~JobSystem()
+{
+    Shutdown();
+}
+
+bool JobSystem::Initialize(unsigned int workerCount)
+{
+    if (isRunning)
+        return true;
+
+    if (workerCount == 0)
+    {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    // queue 0 belongs to the calling thread, the rest to the workers
+    for (unsigned int i = 0; i <= workerCount; ++i)
+        queues.push_back(std::make_unique<JobQueue>());
+
+    currentJobSystem = this;
+    currentQueueIndex = 0;
+
+    isRunning = true;
+    for (unsigned int i = 1; i <= workerCount; ++i)
+        workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+
+    return true;
+}
+
+void JobSystem::Shutdown()
+{
+    if (!isRunning)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        isRunning = false;
+    }
+    wakeCondition.notify_all();
+
+    for (std::thread &worker : workers)
+        worker.join();
+
+    workers.clear();
+
+    // jobs still queued run here, otherwise their counters never reach zero and anyone waiting on them spins forever
+    // isRunning is already false, so anything they schedule runs inline
+    while (TryRunJob(0))
+    {
+    }
+
+    queues.clear();
+    queuedJobs = 0;
+}
+
+void JobSystem::Schedule(Job job, JobCounter *counter)
+{
+    if (!isRunning)
+    {
+        // no workers, just run it here
+        job();
+        return;
+    }
+
+    if (counter)
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+    JobQueue &queue = *queues[CurrentQueue()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.emplace_back(std::move(job), counter);
+    }
+    queuedJobs.fetch_add(1, std::memory_order_release);
+
+    // taking the lock makes sure a worker that's about to sleep sees the new job
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wakeCondition.notify_one();
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &func)
+{
+    if (count == 0)
+        return;
+
+    grainSize = std::max<size_t>(1, grainSize);
+
+    JobCounter counter;
+    for (size_t begin = grainSize; begin < count; begin += grainSize)
+    {
+        size_t end = std::min(begin + grainSize, count);
+        Schedule([&func, begin, end]()
+                 { func(begin, end); },
+                 &counter);
+    }
+
+    // the first range runs on the calling thread
+    func(0, std::min(grainSize, count));
+    Wait(counter);
+}
+
+void JobSystem::Wait(const JobCounter &counter)
+{
+    while (!counter.IsDone())
+    {
+        if (!isRunning || !TryRunJob(CurrentQueue()))
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::WorkerLoop(unsigned int index)
+{
+    currentJobSystem = this;
+    currentQueueIndex = index;
+
+    while (isRunning)
+    {
+        if (TryRunJob(index))
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeCondition.wait(lock, [this]()
+                           { return !isRunning || queuedJobs.load(std::memory_order_acquire) > 0; });
+    }
+}
+
+bool JobSystem::TryRunJob(unsigned int index)
+{
+    std::pair<Job, JobCounter *> entry;
+    bool found = false;
+
+    // own queue first, newest job first
+    {
+        JobQueue &queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty())
+        {
+            entry = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+            found = true;
+        }
+    }
+
+    // then steal the oldest job from someone else
+    for (size_t i = 1; !found && i < queues.size(); ++i)
+    {
+        JobQueue &queue = *queues[(index + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty())
+        {
+            entry = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found)
+        return false;
+
+    queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    entry.first();
+
+    if (entry.second)
+        entry.second->pending.fetch_sub(1, std::memory_order_release);
+
+    return true;
+}
+
+unsigned int JobSystem::CurrentQueue()
+{
+    if (currentJobSystem == this)
+        return currentQueueIndex;
+
+    // threads that don't belong to this job system round-robin over the queues
+    return nextExternalQueue.fetch_add(1, std::memory_order_relaxed) % static_cast<unsigned int>(queues.size());
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class JobCounter
+ * @brief Counts the unfinished jobs of a group so other work can wait on (depend on) them
+ *
+ * Every job scheduled with a counter increments it, and decrements it once it has run.
+ * JobSystem::Wait(counter) returns when it reaches zero.
+ */
+class JobCounter
+{
+public:
+    bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<std::uint32_t> pending{0};
+};
+
+/**
+ * @class JobSystem
+ * @brief Fixed pool of worker threads running small jobs, with work stealing
+ *
+ * Every worker owns a deque: it pushes and pops its own jobs at the back (newest first, still warm in cache)
+ * and steals from the front of the other workers' deques when it runs dry. The thread that called Initialize
+ * (the main thread) owns queue 0 and helps out while it waits on a counter, so waiting never deadlocks even
+ * when jobs schedule and wait on more jobs.
+ */
+class JobSystem
+{
+public:
+    using Job = std::function<void()>;
+
+    JobSystem() = default;
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    /**
+     * @brief Starts the worker threads
+     * @param workerCount Number of worker threads, 0 picks one less than the number of hardware threads
+     */
+    bool Initialize(unsigned int workerCount = 0);
+
+    /** @brief Joins the workers, then runs whatever is still queued on the calling thread so every counter finishes */
+    void Shutdown();
+
+    /**
+     * @brief Queues a job
+     * @param job The work to run
+     * @param counter Optional counter that is incremented now and decremented when the job finishes
+     */
+    void Schedule(Job job, JobCounter *counter = nullptr);
+
+    /**
+     * @brief Runs func(begin, end) over [0, count) split into ranges of at most grainSize, and waits for all of them
+     * @param count Number of items
+     * @param grainSize Items per job, keep it large enough that a job does a meaningful amount of work
+     * @param func Callable taking (size_t begin, size_t end)
+     *
+     * The calling thread runs part of the range itself.
+     */
+    void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &func);
+
+    /** @brief Blocks until the counter reaches zero, running queued jobs in the meantime */
+    void Wait(const JobCounter &counter);
+
+    /** @brief Number of threads that run jobs, including the main thread */
+    unsigned int GetThreadCount() const { return static_cast<unsigned int>(queues.size()); }
+
+private:
+    struct JobQueue
+    {
+        std::mutex mutex;
+        std::deque<std::pair<Job, JobCounter *>> jobs;
+    };
+
+    void WorkerLoop(unsigned int index);
+    bool TryRunJob(unsigned int index);
+    unsigned int CurrentQueue();
+
+    std::vector<std::unique_ptr<JobQueue>> queues;
+    std::vector<std::thread> workers;
+
+    // workers sleep on this when every queue is empty
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<std::uint32_t> queuedJobs{0};
+    std::atomic<bool> isRunning{false};
+
+    // external (non-worker, non-main) threads spread their jobs over the queues
+    std::atomic<unsigned int> nextExternalQueue{0};
+};
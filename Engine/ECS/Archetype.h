@@ -0,0 +1,217 @@
+#pragma once
+
+#include "Component.h"
+#include "ComponentType.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+/**
+ * @class Archetype
+ * @brief Storage for every entity that has exactly the same set of components
+ *
+ * Entities are packed into fixed-size 16 KB chunks. Inside a chunk each component type has its own
+ * column (structure-of-arrays), so iterating one component type over a chunk is a linear, cache-line
+ * aligned walk that can be streamed with SIMD.
+ *
+ * Chunk layout: [entity IDs][column 0][column 1]...[column N], every column starts on a cache line.
+ *
+ * Rows are always packed: every chunk is full except the last one, and removing a row moves the very last
+ * row into the hole.
+ */
+class Archetype
+{
+public:
+    static constexpr size_t CHUNK_SIZE = 16 * 1024;
+    static constexpr size_t COLUMN_ALIGNMENT = 64;
+
+    struct Column
+    {
+        const ComponentTypeInfo *info;
+        size_t offset = 0; // byte offset of the column inside a chunk
+    };
+
+    struct Chunk
+    {
+        struct Deleter
+        {
+            void operator()(std::byte *data) const { ::operator delete(data, std::align_val_t(COLUMN_ALIGNMENT)); }
+        };
+
+        std::unique_ptr<std::byte, Deleter> data;
+        std::uint32_t count = 0;
+    };
+
+    struct Location
+    {
+        std::uint32_t chunk = 0;
+        std::uint32_t row = 0;
+    };
+
+    Archetype(const ComponentSignature &signature, std::vector<const ComponentTypeInfo *> types)
+        : signature(signature)
+    {
+        columnOf.fill(-1);
+
+        // sort so the same set of types always gives the same layout, no matter what order they were added in
+        std::sort(types.begin(), types.end(),
+                  [](const ComponentTypeInfo *a, const ComponentTypeInfo *b)
+                  { return a->id < b->id; });
+
+        size_t rowBytes = sizeof(EntityID);
+        for (const ComponentTypeInfo *info : types)
+        {
+            columnOf[info->id] = static_cast<std::int16_t>(columns.size());
+            columns.push_back({info});
+            rowBytes += info->size;
+        }
+
+        // start from the unpadded estimate and shrink until the aligned layout fits in a chunk
+        capacity = static_cast<std::uint32_t>(std::max<size_t>(1, CHUNK_SIZE / rowBytes));
+        while (capacity > 1 && ComputeLayout(capacity) > CHUNK_SIZE)
+            --capacity;
+
+        ComputeLayout(capacity);
+        addEdges.fill(nullptr);
+        removeEdges.fill(nullptr);
+    }
+
+    ~Archetype()
+    {
+        for (std::uint32_t chunk = 0; chunk < chunks.size(); ++chunk)
+        {
+            for (std::uint32_t row = 0; row < chunks[chunk].count; ++row)
+            {
+                for (size_t column = 0; column < columns.size(); ++column)
+                    columns[column].info->destroy(ComponentAt(column, chunk, row));
+            }
+        }
+    }
+
+    Archetype(const Archetype &) = delete;
+    Archetype &operator=(const Archetype &) = delete;
+
+    /**
+     * @brief Reserves a row for an entity
+     * @note The component memory in the new row is uninitialized, the caller constructs every column
+     */
+    Location Allocate(EntityID entity)
+    {
+        if (chunks.empty() || chunks.back().count == capacity)
+        {
+            Chunk chunk;
+            chunk.data.reset(static_cast<std::byte *>(::operator new(CHUNK_SIZE, std::align_val_t(COLUMN_ALIGNMENT))));
+            chunks.push_back(std::move(chunk));
+        }
+
+        auto chunkIndex = static_cast<std::uint32_t>(chunks.size() - 1);
+        Chunk &chunk = chunks.back();
+        std::uint32_t row = chunk.count++;
+        GetEntities(chunkIndex)[row] = entity;
+        ++entityCount;
+
+        return {chunkIndex, row};
+    }
+
+    /**
+     * @brief Removes a row by moving the last row of the archetype into it
+     * @param location The row to remove
+     * @param componentsAlive false if the caller already destroyed (or moved out and destroyed) the row's components
+     * @return EntityID The entity that was moved into the removed row, or INVALID_ENTITY if nothing moved
+     */
+    EntityID RemoveRow(Location location, bool componentsAlive)
+    {
+        auto lastChunk = static_cast<std::uint32_t>(chunks.size() - 1);
+        std::uint32_t lastRow = chunks[lastChunk].count - 1;
+        bool isLast = location.chunk == lastChunk && location.row == lastRow;
+
+        EntityID moved = INVALID_ENTITY;
+        for (size_t column = 0; column < columns.size(); ++column)
+        {
+            const ComponentTypeInfo *info = columns[column].info;
+            void *hole = ComponentAt(column, location.chunk, location.row);
+
+            if (componentsAlive)
+                info->destroy(hole);
+
+            if (!isLast)
+            {
+                void *last = ComponentAt(column, lastChunk, lastRow);
+                info->moveConstruct(hole, last);
+                info->destroy(last);
+            }
+        }
+
+        if (!isLast)
+        {
+            moved = GetEntities(lastChunk)[lastRow];
+            GetEntities(location.chunk)[location.row] = moved;
+        }
+
+        if (--chunks[lastChunk].count == 0)
+            chunks.pop_back();
+
+        --entityCount;
+        return moved;
+    }
+
+    /** @brief Column index of a component type, or -1 if the archetype doesn't have it */
+    int ColumnIndex(ComponentTypeID typeId) const { return columnOf[typeId]; }
+    bool Has(ComponentTypeID typeId) const { return columnOf[typeId] >= 0; }
+
+    void *ComponentAt(size_t column, std::uint32_t chunk, std::uint32_t row) const
+    {
+        const Column &c = columns[column];
+        return chunks[chunk].data.get() + c.offset + static_cast<size_t>(row) * c.info->size;
+    }
+
+    /** @brief Start of a column inside a chunk, the column holds GetChunkCount(chunk) components */
+    template <typename T>
+    T *GetColumn(size_t column, std::uint32_t chunk) const
+    {
+        return reinterpret_cast<T *>(chunks[chunk].data.get() + columns[column].offset);
+    }
+
+    EntityID *GetEntities(std::uint32_t chunk) const
+    {
+        return reinterpret_cast<EntityID *>(chunks[chunk].data.get());
+    }
+
+    std::uint32_t GetChunkCount() const { return static_cast<std::uint32_t>(chunks.size()); }
+    std::uint32_t GetRowCount(std::uint32_t chunk) const { return chunks[chunk].count; }
+    std::uint32_t GetCapacity() const { return capacity; }
+    size_t GetEntityCount() const { return entityCount; }
+
+    const ComponentSignature &GetSignature() const { return signature; }
+    const std::vector<Column> &GetColumns() const { return columns; }
+
+    // cached archetype transitions so adding/removing a component doesn't need a hash lookup
+    std::array<Archetype *, MAX_COMPONENT_TYPES> addEdges;
+    std::array<Archetype *, MAX_COMPONENT_TYPES> removeEdges;
+
+private:
+    // lays the columns out for a given capacity and returns the total size in bytes
+    size_t ComputeLayout(std::uint32_t rows)
+    {
+        size_t offset = sizeof(EntityID) * rows;
+        for (Column &column : columns)
+        {
+            size_t alignment = std::max(column.info->alignment, COLUMN_ALIGNMENT);
+            offset = (offset + alignment - 1) & ~(alignment - 1);
+            column.offset = offset;
+            offset += column.info->size * rows;
+        }
+        return offset;
+    }
+
+    ComponentSignature signature;
+    std::vector<Column> columns;
+    std::array<std::int16_t, MAX_COMPONENT_TYPES> columnOf;
+    std::vector<Chunk> chunks;
+    std::uint32_t capacity = 0;
+    size_t entityCount = 0;
+};
@@ -0,0 +1,444 @@
+#pragma once
+
+#include "Component.h"
+#include "ComponentType.h"
+#include "Archetype.h"
+#include "../Core/JobSystem.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class ArchetypeView
+ * @brief Iterates every entity whose archetype contains all of the given components
+ * @tparam Ts The component types the entity must have
+ *
+ * Same interface as ComponentView, plus EachChunk for walking whole columns at a time.
+ *
+ * @warning Adding or removing components while iterating invalidates the view.
+ */
+template <typename... Ts>
+class ArchetypeView
+{
+public:
+    class Iterator
+    {
+    public:
+        Iterator(const ArchetypeView *view, size_t archetype)
+            : view(view), archetype(archetype)
+        {
+            SkipEmpty();
+        }
+
+        std::tuple<EntityID, Ts &...> operator*() const
+        {
+            const Archetype *current = (*view->matches)[archetype];
+            return std::tuple<EntityID, Ts &...>(
+                current->GetEntities(chunk)[row],
+                current->GetColumn<Ts>(current->ColumnIndex(ComponentType::GetID<Ts>()), chunk)[row]...);
+        }
+
+        Iterator &operator++()
+        {
+            ++row;
+            SkipEmpty();
+            return *this;
+        }
+
+        bool operator==(const Iterator &other) const
+        {
+            return archetype == other.archetype && chunk == other.chunk && row == other.row;
+        }
+        bool operator!=(const Iterator &other) const { return !(*this == other); }
+
+    private:
+        // moves forward to the next valid row, or to the end position (archetype == matches.size())
+        void SkipEmpty()
+        {
+            size_t archetypeCount = view->matches ? view->matches->size() : 0;
+            while (archetype < archetypeCount)
+            {
+                const Archetype *current = (*view->matches)[archetype];
+                if (chunk < current->GetChunkCount())
+                {
+                    if (row < current->GetRowCount(chunk))
+                        return;
+
+                    ++chunk;
+                    row = 0;
+                    continue;
+                }
+
+                ++archetype;
+                chunk = 0;
+                row = 0;
+            }
+        }
+
+        const ArchetypeView *view;
+        size_t archetype;
+        std::uint32_t chunk = 0;
+        std::uint32_t row = 0;
+    };
+
+    explicit ArchetypeView(const std::vector<Archetype *> *matches)
+        : matches(matches)
+    {
+    }
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, matches ? matches->size() : 0); }
+
+    /**
+     * @brief Calls a function for every matching entity
+     * @param func Callable taking (EntityID, Ts &...)
+     */
+    template <typename Func>
+    void Each(Func &&func) const
+    {
+        EachChunk([&func](std::uint32_t count, const EntityID *entities, Ts *...columns)
+                  {
+                      for (std::uint32_t i = 0; i < count; ++i)
+                          func(entities[i], columns[i]...);
+                  });
+    }
+
+    /**
+     * @brief Calls a function once per chunk with contiguous arrays for every component type
+     * @param func Callable taking (uint32_t count, const EntityID *entities, Ts *...columns)
+     */
+    template <typename Func>
+    void EachChunk(Func &&func) const
+    {
+        if (!matches)
+            return;
+
+        for (const Archetype *archetype : *matches)
+        {
+            int columns[] = {archetype->ColumnIndex(ComponentType::GetID<Ts>())...};
+            for (std::uint32_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+                CallChunk(func, archetype, chunk, columns, std::index_sequence_for<Ts...>());
+        }
+    }
+
+    /**
+     * @brief Calls a function for every matching entity, spread over the job system's threads
+     * @param jobSystem The job system to run on, the calling thread helps and returns when everything is done
+     * @param func Callable taking (EntityID, Ts &...), called concurrently so it must only touch its own entity
+     *
+     * Work is handed out in whole chunks, so two jobs never write to the same cache line.
+     */
+    template <typename Func>
+    void ParallelEach(JobSystem &jobSystem, Func &&func) const
+    {
+        if (!matches)
+            return;
+
+        std::vector<std::pair<const Archetype *, std::uint32_t>> chunks;
+        for (const Archetype *archetype : *matches)
+        {
+            for (std::uint32_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+                chunks.emplace_back(archetype, chunk);
+        }
+
+        // a few jobs per thread so stealing can even out uneven work
+        size_t jobCount = static_cast<size_t>(jobSystem.GetThreadCount()) * 4;
+        size_t chunksPerJob = std::max<size_t>(1, chunks.size() / std::max<size_t>(1, jobCount));
+
+        auto eachRow = [&func](std::uint32_t count, const EntityID *entities, Ts *...columns)
+        {
+            for (std::uint32_t i = 0; i < count; ++i)
+                func(entities[i], columns[i]...);
+        };
+
+        jobSystem.ParallelFor(chunks.size(), chunksPerJob, [&chunks, &eachRow](size_t begin, size_t end)
+                              {
+                                  for (size_t i = begin; i < end; ++i)
+                                  {
+                                      const Archetype *archetype = chunks[i].first;
+                                      int columns[] = {archetype->ColumnIndex(ComponentType::GetID<Ts>())...};
+                                      CallChunk(eachRow, archetype, chunks[i].second, columns, std::index_sequence_for<Ts...>());
+                                  }
+                              });
+    }
+
+    /** @brief Exact number of matching entities */
+    size_t SizeHint() const
+    {
+        size_t count = 0;
+        if (matches)
+        {
+            for (const Archetype *archetype : *matches)
+                count += archetype->GetEntityCount();
+        }
+        return count;
+    }
+
+private:
+    template <typename Func, size_t... Is>
+    static void CallChunk(Func &func, const Archetype *archetype, std::uint32_t chunk,
+                          const int (&columns)[sizeof...(Ts)], std::index_sequence<Is...>)
+    {
+        func(archetype->GetRowCount(chunk), archetype->GetEntities(chunk),
+             archetype->GetColumn<Ts>(columns[Is], chunk)...);
+    }
+
+    const std::vector<Archetype *> *matches;
+};
+
+/**
+ * @class ArchetypeStorage
+ * @brief Component storage backend that groups entities by their exact component signature
+ *
+ * Selected with the ECS_ARCHETYPE_STORAGE compile definition. Iteration over hot components is a linear
+ * walk over 16 KB chunks, at the cost of moving the entity's components to another archetype whenever a
+ * component is added or removed.
+ *
+ * @warning Pointers returned by Add/Get are invalidated when any component is added to or removed from the
+ * same entity, or when another entity in the same archetype is removed.
+ */
+class ArchetypeStorage
+{
+public:
+    template <typename T, typename... Args>
+    T *Add(EntityID entity, Args &&...args)
+    {
+        ComponentTypeID typeId = ComponentType::GetID<T>();
+        EntityLocation &location = Locate(entity);
+
+        if (location.archetype && location.archetype->Has(typeId))
+        {
+            T *component = static_cast<T *>(ComponentAt(location, typeId));
+            *component = T(std::forward<Args>(args)...);
+            return component;
+        }
+
+        Archetype *destination = location.archetype ? location.archetype->addEdges[typeId] : nullptr;
+        if (!destination)
+        {
+            ComponentSignature signature;
+            std::vector<const ComponentTypeInfo *> types;
+            if (location.archetype)
+            {
+                signature = location.archetype->GetSignature();
+                for (const auto &column : location.archetype->GetColumns())
+                    types.push_back(column.info);
+            }
+
+            signature.set(typeId);
+            types.push_back(&ComponentTypeInfo::Get<T>());
+            destination = GetOrCreateArchetype(signature, std::move(types));
+
+            if (location.archetype)
+                location.archetype->addEdges[typeId] = destination;
+        }
+
+        MoveEntity(entity, destination);
+
+        // the new column is still raw memory at this point
+        EntityLocation &moved = locations[GetEntityIndex(entity)];
+        return new (ComponentAt(moved, typeId)) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    void Remove(EntityID entity)
+    {
+        ComponentTypeID typeId = ComponentType::GetID<T>();
+        EntityLocation *location = Find(entity);
+        if (!location || !location->archetype->Has(typeId))
+            return;
+
+        ComponentSignature signature = location->archetype->GetSignature();
+        signature.reset(typeId);
+        if (signature.none())
+        {
+            RemoveRow(*location);
+            return;
+        }
+
+        Archetype *destination = location->archetype->removeEdges[typeId];
+        if (!destination)
+        {
+            std::vector<const ComponentTypeInfo *> types;
+            for (const auto &column : location->archetype->GetColumns())
+            {
+                if (column.info->id != typeId)
+                    types.push_back(column.info);
+            }
+
+            destination = GetOrCreateArchetype(signature, std::move(types));
+            location->archetype->removeEdges[typeId] = destination;
+        }
+
+        MoveEntity(entity, destination);
+    }
+
+    // the archetype already knows which components the entity has, so the signature isn't needed here
+    void RemoveAll(EntityID entity, const ComponentSignature &)
+    {
+        if (EntityLocation *location = Find(entity))
+            RemoveRow(*location);
+    }
+
+    template <typename T>
+    T *Get(EntityID entity)
+    {
+        ComponentTypeID typeId = ComponentType::GetID<T>();
+        const EntityLocation *location = Find(entity);
+        if (!location || !location->archetype->Has(typeId))
+            return nullptr;
+
+        return static_cast<T *>(ComponentAt(*location, typeId));
+    }
+
+    template <typename T>
+    bool Has(EntityID entity)
+    {
+        ComponentTypeID typeId = ComponentType::GetID<T>();
+        const EntityLocation *location = Find(entity);
+        return location && location->archetype->Has(typeId);
+    }
+
+    template <typename T>
+    std::vector<EntityID> GetEntities()
+    {
+        std::vector<EntityID> result;
+        View<T>().EachChunk([&result](std::uint32_t count, const EntityID *entities, T *)
+                            { result.insert(result.end(), entities, entities + count); });
+        return result;
+    }
+
+    template <typename... Ts>
+    ArchetypeView<Ts...> View()
+    {
+        ComponentSignature query;
+        (query.set(ComponentType::GetID<Ts>()), ...);
+
+        return ArchetypeView<Ts...>(&GetQueryMatches(query));
+    }
+
+private:
+    struct EntityLocation
+    {
+        Archetype *archetype = nullptr;
+        std::uint32_t chunk = 0;
+        std::uint32_t row = 0;
+    };
+
+    // archetypes matching a query signature, extended lazily as new archetypes get created
+    struct QueryCache
+    {
+        std::vector<Archetype *> matches;
+        size_t archetypesChecked = 0;
+    };
+
+    // location slot for an entity, grown on demand
+    EntityLocation &Locate(EntityID entity)
+    {
+        std::uint32_t slot = GetEntityIndex(entity);
+        if (slot >= locations.size())
+            locations.resize(static_cast<size_t>(slot) + 1);
+        return locations[slot];
+    }
+
+    // location of an entity that has at least one component, or nullptr
+    // locations are indexed by slot, so the handle stored in the row is compared to reject stale handles
+    EntityLocation *Find(EntityID entity)
+    {
+        std::uint32_t slot = GetEntityIndex(entity);
+        if (slot >= locations.size())
+            return nullptr;
+
+        EntityLocation &location = locations[slot];
+        if (!location.archetype || location.archetype->GetEntities(location.chunk)[location.row] != entity)
+            return nullptr;
+
+        return &location;
+    }
+
+    // destroys every component of the entity in the location and leaves it without an archetype
+    void RemoveRow(EntityLocation &location)
+    {
+        EntityID moved = location.archetype->RemoveRow({location.chunk, location.row}, true);
+        if (moved != INVALID_ENTITY)
+            locations[GetEntityIndex(moved)] = location;
+
+        location = {};
+    }
+
+    void *ComponentAt(const EntityLocation &location, ComponentTypeID typeId) const
+    {
+        return location.archetype->ComponentAt(location.archetype->ColumnIndex(typeId), location.chunk, location.row);
+    }
+
+    Archetype *GetOrCreateArchetype(const ComponentSignature &signature, std::vector<const ComponentTypeInfo *> types)
+    {
+        auto it = archetypes.find(signature);
+        if (it != archetypes.end())
+            return it->second.get();
+
+        auto archetype = std::make_unique<Archetype>(signature, std::move(types));
+        Archetype *result = archetype.get();
+        archetypes.emplace(signature, std::move(archetype));
+        archetypeList.push_back(result);
+        return result;
+    }
+
+    // moves the entity's row into another archetype
+    // components the destination shares are moved over, the rest are destroyed
+    void MoveEntity(EntityID entity, Archetype *destination)
+    {
+        EntityLocation &location = locations[GetEntityIndex(entity)];
+        Archetype::Location target = destination->Allocate(entity);
+
+        if (Archetype *source = location.archetype)
+        {
+            const auto &columns = source->GetColumns();
+            for (size_t column = 0; column < columns.size(); ++column)
+            {
+                const ComponentTypeInfo *info = columns[column].info;
+                void *from = source->ComponentAt(column, location.chunk, location.row);
+
+                int destinationColumn = destination->ColumnIndex(info->id);
+                if (destinationColumn >= 0)
+                    info->moveConstruct(destination->ComponentAt(destinationColumn, target.chunk, target.row), from);
+
+                info->destroy(from);
+            }
+
+            EntityID moved = source->RemoveRow({location.chunk, location.row}, false);
+            if (moved != INVALID_ENTITY)
+                locations[GetEntityIndex(moved)] = location;
+        }
+
+        location = {destination, target.chunk, target.row};
+    }
+
+    // systems running in parallel can create views at the same time, so the cache is guarded
+    // (archetypes themselves are only created by structural changes, which never run in parallel)
+    const std::vector<Archetype *> &GetQueryMatches(const ComponentSignature &query)
+    {
+        std::lock_guard<std::mutex> lock(queryMutex);
+
+        QueryCache &cache = queries[query];
+        for (; cache.archetypesChecked < archetypeList.size(); ++cache.archetypesChecked)
+        {
+            Archetype *archetype = archetypeList[cache.archetypesChecked];
+            if ((archetype->GetSignature() & query) == query)
+                cache.matches.push_back(archetype);
+        }
+        return cache.matches;
+    }
+
+    std::unordered_map<ComponentSignature, std::unique_ptr<Archetype>> archetypes;
+    std::vector<Archetype *> archetypeList; // creation order, used for stable iteration
+    std::unordered_map<ComponentSignature, QueryCache> queries;
+    std::mutex queryMutex;
+    std::vector<EntityLocation> locations;
+};
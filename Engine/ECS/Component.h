@@ -2,11 +2,30 @@
 
 #include <cstdint>
 
+// entity handles pack a slot index and a generation into 32 bits
+// the generation is bumped every time a slot is recycled, so old handles to a reused slot can be detected
 using EntityID = std::uint32_t;
 constexpr EntityID INVALID_ENTITY = 0;
 
+constexpr std::uint32_t ENTITY_INDEX_BITS = 20;
+constexpr std::uint32_t ENTITY_GENERATION_BITS = 32 - ENTITY_INDEX_BITS;
+constexpr std::uint32_t ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+constexpr std::uint32_t ENTITY_GENERATION_MASK = (1u << ENTITY_GENERATION_BITS) - 1;
+
+// the registry never hands out the top generations, EntityCommandBuffer tags its placeholder handles with them
+constexpr std::uint32_t ENTITY_PLACEHOLDER_GENERATIONS = 256;
+constexpr std::uint32_t ENTITY_FIRST_PLACEHOLDER_GENERATION = ENTITY_GENERATION_MASK + 1 - ENTITY_PLACEHOLDER_GENERATIONS;
+
+constexpr std::uint32_t GetEntityIndex(EntityID entity) { return entity & ENTITY_INDEX_MASK; }
+constexpr std::uint32_t GetEntityGeneration(EntityID entity) { return entity >> ENTITY_INDEX_BITS; }
+
+constexpr EntityID MakeEntityID(std::uint32_t index, std::uint32_t generation)
+{
+    return (index & ENTITY_INDEX_MASK) | ((generation & ENTITY_GENERATION_MASK) << ENTITY_INDEX_BITS);
+}
+
+// components are stored by value in their own pools now,
+// so the base class is just a tag and doesn't need a virtual destructor (or a vtable)
 class Component
 {
-public:
-    virtual ~Component() = default;
-};
\ No newline at end of file
+};
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "Component.h"
+#include "ComponentType.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @class SparseSet
+ * @brief Type-independent part of a component pool
+ *
+ * Keeps two arrays:
+ * - sparse: entity slot index → index into the dense arrays (or INVALID_INDEX)
+ * - dense: packed list of the entities that own a component, in the same order as the components
+ *
+ * This gives O(1) add, remove and lookup, and iterating the dense array is a linear walk.
+ * The dense array stores full handles (index + generation), so a stale handle to a recycled slot
+ * never matches and simply isn't found.
+ */
+class SparseSet
+{
+public:
+    virtual ~SparseSet() = default;
+
+    /**
+     * @brief Checks whether an entity has a component in this pool
+     * @param entity The ID of the entity to check
+     * @return true if the entity is in the pool
+     */
+    bool Contains(EntityID entity) const
+    {
+        std::uint32_t slot = GetEntityIndex(entity);
+        return slot < sparse.size() && sparse[slot] != INVALID_INDEX && dense[sparse[slot]] == entity;
+    }
+
+    /**
+     * @brief Removes the entity's component from the pool (if it has one)
+     * @param entity The ID of the entity to remove
+     */
+    virtual void Remove(EntityID entity) = 0;
+
+    /** @brief Number of components stored in the pool */
+    size_t Size() const { return dense.size(); }
+
+    /** @brief Packed list of entities that own a component in this pool */
+    const std::vector<EntityID> &GetEntities() const { return dense; }
+
+protected:
+    static constexpr std::uint32_t INVALID_INDEX = UINT32_MAX;
+
+    std::uint32_t IndexOf(EntityID entity) const { return sparse[GetEntityIndex(entity)]; }
+
+    // appends the entity to the dense array and returns its index
+    std::uint32_t Insert(EntityID entity)
+    {
+        std::uint32_t slot = GetEntityIndex(entity);
+        if (slot >= sparse.size())
+            sparse.resize(static_cast<size_t>(slot) + 1, INVALID_INDEX);
+
+        auto index = static_cast<std::uint32_t>(dense.size());
+        sparse[slot] = index;
+        dense.push_back(entity);
+        return index;
+    }
+
+    // moves the last entity into the removed slot and returns the slot index
+    // the derived pool does the same swap on its component array
+    std::uint32_t SwapAndPop(EntityID entity)
+    {
+        std::uint32_t index = IndexOf(entity);
+        EntityID last = dense.back();
+
+        dense[index] = last;
+        sparse[GetEntityIndex(last)] = index;
+        sparse[GetEntityIndex(entity)] = INVALID_INDEX;
+        dense.pop_back();
+
+        return index;
+    }
+
+    std::vector<std::uint32_t> sparse;
+    std::vector<EntityID> dense;
+};
+
+/**
+ * @class ComponentPool
+ * @brief Sparse-set storage for a single component type
+ * @tparam T The component type (must inherit from Component)
+ *
+ * Components are stored by value in a contiguous array that is kept parallel to the dense entity array.
+ *
+ * @warning Pointers returned by Emplace/Get are only valid until the next component of the same type is added
+ * or removed, since either can move the components around in memory.
+ */
+template <typename T>
+class ComponentPool : public SparseSet
+{
+public:
+    /**
+     * @brief Constructs a component for an entity, replacing any existing one
+     * @return T* pointer to the component
+     */
+    template <typename... Args>
+    T *Emplace(EntityID entity, Args &&...args)
+    {
+        if (Contains(entity))
+        {
+            T &component = components[IndexOf(entity)];
+            component = T(std::forward<Args>(args)...);
+            return &component;
+        }
+
+        Insert(entity);
+        components.emplace_back(std::forward<Args>(args)...);
+        return &components.back();
+    }
+
+    /**
+     * @brief Retrieves the entity's component
+     * @return T* pointer to the component, or nullptr if the entity isn't in the pool
+     */
+    T *Get(EntityID entity)
+    {
+        return Contains(entity) ? &components[IndexOf(entity)] : nullptr;
+    }
+
+    /**
+     * @brief Retrieves the entity's component without checking that it exists
+     * @note Only use this after Contains(entity) returned true (views do this for you)
+     */
+    T &At(EntityID entity) { return components[IndexOf(entity)]; }
+
+    void Remove(EntityID entity) override
+    {
+        if (!Contains(entity))
+            return;
+
+        std::uint32_t index = SwapAndPop(entity);
+        if (index != components.size() - 1)
+            components[index] = std::move(components.back());
+        components.pop_back();
+    }
+
+    /** @brief Packed component array, parallel to GetEntities() */
+    std::vector<T> &GetComponents() { return components; }
+    const std::vector<T> &GetComponents() const { return components; }
+
+private:
+    std::vector<T> components;
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <bitset>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using ComponentTypeID = std::uint32_t;
+
+// upper bound on distinct component types, so a signature fits in a single 64-bit mask
+constexpr ComponentTypeID MAX_COMPONENT_TYPES = 64;
+
+/** @brief Bitmask of component types, one bit per ComponentTypeID */
+using ComponentSignature = std::bitset<MAX_COMPONENT_TYPES>;
+
+/**
+ * @brief Calls func(ComponentTypeID) for every type set in a signature, lowest ID first
+ *
+ * Only visits the set bits, so the cost scales with the number of components rather than MAX_COMPONENT_TYPES.
+ */
+template <typename Func>
+inline void ForEachComponentType(const ComponentSignature &signature, Func &&func)
+{
+    std::uint64_t bits = signature.to_ullong();
+    while (bits)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+#else
+        auto index = static_cast<unsigned long>(__builtin_ctzll(bits));
+#endif
+        func(static_cast<ComponentTypeID>(index));
+        bits &= bits - 1;
+    }
+}
+
+/**
+ * @class ComponentType
+ * @brief Hands out a small, dense ID for every component type
+ *
+ * The IDs are used to index the registry's storage directly,
+ * so looking up a component type never has to hash a std::type_index.
+ */
+class ComponentType
+{
+public:
+    template <typename T>
+    static ComponentTypeID GetID()
+    {
+        static const ComponentTypeID id = nextID.fetch_add(1, std::memory_order_relaxed);
+        assert(id < MAX_COMPONENT_TYPES && "too many component types, bump MAX_COMPONENT_TYPES");
+        return id;
+    }
+
+private:
+    static inline std::atomic<ComponentTypeID> nextID{0};
+};
+
+/**
+ * @struct ComponentTypeInfo
+ * @brief Type-erased size/alignment and lifetime functions for a component type
+ *
+ * Used by storage that moves components around as raw bytes (e.g. archetype chunks)
+ * without knowing their static type.
+ */
+struct ComponentTypeInfo
+{
+    ComponentTypeID id;
+    size_t size;
+    size_t alignment;
+    void (*moveConstruct)(void *destination, void *source);
+    void (*destroy)(void *component);
+
+    template <typename T>
+    static const ComponentTypeInfo &Get()
+    {
+        static const ComponentTypeInfo info = {
+            ComponentType::GetID<T>(),
+            sizeof(T),
+            alignof(T),
+            [](void *destination, void *source)
+            { new (destination) T(std::move(*static_cast<T *>(source))); },
+            [](void *component)
+            { static_cast<T *>(component)->~T(); }};
+        return info;
+    }
+};
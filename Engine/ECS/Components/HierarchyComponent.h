@@ -0,0 +1,11 @@
+#pragma once
+
+#include "../Component.h"
+
+// parent link for the transform hierarchy
+// don't set the parent directly, go through TransformSystem::SetParent so the flattened update order stays in sync
+class HierarchyComponent : public Component
+{
+public:
+    EntityID parent = INVALID_ENTITY;
+};
\ No newline at end of file
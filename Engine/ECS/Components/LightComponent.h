@@ -2,6 +2,7 @@
 
 #include "../Component.h"
 #include <DirectXMath.h>
+#include <cstdint>
 
 // scoped enum outside of class for better type safety and clarity
 enum class LightType
@@ -12,15 +13,25 @@ enum class LightType
 };
 
 // needs fixing
+// the LightingManager keeps a packed copy of every light on the gpu and only re-packs the ones whose version moved,
+// so anything that changes a light after creation has to call MarkDirty()
 class BaseLightComponent : public Component
 {
 public:
+    static constexpr std::uint32_t NO_LIGHT_SLOT = ~0u;
+
     // common light properties
     DirectX::XMFLOAT4 ambientColor = {0.2f, 0.2f, 0.2f, 1.0f};
     DirectX::XMFLOAT4 diffuseColor = {0.8f, 0.8f, 0.8f, 1.0f};
     float intensity = 1.0f;
     bool isEnabled = true;
 
+    std::uint32_t version = 1;
+    void MarkDirty() { ++version; }
+
+    // where the LightingManager packed this light, only meaningful to the manager
+    std::uint32_t lightSlot = NO_LIGHT_SLOT;
+
     virtual LightType GetLightType() const = 0;
 };
 
@@ -31,6 +42,9 @@ public:
     // directional light properties
     DirectX::XMFLOAT3 direction = {0.57735f, -0.57735f, 0.57735f}; // default direction
 
+    // only the first enabled directional light that casts shadows gets the shadow cascades
+    bool castsShadows = true;
+
     LightType GetLightType() const override
     {
         return LightType::Directional;
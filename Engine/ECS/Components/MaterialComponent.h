@@ -14,4 +14,7 @@ public:
 
     DirectX::XMFLOAT4 diffuseColor = {1.0f, 1.0f, 1.0f, 1.0f};
     float specularPower = 32.0f;
+
+    // drawn after every opaque mesh, back to front
+    bool isTransparent = false;
 };
\ No newline at end of file
@@ -3,6 +3,11 @@
 #include "../Component.h"
 #include <d3d11.h>
 #include <wrl/client.h>
+#include <DirectXCollision.h>
+#include <memory>
+
+// defined in Rendering/OcclusionCuller.h, components only hold it by pointer
+struct OccluderGeometry;
 
 class MeshComponent : public Component
 {
@@ -11,4 +16,15 @@ public:
     Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
     UINT indexCount = 0;
     UINT vertexStride = 0;
+
+    // object space bounds copied from the MeshData, meshes without bounds are never culled
+    DirectX::BoundingBox localBounds;
+    DirectX::BoundingSphere localSphere;
+    bool hasBounds = false;
+
+    // drawn into the shadow cascades, meshes without bounds never are since they can't be culled per cascade
+    bool castsShadows = true;
+
+    // CPU copy of the triangles, used if the entity also has an OccluderComponent
+    std::shared_ptr<const OccluderGeometry> occluderGeometry;
 };
\ No newline at end of file
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "../Component.h"
+#include <memory>
+
+struct OccluderGeometry;
+
+// marks a mesh as an occluder, it's drawn into the software depth buffer so the meshes behind it can be skipped
+// only worth it for big things (walls, terrain, large props), small occluders cost more than they hide
+class OccluderComponent : public Component
+{
+public:
+    // stand-in triangles, leave empty to use the mesh's own (MeshComponent::occluderGeometry)
+    std::shared_ptr<const OccluderGeometry> geometry;
+};
@@ -1,7 +1,7 @@
 
 #include "TransformComponent.h"
 
-DirectX::XMMATRIX TransformComponent::GetWorldMatrix() const
+DirectX::XMMATRIX TransformComponent::ComputeWorldMatrix() const
 {
     using namespace DirectX;
 
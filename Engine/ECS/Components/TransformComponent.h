@@ -7,6 +7,8 @@
 // i corrected the component implementations since they all use transforms differently
 // especially the lights
 
+// the world matrix is cached and only rebuilt by the TransformSystem when the transform is dirty,
+// so anything that changes position/rotation/scale after creation has to call MarkDirty()
 class TransformComponent : public Component
 {
 public:
@@ -14,5 +16,19 @@ public:
     DirectX::XMFLOAT3 rotation = {0.0f, 0.0f, 0.0f};
     DirectX::XMFLOAT3 scale = {1.0f, 1.0f, 1.0f};
 
-    DirectX::XMMATRIX GetWorldMatrix() const;
+    // cached world matrix, valid once the TransformSystem has run
+    DirectX::XMFLOAT4X4 world = {1.0f, 0.0f, 0.0f, 0.0f,
+                                 0.0f, 1.0f, 0.0f, 0.0f,
+                                 0.0f, 0.0f, 1.0f, 0.0f,
+                                 0.0f, 0.0f, 0.0f, 1.0f};
+
+    // starts dirty so new transforms get their matrix built on the first update
+    bool isDirty = true;
+
+    void MarkDirty() { isDirty = true; }
+
+    DirectX::XMMATRIX GetWorldMatrix() const { return DirectX::XMLoadFloat4x4(&world); }
+
+    // rebuilds the matrix from position/rotation/scale, used by the TransformSystem
+    DirectX::XMMATRIX ComputeWorldMatrix() const;
 };
\ No newline at end of file
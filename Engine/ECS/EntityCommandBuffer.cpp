@@ -0,0 +1,136 @@
+#include "EntityCommandBuffer.h"
+#include <algorithm>
+
+void *EntityCommandBuffer::Recorder::Allocate(size_t size, size_t alignment)
+{
+    assert(alignment <= PAGE_ALIGNMENT && "Component alignment is larger than the command buffer pages");
+
+    // bump allocate from the current page, moving on to the next one (or a new one) when it's full
+    for (; currentPage < pages.size(); ++currentPage)
+    {
+        Page &page = pages[currentPage];
+        size_t offset = (page.size + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= page.capacity)
+        {
+            page.size = offset + size;
+            return page.data.get() + offset;
+        }
+    }
+
+    // oversized components get a page of their own
+    Page page;
+    page.capacity = std::max(PAGE_SIZE, size);
+    page.data.reset(static_cast<std::byte *>(::operator new(page.capacity, std::align_val_t(PAGE_ALIGNMENT))));
+    page.size = size;
+    pages.push_back(std::move(page));
+    currentPage = pages.size() - 1;
+    return pages.back().data.get();
+}
+
+void EntityCommandBuffer::Recorder::Reset()
+{
+    // anything that wasn't moved out during playback still has to be destroyed
+    for (const Command &command : commands)
+    {
+        if (command.destroy)
+            command.destroy(command.payload);
+    }
+
+    commands.clear();
+    destroys.clear();
+
+    // keep the pages around for the next frame
+    for (Page &page : pages)
+        page.size = 0;
+    currentPage = 0;
+}
+
+std::uint32_t EntityCommandBuffer::NextEpoch()
+{
+    static std::atomic<std::uint32_t> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed) % ENTITY_PLACEHOLDER_GENERATIONS;
+}
+
+EntityCommandBuffer::~EntityCommandBuffer()
+{
+    for (auto &recorder : recorders)
+        recorder->Reset();
+}
+
+EntityCommandBuffer::Recorder &EntityCommandBuffer::GetRecorder()
+{
+    std::lock_guard<std::mutex> lock(recorderMutex);
+
+    if (recordersInUse == recorders.size())
+        recorders.push_back(std::unique_ptr<Recorder>(new Recorder(this)));
+
+    return *recorders[recordersInUse++];
+}
+
+bool EntityCommandBuffer::IsEmpty() const
+{
+    if (pendingCount.load(std::memory_order_relaxed) > 0)
+        return false;
+
+    for (size_t i = 0; i < recordersInUse; ++i)
+    {
+        if (!recorders[i]->commands.empty() || !recorders[i]->destroys.empty())
+            return false;
+    }
+    return true;
+}
+
+void EntityCommandBuffer::Playback(Registry &registry)
+{
+    // create every pending entity first so the other commands can refer to them
+    std::uint32_t created = pendingCount.exchange(0, std::memory_order_relaxed);
+    createdEntities.resize(created);
+    for (std::uint32_t i = 0; i < created; ++i)
+        createdEntities[i] = registry.CreateEntity();
+
+    // counting sort by component type: stable, so commands from one recorder keep their order for each type
+    std::array<size_t, MAX_COMPONENT_TYPES + 1> offsets = {};
+    for (size_t i = 0; i < recordersInUse; ++i)
+    {
+        for (const Recorder::Command &command : recorders[i]->commands)
+            ++offsets[command.typeId + 1];
+    }
+
+    for (ComponentTypeID typeId = 0; typeId < MAX_COMPONENT_TYPES; ++typeId)
+        offsets[typeId + 1] += offsets[typeId];
+
+    sortedCommands.resize(offsets[MAX_COMPONENT_TYPES]);
+    for (size_t i = 0; i < recordersInUse; ++i)
+    {
+        for (const Recorder::Command &command : recorders[i]->commands)
+            sortedCommands[offsets[command.typeId]++] = &command;
+    }
+
+    // the payloads of dropped commands are still destroyed by Reset below
+    for (const Recorder::Command *command : sortedCommands)
+    {
+        EntityID entity = Resolve(command->entity);
+        if (entity != INVALID_ENTITY)
+            command->apply(registry, entity, command->payload);
+    }
+
+    // destroy last, so adding to an entity that also gets destroyed this frame is harmless
+    for (size_t i = 0; i < recordersInUse; ++i)
+    {
+        for (EntityID entity : recorders[i]->destroys)
+        {
+            EntityID resolved = Resolve(entity);
+            if (resolved != INVALID_ENTITY)
+                registry.DestroyEntity(resolved);
+        }
+    }
+
+    for (size_t i = 0; i < recordersInUse; ++i)
+        recorders[i]->Reset();
+
+    recordersInUse = 0;
+    sortedCommands.clear();
+
+    // placeholders handed out so far are used up
+    epoch = NextEpoch();
+}
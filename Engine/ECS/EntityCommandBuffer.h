@@ -0,0 +1,231 @@
+#pragma once
+
+#include "Component.h"
+#include "ComponentType.h"
+#include "Registry.h"
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @class EntityCommandBuffer
+ * @brief Records structural changes (create/destroy entities, add/remove/set components) to apply later
+ *
+ * Changing the registry while a view is being iterated invalidates the view, and the registry isn't safe to
+ * modify from several threads at once. Systems record their changes here instead, and the buffer is played
+ * back into the registry at a sync point (after all systems have updated).
+ *
+ * Recording from several threads: every thread (or job) grabs its own Recorder with GetRecorder() and records
+ * into it without any locking. Recorders stay valid until the next Playback.
+ *
+ * Placeholder handles from Recorder::CreateEntity only mean something to the buffer that made them, up to its next
+ * Playback. Commands on a placeholder from another buffer or from before that are dropped.
+ *
+ * @code
+ * EntityCommandBuffer::Recorder &recorder = commandBuffer.GetRecorder();
+ * EntityID entity = recorder.CreateEntity(); // placeholder, resolved during playback
+ * recorder.AddComponent<TransformComponent>(entity, position, rotation, scale);
+ * ...
+ * commandBuffer.Playback(registry);
+ * @endcode
+ */
+class EntityCommandBuffer
+{
+public:
+    /**
+     * @brief Placeholder handles returned by Recorder::CreateEntity use this generation plus the buffer's epoch
+     *
+     * The registry never hands out these generations (see Registry::DestroyEntity), so a placeholder
+     * can't be confused with a real entity.
+     */
+    static constexpr std::uint32_t FIRST_PENDING_GENERATION = ENTITY_FIRST_PLACEHOLDER_GENERATION;
+
+    /** @brief true if the handle is a placeholder from Recorder::CreateEntity that hasn't been played back yet */
+    static constexpr bool IsPending(EntityID entity) { return GetEntityGeneration(entity) >= FIRST_PENDING_GENERATION; }
+
+    class Recorder
+    {
+    public:
+        /**
+         * @brief Records the creation of an entity
+         * @return Placeholder handle that can be used with the other commands in this buffer
+         */
+        EntityID CreateEntity()
+        {
+            std::uint32_t pending = owner->pendingCount.fetch_add(1, std::memory_order_relaxed);
+            assert(pending <= ENTITY_INDEX_MASK && "Too many entities created in one command buffer");
+            return MakeEntityID(pending, FIRST_PENDING_GENERATION + owner->epoch);
+        }
+
+        /** @brief Records the destruction of an entity (applied after every other command) */
+        void DestroyEntity(EntityID entity)
+        {
+            destroys.push_back(entity);
+        }
+
+        /** @brief Records adding (or replacing) a component */
+        template <typename T, typename... Args>
+        void AddComponent(EntityID entity, Args &&...args)
+        {
+            static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
+
+            T *payload = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            Record(entity, ComponentType::GetID<T>(), payload, &AddPayload<T>, &DestroyPayload<T>);
+        }
+
+        /** @brief Records overwriting a component, ignored if the entity doesn't have it by then */
+        template <typename T>
+        void SetComponent(EntityID entity, T value)
+        {
+            static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
+
+            T *payload = new (Allocate(sizeof(T), alignof(T))) T(std::move(value));
+            Record(entity, ComponentType::GetID<T>(), payload, &SetPayload<T>, &DestroyPayload<T>);
+        }
+
+        /** @brief Records removing a component */
+        template <typename T>
+        void RemoveComponent(EntityID entity)
+        {
+            static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
+
+            Record(entity, ComponentType::GetID<T>(), nullptr, &RemovePayload<T>, nullptr);
+        }
+
+    private:
+        friend class EntityCommandBuffer;
+
+        struct Command
+        {
+            EntityID entity;
+            ComponentTypeID typeId;
+            void *payload;
+            void (*apply)(Registry &registry, EntityID entity, void *payload);
+            void (*destroy)(void *payload);
+        };
+
+        // payload memory comes from fixed pages so recorded components never move
+        struct Page
+        {
+            struct Deleter
+            {
+                void operator()(std::byte *data) const { ::operator delete(data, std::align_val_t(PAGE_ALIGNMENT)); }
+            };
+
+            std::unique_ptr<std::byte, Deleter> data;
+            size_t size = 0;
+            size_t capacity = 0;
+        };
+
+        static constexpr size_t PAGE_SIZE = 64 * 1024;
+        static constexpr size_t PAGE_ALIGNMENT = 64;
+
+        explicit Recorder(EntityCommandBuffer *owner) : owner(owner) {}
+
+        void Record(EntityID entity, ComponentTypeID typeId, void *payload,
+                    void (*apply)(Registry &, EntityID, void *), void (*destroy)(void *))
+        {
+            commands.push_back({entity, typeId, payload, apply, destroy});
+        }
+
+        void *Allocate(size_t size, size_t alignment);
+        void Reset();
+
+        template <typename T>
+        static void AddPayload(Registry &registry, EntityID entity, void *payload)
+        {
+            registry.AddComponent<T>(entity, std::move(*static_cast<T *>(payload)));
+        }
+
+        template <typename T>
+        static void SetPayload(Registry &registry, EntityID entity, void *payload)
+        {
+            if (T *component = registry.GetComponent<T>(entity))
+                *component = std::move(*static_cast<T *>(payload));
+        }
+
+        template <typename T>
+        static void RemovePayload(Registry &registry, EntityID entity, void *)
+        {
+            registry.RemoveComponent<T>(entity);
+        }
+
+        template <typename T>
+        static void DestroyPayload(void *payload)
+        {
+            static_cast<T *>(payload)->~T();
+        }
+
+        EntityCommandBuffer *owner;
+        std::vector<Command> commands;
+        std::vector<EntityID> destroys;
+        std::vector<Page> pages;
+        size_t currentPage = 0;
+    };
+
+    EntityCommandBuffer() = default;
+    ~EntityCommandBuffer();
+
+    EntityCommandBuffer(const EntityCommandBuffer &) = delete;
+    EntityCommandBuffer &operator=(const EntityCommandBuffer &) = delete;
+
+    /**
+     * @brief Hands out a recorder for the calling thread
+     * @return Recorder that only the caller records into, valid until the next Playback
+     *
+     * Takes a lock, so grab one per thread/job and reuse it rather than calling this per command.
+     */
+    Recorder &GetRecorder();
+
+    /**
+     * @brief Applies every recorded command to the registry and clears the buffer
+     * @param registry The registry to apply the commands to
+     *
+     * Must be called from a single thread while nothing else touches the registry. Commands are applied in phases:
+     * - every pending entity is created
+     * - component adds/sets/removes, grouped by component type so each pool is filled in one go
+     *   (commands for the same type keep the order they were recorded in within a recorder)
+     * - entity destruction
+     */
+    void Playback(Registry &registry);
+
+    /** @brief true if nothing has been recorded since the last playback */
+    bool IsEmpty() const;
+
+private:
+    // every playback (of any buffer) takes the next epoch from a shared counter that wraps at
+    // ENTITY_PLACEHOLDER_GENERATIONS, so placeholders from another buffer or an earlier playback carry a
+    // different one unless exactly a multiple of 256 playbacks happened in between
+    static std::uint32_t NextEpoch();
+
+    // a placeholder from another epoch resolves to INVALID_ENTITY and Playback drops its commands,
+    // instead of landing on whichever entity this playback created at the same index
+    EntityID Resolve(EntityID entity) const
+    {
+        if (!IsPending(entity))
+            return entity;
+
+        std::uint32_t index = GetEntityIndex(entity);
+        bool isOwn = GetEntityGeneration(entity) - FIRST_PENDING_GENERATION == epoch;
+        return isOwn && index < createdEntities.size() ? createdEntities[index] : INVALID_ENTITY;
+    }
+
+    std::mutex recorderMutex;
+    std::vector<std::unique_ptr<Recorder>> recorders;
+    size_t recordersInUse = 0;
+
+    std::atomic<std::uint32_t> pendingCount{0};
+    std::uint32_t epoch = NextEpoch();
+
+    // scratch space reused between playbacks
+    std::vector<EntityID> createdEntities;
+    std::vector<const Recorder::Command *> sortedCommands;
+};
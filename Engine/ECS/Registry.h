@@ -1,48 +1,103 @@
 #pragma once
 
 #include "Component.h"
-#include <unordered_map>
-#include <unordered_set>
+#include "ComponentType.h"
+#include <cassert>
+#include <cstdint>
 #include <vector>
-#include <typeindex>
-#include <typeinfo>
-#include <memory>
-#include <functional>
+#include <type_traits>
+
+// the component storage backend is picked at compile time so both can be compared with the same scene
+// configure with -DECS_ARCHETYPE_STORAGE=ON to use archetype chunks instead of sparse sets
+#ifdef ECS_ARCHETYPE_STORAGE
+#include "ArchetypeStorage.h"
+using ComponentStorage = ArchetypeStorage;
+#else
+#include "SparseSetStorage.h"
+using ComponentStorage = SparseSetStorage;
+#endif
 
 /**
  * @class Registry
  * @brief Core of the ECS implementation that manages entities and and their respective components.
  *
  * The registry is responsible for:
- * - Creating and destroying entities
+ * - Creating and destroying entities, recycling the IDs of destroyed ones
  * - Adding components to entities
  * - Retrieving components from entities
  * - Querying entities with specific components
  *
- * @note This class uses type erasure to store components of different types in the same container.
+ * @note Components are stored by the ComponentStorage backend, either one sparse-set pool per component type
+ * (SparseSetStorage.h, the default) or archetype chunks (ArchetypeStorage.h).
+ *
+ * @note Entity IDs are generational handles (see Component.h). Destroying an entity bumps the generation of
+ * its slot and puts the slot on a free list, so storage only grows with the peak number of live entities, and
+ * handles to destroyed entities stop resolving to components instead of aliasing whatever reused the slot.
  */
 class Registry
 {
 public:
     /**
-     * @brief Creates a new entity
+     * @brief Creates a new entity, reusing the slot of a destroyed entity when there is one
      * @return The ID of the newly created entity
      */
     EntityID CreateEntity()
     {
-        return nextEntityId++;
+        if (!freeSlots.empty())
+        {
+            std::uint32_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            slots[slot].alive = true;
+            ++aliveCount;
+            return slots[slot].entity;
+        }
+
+        // slot 0 is never handed out so INVALID_ENTITY can't be a live handle
+        if (slots.empty())
+            slots.push_back({INVALID_ENTITY, {}, false});
+
+        auto slot = static_cast<std::uint32_t>(slots.size());
+        assert(slot <= ENTITY_INDEX_MASK && "Too many live entities for the handle's index bits");
+
+        EntityID entity = MakeEntityID(slot, 0);
+        slots.push_back({entity, {}, true});
+        ++aliveCount;
+        return entity;
     }
 
     /**
      * @brief Destroys an entity and all of its components
      * @param entity The ID of the entity to destroy
+     *
+     * Does nothing if the handle is stale (the entity was already destroyed).
      */
     void DestroyEntity(EntityID entity)
     {
-        for (auto &[type, entityMap] : componentMaps)
-        {
-            entityMap.erase(entity);
-        }
+        if (!IsAlive(entity))
+            return;
+
+        std::uint32_t slot = GetEntityIndex(entity);
+        storage.RemoveAll(entity, slots[slot].signature);
+
+        // bump the generation now so every handle to the old entity is stale from here on
+        // the placeholder generations at the top are skipped, EntityCommandBuffer uses them
+        std::uint32_t generation = (GetEntityGeneration(entity) + 1) % ENTITY_FIRST_PLACEHOLDER_GENERATION;
+        slots[slot].entity = MakeEntityID(slot, generation);
+        slots[slot].signature.reset();
+        slots[slot].alive = false;
+        freeSlots.push_back(slot);
+        --aliveCount;
+    }
+
+    /**
+     * @brief Checks whether a handle refers to an entity that hasn't been destroyed
+     * @param entity The ID of the entity to check
+     * @return true if the entity is alive, false for destroyed, recycled or invalid handles
+     */
+    bool IsAlive(EntityID entity) const
+    {
+        std::uint32_t slot = GetEntityIndex(entity);
+        return slot < slots.size() && slots[slot].alive && slots[slot].entity == entity;
     }
 
     /**
@@ -52,47 +107,64 @@ public:
      * @param entity The ID of the entity to add the component to
      * @param args The arguments to pass to the component constructor
      * @return T* pointer to the newly created component
+     *
+     * @warning The pointer can be invalidated by later structural changes (see the storage backend for details),
+     * so don't hold on to it across other AddComponent/RemoveComponent calls.
      */
     template <typename T, typename... Args>
     T *AddComponent(EntityID entity, Args &&...args)
     {
         static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
+        assert(IsAlive(entity) && "AddComponent on a destroyed entity");
 
-        auto componentType = std::type_index(typeid(T));
+        if (!IsAlive(entity))
+            return nullptr;
 
-        auto mapIt = componentMaps.find(componentType);
-        if (mapIt == componentMaps.end())
-        {
-            componentMaps.emplace(componentType, std::unordered_map<EntityID, std::unique_ptr<Component>>());
-            mapIt = componentMaps.find(componentType);
-        }
+        slots[GetEntityIndex(entity)].signature.set(ComponentType::GetID<T>());
+        return storage.Add<T>(entity, std::forward<Args>(args)...);
+    }
 
-        auto component = std::make_unique<T>(std::forward<Args>(args)...);
-        T *componentPtr = component.get();
-        mapIt->second[entity] = std::move(component);
-        return componentPtr;
+    /**
+     * @brief Removes a component from an entity
+     * @tparam T The component type to remove
+     * @param entity The ID of the entity to remove the component from
+     */
+    template <typename T>
+    void RemoveComponent(EntityID entity)
+    {
+        static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
+
+        if (!IsAlive(entity))
+            return;
+
+        slots[GetEntityIndex(entity)].signature.reset(ComponentType::GetID<T>());
+        storage.Remove<T>(entity);
     }
 
     /**
      * @brief Retrieves a component from an entity
      * @tparam T The component type to retrieve
      * @param entity The ID of the entity to retrieve the component from
-     * @return T* pointer to the component, or nullptr if component not found
+     * @return T* pointer to the component, or nullptr if component not found or the handle is stale
      */
     template <typename T>
     T *GetComponent(EntityID entity)
     {
         static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
 
-        auto componentType = std::type_index(typeid(T));
-        if (componentMaps.find(componentType) == componentMaps.end())
-            return nullptr;
-
-        auto &typeMap = componentMaps[componentType];
-        if (typeMap.find(entity) == typeMap.end())
-            return nullptr;
+        return storage.Get<T>(entity);
+    }
 
-        return static_cast<T *>(typeMap[entity].get());
+    /**
+     * @brief Checks whether an entity has a component
+     * @tparam T The component type to check for
+     * @param entity The ID of the entity to check
+     * @return true if the entity has a component of type T
+     */
+    template <typename T>
+    bool HasComponent(EntityID entity)
+    {
+        return storage.Has<T>(entity);
     }
 
     /**
@@ -105,52 +177,83 @@ public:
     {
         static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
 
-        std::vector<EntityID> result;
-        auto componentType = std::type_index(typeid(T));
+        return storage.GetEntities<T>();
+    }
 
-        if (componentMaps.find(componentType) != componentMaps.end())
-        {
-            auto &typeMap = componentMaps[componentType];
-            result.reserve(typeMap.size());
+    /**
+     * @brief Creates a view over every entity that has all of the given components
+     * @tparam Ts The component types to query for
+     * @return Iterable view yielding (EntityID, Ts &...) tuples, with an Each(func) helper
+     *
+     * Unlike GetEntitiesWith, this doesn't allocate and resolves all components in a single pass.
+     */
+    template <typename... Ts>
+    auto View()
+    {
+        static_assert((std::is_base_of<Component, Ts>::value && ...), "Ts must inherit from Component");
 
-            for (const auto &pair : typeMap)
-            {
-                result.push_back(pair.first);
-            }
-        }
+        return storage.View<Ts...>();
+    }
+
+    /**
+     * @brief Calls a function for every entity that has all of the given components, in parallel
+     * @tparam Ts The component types to query for
+     * @param jobSystem The job system to spread the work over
+     * @param func Callable taking (EntityID, Ts &...)
+     *
+     * The range is split into slices of a multiple of 64 entities (sparse sets) or whole chunks (archetypes), which are
+     * farmed out as jobs.
+     * func runs concurrently, so it may only touch the components it's handed and must not change the registry's
+     * structure, record those changes in an EntityCommandBuffer instead.
+     */
+    template <typename... Ts, typename Func>
+    void ParallelForEach(JobSystem &jobSystem, Func &&func)
+    {
+        static_assert((std::is_base_of<Component, Ts>::value && ...), "Ts must inherit from Component");
 
-        return result;
+        storage.View<Ts...>().ParallelEach(jobSystem, std::forward<Func>(func));
+    }
+
+    /**
+     * @brief Retrieves the component types an entity currently has
+     * @param entity The ID of the entity (must be alive)
+     * @return const ComponentSignature& One bit per ComponentTypeID
+     */
+    const ComponentSignature &GetSignature(EntityID entity) const
+    {
+        assert(IsAlive(entity));
+        return slots[GetEntityIndex(entity)].signature;
     }
 
     /**
      * @brief Retrieves the total number of entities in the registry
-     * @return size_t The number of unique entities
+     * @return size_t The number of live entities, kept up to date by CreateEntity/DestroyEntity
      */
     size_t GetEntityCount() const
     {
-        std::unordered_set<EntityID> uniqueEntities;
-
-        for (const auto &componentTypeMap : componentMaps)
-        {
-            for (const auto &entityComponentPair : componentTypeMap.second)
-            {
-                uniqueEntities.insert(entityComponentPair.first);
-            }
-        }
-
-        return uniqueEntities.size();
+        return aliveCount;
     }
 
+    /** @brief Direct access to the storage backend, for backend-specific fast paths */
+    ComponentStorage &GetStorage() { return storage; }
+
 private:
-    /** @brief ID to assign to the next entity created */
-    EntityID nextEntityId = 1;
+    struct EntitySlot
+    {
+        EntityID entity; // current handle of the slot, the generation is bumped when it's freed
+        ComponentSignature signature; // components the entity has, so DestroyEntity only visits those pools
+        bool alive;
+    };
 
-    /**
-     * @brief Main storage for all components
-     *
-     * Organized as:
-     * - Outer map: Component type → map of entities with this component
-     * - Inner map: Entity ID → Component instance
-     */
-    std::unordered_map<std::type_index, std::unordered_map<EntityID, std::unique_ptr<Component>>> componentMaps;
-};
\ No newline at end of file
+    /** @brief One entry per entity slot ever used, indexed by GetEntityIndex */
+    std::vector<EntitySlot> slots;
+
+    /** @brief Slots of destroyed entities, reused by CreateEntity */
+    std::vector<std::uint32_t> freeSlots;
+
+    /** @brief Number of live entities */
+    size_t aliveCount = 0;
+
+    /** @brief Main storage for all components */
+    ComponentStorage storage;
+};
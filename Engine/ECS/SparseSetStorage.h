@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Component.h"
+#include "ComponentPool.h"
+#include "ComponentType.h"
+#include "View.h"
+#include <memory>
+#include <vector>
+
+/**
+ * @class SparseSetStorage
+ * @brief Component storage backend with one sparse-set pool per component type
+ *
+ * This is the default backend for the Registry. Adding or removing a component only touches the pool
+ * of that type, and GetComponent is an array index into the pool.
+ */
+class SparseSetStorage
+{
+public:
+    template <typename T, typename... Args>
+    T *Add(EntityID entity, Args &&...args)
+    {
+        return GetOrCreatePool<T>().Emplace(entity, std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    void Remove(EntityID entity)
+    {
+        if (auto *pool = GetPool<T>())
+            pool->Remove(entity);
+    }
+
+    // only visits the pools in the entity's signature
+    void RemoveAll(EntityID entity, const ComponentSignature &signature)
+    {
+        ForEachComponentType(signature, [this, entity](ComponentTypeID typeId)
+                             {
+                                 if (typeId < pools.size() && pools[typeId])
+                                     pools[typeId]->Remove(entity);
+                             });
+    }
+
+    template <typename T>
+    T *Get(EntityID entity)
+    {
+        auto *pool = GetPool<T>();
+        return pool ? pool->Get(entity) : nullptr;
+    }
+
+    template <typename T>
+    bool Has(EntityID entity)
+    {
+        auto *pool = GetPool<T>();
+        return pool && pool->Contains(entity);
+    }
+
+    template <typename T>
+    std::vector<EntityID> GetEntities()
+    {
+        auto *pool = GetPool<T>();
+        return pool ? pool->GetEntities() : std::vector<EntityID>();
+    }
+
+    template <typename... Ts>
+    ComponentView<Ts...> View()
+    {
+        return ComponentView<Ts...>(GetPool<Ts>()...);
+    }
+
+    /**
+     * @brief Retrieves the pool that stores a component type
+     * @tparam T The component type
+     * @return ComponentPool<T>* the pool, or nullptr if no component of type T was ever added
+     */
+    template <typename T>
+    ComponentPool<T> *GetPool()
+    {
+        ComponentTypeID typeId = ComponentType::GetID<T>();
+        if (typeId >= pools.size())
+            return nullptr;
+
+        return static_cast<ComponentPool<T> *>(pools[typeId].get());
+    }
+
+private:
+    template <typename T>
+    ComponentPool<T> &GetOrCreatePool()
+    {
+        ComponentTypeID typeId = ComponentType::GetID<T>();
+        if (typeId >= pools.size())
+            pools.resize(static_cast<size_t>(typeId) + 1);
+
+        if (!pools[typeId])
+            pools[typeId] = std::make_unique<ComponentPool<T>>();
+
+        return *static_cast<ComponentPool<T> *>(pools[typeId].get());
+    }
+
+    /**
+     * @brief One sparse-set pool per component type, indexed by ComponentTypeID
+     *
+     * Slots stay null for types that have never been added.
+     */
+    std::vector<std::unique_ptr<SparseSet>> pools;
+};
@@ -1,6 +1,51 @@
 #pragma once
 
 #include "Registry.h"
+#include "ComponentType.h"
+#include "EntityCommandBuffer.h"
+
+/**
+ * @struct ComponentAccess
+ * @brief Component types a system reads and writes during Update
+ *
+ * The SystemScheduler runs systems whose access sets don't conflict at the same time.
+ * Systems that touch anything the scheduler can't see (the D3D immediate context, ImGui, window state)
+ * must stay exclusive, they always run by themselves on the main thread.
+ */
+struct ComponentAccess
+{
+    ComponentSignature reads;
+    ComponentSignature writes;
+    bool exclusive = false;
+
+    template <typename... Ts>
+    ComponentAccess &Read()
+    {
+        (reads.set(ComponentType::GetID<Ts>()), ...);
+        return *this;
+    }
+
+    template <typename... Ts>
+    ComponentAccess &Write()
+    {
+        (writes.set(ComponentType::GetID<Ts>()), ...);
+        return *this;
+    }
+
+    bool ConflictsWith(const ComponentAccess &other) const
+    {
+        return exclusive || other.exclusive ||
+               (writes & (other.reads | other.writes)).any() ||
+               (other.writes & reads).any();
+    }
+
+    static ComponentAccess Exclusive()
+    {
+        ComponentAccess access;
+        access.exclusive = true;
+        return access;
+    }
+};
 
 class System
 {
@@ -11,6 +56,14 @@ public:
     virtual bool Initialize() = 0;
     virtual void Update(float deltaTime) = 0;
 
+    // systems that don't override this are treated as exclusive
+    virtual ComponentAccess GetComponentAccess() const { return ComponentAccess::Exclusive(); }
+
+    // structural changes made during Update should be recorded here instead of going straight to the registry,
+    // the application plays the buffer back once every system has updated
+    void SetCommandBuffer(EntityCommandBuffer *buffer) { commandBuffer = buffer; }
+
 protected:
     Registry &registry;
+    EntityCommandBuffer *commandBuffer = nullptr;
 };
\ No newline at end of file
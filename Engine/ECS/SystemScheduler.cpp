@@ -0,0 +1,79 @@
+#include "SystemScheduler.h"
+
+void SystemScheduler::AddSystem(System *system)
+{
+    systems.push_back(system);
+    batchesDirty = true;
+}
+
+void SystemScheduler::Update(float deltaTime)
+{
+    if (batchesDirty)
+        BuildBatches();
+
+    for (const auto &batch : batches)
+    {
+        // single systems (which includes every exclusive one) run right here on the calling thread
+        if (batch.size() == 1)
+        {
+            batch[0]->Update(deltaTime);
+            continue;
+        }
+
+        JobCounter counter;
+        for (size_t i = 1; i < batch.size(); ++i)
+        {
+            System *system = batch[i];
+            jobSystem.Schedule([system, deltaTime]()
+                               { system->Update(deltaTime); },
+                               &counter);
+        }
+
+        batch[0]->Update(deltaTime);
+        jobSystem.Wait(counter);
+    }
+}
+
+size_t SystemScheduler::GetBatchCount()
+{
+    if (batchesDirty)
+        BuildBatches();
+
+    return batches.size();
+}
+
+void SystemScheduler::BuildBatches()
+{
+    batches.clear();
+
+    std::vector<std::vector<ComponentAccess>> batchAccess;
+    for (System *system : systems)
+    {
+        ComponentAccess access = system->GetComponentAccess();
+
+        size_t target = 0;
+        for (size_t i = batches.size(); i > 0; --i)
+        {
+            bool conflicts = false;
+            for (const ComponentAccess &other : batchAccess[i - 1])
+                conflicts = conflicts || access.ConflictsWith(other);
+
+            if (conflicts)
+            {
+                target = i;
+                break;
+            }
+        }
+
+        if (target == batches.size())
+        {
+            batches.emplace_back();
+            batchAccess.emplace_back();
+        }
+
+        batches[target].push_back(system);
+        batchAccess[target].push_back(access);
+    }
+
+    batchesDirty = false;
+}
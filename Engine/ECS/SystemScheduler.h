@@ -0,0 +1,34 @@
+#pragma once
+
+#include "System.h"
+#include "../Core/JobSystem.h"
+#include <vector>
+
+/**
+ * @class SystemScheduler
+ * @brief Updates systems in registration order, running the ones that don't conflict in parallel
+ *
+ * Systems are grouped into batches using their ComponentAccess. A system goes into the first batch after the
+ * last batch holding a system it conflicts with, so two conflicting systems always run in the order they were
+ * added, and everything in one batch can run at the same time on the job system.
+ *
+ * Systems running in parallel can't change the registry's structure, they record into their command buffer.
+ */
+class SystemScheduler
+{
+public:
+    explicit SystemScheduler(JobSystem &jobSystem) : jobSystem(jobSystem) {}
+
+    void AddSystem(System *system);
+    void Update(float deltaTime);
+
+    size_t GetBatchCount();
+
+private:
+    void BuildBatches();
+
+    JobSystem &jobSystem;
+    std::vector<System *> systems;
+    std::vector<std::vector<System *>> batches;
+    bool batchesDirty = false;
+};
@@ -11,19 +11,12 @@ void CameraManager::ConfigureCameraMatrices(DirectX::XMMATRIX &view, DirectX::XM
 {
     // supporting multiple cameras or a dedicated 'main' camera rather than always picking the first one was the original plan
     // will leave it for future me to solve
-    auto cameraEntities = registry.GetEntitiesWith<CameraComponent>();
-    if (!cameraEntities.empty())
+    // camera component replaced with it's own unique transform component
+    if (auto *camera = GetMainCamera())
     {
-        auto entity = *cameraEntities.begin();
-        auto *camera = registry.GetComponent<CameraComponent>(entity);
-        // camera component replaced with it's own unique transform component
-
-        if (camera)
-        {
-            view = camera->GetViewMatrix();
-            projection = camera->GetProjectionMatrix();
-            return;
-        }
+        view = camera->GetViewMatrix();
+        projection = camera->GetProjectionMatrix();
+        return;
     }
 
     // default just in case
@@ -37,13 +30,7 @@ void CameraManager::ConfigureCameraMatrices(DirectX::XMMATRIX &view, DirectX::XM
 
 void CameraManager::UpdateCameraMovement(float deltaTime)
 {
-    auto cameraEntities = registry.GetEntitiesWith<CameraComponent>();
-    if (cameraEntities.empty())
-        return;
-
-    auto entity = *cameraEntities.begin();
-    auto *camera = registry.GetComponent<CameraComponent>(entity);
-
+    auto *camera = GetMainCamera();
     if (!camera)
         return;
 
@@ -110,31 +97,32 @@ void CameraManager::UpdateCameraMovement(float deltaTime)
 // maybe in a separate class or something
 EntityID CameraManager::FindMainCameraEntity()
 {
-    auto cameraEntities = registry.GetEntitiesWith<CameraComponent>();
-    return cameraEntities.empty() ? INVALID_ENTITY : *cameraEntities.begin();
+    for (auto [entity, camera] : registry.View<CameraComponent>())
+        return entity;
+
+    return INVALID_ENTITY;
+}
+
+// first camera in the pool, same as the old 'first entity with a camera component'
+CameraComponent *CameraManager::GetMainCamera()
+{
+    for (auto [entity, camera] : registry.View<CameraComponent>())
+        return &camera;
+
+    return nullptr;
 }
 
 void CameraManager::UpdateAspectRatio(UINT width, UINT height)
 {
-    auto cameraEntities = registry.GetEntitiesWith<CameraComponent>();
-    for (auto entity : cameraEntities)
+    for (auto [entity, camera] : registry.View<CameraComponent>())
     {
-        if (auto *camera = registry.GetComponent<CameraComponent>(entity))
-        {
-            camera->aspectRatio = static_cast<float>(width) / static_cast<float>(height);
-        }
+        camera.aspectRatio = static_cast<float>(width) / static_cast<float>(height);
     }
 }
 
 bool CameraManager::GetCameraPosition(DirectX::XMFLOAT3 &position)
 {
-    auto cameraEntities = registry.GetEntitiesWith<CameraComponent>();
-    if (cameraEntities.empty())
-        return false;
-
-    auto entity = *cameraEntities.begin();
-    auto *camera = registry.GetComponent<CameraComponent>(entity);
-
+    auto *camera = GetMainCamera();
     if (camera)
     {
         position = camera->position;
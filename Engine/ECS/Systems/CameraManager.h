@@ -16,6 +16,7 @@ public:
     void UpdateCameraMovement(float deltaTime);
 
     EntityID FindMainCameraEntity();
+    CameraComponent *GetMainCamera();
 
     void UpdateAspectRatio(UINT width, UINT height);
     bool GetCameraPosition(DirectX::XMFLOAT3 &position);
@@ -12,6 +12,11 @@ bool InputSystem::Initialize()
     return true;
 }
 
+ComponentAccess InputSystem::GetComponentAccess() const
+{
+    return ComponentAccess().Write<CameraComponent>();
+}
+
 void InputSystem::Update(float deltaTime)
 {
     for (int i = 0; i < 256; i++)
@@ -44,38 +49,34 @@ void InputSystem::Update(float deltaTime)
         mouseButtons[2] = (GetAsyncKeyState(VK_MBUTTON) & 0x8000) != 0;
     }
 
-    auto cameraEntities = registry.GetEntitiesWith<CameraComponent>();
-    for (auto entity : cameraEntities)
+    for (auto [entity, camera] : registry.View<CameraComponent>())
     {
-        if (auto *camera = registry.GetComponent<CameraComponent>(entity))
+        camera.moveForward = IsKeyPressed('W');
+        camera.moveBackward = IsKeyPressed('S');
+        camera.moveLeft = IsKeyPressed('A');
+        camera.moveRight = IsKeyPressed('D');
+        camera.moveUp = IsKeyPressed('E');
+        camera.moveDown = IsKeyPressed('Q');
+
+        if (IsMouseButtonPressed(1)) // right mouse button
         {
-            camera->moveForward = IsKeyPressed('W');
-            camera->moveBackward = IsKeyPressed('S');
-            camera->moveLeft = IsKeyPressed('A');
-            camera->moveRight = IsKeyPressed('D');
-            camera->moveUp = IsKeyPressed('E');
-            camera->moveDown = IsKeyPressed('Q');
-
-            if (IsMouseButtonPressed(1)) // right mouse button
-            {
-                const float sensitivity = 0.003f;
-
-                DirectX::XMVECTOR lookDir = DirectX::XMLoadFloat3(&camera->lookDirection);
-                DirectX::XMVECTOR rightAxis = DirectX::XMVector3Cross(
-                    DirectX::XMVectorSet(0, 1, 0, 0), lookDir);
-                rightAxis = DirectX::XMVector3Normalize(rightAxis);
-
-                DirectX::XMVECTOR quatX = DirectX::XMQuaternionRotationAxis(
-                    rightAxis, mouseDelta.y * sensitivity);
-                DirectX::XMVECTOR quatY = DirectX::XMQuaternionRotationAxis(
-                    DirectX::XMVectorSet(0, 1, 0, 0), mouseDelta.x * sensitivity);
-
-                DirectX::XMVECTOR finalQuat = DirectX::XMQuaternionMultiply(quatX, quatY);
-                lookDir = DirectX::XMVector3Rotate(lookDir, finalQuat);
-                lookDir = DirectX::XMVector3Normalize(lookDir);
-
-                DirectX::XMStoreFloat3(&camera->lookDirection, lookDir);
-            }
+            const float sensitivity = 0.003f;
+
+            DirectX::XMVECTOR lookDir = DirectX::XMLoadFloat3(&camera.lookDirection);
+            DirectX::XMVECTOR rightAxis = DirectX::XMVector3Cross(
+                DirectX::XMVectorSet(0, 1, 0, 0), lookDir);
+            rightAxis = DirectX::XMVector3Normalize(rightAxis);
+
+            DirectX::XMVECTOR quatX = DirectX::XMQuaternionRotationAxis(
+                rightAxis, mouseDelta.y * sensitivity);
+            DirectX::XMVECTOR quatY = DirectX::XMQuaternionRotationAxis(
+                DirectX::XMVectorSet(0, 1, 0, 0), mouseDelta.x * sensitivity);
+
+            DirectX::XMVECTOR finalQuat = DirectX::XMQuaternionMultiply(quatX, quatY);
+            lookDir = DirectX::XMVector3Rotate(lookDir, finalQuat);
+            lookDir = DirectX::XMVector3Normalize(lookDir);
+
+            DirectX::XMStoreFloat3(&camera.lookDirection, lookDir);
         }
     }
 }
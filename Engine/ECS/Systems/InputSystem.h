@@ -12,6 +12,7 @@ public:
 
     bool Initialize() override;
     void Update(float deltaTime) override;
+    ComponentAccess GetComponentAccess() const override;
 
     void ProcessMessage(UINT message, WPARAM wParam, LPARAM lParam);
 
@@ -2,11 +2,13 @@
 #include "../Component.h"
 #include "../../Rendering/Vertex.h"
 #include "../../Rendering/Buffers.h"
+#include "../../Rendering/D3D11RenderDevice.h"
 #include "../Components/MeshComponent.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/CameraComponent.h"
 #include "../Components/LightComponent.h"
 #include "../Components/MaterialComponent.h"
+#include "../Components/OccluderComponent.h"
 
 #include <DirectXMath.h>
 #include <d3dcompiler.h>
@@ -30,6 +32,11 @@ bool RenderSystem::Initialize()
         return false;
 
     resourceManager = std::make_shared<ResourceManager>(graphicsDevice->GetDevice(), graphicsDevice->GetContext());
+    auto d3dDevice = std::make_shared<D3D11RenderDevice>(graphicsDevice, resourceManager);
+    if (!d3dDevice->Initialize())
+        return false;
+
+    renderDevice = d3dDevice;
     meshManager = std::make_shared<MeshManager>(resourceManager);
     shaderManager = std::make_shared<ShaderManager>(resourceManager);
     cameraManager = std::make_shared<CameraManager>(registry);
@@ -42,10 +49,29 @@ bool RenderSystem::Initialize()
     if (!guiManager->Initialize(graphicsDevice->GetDevice(), graphicsDevice->GetContext()))
         return false;
 
-    renderPipeline = std::make_shared<RenderPipelineManager>(graphicsDevice, resourceManager);
+    auto compileShader = [this](const std::wstring &filename, const std::string &shaderModel, std::vector<std::uint8_t> &bytecode)
+    {
+        Microsoft::WRL::ComPtr<ID3DBlob> blob;
+        if (!shaderManager->CompileShaderFromFile(filename, "main", shaderModel, blob))
+            return false;
+
+        const auto *data = static_cast<const std::uint8_t *>(blob->GetBufferPointer());
+        bytecode.assign(data, data + blob->GetBufferSize());
+        return true;
+    };
+
+    renderPipeline = std::make_shared<RenderPipelineManager>(renderDevice, compileShader);
     if (!renderPipeline->Initialize())
         return false;
 
+    if (renderPipeline->SupportsDeferredContexts())
+    {
+        commandRecorder = std::make_unique<ParallelCommandRecorder>(
+            [this]()
+            { return renderPipeline->CreateDeferredContext(); },
+            MIN_DRAWS_PER_CHUNK);
+    }
+
     cubeMeshData = meshManager->CreateCubeMesh();
     if (!cubeMeshData.vertexBuffer || !cubeMeshData.indexBuffer)
         return false;
@@ -56,6 +82,10 @@ bool RenderSystem::Initialize()
     if (!lightingManager->Initialize())
         return false;
 
+    shadowMapManager = std::make_shared<ShadowMapManager>(resourceManager);
+    if (!shadowMapManager->Initialize())
+        return false;
+
     return true;
 }
 
@@ -86,6 +116,9 @@ void RenderSystem::Update(float deltaTime)
         isWireframeEnabled = guiManager->GetWireframeEnabled();
         renderPipeline->SetWireframeMode(isWireframeEnabled);
     }
+
+    if (renderPipeline->IsInstancingEnabled() != guiManager->GetInstancingEnabled())
+        renderPipeline->SetInstancingEnabled(guiManager->GetInstancingEnabled());
 }
 
 void RenderSystem::Render()
@@ -103,50 +136,224 @@ void RenderSystem::Render()
         renderPipeline->UpdateCameraBuffer(cameraPosition);
     }
 
-    lightingManager->Update();
-    lightingManager->Apply(1);
+    lightingManager->Update(jobSystem, view, projection, windowWidth, windowHeight);
+    RenderShadows(view, projection);
+    BindLightingState(renderPipeline->GetImmediateContext());
 
-    renderPipeline->SetTexture(defaultDiffuseTexture.Get(), 0);
-    renderPipeline->SetTexture(defaultNormalTexture.Get(), 1);
-    renderPipeline->SetSampler(defaultSamplerState.Get(), 0);
+    // frustum culling, only the meshes that survive reach the draw loop
+    // meshes without bounds can't be tested, so they're always drawn
+    frustumCuller.SetFrustum(view, projection);
+    frustumCuller.Clear();
+    drawCandidates.clear();
+    candidateBounds.clear();
+    visibleMeshes.clear();
 
-    auto meshEntities = registry.GetEntitiesWith<MeshComponent>();
-    for (auto entity : meshEntities)
+    size_t meshCount = 0;
+    if (spatialIndex)
     {
-        auto *transform = registry.GetComponent<TransformComponent>(entity);
-        auto *mesh = registry.GetComponent<MeshComponent>(entity);
-        auto *material = registry.GetComponent<MaterialComponent>(entity);
+        // the index only hands back what's near the frustum (loose bounds), the exact test below sorts out the rest
+        for (EntityID entity : spatialIndex->GetUnboundedEntities())
+        {
+            auto *transform = registry.GetComponent<TransformComponent>(entity);
+            auto *mesh = registry.GetComponent<MeshComponent>(entity);
+            if (transform && mesh)
+                visibleMeshes.push_back({entity, transform, mesh});
+        }
 
-        if (transform && mesh)
+        spatialIndex->QueryFrustum(frustumCuller.GetPlanes(), queryResults);
+        for (EntityID entity : queryResults)
         {
-            XMMATRIX world = transform->GetWorldMatrix();
+            auto *transform = registry.GetComponent<TransformComponent>(entity);
+            auto *mesh = registry.GetComponent<MeshComponent>(entity);
+            if (!transform || !mesh || !mesh->hasBounds)
+                continue;
+
+            candidateBounds.push_back(FrustumCuller::TransformBounds(mesh->localBounds, transform->GetWorldMatrix()));
+            frustumCuller.Add(candidateBounds.back());
+            drawCandidates.push_back({entity, transform, mesh});
+        }
 
-            renderPipeline->UpdateMatrixBuffer(world, view, projection);
+        meshCount = visibleMeshes.size() + spatialIndex->GetProxyCount();
+    }
+    else
+    {
+        for (auto [entity, transform, mesh] : registry.View<TransformComponent, MeshComponent>())
+        {
+            if (!mesh.hasBounds)
+            {
+                visibleMeshes.push_back({entity, &transform, &mesh});
+                continue;
+            }
+
+            candidateBounds.push_back(FrustumCuller::TransformBounds(mesh.localBounds, transform.GetWorldMatrix()));
+            frustumCuller.Add(candidateBounds.back());
+            drawCandidates.push_back({entity, &transform, &mesh});
+        }
+
+        meshCount = visibleMeshes.size() + drawCandidates.size();
+    }
 
-            renderPipeline->SetVertexBuffer(mesh->vertexBuffer.Get(), mesh->vertexStride);
-            renderPipeline->SetIndexBuffer(mesh->indexBuffer.Get());
+    frustumCuller.Cull(visibleIndices);
 
-            if (material)
+    // occlusion culling, occluders go into the software depth buffer and whatever survived the frustum is tested
+    // against it, occluders themselves are always drawn
+    occlusionCuller.BeginFrame(XMMatrixMultiply(view, projection));
+    size_t occluderCount = 0;
+    for (auto [entity, transform, mesh, occluder] : registry.View<TransformComponent, MeshComponent, OccluderComponent>())
+    {
+        const auto &geometry = occluder.geometry ? occluder.geometry : mesh.occluderGeometry;
+        if (!geometry)
+            continue;
+
+        occlusionCuller.RenderOccluder(*geometry, transform.GetWorldMatrix());
+        ++occluderCount;
+    }
+
+    if (occluderCount > 0)
+        occlusionCuller.BuildHierarchy();
+
+    size_t occludedCount = 0;
+    for (std::uint32_t index : visibleIndices)
+    {
+        const DrawCandidate &candidate = drawCandidates[index];
+        if (occluderCount > 0 && !occlusionCuller.IsVisible(candidateBounds[index]) &&
+            !registry.HasComponent<OccluderComponent>(candidate.entity))
+        {
+            ++occludedCount;
+            continue;
+        }
+
+        visibleMeshes.push_back(candidate);
+    }
+
+    guiManager->SetCullingStats(visibleMeshes.size(), meshCount, occludedCount);
+
+    // per object light lists, each draw brings its most important lights instead of reading its pixels' clusters
+    // meshes without bounds stay on the clusters
+    const bool useObjectLights = guiManager->GetObjectLightsEnabled();
+    if (useObjectLights)
+    {
+        visibleSpheres.resize(visibleMeshes.size());
+        for (size_t i = 0; i < visibleMeshes.size(); ++i)
+        {
+            const DrawCandidate &candidate = visibleMeshes[i];
+            if (!candidate.mesh->hasBounds)
+            {
+                visibleSpheres[i] = XMFLOAT4(0.0f, 0.0f, 0.0f, -1.0f);
+                continue;
+            }
+
+            BoundingSphere sphere;
+            candidate.mesh->localSphere.Transform(sphere, candidate.transform->GetWorldMatrix());
+            visibleSpheres[i] = XMFLOAT4(sphere.Center.x, sphere.Center.y, sphere.Center.z, sphere.Radius);
+        }
+
+        lightingManager->SelectObjectLights(jobSystem, visibleSpheres.data(), visibleSpheres.size());
+    }
+
+    // sort the draws so the ones sharing state are next to each other, opaque front to back and transparent back to front
+    // material is optional, so it's looked up separately instead of being part of the view
+    auto *camera = cameraManager->GetMainCamera();
+    float inverseFarPlane = 1.0f / (camera ? camera->farPlane : 100.0f);
+
+    renderQueue.Clear();
+    for (size_t i = 0; i < visibleMeshes.size(); ++i)
+    {
+        DrawCandidate &candidate = visibleMeshes[i];
+        candidate.material = registry.GetComponent<MaterialComponent>(candidate.entity);
+
+        const XMFLOAT4X4 &world = candidate.transform->world;
+        float depth = XMVectorGetZ(XMVector3Transform(XMVectorSet(world._41, world._42, world._43, 1.0f), view));
+
+        const MaterialComponent *material = candidate.material;
+        RenderQueue::Pass pass = material && material->isTransparent ? RenderQueue::Pass::Transparent : RenderQueue::Pass::Opaque;
+        std::uint32_t materialID = 0;
+        if (material)
+            materialID = renderQueue.GetStateID(RenderQueue::StateType::Material,
+                                                {material->diffuseTexture.Get(), material->normalTexture.Get(), material->samplerState.Get()});
+        std::uint32_t meshID = renderQueue.GetStateID(RenderQueue::StateType::Mesh,
+                                                      {candidate.mesh->vertexBuffer.Get(), candidate.mesh->indexBuffer.Get()});
+
+        // everything uses the same shaders for now
+        renderQueue.Submit(RenderQueue::MakeKey(pass, 0, materialID, meshID, depth * inverseFarPlane), static_cast<std::uint32_t>(i));
+    }
+    renderQueue.Sort();
+
+    size_t drawCalls = 0;
+    if (renderPipeline->IsInstancingEnabled())
+    {
+        // the queue already put draws with the same mesh and material next to each other, each run becomes one draw
+        instanceBatcher.Clear();
+        for (const RenderQueue::Entry &entry : renderQueue.GetEntries())
+        {
+            const DrawCandidate &candidate = visibleMeshes[entry.item];
+            InstanceBatcher::DrawState state;
+            state.vertexBuffer = candidate.mesh->vertexBuffer.Get();
+            state.indexBuffer = candidate.mesh->indexBuffer.Get();
+            state.indexCount = candidate.mesh->indexCount;
+            if (const MaterialComponent *material = candidate.material)
             {
-                if (material->diffuseTexture)
-                {
-                    renderPipeline->SetTexture(material->diffuseTexture.Get(), 0);
-                }
-
-                if (material->normalTexture)
-                {
-                    renderPipeline->SetTexture(material->normalTexture.Get(), 1);
-                }
-
-                if (material->samplerState)
-                {
-                    renderPipeline->SetSampler(material->samplerState.Get(), 0);
-                }
+                state.diffuseTexture = material->diffuseTexture.Get();
+                state.normalTexture = material->normalTexture.Get();
+                state.sampler = material->samplerState.Get();
             }
 
-            renderPipeline->DrawIndexed(mesh->indexCount);
+            instanceBatcher.Add(state, entry.item, candidate.transform->world,
+                                useObjectLights ? &lightingManager->GetObjectLights(entry.item) : nullptr);
+        }
+
+        // the world matrix comes from the instance stream, so the constant buffer only holds the camera
+        UINT cameraMatrices = renderPipeline->AddMatrixBuffer(XMMatrixIdentity(), view, projection);
+
+        const std::vector<InstanceData> &instances = instanceBatcher.GetInstances();
+        if (renderPipeline->UploadInstances(instances.data(), static_cast<std::uint32_t>(instances.size())) &&
+            renderPipeline->UploadMatrixBuffers())
+        {
+            const std::vector<InstanceBatcher::Batch> &batches = instanceBatcher.GetBatches();
+            SubmitDraws(batches.size(), [&](ICommandContext &context, size_t begin, size_t end)
+                        {
+                            renderPipeline->BindMatrixBuffer(context, cameraMatrices);
+                            for (size_t i = begin; i < end; ++i)
+                            {
+                                const InstanceBatcher::Batch &batch = batches[i];
+                                const DrawCandidate &candidate = visibleMeshes[batch.firstItem];
+                                BindDrawState(context, candidate);
+                                context.DrawIndexedInstanced(candidate.mesh->indexCount, batch.instanceCount, batch.firstInstance);
+                            }
+                        });
+            drawCalls = batches.size();
         }
     }
+    else
+    {
+        // all matrices of the frame are written in one go, the draws then only pick theirs (same order as the queue)
+        const std::vector<RenderQueue::Entry> &entries = renderQueue.GetEntries();
+        for (const RenderQueue::Entry &entry : entries)
+            renderPipeline->AddMatrixBuffer(visibleMeshes[entry.item].transform->GetWorldMatrix(), view, projection,
+                                            useObjectLights ? &lightingManager->GetObjectLights(entry.item) : nullptr);
+
+        if (renderPipeline->UploadMatrixBuffers())
+        {
+            SubmitDraws(entries.size(), [&](ICommandContext &context, size_t begin, size_t end)
+                        {
+                            for (size_t i = begin; i < end; ++i)
+                            {
+                                const DrawCandidate &candidate = visibleMeshes[entries[i].item];
+                                renderPipeline->BindMatrixBuffer(context, static_cast<UINT>(i));
+                                BindDrawState(context, candidate);
+                                context.DrawIndexed(candidate.mesh->indexCount);
+                            }
+                        });
+            drawCalls = entries.size();
+        }
+    }
+
+    guiManager->SetDrawCallCount(drawCalls);
+
+    const RenderStateCache::Stats &stateStats = renderPipeline->GetStateStats();
+    guiManager->SetStateBindStats(stateStats.issued, stateStats.skipped);
+    guiManager->SetLightStats(lightingManager->GetLightCount(), lightingManager->GetRepackedCount(),
+                              lightingManager->GetDroppedLightCount());
 
     // can probably the gui rendering less wordy
     guiManager->NewFrame();
@@ -158,16 +365,187 @@ void RenderSystem::Render()
     static bool showDemoWindow = false;
     guiManager->ShowDemoWindow(&showDemoWindow);
 
+    // the imgui backend saves the state it touches and puts it back afterwards, so the state cache stays valid
+    // (except for constant buffer ranges, the pipeline forgets those at the start of the next frame)
     guiManager->Render();
 
     renderPipeline->Present();
 }
 
+void RenderSystem::RenderShadows(FXMMATRIX view, CXMMATRIX projection)
+{
+    // the first enabled directional light that casts shadows gets the cascades, it needs a slot for the shader to match
+    const DirectionalLightComponent *shadowLight = nullptr;
+    if (guiManager->GetShadowsEnabled())
+    {
+        for (auto [entity, light] : registry.View<DirectionalLightComponent>())
+        {
+            if (light.isEnabled && light.castsShadows && light.lightSlot != BaseLightComponent::NO_LIGHT_SLOT)
+            {
+                shadowLight = &light;
+                break;
+            }
+        }
+    }
+
+    // casters aren't limited to the camera frustum, anything between the light and the view can throw a shadow into it
+    ShadowCascades &cascades = shadowMapManager->GetCascades();
+    cascades.Clear();
+    shadowCasters.clear();
+    if (shadowLight)
+    {
+        for (auto [entity, transform, mesh] : registry.View<TransformComponent, MeshComponent>())
+        {
+            if (!mesh.hasBounds || !mesh.castsShadows)
+                continue;
+
+            cascades.Add(FrustumCuller::TransformBounds(mesh.localBounds, transform.GetWorldMatrix()),
+                         ShadowCascades::HashCaster(entity, mesh.vertexBuffer.Get(), transform.world));
+            shadowCasters.push_back({entity, &transform, &mesh});
+        }
+    }
+
+    shadowMapManager->Update(view, projection, shadowLight);
+    if (!shadowLight)
+    {
+        guiManager->SetShadowStats(0, 0);
+        return;
+    }
+
+    // cascades whose projection and casters are the same as when they were drawn keep their slice of the map
+    bool isDirty[ShadowCascades::CASCADE_COUNT];
+    size_t dirtyCount = 0;
+    for (std::uint32_t c = 0; c < ShadowCascades::CASCADE_COUNT; ++c)
+    {
+        isDirty[c] = cascades.IsDirty(c);
+        dirtyCount += isDirty[c] ? 1 : 0;
+    }
+
+    if (dirtyCount == 0)
+    {
+        guiManager->SetShadowStats(shadowCasters.size(), 0);
+        return;
+    }
+
+    // the matrices of every cascade that has to be redrawn go up in one go, in the order they're drawn
+    XMMATRIX lightView = XMLoadFloat4x4(&cascades.GetLightView());
+    for (std::uint32_t c = 0; c < ShadowCascades::CASCADE_COUNT; ++c)
+    {
+        if (!isDirty[c])
+            continue;
+
+        const ShadowCascades::Cascade &cascade = cascades.GetCascade(c);
+        XMMATRIX cascadeProjection = XMLoadFloat4x4(&cascade.projection);
+        for (std::uint32_t caster : cascade.casters)
+            renderPipeline->AddMatrixBuffer(shadowCasters[caster].transform->GetWorldMatrix(), lightView, cascadeProjection);
+    }
+
+    size_t redrawnCount = 0;
+    if (renderPipeline->UploadMatrixBuffers())
+    {
+        ICommandContext &context = renderPipeline->GetImmediateContext();
+        const void *inputLayout = renderPipeline->GetDefaultInputLayout();
+
+        UINT matrixIndex = 0;
+        for (std::uint32_t c = 0; c < ShadowCascades::CASCADE_COUNT; ++c)
+        {
+            if (!isDirty[c])
+                continue;
+
+            shadowMapManager->BeginCascade(context, c, inputLayout);
+            for (std::uint32_t caster : cascades.GetCascade(c).casters)
+            {
+                const MeshComponent &mesh = *shadowCasters[caster].mesh;
+                renderPipeline->BindMatrixBuffer(context, matrixIndex++);
+                context.SetVertexBuffer(0, mesh.vertexBuffer.Get(), mesh.vertexStride, 0);
+                context.SetIndexBuffer(mesh.indexBuffer.Get(), FORMAT_R32_UINT, 0);
+                context.DrawIndexed(mesh.indexCount);
+            }
+
+            cascades.MarkRendered(c);
+            ++redrawnCount;
+        }
+
+        // back to the main pass' targets, shaders and states
+        renderPipeline->BindPassState(context);
+    }
+
+    // the main pass numbers its matrices from 0 again
+    renderPipeline->ClearMatrixBuffers();
+    guiManager->SetShadowStats(shadowCasters.size(), redrawnCount);
+}
+
+void RenderSystem::SubmitDraws(size_t drawCount, const ParallelCommandRecorder::RecordFunction &record)
+{
+    // big frames are split into one chunk per thread, each chunk is recorded on a deferred context and the chunks
+    // are executed in order. A deferred context starts with nothing bound, so every chunk binds the frame state
+    // first, and every draw binds all of its own state (BindDrawState), which keeps a draw from seeing anything
+    // the draw before it left behind. That way the picture doesn't depend on where the chunks were cut.
+    if (commandRecorder && jobSystem && drawCount >= 2 * MIN_DRAWS_PER_CHUNK)
+    {
+        bool isRecorded = commandRecorder->Record(jobSystem, drawCount, [&](ICommandContext &context, size_t begin, size_t end)
+                                                  {
+                                                      BindFrameState(context);
+                                                      record(context, begin, end);
+                                                  });
+        if (isRecorded)
+        {
+            commandRecorder->Execute();
+            return;
+        }
+    }
+
+    // the immediate context already has the frame state bound
+    record(renderPipeline->GetImmediateContext(), 0, drawCount);
+}
+
+void RenderSystem::BindFrameState(ICommandContext &context)
+{
+    renderPipeline->BindPassState(context);
+    BindLightingState(context);
+}
+
+void RenderSystem::BindLightingState(ICommandContext &context)
+{
+    context.SetConstantBuffer(ICommandContext::Stage::Pixel, 1, lightingManager->GetLightBuffer());
+    context.SetTexture(LightingManager::DIRECTIONAL_LIGHT_SLOT, lightingManager->GetDirectionalLightView());
+    context.SetTexture(LightingManager::POINT_LIGHT_SLOT, lightingManager->GetPointLightView());
+    context.SetTexture(LightingManager::SPOT_LIGHT_SLOT, lightingManager->GetSpotLightView());
+    context.SetTexture(LightingManager::CLUSTER_RANGE_SLOT, lightingManager->GetClusterRangeView());
+    context.SetTexture(LightingManager::CLUSTER_INDEX_SLOT, lightingManager->GetClusterIndexView());
+
+    context.SetConstantBuffer(ICommandContext::Stage::Pixel, ShadowMapManager::SHADOW_BUFFER_SLOT, shadowMapManager->GetShadowBuffer());
+    context.SetTexture(ShadowMapManager::SHADOW_MAP_SLOT, shadowMapManager->GetShadowMapView());
+    context.SetSampler(ShadowMapManager::SHADOW_SAMPLER_SLOT, shadowMapManager->GetShadowSampler());
+}
+
+void RenderSystem::BindDrawState(ICommandContext &context, const DrawCandidate &candidate)
+{
+    const MeshComponent &mesh = *candidate.mesh;
+    const MaterialComponent *material = candidate.material;
+
+    context.SetVertexBuffer(0, mesh.vertexBuffer.Get(), mesh.vertexStride, 0);
+    context.SetIndexBuffer(mesh.indexBuffer.Get(), FORMAT_R32_UINT, 0);
+
+    // whatever the material leaves out comes from the defaults, never from the previous draw (the state cache
+    // drops the binds that don't change anything)
+    ID3D11ShaderResourceView *diffuse = material && material->diffuseTexture ? material->diffuseTexture.Get() : defaultDiffuseTexture.Get();
+    ID3D11ShaderResourceView *normal = material && material->normalTexture ? material->normalTexture.Get() : defaultNormalTexture.Get();
+    ID3D11SamplerState *sampler = material && material->samplerState ? material->samplerState.Get() : defaultSamplerState.Get();
+
+    context.SetTexture(0, diffuse);
+    context.SetTexture(1, normal);
+    context.SetSampler(0, sampler);
+}
+
 bool RenderSystem::OnResize(UINT newWidth, UINT newHeight)
 {
     if (!graphicsDevice->OnResize(newWidth, newHeight))
         return false;
 
+    // resizing goes straight to the context, don't trust what was bound before
+    renderPipeline->InvalidateStateCache();
+
     windowWidth = newWidth;
     windowHeight = newHeight;
 
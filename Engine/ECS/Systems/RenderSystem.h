@@ -5,11 +5,23 @@
 #include "../../Resources/MeshManager.h"
 #include "../../Resources/ShaderManager.h"
 #include "../../Rendering/LightingManager.h"
+#include "../../Rendering/ShadowMapManager.h"
 #include "CameraManager.h"
 #include "../../Core/Timer.h"
 #include "../../Rendering/GraphicsDeviceManager.h"
+#include "../../Rendering/IRenderDevice.h"
 #include "../../Rendering/RenderPipelineManager.h"
 #include "../../Rendering/GUIManager.h"
+#include "../../Rendering/FrustumCuller.h"
+#include "../../Rendering/OcclusionCuller.h"
+#include "../../Rendering/RenderQueue.h"
+#include "../../Rendering/InstanceBatcher.h"
+#include "../../Rendering/ParallelCommandRecorder.h"
+#include "../../Core/JobSystem.h"
+#include "SpatialIndexSystem.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/MeshComponent.h"
+#include "../Components/MaterialComponent.h"
 #include <d3d11.h>
 #include <wrl/client.h>
 #include <DirectXMath.h>
@@ -46,12 +58,36 @@ public:
     std::shared_ptr<ShaderManager> GetShaderManager() const { return shaderManager; }
     std::shared_ptr<GraphicsDeviceManager> GetGraphicsDevice() const { return graphicsDevice; }
     std::shared_ptr<RenderPipelineManager> GetRenderPipeline() const { return renderPipeline; }
+    std::shared_ptr<IRenderDevice> GetRenderDevice() const { return renderDevice; }
     std::shared_ptr<GUIManager> GetGUIManager() const { return guiManager; }
     std::shared_ptr<CameraManager> GetCameraManager() const { return cameraManager; }
 
+    // with a spatial index only the entities it returns for the frustum are tested, instead of every mesh
+    void SetSpatialIndex(const SpatialIndexSystem *index) { spatialIndex = index; }
+
+    // with a job system large frames are recorded on deferred contexts, one chunk of draws per thread
+    void SetJobSystem(JobSystem *system) { jobSystem = system; }
+
 private:
     bool LoadDefaultTextures();
 
+    struct DrawCandidate
+    {
+        EntityID entity;
+        const TransformComponent *transform;
+        const MeshComponent *mesh;
+        const MaterialComponent *material = nullptr; // filled in when the draw is queued
+    };
+
+    // below this many draws a frame is recorded on the immediate context, splitting it up wouldn't pay off
+    static constexpr size_t MIN_DRAWS_PER_CHUNK = 256;
+
+    void BindFrameState(ICommandContext &context); // pass and lighting state, what every chunk of draws starts from
+    void BindLightingState(ICommandContext &context); // light constants, the clustered light lists and the shadow map
+    void RenderShadows(DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection);
+    void BindDrawState(ICommandContext &context, const DrawCandidate &candidate); // buffers, textures and sampler, all of them
+    void SubmitDraws(size_t drawCount, const ParallelCommandRecorder::RecordFunction &record);
+
     HWND windowHandle;
     UINT windowWidth;
     UINT windowHeight;
@@ -69,10 +105,29 @@ private:
 
     std::shared_ptr<GraphicsDeviceManager> graphicsDevice;
     std::shared_ptr<ResourceManager> resourceManager;
+    std::shared_ptr<IRenderDevice> renderDevice;
     std::shared_ptr<MeshManager> meshManager;
     std::shared_ptr<ShaderManager> shaderManager;
     std::shared_ptr<LightingManager> lightingManager;
+    std::shared_ptr<ShadowMapManager> shadowMapManager;
     std::shared_ptr<RenderPipelineManager> renderPipeline;
     std::shared_ptr<GUIManager> guiManager;
     std::shared_ptr<CameraManager> cameraManager;
+
+    const SpatialIndexSystem *spatialIndex = nullptr;
+    JobSystem *jobSystem = nullptr;
+    std::unique_ptr<ParallelCommandRecorder> commandRecorder;
+    std::vector<EntityID> queryResults;
+
+    FrustumCuller frustumCuller;
+    OcclusionCuller occlusionCuller;
+    std::vector<DrawCandidate> drawCandidates;
+    std::vector<DirectX::BoundingBox> candidateBounds;
+    std::vector<DrawCandidate> visibleMeshes;
+    std::vector<std::uint32_t> visibleIndices;
+    std::vector<DirectX::XMFLOAT4> visibleSpheres; // world space bounding spheres of visibleMeshes, for the light lists
+    std::vector<DrawCandidate> shadowCasters;      // same order as the casters handed to the shadow cascades
+
+    RenderQueue renderQueue;
+    InstanceBatcher instanceBatcher;
 };
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "SpatialIndexSystem.h"
+#include "TransformSystem.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/MeshComponent.h"
+#include "../../Rendering/FrustumCuller.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+    // tracked slots checked for destroyed entities per update
+    constexpr size_t SWEEP_PER_UPDATE = 1024;
+}
+
+SpatialIndexSystem::SpatialIndexSystem(Registry &registry, const TransformSystem &transformSystem, SpatialIndexType indexType)
+    : System(registry), transformSystem(transformSystem), index(ISpatialIndex::Create(indexType))
+{
+}
+
+bool SpatialIndexSystem::Initialize()
+{
+    return true;
+}
+
+ComponentAccess SpatialIndexSystem::GetComponentAccess() const
+{
+    // reads what the TransformSystem writes, so the scheduler keeps it after the TransformSystem
+    return ComponentAccess().Read<TransformComponent, MeshComponent>();
+}
+
+void SpatialIndexSystem::SetIndexType(SpatialIndexType type)
+{
+    if (index->GetType() == type)
+        return;
+
+    index = ISpatialIndex::Create(type);
+    tracked.clear();
+    unboundedEntities.clear();
+    sweepCursor = 0;
+    needsRescan = true;
+}
+
+void SpatialIndexSystem::Update(float deltaTime)
+{
+    Sweep(SWEEP_PER_UPDATE);
+
+    // a mesh added to an entity whose transform didn't change wouldn't show up below, so look for
+    // untracked entities whenever the number of meshes changes (rare, it's a structural change)
+    size_t meshCount = registry.View<MeshComponent>().SizeHint();
+    if (needsRescan || meshCount != knownMeshCount)
+    {
+        knownMeshCount = meshCount;
+        needsRescan = false;
+        for (auto [entity, transform, mesh] : registry.View<TransformComponent, MeshComponent>())
+        {
+            std::uint32_t slot = GetEntityIndex(entity);
+            if (slot >= tracked.size() || tracked[slot].entity != entity)
+                Refresh(entity);
+        }
+    }
+
+    for (EntityID entity : transformSystem.GetChangedEntities())
+        Refresh(entity);
+}
+
+void SpatialIndexSystem::Refresh(EntityID entity)
+{
+    std::uint32_t slot = GetEntityIndex(entity);
+    if (slot >= tracked.size())
+        tracked.resize(static_cast<size_t>(slot) + 1);
+
+    // the slot was recycled, the old entity is gone
+    if (tracked[slot].entity != INVALID_ENTITY && tracked[slot].entity != entity)
+        Forget(slot);
+
+    auto *transform = registry.GetComponent<TransformComponent>(entity);
+    auto *mesh = registry.GetComponent<MeshComponent>(entity);
+    if (!transform || !mesh)
+    {
+        if (tracked[slot].entity == entity)
+            Forget(slot);
+        return;
+    }
+
+    TrackedEntity &entry = tracked[slot];
+    bool isTracked = entry.entity == entity;
+
+    if (!mesh->hasBounds)
+    {
+        if (isTracked && entry.proxy == ISpatialIndex::NULL_PROXY)
+            return;
+
+        if (isTracked)
+            Forget(slot);
+
+        entry.entity = entity;
+        entry.proxy = ISpatialIndex::NULL_PROXY;
+        unboundedEntities.push_back(entity);
+        return;
+    }
+
+    BoundingBox worldBounds = FrustumCuller::TransformBounds(mesh->localBounds, transform->GetWorldMatrix());
+    if (isTracked && entry.proxy != ISpatialIndex::NULL_PROXY)
+    {
+        index->MoveProxy(entry.proxy, worldBounds);
+        return;
+    }
+
+    // was unbounded until now
+    if (isTracked)
+        Forget(slot);
+
+    entry.entity = entity;
+    entry.proxy = index->CreateProxy(worldBounds, entity);
+}
+
+void SpatialIndexSystem::Forget(std::uint32_t slot)
+{
+    TrackedEntity &entry = tracked[slot];
+    if (entry.proxy != ISpatialIndex::NULL_PROXY)
+    {
+        index->DestroyProxy(entry.proxy);
+    }
+    else
+    {
+        auto it = std::find(unboundedEntities.begin(), unboundedEntities.end(), entry.entity);
+        if (it != unboundedEntities.end())
+        {
+            *it = unboundedEntities.back();
+            unboundedEntities.pop_back();
+        }
+    }
+
+    entry = TrackedEntity();
+}
+
+void SpatialIndexSystem::Sweep(size_t count)
+{
+    count = std::min(count, tracked.size());
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (sweepCursor >= tracked.size())
+            sweepCursor = 0;
+
+        auto slot = static_cast<std::uint32_t>(sweepCursor++);
+        EntityID entity = tracked[slot].entity;
+        if (entity == INVALID_ENTITY)
+            continue;
+
+        if (!registry.IsAlive(entity) || !registry.HasComponent<MeshComponent>(entity) ||
+            !registry.HasComponent<TransformComponent>(entity))
+            Forget(slot);
+    }
+}
+
+void SpatialIndexSystem::FilterDead(std::vector<EntityID> &results) const
+{
+    // entities destroyed since the last sweep are still in the index
+    auto end = std::remove_if(results.begin(), results.end(), [this](EntityID entity)
+                              { return !registry.IsAlive(entity); });
+    results.erase(end, results.end());
+}
+
+void SpatialIndexSystem::QueryFrustum(const XMFLOAT4 (&planes)[6], std::vector<EntityID> &results) const
+{
+    index->QueryFrustum(planes, results);
+    FilterDead(results);
+}
+
+void SpatialIndexSystem::QuerySphere(const BoundingSphere &sphere, std::vector<EntityID> &results) const
+{
+    index->QuerySphere(sphere, results);
+    FilterDead(results);
+}
+
+void SpatialIndexSystem::QueryBox(const BoundingBox &box, std::vector<EntityID> &results) const
+{
+    index->QueryBox(box, results);
+    FilterDead(results);
+}
+
+void SpatialIndexSystem::QueryRay(const XMFLOAT3 &origin, const XMFLOAT3 &direction, float maxDistance,
+                                  std::vector<EntityID> &results) const
+{
+    index->QueryRay(origin, direction, maxDistance, results);
+    FilterDead(results);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../System.h"
+#include "../../Scene/ISpatialIndex.h"
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class TransformSystem;
+
+// keeps a spatial index (see ISpatialIndex) of the world bounds of every entity with a transform and a mesh
+// only entities whose world matrix changed this frame (see TransformSystem::GetChangedEntities) are touched,
+// so a scene that barely moves costs next to nothing
+//
+// destroyed entities and removed meshes are swept out a few at a time, queries never return dead entities
+// meshes without bounds can't go in the index, they're listed separately so the renderer can still draw them
+class SpatialIndexSystem : public System
+{
+public:
+    SpatialIndexSystem(Registry &registry, const TransformSystem &transformSystem,
+                       SpatialIndexType indexType = SpatialIndexType::BoundingVolumeHierarchy);
+    ~SpatialIndexSystem() = default;
+
+    bool Initialize() override;
+    void Update(float deltaTime) override;
+    ComponentAccess GetComponentAccess() const override;
+
+    // switches to another index type, everything is reinserted on the next update
+    void SetIndexType(SpatialIndexType type);
+    SpatialIndexType GetIndexType() const { return index->GetType(); }
+
+    // all of these fill results with the entities whose (slightly enlarged) bounds pass the test,
+    // exact tests against the real bounds are up to the caller
+    void QueryFrustum(const DirectX::XMFLOAT4 (&planes)[6], std::vector<EntityID> &results) const;
+    void QuerySphere(const DirectX::BoundingSphere &sphere, std::vector<EntityID> &results) const;
+    void QueryBox(const DirectX::BoundingBox &box, std::vector<EntityID> &results) const;
+    void QueryRay(const DirectX::XMFLOAT3 &origin, const DirectX::XMFLOAT3 &direction, float maxDistance,
+                  std::vector<EntityID> &results) const;
+
+    // entities with a mesh that has no bounds, they're never in query results
+    const std::vector<EntityID> &GetUnboundedEntities() const { return unboundedEntities; }
+
+    size_t GetProxyCount() const { return index->GetProxyCount(); }
+
+private:
+    struct TrackedEntity
+    {
+        EntityID entity = INVALID_ENTITY;
+        std::int32_t proxy = ISpatialIndex::NULL_PROXY; // NULL_PROXY for unbounded meshes
+    };
+
+    // inserts or moves the entity, or forgets it if it no longer has a transform and a mesh
+    void Refresh(EntityID entity);
+    void Forget(std::uint32_t slot);
+
+    // drops up to count tracked entities that were destroyed or lost their mesh
+    void Sweep(size_t count);
+
+    void FilterDead(std::vector<EntityID> &results) const;
+
+    const TransformSystem &transformSystem;
+
+    std::unique_ptr<ISpatialIndex> index;
+    std::vector<TrackedEntity> tracked; // indexed by entity slot
+    std::vector<EntityID> unboundedEntities;
+    size_t sweepCursor = 0;
+    size_t knownMeshCount = 0;
+    bool needsRescan = true;
+};
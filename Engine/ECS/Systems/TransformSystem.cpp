@@ -0,0 +1,173 @@
+#include "TransformSystem.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/HierarchyComponent.h"
+
+using namespace DirectX;
+
+namespace
+{
+    // below this many dirty transforms it's cheaper to just do them here than to hand out jobs
+    constexpr size_t PARALLEL_THRESHOLD = 1024;
+}
+
+TransformSystem::TransformSystem(Registry &registry, JobSystem &jobSystem)
+    : System(registry), jobSystem(jobSystem)
+{
+}
+
+bool TransformSystem::Initialize()
+{
+    return true;
+}
+
+ComponentAccess TransformSystem::GetComponentAccess() const
+{
+    return ComponentAccess().Write<TransformComponent, HierarchyComponent>();
+}
+
+bool TransformSystem::SetParent(EntityID child, EntityID parent)
+{
+    if (!registry.IsAlive(child) || (parent != INVALID_ENTITY && !registry.IsAlive(parent)))
+        return false;
+
+    if (!hierarchy.SetParent(child, parent))
+        return false;
+
+    auto *link = registry.GetComponent<HierarchyComponent>(child);
+    if (!link)
+    {
+        link = registry.AddComponent<HierarchyComponent>(child);
+        ++trackedLinks;
+    }
+    link->parent = parent;
+
+    // the child (and everything below it) needs a new world matrix
+    if (auto *transform = registry.GetComponent<TransformComponent>(child))
+        transform->MarkDirty();
+
+    return true;
+}
+
+void TransformSystem::Update(float deltaTime)
+{
+    changedEntities.clear();
+    dirtyTransforms.clear();
+
+    SyncHierarchy();
+
+    // gather first, so the number of dirty transforms decides how the matrix work is done
+    // transforms that are part of the hierarchy are handled separately below
+    bool hasHierarchy = !hierarchy.GetNodes().empty();
+    for (auto [entity, transform] : registry.View<TransformComponent>())
+    {
+        if (!transform.isDirty || (hasHierarchy && hierarchy.Contains(entity)))
+            continue;
+
+        changedEntities.push_back(entity);
+        dirtyTransforms.push_back(&transform);
+    }
+
+    if (dirtyTransforms.size() < PARALLEL_THRESHOLD)
+    {
+        for (TransformComponent *transform : dirtyTransforms)
+        {
+            XMStoreFloat4x4(&transform->world, transform->ComputeWorldMatrix());
+            transform->isDirty = false;
+        }
+    }
+    else
+    {
+        // most of the scene moved, split the pool itself into slices on the job system
+        registry.ParallelForEach<TransformComponent>(jobSystem, [this, hasHierarchy](EntityID entity, TransformComponent &transform)
+                                                     {
+                                                         if (!transform.isDirty || (hasHierarchy && hierarchy.Contains(entity)))
+                                                             return;
+
+                                                         XMStoreFloat4x4(&transform.world, transform.ComputeWorldMatrix());
+                                                         transform.isDirty = false;
+                                                     });
+    }
+
+    if (hasHierarchy)
+        UpdateHierarchy();
+}
+
+void TransformSystem::SyncHierarchy()
+{
+    bool isStale = registry.View<HierarchyComponent>().SizeHint() != trackedLinks;
+    for (const auto &node : hierarchy.GetNodes())
+    {
+        if (isStale)
+            break;
+        isStale = !registry.IsAlive(node.entity);
+    }
+
+    if (!isStale)
+        return;
+
+    // links to destroyed parents are dropped, the child becomes a root
+    std::vector<std::pair<EntityID, EntityID>> links;
+    for (auto [entity, link] : registry.View<HierarchyComponent>())
+    {
+        if (link.parent != INVALID_ENTITY && !registry.IsAlive(link.parent))
+            link.parent = INVALID_ENTITY;
+
+        links.emplace_back(entity, link.parent);
+    }
+
+    hierarchy.Build(links);
+    trackedLinks = links.size();
+
+    // Build drops links that form a cycle, keep the components in line with what it decided
+    for (auto [entity, link] : registry.View<HierarchyComponent>())
+        link.parent = hierarchy.GetParent(entity);
+
+    for (const auto &node : hierarchy.GetNodes())
+    {
+        if (auto *transform = registry.GetComponent<TransformComponent>(node.entity))
+            transform->MarkDirty();
+    }
+}
+
+void TransformSystem::UpdateHierarchy()
+{
+    const auto &nodes = hierarchy.GetNodes();
+    nodeTransforms.resize(nodes.size());
+    nodeChanged.assign(nodes.size(), false);
+
+    // parents are always ahead of their children, so by the time a node is reached its parent's world matrix is final
+    // a node without a transform acts as an identity transform for its children
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        const TransformHierarchy::Node &node = nodes[i];
+        TransformComponent *transform = registry.GetComponent<TransformComponent>(node.entity);
+        nodeTransforms[i] = transform;
+
+        bool parentChanged = node.parent != TransformHierarchy::NO_PARENT && nodeChanged[node.parent];
+        if (!transform)
+        {
+            nodeChanged[i] = parentChanged;
+            continue;
+        }
+
+        if (!transform->isDirty && !parentChanged)
+            continue;
+
+        XMMATRIX world = transform->ComputeWorldMatrix();
+
+        // walk past parents without a transform
+        for (std::int32_t parent = node.parent; parent != TransformHierarchy::NO_PARENT; parent = nodes[parent].parent)
+        {
+            if (nodeTransforms[parent])
+            {
+                world = world * nodeTransforms[parent]->GetWorldMatrix();
+                break;
+            }
+        }
+
+        XMStoreFloat4x4(&transform->world, world);
+        transform->isDirty = false;
+        nodeChanged[i] = true;
+        changedEntities.push_back(node.entity);
+    }
+}
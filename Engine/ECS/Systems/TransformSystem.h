@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../System.h"
+#include "../TransformHierarchy.h"
+#include "../../Core/JobSystem.h"
+#include <vector>
+
+class TransformComponent;
+
+// rebuilds the cached world matrix of every dirty TransformComponent
+// static transforms are skipped, so a scene that doesn't move costs a single pass over the dirty flags
+//
+// entities with a parent (see SetParent) are updated in one linear pass over the flattened hierarchy,
+// a dirty parent makes all of its children dirty on the way down
+class TransformSystem : public System
+{
+public:
+    TransformSystem(Registry &registry, JobSystem &jobSystem);
+    ~TransformSystem() = default;
+
+    bool Initialize() override;
+    void Update(float deltaTime) override;
+    ComponentAccess GetComponentAccess() const override;
+
+    // attaches child to parent (INVALID_ENTITY detaches it), returns false if that would create a cycle
+    // changes the registry's structure, so call it from the main thread outside of system updates
+    bool SetParent(EntityID child, EntityID parent);
+    EntityID GetParent(EntityID entity) const { return hierarchy.GetParent(entity); }
+
+    // number of world matrices rebuilt during the last update
+    size_t GetRecomputedCount() const { return changedEntities.size(); }
+
+    // entities whose world matrix changed during the last update
+    const std::vector<EntityID> &GetChangedEntities() const { return changedEntities; }
+
+private:
+    // rebuilds the hierarchy if entities in it were destroyed or hierarchy components were added behind our back
+    void SyncHierarchy();
+    void UpdateHierarchy();
+
+    JobSystem &jobSystem;
+
+    std::vector<EntityID> changedEntities;
+    std::vector<TransformComponent *> dirtyTransforms;
+
+    TransformHierarchy hierarchy;
+    size_t trackedLinks = 0; // hierarchy components the flattened order knows about
+    std::vector<TransformComponent *> nodeTransforms;
+    std::vector<bool> nodeChanged;
+};
@@ -0,0 +1,254 @@
+#include "TransformHierarchy.h"
+#include <algorithm>
+
+bool TransformHierarchy::SetParent(EntityID child, EntityID parent)
+{
+    if (child == INVALID_ENTITY || child == parent)
+        return false;
+
+    if (!Contains(child))
+        AddRoot(child);
+
+    std::int32_t parentIndex = NO_PARENT;
+    if (parent != INVALID_ENTITY)
+    {
+        parentIndex = IndexOf(parent);
+        if (parentIndex < 0)
+            parentIndex = AddRoot(parent);
+    }
+
+    std::int32_t childIndex = IndexOf(child);
+    if (nodes[childIndex].parent == parentIndex)
+        return true;
+
+    // the new parent can't be somewhere below the child
+    for (std::int32_t ancestor = parentIndex; ancestor != NO_PARENT; ancestor = nodes[ancestor].parent)
+    {
+        if (ancestor == childIndex)
+            return false;
+    }
+
+    // the child's block goes to the end of the parent's block (or the end of the array for a new root)
+    // by swapping it with whatever lies in between, which is the only stretch of the array that moves
+    size_t blockBegin = static_cast<size_t>(childIndex);
+    size_t blockEnd = blockBegin + blockSizes[blockBegin];
+    size_t target = parentIndex == NO_PARENT ? nodes.size() : static_cast<size_t>(parentIndex) + blockSizes[parentIndex];
+
+    size_t first, middle, last;
+    if (target <= blockBegin)
+    {
+        first = target;
+        middle = blockBegin;
+        last = blockEnd;
+    }
+    else
+    {
+        first = blockBegin;
+        middle = blockEnd;
+        last = target;
+    }
+
+    // where a node in [first, last) ends up once the two halves are swapped
+    auto moved = [first, middle, last](std::int32_t index) -> std::int32_t
+    {
+        auto i = static_cast<size_t>(index);
+        if (index == NO_PARENT || i < first || i >= last)
+            return index;
+        return static_cast<std::int32_t>(i < middle ? i + (last - middle) : i - (middle - first));
+    };
+
+    // nodes past the range whose parent is inside it: only the ancestors of the range's last node reach past it,
+    // so their later children are found by hopping from block to block instead of scanning the rest of the array
+    overhang.clear();
+    size_t below = last - 1;
+    for (std::int32_t ancestor = static_cast<std::int32_t>(last - 1);
+         ancestor != NO_PARENT && static_cast<size_t>(ancestor) >= first; ancestor = nodes[ancestor].parent)
+    {
+        auto index = static_cast<size_t>(ancestor);
+        size_t next = index == last - 1 ? last : below + blockSizes[below];
+        for (; next < index + blockSizes[index]; next += blockSizes[next])
+            overhang.push_back(static_cast<std::int32_t>(next));
+        below = index;
+    }
+
+    std::uint32_t blockSize = blockSizes[blockBegin];
+    for (std::int32_t ancestor = nodes[childIndex].parent; ancestor != NO_PARENT; ancestor = nodes[ancestor].parent)
+        blockSizes[ancestor] -= blockSize;
+
+    std::int64_t newDepth = parentIndex == NO_PARENT ? 0 : static_cast<std::int64_t>(nodes[parentIndex].depth) + 1;
+    std::int64_t depthChange = newDepth - static_cast<std::int64_t>(nodes[childIndex].depth);
+    for (size_t i = blockBegin; i < blockEnd; ++i)
+        nodes[i].depth = static_cast<std::uint32_t>(static_cast<std::int64_t>(nodes[i].depth) + depthChange);
+
+    // parents before the range don't move, so only links into it need fixing
+    for (size_t i = first; i < last; ++i)
+        nodes[i].parent = moved(nodes[i].parent);
+    for (std::int32_t index : overhang)
+        nodes[index].parent = moved(nodes[index].parent);
+    nodes[childIndex].parent = moved(parentIndex);
+
+    std::rotate(nodes.begin() + first, nodes.begin() + middle, nodes.begin() + last);
+    std::rotate(blockSizes.begin() + first, blockSizes.begin() + middle, blockSizes.begin() + last);
+
+    for (std::int32_t ancestor = moved(parentIndex); ancestor != NO_PARENT; ancestor = nodes[ancestor].parent)
+        blockSizes[ancestor] += blockSize;
+
+    UpdateLookup(first, last);
+    return true;
+}
+
+void TransformHierarchy::Build(const std::vector<std::pair<EntityID, EntityID>> &links)
+{
+    constexpr std::int64_t UNKNOWN = -1;
+    constexpr std::int64_t VISITING = -2;
+
+    Clear();
+
+    std::vector<EntityID> entities;
+    std::vector<EntityID> parentOf;
+    std::vector<std::int64_t> depthOf;
+
+    auto track = [&](EntityID entity)
+    {
+        std::uint32_t slot = GetEntityIndex(entity);
+        if (slot >= depthOf.size())
+        {
+            depthOf.resize(static_cast<size_t>(slot) + 1, UNKNOWN);
+            parentOf.resize(static_cast<size_t>(slot) + 1, INVALID_ENTITY);
+            nodeOf.resize(static_cast<size_t>(slot) + 1, -1);
+        }
+
+        // nodeOf doubles as a 'seen' marker until the nodes are laid out
+        if (nodeOf[slot] < 0)
+        {
+            nodeOf[slot] = 0;
+            entities.push_back(entity);
+        }
+    };
+
+    for (const auto &[child, parent] : links)
+    {
+        if (child == INVALID_ENTITY)
+            continue;
+
+        track(child);
+        if (parent != INVALID_ENTITY && parent != child)
+        {
+            track(parent);
+            parentOf[GetEntityIndex(child)] = parent;
+        }
+    }
+
+    // walk up from every entity until a known depth (or a root) is found, then fill in the path on the way back
+    std::vector<EntityID> path;
+    for (EntityID entity : entities)
+    {
+        path.clear();
+        EntityID current = entity;
+        while (current != INVALID_ENTITY && depthOf[GetEntityIndex(current)] == UNKNOWN)
+        {
+            depthOf[GetEntityIndex(current)] = VISITING;
+            path.push_back(current);
+            current = parentOf[GetEntityIndex(current)];
+        }
+
+        // ran into our own path, cut the link that closes the cycle
+        if (current != INVALID_ENTITY && depthOf[GetEntityIndex(current)] == VISITING)
+            parentOf[GetEntityIndex(path.back())] = INVALID_ENTITY;
+
+        for (size_t i = path.size(); i-- > 0;)
+        {
+            std::uint32_t slot = GetEntityIndex(path[i]);
+            EntityID parent = parentOf[slot];
+            depthOf[slot] = parent == INVALID_ENTITY ? 0 : depthOf[GetEntityIndex(parent)] + 1;
+        }
+    }
+
+    // group the children of every entity (in link order) and lay the nodes out depth first, so every subtree
+    // ends up as one block; nodeOf holds each entity's position in 'entities' until its node is placed
+    std::vector<std::uint32_t> childStart(entities.size() + 1, 0);
+    std::vector<std::uint32_t> children(entities.size());
+    for (size_t i = 0; i < entities.size(); ++i)
+        nodeOf[GetEntityIndex(entities[i])] = static_cast<std::int32_t>(i);
+
+    for (EntityID entity : entities)
+    {
+        EntityID parent = parentOf[GetEntityIndex(entity)];
+        if (parent != INVALID_ENTITY)
+            ++childStart[nodeOf[GetEntityIndex(parent)] + 1];
+    }
+
+    for (size_t i = 0; i < entities.size(); ++i)
+        childStart[i + 1] += childStart[i];
+
+    std::vector<std::uint32_t> nextChild(childStart.begin(), childStart.end() - 1);
+    for (size_t i = 0; i < entities.size(); ++i)
+    {
+        EntityID parent = parentOf[GetEntityIndex(entities[i])];
+        if (parent != INVALID_ENTITY)
+            children[nextChild[nodeOf[GetEntityIndex(parent)]]++] = static_cast<std::uint32_t>(i);
+    }
+
+    nodes.reserve(entities.size());
+    std::vector<std::uint32_t> stack;
+    for (size_t root = 0; root < entities.size(); ++root)
+    {
+        if (parentOf[GetEntityIndex(entities[root])] != INVALID_ENTITY)
+            continue;
+
+        stack.push_back(static_cast<std::uint32_t>(root));
+        while (!stack.empty())
+        {
+            EntityID entity = entities[stack.back()];
+            stack.pop_back();
+
+            // children go on the stack backwards so they come off it in link order
+            std::uint32_t position = static_cast<std::uint32_t>(nodeOf[GetEntityIndex(entity)]);
+            for (std::uint32_t i = childStart[position + 1]; i-- > childStart[position];)
+                stack.push_back(children[i]);
+
+            // the parent was placed already, so its nodeOf is a node index by now
+            std::uint32_t slot = GetEntityIndex(entity);
+            EntityID parent = parentOf[slot];
+            std::int32_t parentIndex = parent == INVALID_ENTITY ? NO_PARENT : nodeOf[GetEntityIndex(parent)];
+            nodeOf[slot] = static_cast<std::int32_t>(nodes.size());
+            nodes.push_back({entity, parentIndex, static_cast<std::uint32_t>(depthOf[slot])});
+        }
+    }
+
+    // children come after their parents, so one backwards pass adds every block into its parent's
+    blockSizes.assign(nodes.size(), 1);
+    for (size_t i = nodes.size(); i-- > 0;)
+    {
+        if (nodes[i].parent != NO_PARENT)
+            blockSizes[nodes[i].parent] += blockSizes[i];
+    }
+}
+
+void TransformHierarchy::Clear()
+{
+    nodes.clear();
+    blockSizes.clear();
+    nodeOf.clear();
+}
+
+std::int32_t TransformHierarchy::AddRoot(EntityID entity)
+{
+    auto index = static_cast<std::int32_t>(nodes.size());
+    nodes.push_back({entity, NO_PARENT, 0});
+    blockSizes.push_back(1);
+    UpdateLookup(nodes.size() - 1, nodes.size());
+    return index;
+}
+
+void TransformHierarchy::UpdateLookup(size_t first, size_t last)
+{
+    for (size_t i = first; i < last; ++i)
+    {
+        std::uint32_t slot = GetEntityIndex(nodes[i].entity);
+        if (slot >= nodeOf.size())
+            nodeOf.resize(static_cast<size_t>(slot) + 1, -1);
+
+        nodeOf[slot] = static_cast<std::int32_t>(i);
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Component.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @class TransformHierarchy
+ * @brief Parent/child links flattened into a single array in depth-first order
+ *
+ * Every parent comes before all of its children, so world matrices can be propagated with one linear pass
+ * over GetNodes(), without recursion. Parents are stored as indices into the same array.
+ *
+ * Each subtree is a contiguous block starting at its root, which is what lets SetParent move one as a whole.
+ *
+ * Only entities that are part of a hierarchy (have a parent or at least had a child attached) are stored here.
+ */
+class TransformHierarchy
+{
+public:
+    static constexpr std::int32_t NO_PARENT = -1;
+
+    struct Node
+    {
+        EntityID entity;
+        std::int32_t parent; // index into the node array, or NO_PARENT
+        std::uint32_t depth;
+    };
+
+    /**
+     * @brief Attaches an entity (and everything below it) to a new parent
+     * @param child The entity to move
+     * @param parent The new parent, or INVALID_ENTITY to make the child a root
+     * @return false if the parent is the child itself or one of its descendants
+     *
+     * Incremental: the child's block is rotated to the end of the new parent's block. The cost is the size of the
+     * blocks passed over, plus a walk up both parent chains, not the size of the whole hierarchy.
+     */
+    bool SetParent(EntityID child, EntityID parent);
+
+    /**
+     * @brief Rebuilds the whole order from a list of (child, parent) links
+     * @note Links that would form a cycle are dropped, the child becomes a root
+     */
+    void Build(const std::vector<std::pair<EntityID, EntityID>> &links);
+
+    void Clear();
+
+    /** @brief Index of an entity in GetNodes(), or -1 if it isn't part of the hierarchy */
+    std::int32_t IndexOf(EntityID entity) const
+    {
+        std::uint32_t slot = GetEntityIndex(entity);
+        if (slot >= nodeOf.size() || nodeOf[slot] < 0 || nodes[nodeOf[slot]].entity != entity)
+            return -1;
+        return nodeOf[slot];
+    }
+
+    bool Contains(EntityID entity) const { return IndexOf(entity) >= 0; }
+
+    /** @brief Parent of an entity, or INVALID_ENTITY */
+    EntityID GetParent(EntityID entity) const
+    {
+        std::int32_t index = IndexOf(entity);
+        if (index < 0 || nodes[index].parent == NO_PARENT)
+            return INVALID_ENTITY;
+        return nodes[nodes[index].parent].entity;
+    }
+
+    const std::vector<Node> &GetNodes() const { return nodes; }
+
+private:
+    // adds an entity as a root at the end of the array
+    std::int32_t AddRoot(EntityID entity);
+
+    // rewrites nodeOf for the nodes in [first, last)
+    void UpdateLookup(size_t first, size_t last);
+
+    std::vector<Node> nodes;
+    std::vector<std::uint32_t> blockSizes; // nodes in the subtree starting at each node, itself included
+    std::vector<std::int32_t> nodeOf;      // entity slot index → node index
+
+    // scratch space reused between reparents
+    std::vector<std::int32_t> overhang;
+};
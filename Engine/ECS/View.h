@@ -0,0 +1,158 @@
+#pragma once
+
+#include "Component.h"
+#include "ComponentPool.h"
+#include "../Core/JobSystem.h"
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <vector>
+
+/**
+ * @class ComponentView
+ * @brief Single-pass iteration over every entity that has all of the given components
+ * @tparam Ts The component types the entity must have
+ *
+ * The view walks the dense entity list of the smallest pool and probes the other pools directly,
+ * so no temporary entity list is allocated. Dereferencing the iterator yields a tuple of the entity
+ * and references to its components, which plays nicely with structured bindings:
+ *
+ * @code
+ * for (auto [entity, transform, mesh] : registry.View<TransformComponent, MeshComponent>())
+ * {
+ *     ...
+ * }
+ * @endcode
+ *
+ * @warning Adding or removing any of the viewed component types while iterating invalidates the view.
+ */
+template <typename... Ts>
+class ComponentView
+{
+public:
+    using Pools = std::tuple<ComponentPool<Ts> *...>;
+
+    class Iterator
+    {
+    public:
+        Iterator(const ComponentView *view, size_t index)
+            : view(view), index(index)
+        {
+            SkipMissing();
+        }
+
+        std::tuple<EntityID, Ts &...> operator*() const
+        {
+            EntityID entity = (*view->lead)[index];
+            return std::tuple<EntityID, Ts &...>(entity, std::get<ComponentPool<Ts> *>(view->pools)->At(entity)...);
+        }
+
+        Iterator &operator++()
+        {
+            ++index;
+            SkipMissing();
+            return *this;
+        }
+
+        bool operator==(const Iterator &other) const { return index == other.index; }
+        bool operator!=(const Iterator &other) const { return index != other.index; }
+
+    private:
+        // the lead pool has every entity we care about, but not every entity in it has the other components
+        void SkipMissing()
+        {
+            while (index < view->leadSize && !view->HasAll((*view->lead)[index]))
+                ++index;
+        }
+
+        const ComponentView *view;
+        size_t index;
+    };
+
+    explicit ComponentView(ComponentPool<Ts> *...componentPools)
+        : pools(componentPools...)
+    {
+        // if any pool doesn't exist yet, no entity can match and the view stays empty
+        if (!(componentPools && ...))
+            return;
+
+        const SparseSet *candidates[] = {componentPools...};
+        const SparseSet *smallest = candidates[0];
+        for (const SparseSet *pool : candidates)
+        {
+            if (pool->Size() < smallest->Size())
+                smallest = pool;
+        }
+
+        lead = &smallest->GetEntities();
+        leadSize = lead->size();
+    }
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, leadSize); }
+
+    /**
+     * @brief Calls a function for every matching entity
+     * @param func Callable taking (EntityID, Ts &...)
+     */
+    template <typename Func>
+    void Each(Func &&func) const
+    {
+        EachInRange(0, leadSize, func);
+    }
+
+    /**
+     * @brief Calls a function for every matching entity, spread over the job system's threads
+     * @param jobSystem The job system to run on, the calling thread helps and returns when everything is done
+     * @param func Callable taking (EntityID, Ts &...), called concurrently so it must only touch its own entity
+     *
+     * The lead pool's dense range is split into slices that are a multiple of 64 entities. The component arrays
+     * themselves aren't cache line aligned, so two neighbouring slices can still share the one line at their boundary.
+     */
+    template <typename Func>
+    void ParallelEach(JobSystem &jobSystem, Func &&func) const
+    {
+        constexpr size_t SLICE_GRANULARITY = 64;
+        constexpr size_t MIN_SLICE_SIZE = 256;
+
+        // a few slices per thread so stealing can even out uneven work
+        size_t sliceCount = static_cast<size_t>(jobSystem.GetThreadCount()) * 4;
+        size_t sliceSize = std::max(MIN_SLICE_SIZE, (leadSize + sliceCount - 1) / std::max<size_t>(1, sliceCount));
+        sliceSize = (sliceSize + SLICE_GRANULARITY - 1) / SLICE_GRANULARITY * SLICE_GRANULARITY;
+
+        if (leadSize <= sliceSize)
+        {
+            EachInRange(0, leadSize, func);
+            return;
+        }
+
+        jobSystem.ParallelFor(leadSize, sliceSize, [this, &func](size_t begin, size_t end)
+                              { EachInRange(begin, end, func); });
+    }
+
+    /**
+     * @brief Upper bound on the number of matching entities (the size of the smallest pool)
+     */
+    size_t SizeHint() const { return leadSize; }
+
+private:
+    template <typename Func>
+    void EachInRange(size_t begin, size_t end, Func &func) const
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            EntityID entity = (*lead)[i];
+            if (HasAll(entity))
+                func(entity, std::get<ComponentPool<Ts> *>(pools)->At(entity)...);
+        }
+    }
+
+    bool HasAll(EntityID entity) const
+    {
+        return (std::get<ComponentPool<Ts> *>(pools)->Contains(entity) && ...);
+    }
+
+    Pools pools;
+    const std::vector<EntityID> *lead = nullptr;
+    size_t leadSize = 0;
+};
@@ -1,40 +1,87 @@
 #pragma once
 
 #include <DirectXMath.h>
+#include <cstdint>
 
-// some small number for now
-#define MAX_LIGHTS 8
+// a draw's own short light list, the most important lights for its bounds (see LightSelector)
+// it travels with the world matrix, the shader falls back to the clustered lights when isEnabled is 0
+struct ObjectLightData
+{
+    std::uint32_t pointCount;
+    std::uint32_t spotCount;
+    std::uint32_t isEnabled;
+    std::uint32_t padding;
+    std::uint32_t slots[8]; // point light slots, then spot light slots
+};
 
 struct MatrixBuffer
 {
     DirectX::XMMATRIX world;
     DirectX::XMMATRIX wvp;
+    ObjectLightData lights; // still fits the 256 byte block every draw gets in the constant ring
 };
 
-// this is the buffer that will be used to pass the light data to the pixel shader
-// so we can just change the name of this buffer to LightData instead
-struct LightData
+// the light lists (structured buffers), one per type so each only carries what its type uses
+// entries sit at the slot the LightingManager gave the light, colors are rgb, ambient isn't used by the shader
+struct DirectionalLightData
 {
-    DirectX::XMFLOAT4 ambientColor;
-    DirectX::XMFLOAT4 diffuseColor;
-    DirectX::XMFLOAT3 lightDirection;
-    float padding1;
+    DirectX::XMFLOAT3 toLight; // normalized, opposite of the light's direction
+    float intensity;
+    DirectX::XMFLOAT3 color;
+    float padding;
+};
 
-    DirectX::XMFLOAT3 lightPosition;
-    float lightRange;
+struct PointLightData
+{
+    DirectX::XMFLOAT3 position;
+    float range;
+    DirectX::XMFLOAT3 color;
+    float intensity;
+};
 
-    float spotInnerCone;
-    float spotOuterCone;
+struct SpotLightData
+{
+    DirectX::XMFLOAT3 position;
+    float range;
+    DirectX::XMFLOAT3 color;
+    float intensity;
+    DirectX::XMFLOAT3 direction; // normalized
+    float cosOuterCone;
+    float cosInnerCone;
+    DirectX::XMFLOAT3 padding; // keeps the stride a multiple of 16
+};
 
-    int lightType;
-    float lightIntensity;
+// a cluster's lights in the cluster index list, its point lights first and then its spot lights
+struct ClusterLightRange
+{
+    std::uint32_t offset; // counted from after the directional lights
+    std::uint32_t pointCount;
+    std::uint32_t spotCount;
 };
 
+// how the pixel shader finds its cluster, the lights themselves are in structured buffers
 struct LightBuffer
 {
-    LightData lights[MAX_LIGHTS];
-    int activeLightCount;
-    DirectX::XMFLOAT3 padding;
+    DirectX::XMFLOAT4 viewDepthPlane; // dot(float4(worldPos, 1), plane) is the view space depth
+    DirectX::XMFLOAT2 tileScale;      // pixel position to cluster x / y
+    float depthScale;                 // slice = log(depth) * depthScale + depthBias
+    float depthBias;
+
+    std::uint32_t directionalLightCount; // lit everywhere, their slots lead the cluster index list
+    std::uint32_t clusterCountX;
+    std::uint32_t clusterCountY;
+    std::uint32_t clusterCountZ;
+};
+
+// cascaded shadows of one directional light (see ShadowCascades), cascade c covers view depths up to cascadeSplits[c]
+struct ShadowBuffer
+{
+    DirectX::XMMATRIX cascadeViewProjection[4]; // world to the cascade's shadow map, transposed
+    DirectX::XMFLOAT4 cascadeSplits;            // far view depth of each cascade
+    DirectX::XMFLOAT4 cascadeTexelSizes;        // world size of a shadow map texel, for the normal offset
+
+    std::uint32_t shadowLightSlot; // directional light slot that gets the shadows, ~0 for none
+    float padding[3];
 };
 
 struct CameraBuffer
@@ -0,0 +1,127 @@
+#include "CommandStream.h"
+#include <cassert>
+
+namespace
+{
+    struct OpcodeInfo
+    {
+        const char *name;
+        size_t operandCount;
+    };
+
+    // same order as CommandStream::Opcode
+    constexpr OpcodeInfo OPCODES[] = {
+        {"SetRenderTargets", 2},
+        {"SetViewport", 2},
+        {"SetRasterizerState", 1},
+        {"SetDepthStencilState", 2},
+        {"SetPrimitiveTopology", 1},
+        {"SetInputLayout", 1},
+        {"SetVertexShader", 1},
+        {"SetPixelShader", 1},
+        {"SetVertexBuffer", 4},
+        {"SetIndexBuffer", 3},
+        {"SetVertexConstantBuffer", 4},
+        {"SetPixelConstantBuffer", 4},
+        {"SetTexture", 2},
+        {"SetSampler", 2},
+        {"DrawIndexed", 3},
+        {"DrawIndexedInstanced", 5},
+        {"WriteBuffer", 4},
+        {"Clear", 1},
+        {"Present", 1},
+    };
+
+    static_assert(sizeof(OPCODES) / sizeof(OPCODES[0]) == static_cast<size_t>(CommandStream::Opcode::Count),
+                  "every opcode needs an entry");
+}
+
+size_t CommandStream::GetOperandCount(Opcode opcode)
+{
+    return OPCODES[static_cast<size_t>(opcode)].operandCount;
+}
+
+const char *CommandStream::GetName(Opcode opcode)
+{
+    return OPCODES[static_cast<size_t>(opcode)].name;
+}
+
+void CommandStream::Write(Opcode opcode, std::initializer_list<std::uint32_t> operands)
+{
+    assert(operands.size() == GetOperandCount(opcode));
+
+    bytes.push_back(static_cast<std::uint8_t>(opcode));
+
+    // LEB128, 7 bits per byte, the top bit says another byte follows
+    for (std::uint32_t value : operands)
+    {
+        while (value >= 0x80)
+        {
+            bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<std::uint8_t>(value));
+    }
+}
+
+bool CommandStream::Decode(const std::vector<std::uint8_t> &bytes, std::vector<Command> &commands)
+{
+    commands.clear();
+
+    size_t position = 0;
+    while (position < bytes.size())
+    {
+        if (bytes[position] >= static_cast<std::uint8_t>(Opcode::Count))
+            return false;
+
+        Command command = {};
+        command.opcode = static_cast<Opcode>(bytes[position++]);
+
+        size_t operandCount = GetOperandCount(command.opcode);
+        for (size_t i = 0; i < operandCount; ++i)
+        {
+            std::uint32_t value = 0;
+            for (std::uint32_t shift = 0;; shift += 7)
+            {
+                // a uint32 never needs more than 5 bytes
+                if (position >= bytes.size() || shift > 28)
+                    return false;
+
+                std::uint8_t byte = bytes[position++];
+                value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                    break;
+            }
+            command.operands[i] = value;
+        }
+
+        commands.push_back(command);
+    }
+
+    return true;
+}
+
+std::string CommandStream::Disassemble(const std::vector<std::uint8_t> &bytes)
+{
+    std::vector<Command> commands;
+    bool isValid = Decode(bytes, commands);
+
+    std::string text;
+    for (const Command &command : commands)
+    {
+        text += GetName(command.opcode);
+
+        size_t operandCount = GetOperandCount(command.opcode);
+        for (size_t i = 0; i < operandCount; ++i)
+        {
+            text += ' ';
+            text += std::to_string(command.operands[i]);
+        }
+        text += '\n';
+    }
+
+    if (!isValid)
+        text += "<malformed>\n";
+
+    return text;
+}
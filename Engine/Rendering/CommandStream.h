@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+/**
+ * @class CommandStream
+ * @brief Compact binary log of render commands, written by the null backend
+ *
+ * Every command is one opcode byte followed by a fixed number of operands (see GetOperandCount), each stored as an
+ * LEB128 varint, so the small values most commands carry (slots, counts, resource IDs) take a byte or two.
+ * Resources are referred to by the IDs the device gave them, which don't change from run to run, so the streams
+ * of two runs can be compared byte for byte, or disassembled and diffed as text.
+ */
+class CommandStream
+{
+public:
+    enum class Opcode : std::uint8_t
+    {
+        SetRenderTargets,        // renderTarget, depthStencil
+        SetViewport,             // width, height
+        SetRasterizerState,      // state
+        SetDepthStencilState,    // state, stencilRef
+        SetPrimitiveTopology,    // topology
+        SetInputLayout,          // layout
+        SetVertexShader,         // shader
+        SetPixelShader,          // shader
+        SetVertexBuffer,         // slot, buffer, stride, offset
+        SetIndexBuffer,          // buffer, format, offset
+        SetVertexConstantBuffer, // slot, buffer, firstConstant, constantCount
+        SetPixelConstantBuffer,  // slot, buffer, firstConstant, constantCount
+        SetTexture,              // slot, texture
+        SetSampler,              // slot, sampler
+        DrawIndexed,             // indexCount, startIndex, baseVertex
+        DrawIndexedInstanced,    // indexCount, instanceCount, startInstance, startIndex, baseVertex
+        WriteBuffer,             // buffer, offset, size, mode
+        Clear,                   // color as RGBA8
+        Present,                 // frame number
+        Count
+    };
+
+    static constexpr size_t MAX_OPERANDS = 5;
+
+    struct Command
+    {
+        Opcode opcode;
+        std::uint32_t operands[MAX_OPERANDS];
+    };
+
+    static size_t GetOperandCount(Opcode opcode);
+    static const char *GetName(Opcode opcode);
+
+    /** @brief Appends a command, the operand list has to match GetOperandCount */
+    void Write(Opcode opcode, std::initializer_list<std::uint32_t> operands);
+
+    void Append(const CommandStream &other) { bytes.insert(bytes.end(), other.bytes.begin(), other.bytes.end()); }
+    void Swap(CommandStream &other) { bytes.swap(other.bytes); }
+    void Clear() { bytes.clear(); }
+
+    const std::vector<std::uint8_t> &GetBytes() const { return bytes; }
+    size_t GetSize() const { return bytes.size(); }
+
+    /** @return false if the bytes aren't a valid stream, commands holds everything decoded up to that point */
+    static bool Decode(const std::vector<std::uint8_t> &bytes, std::vector<Command> &commands);
+
+    /** @brief One command per line ("DrawIndexed 36 0 0"), for diffs and logs */
+    static std::string Disassemble(const std::vector<std::uint8_t> &bytes);
+
+private:
+    std::vector<std::uint8_t> bytes;
+};
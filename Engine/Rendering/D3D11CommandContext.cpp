@@ -0,0 +1,183 @@
+#include "D3D11CommandContext.h"
+
+D3D11CommandContext::D3D11CommandContext(ID3D11DeviceContext *immediateContext, RenderStateCache &stateCache)
+    : context(immediateContext), immediateContext(immediateContext), isDeferred(false), stateCache(stateCache)
+{
+    context.As(&context1);
+}
+
+D3D11CommandContext::D3D11CommandContext(Microsoft::WRL::ComPtr<ID3D11DeviceContext> deferredContext, ID3D11DeviceContext *immediateContext)
+    : context(std::move(deferredContext)), immediateContext(immediateContext), isDeferred(true), stateCache(ownStateCache)
+{
+    context.As(&context1);
+}
+
+std::unique_ptr<D3D11CommandContext> D3D11CommandContext::CreateDeferred(ID3D11Device *device, ID3D11DeviceContext *immediateContext)
+{
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext> deferredContext;
+    if (FAILED(device->CreateDeferredContext(0, deferredContext.GetAddressOf())))
+    {
+        OutputDebugString(L"[D3D11CommandContext] Failed to create deferred context\n");
+        return nullptr;
+    }
+
+    return std::unique_ptr<D3D11CommandContext>(new D3D11CommandContext(std::move(deferredContext), immediateContext));
+}
+
+void D3D11CommandContext::Begin()
+{
+    // a deferred context starts from the default state after every FinishCommandList
+    if (isDeferred)
+    {
+        stateCache.Invalidate();
+        commandList.Reset();
+    }
+}
+
+bool D3D11CommandContext::Finish()
+{
+    if (!isDeferred)
+        return true;
+
+    return SUCCEEDED(context->FinishCommandList(FALSE, commandList.ReleaseAndGetAddressOf()));
+}
+
+void D3D11CommandContext::Execute()
+{
+    if (!isDeferred || !commandList)
+        return;
+
+    // TRUE puts the immediate context back the way it was, the pipeline's state cache relies on that
+    immediateContext->ExecuteCommandList(commandList.Get(), TRUE);
+    commandList.Reset();
+}
+
+void D3D11CommandContext::SetRenderTargets(const void *renderTarget, const void *depthStencil)
+{
+    if (!stateCache.SetRenderTargets(renderTarget, depthStencil))
+        return;
+
+    ID3D11RenderTargetView *renderTargetView = As<ID3D11RenderTargetView>(renderTarget);
+    context->OMSetRenderTargets(renderTargetView ? 1 : 0, &renderTargetView, As<ID3D11DepthStencilView>(depthStencil));
+}
+
+void D3D11CommandContext::SetViewport(std::uint32_t width, std::uint32_t height)
+{
+    if (!stateCache.SetViewport(width, height))
+        return;
+
+    D3D11_VIEWPORT viewport = {};
+    viewport.Width = static_cast<float>(width);
+    viewport.Height = static_cast<float>(height);
+    viewport.MinDepth = 0.0f;
+    viewport.MaxDepth = 1.0f;
+    context->RSSetViewports(1, &viewport);
+}
+
+void D3D11CommandContext::SetRasterizerState(const void *state)
+{
+    if (stateCache.SetRasterizerState(state))
+        context->RSSetState(As<ID3D11RasterizerState>(state));
+}
+
+void D3D11CommandContext::SetDepthStencilState(const void *state, std::uint32_t stencilRef)
+{
+    if (stateCache.SetDepthStencilState(state, stencilRef))
+        context->OMSetDepthStencilState(As<ID3D11DepthStencilState>(state), stencilRef);
+}
+
+void D3D11CommandContext::SetPrimitiveTopology(std::uint32_t topology)
+{
+    if (stateCache.SetPrimitiveTopology(topology))
+        context->IASetPrimitiveTopology(static_cast<D3D11_PRIMITIVE_TOPOLOGY>(topology));
+}
+
+void D3D11CommandContext::SetInputLayout(const void *layout)
+{
+    if (stateCache.SetInputLayout(layout))
+        context->IASetInputLayout(As<ID3D11InputLayout>(layout));
+}
+
+void D3D11CommandContext::SetVertexShader(const void *shader)
+{
+    if (stateCache.SetVertexShader(shader))
+        context->VSSetShader(As<ID3D11VertexShader>(shader), nullptr, 0);
+}
+
+void D3D11CommandContext::SetPixelShader(const void *shader)
+{
+    if (stateCache.SetPixelShader(shader))
+        context->PSSetShader(As<ID3D11PixelShader>(shader), nullptr, 0);
+}
+
+void D3D11CommandContext::SetVertexBuffer(std::uint32_t slot, const void *buffer, std::uint32_t stride, std::uint32_t offset)
+{
+    if (!stateCache.SetVertexBuffer(slot, buffer, stride, offset))
+        return;
+
+    ID3D11Buffer *vertexBuffer = As<ID3D11Buffer>(buffer);
+    UINT vertexStride = stride;
+    UINT vertexOffset = offset;
+    context->IASetVertexBuffers(slot, 1, &vertexBuffer, &vertexStride, &vertexOffset);
+}
+
+void D3D11CommandContext::SetIndexBuffer(const void *buffer, std::uint32_t format, std::uint32_t offset)
+{
+    if (stateCache.SetIndexBuffer(buffer, format, offset))
+        context->IASetIndexBuffer(As<ID3D11Buffer>(buffer), static_cast<DXGI_FORMAT>(format), offset);
+}
+
+void D3D11CommandContext::SetConstantBuffer(Stage stage, std::uint32_t slot, const void *buffer,
+                                            std::uint32_t firstConstant, std::uint32_t constantCount)
+{
+    if (!stateCache.SetConstantBuffer(stage, slot, buffer, firstConstant, constantCount))
+        return;
+
+    ID3D11Buffer *constantBuffer = As<ID3D11Buffer>(buffer);
+    UINT first = firstConstant;
+    UINT count = constantCount;
+
+    // ranges need 11.1, a whole buffer works everywhere
+    if (constantCount != 0 && context1)
+    {
+        if (stage == Stage::Vertex)
+            context1->VSSetConstantBuffers1(slot, 1, &constantBuffer, &first, &count);
+        else
+            context1->PSSetConstantBuffers1(slot, 1, &constantBuffer, &first, &count);
+        return;
+    }
+
+    if (stage == Stage::Vertex)
+        context->VSSetConstantBuffers(slot, 1, &constantBuffer);
+    else
+        context->PSSetConstantBuffers(slot, 1, &constantBuffer);
+}
+
+void D3D11CommandContext::SetTexture(std::uint32_t slot, const void *texture)
+{
+    if (!stateCache.SetTexture(slot, texture))
+        return;
+
+    ID3D11ShaderResourceView *view = As<ID3D11ShaderResourceView>(texture);
+    context->PSSetShaderResources(slot, 1, &view);
+}
+
+void D3D11CommandContext::SetSampler(std::uint32_t slot, const void *sampler)
+{
+    if (!stateCache.SetSampler(slot, sampler))
+        return;
+
+    ID3D11SamplerState *samplerState = As<ID3D11SamplerState>(sampler);
+    context->PSSetSamplers(slot, 1, &samplerState);
+}
+
+void D3D11CommandContext::DrawIndexed(std::uint32_t indexCount, std::uint32_t startIndex, std::int32_t baseVertex)
+{
+    context->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+void D3D11CommandContext::DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount, std::uint32_t startInstance,
+                                               std::uint32_t startIndex, std::int32_t baseVertex)
+{
+    context->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ICommandContext.h"
+#include "RenderStateCache.h"
+#include <d3d11.h>
+#include <d3d11_1.h>
+#include <wrl/client.h>
+#include <memory>
+
+/**
+ * @class D3D11CommandContext
+ * @brief ICommandContext on top of a D3D11 device context, binds go through a RenderStateCache
+ *
+ * Two flavours:
+ *  - immediate: draws go straight to the immediate context and share the pipeline's state cache,
+ *    Begin / Finish / Execute do nothing
+ *  - deferred: draws are recorded on a deferred context into an ID3D11CommandList, which Execute runs on the
+ *    immediate context (restoring the immediate context's state afterwards, so its cache stays valid)
+ */
+class D3D11CommandContext : public ICommandContext
+{
+public:
+    /** @brief Immediate flavour, the cache has to be the one every other bind on that context goes through */
+    D3D11CommandContext(ID3D11DeviceContext *immediateContext, RenderStateCache &stateCache);
+
+    /** @return nullptr if the device can't create deferred contexts */
+    static std::unique_ptr<D3D11CommandContext> CreateDeferred(ID3D11Device *device, ID3D11DeviceContext *immediateContext);
+
+    void Begin() override;
+    bool Finish() override;
+    void Execute() override;
+
+    void SetRenderTargets(const void *renderTarget, const void *depthStencil) override;
+    void SetViewport(std::uint32_t width, std::uint32_t height) override;
+    void SetRasterizerState(const void *state) override;
+    void SetDepthStencilState(const void *state, std::uint32_t stencilRef) override;
+    void SetPrimitiveTopology(std::uint32_t topology) override;
+    void SetInputLayout(const void *layout) override;
+    void SetVertexShader(const void *shader) override;
+    void SetPixelShader(const void *shader) override;
+
+    void SetVertexBuffer(std::uint32_t slot, const void *buffer, std::uint32_t stride, std::uint32_t offset) override;
+    void SetIndexBuffer(const void *buffer, std::uint32_t format, std::uint32_t offset) override;
+    void SetConstantBuffer(Stage stage, std::uint32_t slot, const void *buffer,
+                           std::uint32_t firstConstant = 0, std::uint32_t constantCount = 0) override;
+    void SetTexture(std::uint32_t slot, const void *texture) override;
+    void SetSampler(std::uint32_t slot, const void *sampler) override;
+
+    void DrawIndexed(std::uint32_t indexCount, std::uint32_t startIndex = 0, std::int32_t baseVertex = 0) override;
+    void DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount, std::uint32_t startInstance = 0,
+                              std::uint32_t startIndex = 0, std::int32_t baseVertex = 0) override;
+
+private:
+    D3D11CommandContext(Microsoft::WRL::ComPtr<ID3D11DeviceContext> deferredContext, ID3D11DeviceContext *immediateContext);
+
+    // resources come in as opaque pointers, the D3D calls want them back as what they are
+    template <typename T>
+    static T *As(const void *resource) { return static_cast<T *>(const_cast<void *>(resource)); }
+
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext1> context1; // for constant buffer ranges, null before D3D 11.1
+    ID3D11DeviceContext *immediateContext;
+    bool isDeferred;
+
+    RenderStateCache ownStateCache; // only used by the deferred flavour
+    RenderStateCache &stateCache;
+
+    Microsoft::WRL::ComPtr<ID3D11CommandList> commandList;
+};
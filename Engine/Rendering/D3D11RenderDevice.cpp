@@ -0,0 +1,212 @@
+#include "D3D11RenderDevice.h"
+#include <d3d11_1.h>
+#include <cstring>
+#include <vector>
+
+// IRenderDevice spells these out so its users don't need the D3D headers
+static_assert(FORMAT_R32G32B32A32_FLOAT == DXGI_FORMAT_R32G32B32A32_FLOAT, "format values have to match DXGI");
+static_assert(FORMAT_R32G32B32A32_UINT == DXGI_FORMAT_R32G32B32A32_UINT, "format values have to match DXGI");
+static_assert(FORMAT_R32G32B32_FLOAT == DXGI_FORMAT_R32G32B32_FLOAT, "format values have to match DXGI");
+static_assert(FORMAT_R32G32_FLOAT == DXGI_FORMAT_R32G32_FLOAT, "format values have to match DXGI");
+static_assert(FORMAT_R32_UINT == DXGI_FORMAT_R32_UINT, "format values have to match DXGI");
+static_assert(PRIMITIVE_TOPOLOGY_TRIANGLELIST == D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST, "topology values have to match D3D11");
+
+D3D11RenderDevice::D3D11RenderDevice(std::shared_ptr<GraphicsDeviceManager> graphicsDevice,
+                                     std::shared_ptr<ResourceManager> resourceManager)
+    : graphicsDevice(graphicsDevice), resourceManager(resourceManager),
+      immediateContext(graphicsDevice->GetContext(), stateCache)
+{
+}
+
+bool D3D11RenderDevice::Initialize()
+{
+    for (auto &query : fenceQueries)
+    {
+        query = resourceManager->CreateEventQuery();
+        if (!query)
+            return false;
+    }
+
+    // binding part of a constant buffer and mapping one with NO_OVERWRITE both need D3D 11.1
+    D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+    graphicsDevice->GetDevice()->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext1> context1;
+    hasConstantBufferRanges = options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer &&
+                              SUCCEEDED(graphicsDevice->GetContext()->QueryInterface(IID_PPV_ARGS(context1.GetAddressOf())));
+    return true;
+}
+
+const void *D3D11RenderDevice::Keep(Microsoft::WRL::ComPtr<IUnknown> resource, const void *handle)
+{
+    if (!resource)
+        return nullptr;
+
+    resources[handle] = std::move(resource);
+    return handle;
+}
+
+const void *D3D11RenderDevice::CreateBuffer(const BufferDesc &desc)
+{
+    Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+    switch (desc.usage)
+    {
+    case BufferUsage::Vertex:
+        buffer = resourceManager->CreateVertexBuffer(desc.initialData, desc.byteWidth);
+        break;
+    case BufferUsage::Index:
+        buffer = resourceManager->CreateIndexBuffer(desc.initialData, desc.byteWidth);
+        break;
+    case BufferUsage::Constant:
+        buffer = resourceManager->CreateConstantBuffer(desc.byteWidth, desc.initialData);
+        break;
+    case BufferUsage::DynamicVertex:
+        buffer = resourceManager->CreateDynamicVertexBuffer(desc.byteWidth);
+        break;
+    case BufferUsage::DynamicConstant:
+        buffer = resourceManager->CreateDynamicConstantBuffer(desc.byteWidth);
+        break;
+    }
+
+    if (!buffer)
+        return nullptr;
+
+    ID3D11Buffer *handle = buffer.Get();
+    if (!Keep(buffer, handle))
+        return nullptr;
+
+    // dynamic buffers can't take initial data at creation, so it goes in with the first write
+    bool isDynamic = desc.usage == BufferUsage::DynamicVertex || desc.usage == BufferUsage::DynamicConstant;
+    if (isDynamic && desc.initialData && !WriteBuffer(handle, 0, desc.initialData, desc.byteWidth, WriteMode::Discard))
+    {
+        ReleaseResource(handle);
+        return nullptr;
+    }
+
+    return handle;
+}
+
+const void *D3D11RenderDevice::CreateTexture(const TextureDesc &desc)
+{
+    auto view = resourceManager->CreateTexture(desc.width, desc.height, static_cast<DXGI_FORMAT>(desc.format),
+                                               desc.initialData, desc.rowPitch);
+    return Keep(view, view.Get());
+}
+
+const void *D3D11RenderDevice::CreateSamplerState()
+{
+    auto samplerState = resourceManager->CreateSamplerState();
+    return Keep(samplerState, samplerState.Get());
+}
+
+const void *D3D11RenderDevice::CreateRasterizerState(bool wireframe)
+{
+    auto rasterizerState = resourceManager->CreateRasterizerState(wireframe);
+    return Keep(rasterizerState, rasterizerState.Get());
+}
+
+const void *D3D11RenderDevice::CreateDepthStencilState()
+{
+    auto depthStencilState = resourceManager->CreateDepthStencilState();
+    return Keep(depthStencilState, depthStencilState.Get());
+}
+
+const void *D3D11RenderDevice::CreateVertexShader(const void *bytecode, size_t bytecodeLength)
+{
+    Microsoft::WRL::ComPtr<ID3D11VertexShader> shader;
+    if (FAILED(graphicsDevice->GetDevice()->CreateVertexShader(bytecode, bytecodeLength, nullptr, shader.GetAddressOf())))
+    {
+        OutputDebugString(L"[D3D11RenderDevice] Failed to create vertex shader\n");
+        return nullptr;
+    }
+
+    return Keep(shader, shader.Get());
+}
+
+const void *D3D11RenderDevice::CreatePixelShader(const void *bytecode, size_t bytecodeLength)
+{
+    Microsoft::WRL::ComPtr<ID3D11PixelShader> shader;
+    if (FAILED(graphicsDevice->GetDevice()->CreatePixelShader(bytecode, bytecodeLength, nullptr, shader.GetAddressOf())))
+    {
+        OutputDebugString(L"[D3D11RenderDevice] Failed to create pixel shader\n");
+        return nullptr;
+    }
+
+    return Keep(shader, shader.Get());
+}
+
+const void *D3D11RenderDevice::CreateInputLayout(const VertexElement *elements, std::uint32_t elementCount,
+                                                 const void *shaderBytecode, size_t bytecodeLength)
+{
+    std::vector<D3D11_INPUT_ELEMENT_DESC> layoutDesc(elementCount);
+    for (std::uint32_t i = 0; i < elementCount; ++i)
+    {
+        layoutDesc[i].SemanticName = elements[i].semanticName;
+        layoutDesc[i].SemanticIndex = elements[i].semanticIndex;
+        layoutDesc[i].Format = static_cast<DXGI_FORMAT>(elements[i].format);
+        layoutDesc[i].InputSlot = elements[i].slot;
+        layoutDesc[i].AlignedByteOffset = elements[i].offset;
+        layoutDesc[i].InputSlotClass = elements[i].isPerInstance ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA;
+        layoutDesc[i].InstanceDataStepRate = elements[i].isPerInstance ? 1 : 0;
+    }
+
+    Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout;
+    if (FAILED(graphicsDevice->GetDevice()->CreateInputLayout(layoutDesc.data(), elementCount, shaderBytecode,
+                                                              bytecodeLength, inputLayout.GetAddressOf())))
+    {
+        OutputDebugString(L"[D3D11RenderDevice] Failed to create input layout\n");
+        return nullptr;
+    }
+
+    return Keep(inputLayout, inputLayout.Get());
+}
+
+void D3D11RenderDevice::ReleaseResource(const void *resource)
+{
+    resources.erase(resource);
+}
+
+bool D3D11RenderDevice::WriteBuffer(const void *buffer, std::uint32_t offset, const void *data, std::uint32_t size, WriteMode mode)
+{
+    if (!buffer)
+        return false;
+
+    ID3D11Buffer *d3dBuffer = static_cast<ID3D11Buffer *>(const_cast<void *>(buffer));
+    auto d3dContext = graphicsDevice->GetContext();
+
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    D3D11_MAP mapType = mode == WriteMode::Discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+    if (FAILED(d3dContext->Map(d3dBuffer, 0, mapType, 0, &mapped)))
+        return false;
+
+    std::memcpy(static_cast<std::uint8_t *>(mapped.pData) + offset, data, size);
+    d3dContext->Unmap(d3dBuffer, 0);
+    return true;
+}
+
+std::unique_ptr<ICommandContext> D3D11RenderDevice::CreateDeferredContext()
+{
+    return D3D11CommandContext::CreateDeferred(graphicsDevice->GetDevice(), graphicsDevice->GetContext());
+}
+
+void D3D11RenderDevice::SignalFence(std::uint64_t fence)
+{
+    graphicsDevice->GetContext()->End(fenceQueries[fence % MAX_FENCES_IN_FLIGHT].Get());
+}
+
+bool D3D11RenderDevice::IsFenceComplete(std::uint64_t fence, bool flush)
+{
+    // S_FALSE means the GPU isn't there yet, anything else (done or a lost device) counts as complete
+    ID3D11Query *query = fenceQueries[fence % MAX_FENCES_IN_FLIGHT].Get();
+    return graphicsDevice->GetContext()->GetData(query, nullptr, 0, flush ? 0 : D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_FALSE;
+}
+
+void D3D11RenderDevice::Clear(const float color[4])
+{
+    graphicsDevice->ClearBuffers(color);
+}
+
+void D3D11RenderDevice::Present()
+{
+    graphicsDevice->Present();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "IRenderDevice.h"
+#include "D3D11CommandContext.h"
+#include "RenderStateCache.h"
+#include "GraphicsDeviceManager.h"
+#include "../Resources/ResourceManager.h"
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <array>
+#include <memory>
+#include <unordered_map>
+
+/**
+ * @class D3D11RenderDevice
+ * @brief IRenderDevice on top of GraphicsDeviceManager (device, swap chain) and ResourceManager (resource creation)
+ *
+ * Handles are the D3D11 objects themselves (buffers, shader resource views, states, shaders, layouts), so code that
+ * still talks to D3D11 directly can hand its own objects to the contexts. Everything created through the device is
+ * kept alive here until ReleaseResource. The immediate context's state cache lives here as well, every bind on the
+ * immediate context has to go through it.
+ */
+class D3D11RenderDevice : public IRenderDevice
+{
+public:
+    D3D11RenderDevice(std::shared_ptr<GraphicsDeviceManager> graphicsDevice, std::shared_ptr<ResourceManager> resourceManager);
+
+    // checks for constant buffer ranges (D3D 11.1) and creates the fence queries
+    bool Initialize();
+
+    RenderBackend GetBackend() const override { return RenderBackend::D3D11; }
+    bool SupportsConstantBufferRanges() const override { return hasConstantBufferRanges; }
+
+    const void *CreateBuffer(const BufferDesc &desc) override;
+    const void *CreateTexture(const TextureDesc &desc) override;
+    const void *CreateSamplerState() override;
+    const void *CreateRasterizerState(bool wireframe) override;
+    const void *CreateDepthStencilState() override;
+    const void *CreateVertexShader(const void *bytecode, size_t bytecodeLength) override;
+    const void *CreatePixelShader(const void *bytecode, size_t bytecodeLength) override;
+    const void *CreateInputLayout(const VertexElement *elements, std::uint32_t elementCount,
+                                  const void *shaderBytecode, size_t bytecodeLength) override;
+    void ReleaseResource(const void *resource) override;
+
+    bool WriteBuffer(const void *buffer, std::uint32_t offset, const void *data, std::uint32_t size, WriteMode mode) override;
+
+    const void *GetBackBufferTarget() const override { return graphicsDevice->GetRenderTargetView(); }
+    const void *GetDepthStencilTarget() const override { return graphicsDevice->GetDepthStencilView(); }
+    std::uint32_t GetWidth() const override { return graphicsDevice->GetWidth(); }
+    std::uint32_t GetHeight() const override { return graphicsDevice->GetHeight(); }
+
+    ICommandContext &GetImmediateContext() override { return immediateContext; }
+    RenderStateCache &GetStateCache() override { return stateCache; }
+    std::unique_ptr<ICommandContext> CreateDeferredContext() override;
+
+    void SignalFence(std::uint64_t fence) override;
+    bool IsFenceComplete(std::uint64_t fence, bool flush) override;
+
+    void Clear(const float color[4]) override;
+    void Present() override;
+
+private:
+    // keeps the object alive and hands out the raw pointer as the handle
+    const void *Keep(Microsoft::WRL::ComPtr<IUnknown> resource, const void *handle);
+
+    std::shared_ptr<GraphicsDeviceManager> graphicsDevice;
+    std::shared_ptr<ResourceManager> resourceManager;
+
+    std::unordered_map<const void *, Microsoft::WRL::ComPtr<IUnknown>> resources;
+
+    // an event query per fence in flight, fence n uses query n % MAX_FENCES_IN_FLIGHT
+    std::array<Microsoft::WRL::ComPtr<ID3D11Query>, MAX_FENCES_IN_FLIGHT> fenceQueries;
+    bool hasConstantBufferRanges = false;
+
+    RenderStateCache stateCache;
+    D3D11CommandContext immediateContext;
+};
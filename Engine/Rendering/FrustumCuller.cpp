@@ -0,0 +1,132 @@
+#include "FrustumCuller.h"
+
+using namespace DirectX;
+
+void FrustumCuller::SetFrustum(FXMMATRIX view, CXMMATRIX projection)
+{
+    // DirectXMath uses row vectors (clip = v * viewProjection), so the planes come from the columns of the matrix,
+    // which are the rows of its transpose
+    XMMATRIX columns = XMMatrixTranspose(XMMatrixMultiply(view, projection));
+
+    XMVECTOR extracted[6] = {
+        XMVectorAdd(columns.r[3], columns.r[0]),      // left
+        XMVectorSubtract(columns.r[3], columns.r[0]), // right
+        XMVectorAdd(columns.r[3], columns.r[1]),      // bottom
+        XMVectorSubtract(columns.r[3], columns.r[1]), // top
+        columns.r[2],                                 // near (z >= 0 in D3D)
+        XMVectorSubtract(columns.r[3], columns.r[2]), // far
+    };
+
+    for (int i = 0; i < 6; ++i)
+        XMStoreFloat4(&planes[i], XMPlaneNormalize(extracted[i]));
+}
+
+void FrustumCuller::Clear()
+{
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    extentX.clear();
+    extentY.clear();
+    extentZ.clear();
+    count = 0;
+}
+
+std::uint32_t FrustumCuller::Add(const BoundingBox &worldBounds)
+{
+    // keep the arrays padded to a multiple of four, the padding boxes are never reported
+    if (count == centerX.size())
+    {
+        size_t padded = centerX.size() + 4;
+        centerX.resize(padded, 0.0f);
+        centerY.resize(padded, 0.0f);
+        centerZ.resize(padded, 0.0f);
+        extentX.resize(padded, 0.0f);
+        extentY.resize(padded, 0.0f);
+        extentZ.resize(padded, 0.0f);
+    }
+
+    centerX[count] = worldBounds.Center.x;
+    centerY[count] = worldBounds.Center.y;
+    centerZ[count] = worldBounds.Center.z;
+    extentX[count] = worldBounds.Extents.x;
+    extentY[count] = worldBounds.Extents.y;
+    extentZ[count] = worldBounds.Extents.z;
+
+    return static_cast<std::uint32_t>(count++);
+}
+
+void FrustumCuller::Cull(std::vector<std::uint32_t> &visible) const
+{
+    visible.clear();
+
+    // splat every plane once up front
+    XMVECTOR planeX[6], planeY[6], planeZ[6], planeW[6];
+    XMVECTOR absX[6], absY[6], absZ[6];
+    for (int p = 0; p < 6; ++p)
+    {
+        planeX[p] = XMVectorReplicate(planes[p].x);
+        planeY[p] = XMVectorReplicate(planes[p].y);
+        planeZ[p] = XMVectorReplicate(planes[p].z);
+        planeW[p] = XMVectorReplicate(planes[p].w);
+        absX[p] = XMVectorAbs(planeX[p]);
+        absY[p] = XMVectorAbs(planeY[p]);
+        absZ[p] = XMVectorAbs(planeZ[p]);
+    }
+
+    XMVECTOR zero = XMVectorZero();
+    for (size_t i = 0; i < count; i += 4)
+    {
+        XMVECTOR cx = XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(&centerX[i]));
+        XMVECTOR cy = XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(&centerY[i]));
+        XMVECTOR cz = XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(&centerZ[i]));
+        XMVECTOR ex = XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(&extentX[i]));
+        XMVECTOR ey = XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(&extentY[i]));
+        XMVECTOR ez = XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(&extentZ[i]));
+
+        // a box is outside if it's completely behind any plane:
+        // distance of the center + projected radius of the extents onto the plane normal < 0
+        XMVECTOR outside = XMVectorFalseInt();
+        for (int p = 0; p < 6; ++p)
+        {
+            XMVECTOR distance = XMVectorMultiplyAdd(cx, planeX[p], planeW[p]);
+            distance = XMVectorMultiplyAdd(cy, planeY[p], distance);
+            distance = XMVectorMultiplyAdd(cz, planeZ[p], distance);
+
+            XMVECTOR radius = XMVectorMultiply(ex, absX[p]);
+            radius = XMVectorMultiplyAdd(ey, absY[p], radius);
+            radius = XMVectorMultiplyAdd(ez, absZ[p], radius);
+
+            outside = XMVectorOrInt(outside, XMVectorLess(XMVectorAdd(distance, radius), zero));
+        }
+
+        // all four culled, the common case when most of the scene is off screen
+        if (XMVector4EqualInt(outside, XMVectorTrueInt()))
+            continue;
+
+        XMUINT4 results;
+        XMStoreUInt4(&results, outside);
+        const std::uint32_t lanes[4] = {results.x, results.y, results.z, results.w};
+        for (size_t lane = 0; lane < 4 && i + lane < count; ++lane)
+        {
+            if (!lanes[lane])
+                visible.push_back(static_cast<std::uint32_t>(i + lane));
+        }
+    }
+}
+
+BoundingBox FrustumCuller::TransformBounds(const BoundingBox &localBounds, FXMMATRIX world)
+{
+    // center goes through the full matrix, the extents through the absolute value of the 3x3 part
+    XMVECTOR center = XMVector3Transform(XMLoadFloat3(&localBounds.Center), world);
+    XMVECTOR extents = XMLoadFloat3(&localBounds.Extents);
+
+    XMVECTOR worldExtents = XMVectorMultiply(XMVectorSplatX(extents), XMVectorAbs(world.r[0]));
+    worldExtents = XMVectorMultiplyAdd(XMVectorSplatY(extents), XMVectorAbs(world.r[1]), worldExtents);
+    worldExtents = XMVectorMultiplyAdd(XMVectorSplatZ(extents), XMVectorAbs(world.r[2]), worldExtents);
+
+    BoundingBox result;
+    XMStoreFloat3(&result.Center, center);
+    XMStoreFloat3(&result.Extents, worldExtents);
+    return result;
+}
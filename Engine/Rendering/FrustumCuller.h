@@ -0,0 +1,53 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class FrustumCuller
+ * @brief Tests world space bounding boxes against the camera frustum, four at a time
+ *
+ * Boxes are stored structure-of-arrays (center x/y/z, extents x/y/z) so one SIMD register holds the same
+ * coordinate of four boxes, and each frustum plane is tested against four boxes per instruction.
+ *
+ * Usage per frame: SetFrustum, Add every candidate, then Cull to get the indices of the visible ones.
+ */
+class FrustumCuller
+{
+public:
+    /** @brief Extracts the six frustum planes from the camera matrices (D3D clip space, z in [0, 1]) */
+    void SetFrustum(DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection);
+
+    /** @brief Removes every candidate, keeps the memory */
+    void Clear();
+
+    /**
+     * @brief Adds a world space box as a candidate
+     * @return Index of the candidate, as reported by Cull
+     */
+    std::uint32_t Add(const DirectX::BoundingBox &worldBounds);
+
+    /**
+     * @brief Tests every candidate against the frustum
+     * @param visible Receives the indices of the candidates that are at least partly inside, in the order they were added
+     */
+    void Cull(std::vector<std::uint32_t> &visible) const;
+
+    size_t GetCandidateCount() const { return count; }
+
+    /** @brief Planes set by the last SetFrustum, normals point inwards (ax + by + cz + d >= 0 is inside) */
+    const DirectX::XMFLOAT4 (&GetPlanes() const)[6] { return planes; }
+
+    /** @brief Transforms an object space box by a world matrix, the result is the box around the transformed box */
+    static DirectX::BoundingBox TransformBounds(const DirectX::BoundingBox &localBounds, DirectX::FXMMATRIX world);
+
+private:
+    DirectX::XMFLOAT4 planes[6] = {};
+
+    // SoA candidate data, padded to a multiple of four
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    size_t count = 0;
+};
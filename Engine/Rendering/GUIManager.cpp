@@ -2,9 +2,11 @@
 #include "../Core/Timer.h"
 
 #include "../ECS/Components/TransformComponent.h"
+#include "../ECS/Systems/TransformSystem.h"
 #include "../ECS/Components/CameraComponent.h"
 #include "../ECS/Components/LightComponent.h"
 #include "../ECS/Components/MaterialComponent.h"
+#include "../ECS/EntityCommandBuffer.h"
 
 GUIManager::GUIManager(Registry &registry, HWND windowHandle, Timer &timer)
     : registry(registry), windowHandle(windowHandle), timer(timer)
@@ -82,9 +84,20 @@ void GUIManager::ShowStatsWindow()
     ImGui::Separator();
     ImGui::Text("Render Settings");
     ImGui::Checkbox("Wireframe Mode", &isWireframeEnabled);
+    ImGui::Checkbox("Instancing", &isInstancingEnabled);
+    ImGui::Checkbox("Per-Object Lights", &isObjectLightsEnabled);
+    ImGui::Checkbox("Shadows", &isShadowsEnabled);
 
     ImGui::Separator();
     ImGui::Text("Entities: %zu", registry.GetEntityCount());
+    if (transformSystem)
+        ImGui::Text("Transforms Updated: %zu", transformSystem->GetRecomputedCount());
+    ImGui::Text("Meshes Drawn: %zu / %zu", drawnMeshes, totalMeshes);
+    ImGui::Text("Meshes Occluded: %zu", occludedMeshes);
+    ImGui::Text("Draw Calls: %zu", drawCalls);
+    ImGui::Text("State Binds: %zu issued, %zu skipped", issuedBinds, skippedBinds);
+    ImGui::Text("Lights: %zu, %zu re-packed, %zu dropped", lightCount, repackedLights, droppedLights);
+    ImGui::Text("Shadow Casters: %zu, %zu cascades redrawn", shadowCasters, redrawnShadowCascades);
 
     ImGui::End();
 }
@@ -134,13 +147,7 @@ void GUIManager::ShowEntityInspector()
 
         // go through each new entity type separately
 
-        auto entities = registry.GetEntitiesWith<TransformComponent>();
-        auto cameraEntities = registry.GetEntitiesWith<CameraComponent>();
-        auto directionalLightEntities = registry.GetEntitiesWith<DirectionalLightComponent>();
-        auto pointLightEntities = registry.GetEntitiesWith<PointLightComponent>();
-        auto spotLightEntities = registry.GetEntitiesWith<SpotLightComponent>();
-
-        for (auto entity : cameraEntities)
+        for (auto [entity, camera] : registry.View<CameraComponent>())
         {
             std::string label = "Camera " + std::to_string(entity);
             if (ImGui::Selectable(label.c_str(), selectedEntity == entity))
@@ -149,7 +156,7 @@ void GUIManager::ShowEntityInspector()
             }
         }
 
-        for (auto entity : directionalLightEntities)
+        for (auto [entity, light] : registry.View<DirectionalLightComponent>())
         {
             std::string label = "Directional Light " + std::to_string(entity);
             if (ImGui::Selectable(label.c_str(), selectedEntity == entity))
@@ -158,7 +165,7 @@ void GUIManager::ShowEntityInspector()
             }
         }
 
-        for (auto entity : pointLightEntities)
+        for (auto [entity, light] : registry.View<PointLightComponent>())
         {
             std::string label = "Point Light " + std::to_string(entity);
             if (ImGui::Selectable(label.c_str(), selectedEntity == entity))
@@ -167,7 +174,7 @@ void GUIManager::ShowEntityInspector()
             }
         }
 
-        for (auto entity : spotLightEntities)
+        for (auto [entity, light] : registry.View<SpotLightComponent>())
         {
             std::string label = "Spot Light " + std::to_string(entity);
             if (ImGui::Selectable(label.c_str(), selectedEntity == entity))
@@ -178,12 +185,12 @@ void GUIManager::ShowEntityInspector()
 
         // add any other entities (such as the meshes)
         // should just create a mesh transform component for each mesh entity tbh
-        for (auto entity : entities)
+        for (auto [entity, transform] : registry.View<TransformComponent>())
         {
-            if (registry.GetComponent<CameraComponent>(entity) ||
-                registry.GetComponent<DirectionalLightComponent>(entity) ||
-                registry.GetComponent<PointLightComponent>(entity) ||
-                registry.GetComponent<SpotLightComponent>(entity))
+            if (registry.HasComponent<CameraComponent>(entity) ||
+                registry.HasComponent<DirectionalLightComponent>(entity) ||
+                registry.HasComponent<PointLightComponent>(entity) ||
+                registry.HasComponent<SpotLightComponent>(entity))
             {
                 continue;
             }
@@ -197,6 +204,36 @@ void GUIManager::ShowEntityInspector()
 
         // --
 
+        // the views above are still in use this frame, so creating and destroying goes through the command buffer
+        // and the changes show up after the next playback
+        if (commandBuffer)
+        {
+            ImGui::Separator();
+
+            if (ImGui::Button("Add Point Light"))
+            {
+                PointLightComponent light;
+                EntityID cameraEntity = FindMainCameraEntity();
+                if (auto *cameraTransform = registry.GetComponent<TransformComponent>(cameraEntity))
+                    light.position = cameraTransform->position;
+
+                EntityCommandBuffer::Recorder &recorder = commandBuffer->GetRecorder();
+                EntityID entity = recorder.CreateEntity();
+                recorder.AddComponent<PointLightComponent>(entity, light);
+            }
+
+            // the camera drives the view, deleting it would leave nothing to render from
+            if (registry.IsAlive(selectedEntity) && !registry.HasComponent<CameraComponent>(selectedEntity))
+            {
+                ImGui::SameLine();
+                if (ImGui::Button("Delete Entity"))
+                {
+                    commandBuffer->GetRecorder().DestroyEntity(selectedEntity);
+                    selectedEntity = INVALID_ENTITY;
+                }
+            }
+        }
+
         ImGui::Separator();
 
         if (selectedEntity != INVALID_ENTITY)
@@ -209,9 +246,12 @@ void GUIManager::ShowEntityInspector()
             {
                 if (ImGui::CollapsingHeader("Transform", ImGuiTreeNodeFlags_DefaultOpen))
                 {
-                    ImGui::DragFloat3("Position", &transform->position.x, 0.1f);
-                    ImGui::DragFloat3("Rotation", &transform->rotation.x, 0.01f);
-                    ImGui::DragFloat3("Scale", &transform->scale.x, 0.1f, 0.1f, 10.0f);
+                    // the world matrix is cached, so it has to be told when something changed
+                    bool changed = ImGui::DragFloat3("Position", &transform->position.x, 0.1f);
+                    changed |= ImGui::DragFloat3("Rotation", &transform->rotation.x, 0.01f);
+                    changed |= ImGui::DragFloat3("Scale", &transform->scale.x, 0.1f, 0.1f, 10.0f);
+                    if (changed)
+                        transform->MarkDirty();
                 }
             }
 
@@ -239,10 +279,15 @@ void GUIManager::ShowEntityInspector()
             {
                 if (ImGui::CollapsingHeader("Directional Light", ImGuiTreeNodeFlags_DefaultOpen))
                 {
-                    ImGui::ColorEdit3("Ambient", &light->ambientColor.x);
-                    ImGui::ColorEdit3("Diffuse", &light->diffuseColor.x);
-                    ImGui::DragFloat3("Direction", &light->direction.x, 0.01f, -1.0f, 1.0f);
-                    ImGui::SliderFloat("Intensity", &light->intensity, 0.0f, 5.0f);
+                    bool changed = ImGui::ColorEdit3("Ambient", &light->ambientColor.x);
+                    changed |= ImGui::ColorEdit3("Diffuse", &light->diffuseColor.x);
+                    changed |= ImGui::DragFloat3("Direction", &light->direction.x, 0.01f, -1.0f, 1.0f);
+                    changed |= ImGui::SliderFloat("Intensity", &light->intensity, 0.0f, 5.0f);
+                    if (changed)
+                        light->MarkDirty();
+
+                    // read every frame by the shadow pass, nothing to re-pack
+                    ImGui::Checkbox("Casts Shadows", &light->castsShadows);
                 }
             }
 
@@ -250,11 +295,13 @@ void GUIManager::ShowEntityInspector()
             {
                 if (ImGui::CollapsingHeader("Point Light", ImGuiTreeNodeFlags_DefaultOpen))
                 {
-                    ImGui::ColorEdit3("Ambient", &light->ambientColor.x);
-                    ImGui::ColorEdit3("Diffuse", &light->diffuseColor.x);
-                    ImGui::DragFloat3("Position", &light->position.x, 0.1f);
-                    ImGui::SliderFloat("Range", &light->range, 1.0f, 200.0f);
-                    ImGui::SliderFloat("Intensity", &light->intensity, 0.0f, 5.0f);
+                    bool changed = ImGui::ColorEdit3("Ambient", &light->ambientColor.x);
+                    changed |= ImGui::ColorEdit3("Diffuse", &light->diffuseColor.x);
+                    changed |= ImGui::DragFloat3("Position", &light->position.x, 0.1f);
+                    changed |= ImGui::SliderFloat("Range", &light->range, 1.0f, 200.0f);
+                    changed |= ImGui::SliderFloat("Intensity", &light->intensity, 0.0f, 5.0f);
+                    if (changed)
+                        light->MarkDirty();
                 }
             }
 
@@ -262,14 +309,16 @@ void GUIManager::ShowEntityInspector()
             {
                 if (ImGui::CollapsingHeader("Spot Light", ImGuiTreeNodeFlags_DefaultOpen))
                 {
-                    ImGui::ColorEdit3("Ambient", &light->ambientColor.x);
-                    ImGui::ColorEdit3("Diffuse", &light->diffuseColor.x);
-                    ImGui::DragFloat3("Position", &light->position.x, 0.1f);
-                    ImGui::DragFloat3("Direction", &light->direction.x, 0.01f, -1.0f, 1.0f);
-                    ImGui::SliderFloat("Range", &light->range, 1.0f, 200.0f);
-                    ImGui::SliderFloat("Inner Cone Angle", &light->innerConeAngle, 0.0f, DirectX::XM_PIDIV2);
-                    ImGui::SliderFloat("Outer Cone Angle", &light->outerConeAngle, 0.0f, DirectX::XM_PIDIV2);
-                    ImGui::SliderFloat("Intensity", &light->intensity, 0.0f, 5.0f);
+                    bool changed = ImGui::ColorEdit3("Ambient", &light->ambientColor.x);
+                    changed |= ImGui::ColorEdit3("Diffuse", &light->diffuseColor.x);
+                    changed |= ImGui::DragFloat3("Position", &light->position.x, 0.1f);
+                    changed |= ImGui::DragFloat3("Direction", &light->direction.x, 0.01f, -1.0f, 1.0f);
+                    changed |= ImGui::SliderFloat("Range", &light->range, 1.0f, 200.0f);
+                    changed |= ImGui::SliderFloat("Inner Cone Angle", &light->innerConeAngle, 0.0f, DirectX::XM_PIDIV2);
+                    changed |= ImGui::SliderFloat("Outer Cone Angle", &light->outerConeAngle, 0.0f, DirectX::XM_PIDIV2);
+                    changed |= ImGui::SliderFloat("Intensity", &light->intensity, 0.0f, 5.0f);
+                    if (changed)
+                        light->MarkDirty();
                 }
             }
         }
@@ -298,6 +347,8 @@ void GUIManager::Shutdown()
 
 EntityID GUIManager::FindMainCameraEntity() const
 {
-    auto cameraEntities = registry.GetEntitiesWith<CameraComponent>();
-    return cameraEntities.empty() ? INVALID_ENTITY : cameraEntities[0];
+    for (auto [entity, camera] : registry.View<CameraComponent>())
+        return entity;
+
+    return INVALID_ENTITY;
 }
\ No newline at end of file
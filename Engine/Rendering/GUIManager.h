@@ -10,6 +10,8 @@
 #include <memory>
 
 class Timer;
+class TransformSystem;
+class EntityCommandBuffer;
 
 // need a better gui tbh. might convert it from a manager to a system
 // and maybe implement a gizmo system for moving entities around
@@ -30,6 +32,45 @@ public:
     void ShowDemoWindow(bool *open);
 
     bool GetWireframeEnabled() const { return isWireframeEnabled; }
+    bool GetInstancingEnabled() const { return isInstancingEnabled; }
+    bool GetObjectLightsEnabled() const { return isObjectLightsEnabled; }
+    bool GetShadowsEnabled() const { return isShadowsEnabled; }
+
+    // optional, used to show how many world matrices were rebuilt each frame
+    void SetTransformSystem(const TransformSystem *system) { transformSystem = system; }
+
+    // entities added or deleted in the inspector are recorded here and show up after the next playback
+    // without one the inspector can only edit what's already there
+    void SetCommandBuffer(EntityCommandBuffer *buffer) { commandBuffer = buffer; }
+
+    void SetCullingStats(size_t drawn, size_t total, size_t occluded = 0)
+    {
+        drawnMeshes = drawn;
+        totalMeshes = total;
+        occludedMeshes = occluded;
+    }
+
+    void SetDrawCallCount(size_t count) { drawCalls = count; }
+
+    void SetStateBindStats(size_t issued, size_t skipped)
+    {
+        issuedBinds = issued;
+        skippedBinds = skipped;
+    }
+
+    // dropped counts light / cluster pairs that didn't fit a cluster's list, anything above 0 means missing lighting
+    void SetLightStats(size_t count, size_t repacked, size_t dropped = 0)
+    {
+        lightCount = count;
+        repackedLights = repacked;
+        droppedLights = dropped;
+    }
+
+    void SetShadowStats(size_t casters, size_t redrawnCascades)
+    {
+        shadowCasters = casters;
+        redrawnShadowCascades = redrawnCascades;
+    }
 
 private:
     EntityID FindMainCameraEntity() const;
@@ -37,8 +78,25 @@ private:
     Registry &registry;
     HWND windowHandle;
     Timer &timer;
+    const TransformSystem *transformSystem = nullptr;
+    EntityCommandBuffer *commandBuffer = nullptr;
+
+    size_t drawnMeshes = 0;
+    size_t totalMeshes = 0;
+    size_t occludedMeshes = 0;
+    size_t drawCalls = 0;
+    size_t issuedBinds = 0;
+    size_t skippedBinds = 0;
+    size_t lightCount = 0;
+    size_t repackedLights = 0;
+    size_t droppedLights = 0;
+    size_t shadowCasters = 0;
+    size_t redrawnShadowCascades = 0;
 
     bool isWireframeEnabled = false;
+    bool isInstancingEnabled = true;
+    bool isObjectLightsEnabled = false;
+    bool isShadowsEnabled = true;
     bool showDemoWindow = false;
 };
 
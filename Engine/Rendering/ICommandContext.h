@@ -0,0 +1,50 @@
+#pragma once
+
+#include "RenderStateCache.h"
+#include <cstdint>
+
+/**
+ * @class ICommandContext
+ * @brief Something draws can be recorded into, either straight onto the GPU or into a list that is played back later
+ *
+ * Resources are passed as opaque pointers (the backend knows what they really are), so code that records draws
+ * doesn't depend on D3D and can run against the CPU recording backend.
+ *
+ * Begin, the Set and Draw functions and Finish may run on any thread, as long as each thread uses its own context.
+ * Execute plays the finished commands back and must run on the thread that owns the device (usually the main thread).
+ * Like a D3D deferred context, a context starts every Begin with nothing bound, so it has to bind everything it needs.
+ */
+class ICommandContext
+{
+public:
+    using Stage = RenderStateCache::Stage;
+
+    virtual ~ICommandContext() = default;
+
+    virtual void Begin() = 0;
+
+    /** @return false if the commands couldn't be closed into a list, Execute does nothing then */
+    virtual bool Finish() = 0;
+    virtual void Execute() = 0;
+
+    virtual void SetRenderTargets(const void *renderTarget, const void *depthStencil) = 0;
+    virtual void SetViewport(std::uint32_t width, std::uint32_t height) = 0;
+    virtual void SetRasterizerState(const void *state) = 0;
+    virtual void SetDepthStencilState(const void *state, std::uint32_t stencilRef) = 0;
+    virtual void SetPrimitiveTopology(std::uint32_t topology) = 0;
+    virtual void SetInputLayout(const void *layout) = 0;
+    virtual void SetVertexShader(const void *shader) = 0;
+    virtual void SetPixelShader(const void *shader) = 0;
+
+    virtual void SetVertexBuffer(std::uint32_t slot, const void *buffer, std::uint32_t stride, std::uint32_t offset) = 0;
+    virtual void SetIndexBuffer(const void *buffer, std::uint32_t format, std::uint32_t offset) = 0;
+    // a range is given in 16 byte constants, a count of 0 binds the whole buffer
+    virtual void SetConstantBuffer(Stage stage, std::uint32_t slot, const void *buffer,
+                                   std::uint32_t firstConstant = 0, std::uint32_t constantCount = 0) = 0;
+    virtual void SetTexture(std::uint32_t slot, const void *texture) = 0;
+    virtual void SetSampler(std::uint32_t slot, const void *sampler) = 0;
+
+    virtual void DrawIndexed(std::uint32_t indexCount, std::uint32_t startIndex = 0, std::int32_t baseVertex = 0) = 0;
+    virtual void DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount, std::uint32_t startInstance = 0,
+                                      std::uint32_t startIndex = 0, std::int32_t baseVertex = 0) = 0;
+};
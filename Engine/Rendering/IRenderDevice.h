@@ -0,0 +1,121 @@
+#pragma once
+
+#include "ICommandContext.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+enum class RenderBackend : std::uint8_t
+{
+    D3D11 = 0,
+    Null = 1, // no GPU, commands are only recorded (headless builds, profiling, tests)
+};
+
+enum class BufferUsage : std::uint8_t
+{
+    Vertex = 0,
+    Index = 1,
+    Constant = 2,
+    DynamicVertex = 3,   // rewritten by the CPU with WriteBuffer
+    DynamicConstant = 4, // same, and can be bound a range at a time
+};
+
+enum class WriteMode : std::uint8_t
+{
+    Discard = 0,     // the old contents are thrown away (the GPU may still be reading them, that's fine)
+    NoOverwrite = 1, // the caller promises not to touch anything the GPU may still read
+};
+
+// the few DXGI formats and D3D topologies code above the device hands to it, so that code doesn't need the D3D headers
+constexpr std::uint32_t FORMAT_R32G32B32A32_FLOAT = 2;
+constexpr std::uint32_t FORMAT_R32G32B32A32_UINT = 3;
+constexpr std::uint32_t FORMAT_R32G32B32_FLOAT = 6;
+constexpr std::uint32_t FORMAT_R32G32_FLOAT = 16;
+constexpr std::uint32_t FORMAT_R32_UINT = 42;
+constexpr std::uint32_t PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4;
+
+struct BufferDesc
+{
+    BufferUsage usage = BufferUsage::Vertex;
+    std::uint32_t byteWidth = 0;
+    const void *initialData = nullptr; // required for Vertex / Index, optional otherwise
+};
+
+struct VertexElement
+{
+    const char *semanticName = nullptr;
+    std::uint32_t semanticIndex = 0;
+    std::uint32_t format = 0; // DXGI_FORMAT value
+    std::uint32_t slot = 0;
+    std::uint32_t offset = 0;
+    bool isPerInstance = false; // advances once per instance instead of once per vertex
+};
+
+struct TextureDesc
+{
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::uint32_t format = 0; // DXGI_FORMAT value
+    const void *initialData = nullptr;
+    std::uint32_t rowPitch = 0;
+};
+
+/**
+ * @class IRenderDevice
+ * @brief Thin layer over the graphics API: creates resources and states, hands out command contexts, presents
+ *
+ * Resources are opaque pointers, the same ones the command contexts take, and they stay owned by the device until
+ * ReleaseResource (or the device goes away). Only pass a device the handles it created itself.
+ * Creating, writing and releasing resources, fences, Clear and Present belong to the thread that owns the device.
+ */
+class IRenderDevice
+{
+public:
+    // how many frame fences can be waited on at once, signal no more until the oldest one completed
+    static constexpr std::uint32_t MAX_FENCES_IN_FLIGHT = 4;
+
+    virtual ~IRenderDevice() = default;
+
+    virtual RenderBackend GetBackend() const = 0;
+
+    // whether a constant buffer can be bound a range at a time and written with WriteMode::NoOverwrite
+    virtual bool SupportsConstantBufferRanges() const = 0;
+
+    // nullptr on failure
+    virtual const void *CreateBuffer(const BufferDesc &desc) = 0;
+    virtual const void *CreateTexture(const TextureDesc &desc) = 0; // returns the view shaders read it through
+    virtual const void *CreateSamplerState() = 0;
+    virtual const void *CreateRasterizerState(bool wireframe) = 0;
+    virtual const void *CreateDepthStencilState() = 0;
+    virtual const void *CreateVertexShader(const void *bytecode, size_t bytecodeLength) = 0;
+    virtual const void *CreatePixelShader(const void *bytecode, size_t bytecodeLength) = 0;
+    virtual const void *CreateInputLayout(const VertexElement *elements, std::uint32_t elementCount,
+                                          const void *shaderBytecode, size_t bytecodeLength) = 0;
+    virtual void ReleaseResource(const void *resource) = 0;
+
+    /** @brief Copies size bytes into a dynamic buffer at offset */
+    virtual bool WriteBuffer(const void *buffer, std::uint32_t offset, const void *data, std::uint32_t size, WriteMode mode) = 0;
+
+    // what SetRenderTargets takes to draw to the screen, and its size
+    virtual const void *GetBackBufferTarget() const = 0;
+    virtual const void *GetDepthStencilTarget() const = 0;
+    virtual std::uint32_t GetWidth() const = 0;
+    virtual std::uint32_t GetHeight() const = 0;
+
+    virtual ICommandContext &GetImmediateContext() = 0;
+
+    /** @brief Cache of what's bound on the immediate context, for its stats and for invalidating it */
+    virtual RenderStateCache &GetStateCache() = 0;
+
+    /** @return nullptr if the backend can't record on other threads */
+    virtual std::unique_ptr<ICommandContext> CreateDeferredContext() = 0;
+
+    /** @brief Marks the end of the work submitted so far, the fence completes once the GPU got past it */
+    virtual void SignalFence(std::uint64_t fence) = 0;
+
+    /** @param flush Pushes queued work to the GPU first, so waiting on the fence can't stall forever */
+    virtual bool IsFenceComplete(std::uint64_t fence, bool flush) = 0;
+
+    virtual void Clear(const float color[4]) = 0;
+    virtual void Present() = 0;
+};
@@ -0,0 +1,22 @@
+#include "InstanceBatcher.h"
+
+void InstanceBatcher::Clear()
+{
+    batches.clear();
+    instances.clear();
+}
+
+void InstanceBatcher::Add(const DrawState &state, std::uint32_t item, const DirectX::XMFLOAT4X4 &world, const ObjectLightData *lights)
+{
+    bool startsBatch = batches.empty() || batches.back().state != state ||
+                       (maxInstancesPerBatch != 0 && batches.back().instanceCount == maxInstancesPerBatch);
+
+    if (startsBatch)
+        batches.push_back({state, item, static_cast<std::uint32_t>(instances.size()), 0});
+
+    InstanceData instance = {world, {}};
+    if (lights)
+        instance.lights = *lights;
+    instances.push_back(instance);
+    ++batches.back().instanceCount;
+}
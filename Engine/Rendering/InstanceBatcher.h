@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Buffers.h"
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct InstanceData
+ * @brief Per instance stream of the instanced vertex shader, one entry per drawn object
+ *
+ * The world matrix is stored as is (row major, not transposed like the constant buffers), the shader rebuilds it
+ * from four row vectors. The light list is the instance's own, the same one a non instanced draw would get.
+ */
+struct InstanceData
+{
+    DirectX::XMFLOAT4X4 world;
+    ObjectLightData lights;
+};
+
+/**
+ * @class InstanceBatcher
+ * @brief Merges consecutive draws that share mesh and material into instanced batches, CPU side only
+ *
+ * Draws are added in the order they should be drawn (usually straight out of the sorted RenderQueue, which already
+ * puts draws with the same state next to each other). A draw that binds exactly what the previous one binds joins
+ * its batch, anything else starts a new batch, so the order of the draws never changes and blending still works.
+ * The resources are compared themselves rather than the queue's sort key, whose IDs are allowed to wrap.
+ * The instances of all batches end up in one array that can be uploaded with a single copy.
+ */
+class InstanceBatcher
+{
+public:
+    /** @brief Everything a draw binds that instances of one batch have to share, resources by address */
+    struct DrawState
+    {
+        const void *vertexBuffer = nullptr;
+        const void *indexBuffer = nullptr;
+        std::uint32_t indexCount = 0;
+        const void *diffuseTexture = nullptr;
+        const void *normalTexture = nullptr;
+        const void *sampler = nullptr;
+
+        bool operator==(const DrawState &other) const
+        {
+            return vertexBuffer == other.vertexBuffer && indexBuffer == other.indexBuffer && indexCount == other.indexCount &&
+                   diffuseTexture == other.diffuseTexture && normalTexture == other.normalTexture && sampler == other.sampler;
+        }
+        bool operator!=(const DrawState &other) const { return !(*this == other); }
+    };
+
+    struct Batch
+    {
+        DrawState state;
+        std::uint32_t firstItem;     // item of the first draw, to look up the mesh and material to bind
+        std::uint32_t firstInstance; // offset into GetInstances()
+        std::uint32_t instanceCount;
+    };
+
+    /** @param maxInstancesPerBatch Longer runs are split, 0 means no limit */
+    explicit InstanceBatcher(std::uint32_t maxInstancesPerBatch = 0) : maxInstancesPerBatch(maxInstancesPerBatch) {}
+
+    void Clear();
+
+    /**
+     * @brief Adds one draw
+     * @param state Draws can only share a batch if their states are equal
+     * @param item Caller's index of the draw, only the first one of each batch is kept
+     * @param lights The draw's light list, nullptr leaves it to the clustered lights
+     */
+    void Add(const DrawState &state, std::uint32_t item, const DirectX::XMFLOAT4X4 &world, const ObjectLightData *lights = nullptr);
+
+    const std::vector<Batch> &GetBatches() const { return batches; }
+    const std::vector<InstanceData> &GetInstances() const { return instances; }
+
+private:
+    std::uint32_t maxInstancesPerBatch;
+
+    std::vector<Batch> batches;
+    std::vector<InstanceData> instances;
+};
@@ -0,0 +1,311 @@
+#include "LightClusterer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr size_t LIGHTS_PER_JOB = 256;
+    constexpr size_t ROWS_PER_JOB = 2;
+
+    // runs on the job system if there is one, otherwise on the calling thread
+    void Run(JobSystem *jobSystem, size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &func)
+    {
+        if (jobSystem)
+            jobSystem->ParallelFor(count, grainSize, func);
+        else if (count > 0)
+            func(0, count);
+    }
+
+    // floor(value), clamped to [0, count - 1]
+    std::uint16_t ToIndex(float value, std::uint32_t count)
+    {
+        if (!(value > 0.0f))
+            return 0;
+        if (value >= static_cast<float>(count))
+            return static_cast<std::uint16_t>(count - 1);
+        return static_cast<std::uint16_t>(value);
+    }
+
+    XMVECTOR XM_CALLCONV LoadFour(const float *values)
+    {
+        return XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(values));
+    }
+}
+
+void LightClusterer::SetProjection(CXMMATRIX projectionMatrix)
+{
+    XMFLOAT4X4 newProjection;
+    XMStoreFloat4x4(&newProjection, projectionMatrix);
+    if (hasProjection && std::memcmp(&newProjection, &projection, sizeof(projection)) == 0)
+        return;
+
+    projection = newProjection;
+    hasProjection = true;
+
+    // straight from XMMatrixPerspectiveFovLH: m00 = 1 / tan(fovX / 2), m22 = f / (f - n), m32 = -n * f / (f - n)
+    tanHalfX = 1.0f / projection.m[0][0];
+    tanHalfY = 1.0f / projection.m[1][1];
+    nearZ = -projection.m[3][2] / projection.m[2][2];
+    farZ = projection.m[3][2] / (1.0f - projection.m[2][2]);
+
+    float logDepthRatio = std::log(farZ / nearZ);
+    depthScale = static_cast<float>(GRID_Z) / logDepthRatio;
+    depthBias = -static_cast<float>(GRID_Z) * std::log(nearZ) / logDepthRatio;
+
+    for (auto *values : {&boxMinX, &boxMinY, &boxMinZ, &boxMaxX, &boxMaxY, &boxMaxZ, &sphereX, &sphereY, &sphereZ, &sphereRadius})
+        values->resize(CLUSTER_COUNT);
+
+    for (std::uint32_t z = 0; z < GRID_Z; ++z)
+    {
+        // slice z covers [near * (far / near)^(z / GRID_Z), near * (far / near)^((z + 1) / GRID_Z)]
+        float sliceNear = nearZ * std::pow(farZ / nearZ, static_cast<float>(z) / GRID_Z);
+        float sliceFar = z + 1 == GRID_Z ? farZ : nearZ * std::pow(farZ / nearZ, static_cast<float>(z + 1) / GRID_Z);
+
+        for (std::uint32_t y = 0; y < GRID_Y; ++y)
+        {
+            // rows count from the top of the screen, like pixel coordinates
+            float tanTop = tanHalfY * (1.0f - 2.0f * y / GRID_Y);
+            float tanBottom = tanHalfY * (1.0f - 2.0f * (y + 1) / GRID_Y);
+
+            for (std::uint32_t x = 0; x < GRID_X; ++x)
+            {
+                float tanLeft = tanHalfX * (2.0f * x / GRID_X - 1.0f);
+                float tanRight = tanHalfX * (2.0f * (x + 1) / GRID_X - 1.0f);
+
+                std::uint32_t cluster = GetClusterIndex(x, y, z);
+                boxMinX[cluster] = std::min(tanLeft * sliceNear, tanLeft * sliceFar);
+                boxMaxX[cluster] = std::max(tanRight * sliceNear, tanRight * sliceFar);
+                boxMinY[cluster] = std::min(tanBottom * sliceNear, tanBottom * sliceFar);
+                boxMaxY[cluster] = std::max(tanTop * sliceNear, tanTop * sliceFar);
+                boxMinZ[cluster] = sliceNear;
+                boxMaxZ[cluster] = sliceFar;
+
+                float halfX = 0.5f * (boxMaxX[cluster] - boxMinX[cluster]);
+                float halfY = 0.5f * (boxMaxY[cluster] - boxMinY[cluster]);
+                float halfZ = 0.5f * (sliceFar - sliceNear);
+                sphereX[cluster] = boxMinX[cluster] + halfX;
+                sphereY[cluster] = boxMinY[cluster] + halfY;
+                sphereZ[cluster] = sliceNear + halfZ;
+                sphereRadius[cluster] = std::sqrt(halfX * halfX + halfY * halfY + halfZ * halfZ);
+            }
+        }
+    }
+}
+
+std::uint32_t LightClusterer::GetSlice(float viewDepth) const
+{
+    if (viewDepth <= nearZ)
+        return 0;
+
+    return ToIndex(std::log(viewDepth) * depthScale + depthBias, GRID_Z);
+}
+
+void LightClusterer::ComputeBounds(const Light &light, FXMMATRIX view, LightBounds &bounds) const
+{
+    bounds.isVisible = false;
+
+    // empty slot, see Assign
+    if (!(light.range > 0.0f))
+        return;
+
+    XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&light.position), view);
+    XMStoreFloat4(&bounds.sphere, XMVectorSetW(center, light.range));
+
+    float centerX = bounds.sphere.x;
+    float centerY = bounds.sphere.y;
+    float centerZ = bounds.sphere.z;
+    float radius = light.range;
+
+    if (centerZ + radius < nearZ || centerZ - radius > farZ)
+        return;
+
+    XMStoreFloat3(&bounds.direction, XMVector3TransformNormal(XMLoadFloat3(&light.direction), view));
+    bounds.cosAngle = light.cosOuterCone;
+    bounds.sinAngle = std::sqrt(std::max(0.0f, 1.0f - light.cosOuterCone * light.cosOuterCone));
+
+    float depthNear = std::max(centerZ - radius, nearZ);
+    float depthFar = std::min(centerZ + radius, farZ);
+
+    // x / z over the sphere's box peaks at one of its corners, so the near and far depth are enough
+    float minX = centerX - radius;
+    float maxX = centerX + radius;
+    float tanMinX = std::min(minX / depthNear, minX / depthFar);
+    float tanMaxX = std::max(maxX / depthNear, maxX / depthFar);
+    if (tanMaxX < -tanHalfX || tanMinX > tanHalfX)
+        return;
+
+    float minY = centerY - radius;
+    float maxY = centerY + radius;
+    float tanMinY = std::min(minY / depthNear, minY / depthFar);
+    float tanMaxY = std::max(maxY / depthNear, maxY / depthFar);
+    if (tanMaxY < -tanHalfY || tanMinY > tanHalfY)
+        return;
+
+    float tilesPerTanX = GRID_X / (2.0f * tanHalfX);
+    float rowsPerTanY = GRID_Y / (2.0f * tanHalfY);
+
+    bounds.minX = ToIndex((tanMinX + tanHalfX) * tilesPerTanX, GRID_X);
+    bounds.maxX = ToIndex((tanMaxX + tanHalfX) * tilesPerTanX, GRID_X);
+    bounds.minY = ToIndex((tanHalfY - tanMaxY) * rowsPerTanY, GRID_Y);
+    bounds.maxY = ToIndex((tanHalfY - tanMinY) * rowsPerTanY, GRID_Y);
+    bounds.minZ = static_cast<std::uint16_t>(GetSlice(depthNear));
+    bounds.maxZ = static_cast<std::uint16_t>(GetSlice(depthFar));
+    bounds.isVisible = true;
+}
+
+void LightClusterer::Assign(JobSystem *jobSystem, FXMMATRIX view, const Light *lights, size_t lightCount)
+{
+    XMMATRIX viewMatrix = view;
+
+    lightBounds.resize(lightCount);
+    Run(jobSystem, lightCount, LIGHTS_PER_JOB, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                ComputeBounds(lights[i], viewMatrix, lightBounds[i]);
+        });
+
+    // bucket the lights by slice (counting sort), each row job then only looks at the lights of its own slice
+    sliceOffsets.assign(GRID_Z + 1, 0);
+    for (const LightBounds &bounds : lightBounds)
+    {
+        if (!bounds.isVisible)
+            continue;
+
+        for (std::uint32_t z = bounds.minZ; z <= bounds.maxZ; ++z)
+            ++sliceOffsets[z + 1];
+    }
+
+    for (std::uint32_t z = 0; z < GRID_Z; ++z)
+        sliceOffsets[z + 1] += sliceOffsets[z];
+
+    sliceLights.resize(sliceOffsets[GRID_Z]);
+    std::vector<std::uint32_t> sliceCursor(sliceOffsets.begin(), sliceOffsets.end() - 1);
+    for (std::uint32_t i = 0; i < static_cast<std::uint32_t>(lightCount); ++i)
+    {
+        const LightBounds &bounds = lightBounds[i];
+        if (!bounds.isVisible)
+            continue;
+
+        for (std::uint32_t z = bounds.minZ; z <= bounds.maxZ; ++z)
+            sliceLights[sliceCursor[z]++] = i;
+    }
+
+    // every job owns whole rows of clusters, so nothing is shared and the lights of a cluster stay in input order
+    const size_t rowCount = GRID_Z * GRID_Y;
+    clusterCounts.assign(CLUSTER_COUNT, 0);
+    clusterSlots.resize(static_cast<size_t>(CLUSTER_COUNT) * MAX_LIGHTS_PER_CLUSTER);
+    rowDropped.assign(rowCount, 0);
+
+    Run(jobSystem, rowCount, ROWS_PER_JOB, [&](size_t begin, size_t end)
+        {
+            for (size_t row = begin; row < end; ++row)
+                AssignRow(static_cast<std::uint32_t>(row / GRID_Y), static_cast<std::uint32_t>(row % GRID_Y));
+        });
+
+    clusterRanges.resize(CLUSTER_COUNT);
+    std::uint32_t offset = 0;
+    for (std::uint32_t cluster = 0; cluster < CLUSTER_COUNT; ++cluster)
+    {
+        clusterRanges[cluster] = {offset, clusterCounts[cluster]};
+        offset += clusterCounts[cluster];
+    }
+
+    lightIndices.resize(offset);
+    Run(jobSystem, rowCount, ROWS_PER_JOB * 4, [&](size_t begin, size_t end)
+        {
+            for (std::uint32_t cluster = static_cast<std::uint32_t>(begin * GRID_X); cluster < end * GRID_X; ++cluster)
+            {
+                const std::uint32_t *slots = &clusterSlots[static_cast<size_t>(cluster) * MAX_LIGHTS_PER_CLUSTER];
+                std::copy(slots, slots + clusterRanges[cluster].count, lightIndices.begin() + clusterRanges[cluster].offset);
+            }
+        });
+
+    droppedCount = 0;
+    for (std::uint32_t dropped : rowDropped)
+        droppedCount += dropped;
+}
+
+void LightClusterer::AssignRow(std::uint32_t slice, std::uint32_t row)
+{
+    const std::uint32_t rowStart = GetClusterIndex(0, row, slice);
+    const XMVECTOR zero = XMVectorZero();
+    std::uint32_t dropped = 0;
+
+    for (std::uint32_t k = sliceOffsets[slice]; k < sliceOffsets[slice + 1]; ++k)
+    {
+        const std::uint32_t lightIndex = sliceLights[k];
+        const LightBounds &bounds = lightBounds[lightIndex];
+        if (row < bounds.minY || row > bounds.maxY)
+            continue;
+
+        const XMVECTOR centerX = XMVectorReplicate(bounds.sphere.x);
+        const XMVECTOR centerY = XMVectorReplicate(bounds.sphere.y);
+        const XMVECTOR centerZ = XMVectorReplicate(bounds.sphere.z);
+        const XMVECTOR range = XMVectorReplicate(bounds.sphere.w);
+        const XMVECTOR rangeSq = XMVectorMultiply(range, range);
+        const bool isSpot = bounds.cosAngle > -1.0f;
+
+        for (std::uint32_t group = bounds.minX / 4; group <= bounds.maxX / 4u; ++group)
+        {
+            const std::uint32_t first = rowStart + group * 4;
+
+            // squared distance from the light to the box, 0 inside
+            XMVECTOR dx = XMVectorAdd(XMVectorMax(XMVectorSubtract(LoadFour(&boxMinX[first]), centerX), zero),
+                                      XMVectorMax(XMVectorSubtract(centerX, LoadFour(&boxMaxX[first])), zero));
+            XMVECTOR dy = XMVectorAdd(XMVectorMax(XMVectorSubtract(LoadFour(&boxMinY[first]), centerY), zero),
+                                      XMVectorMax(XMVectorSubtract(centerY, LoadFour(&boxMaxY[first])), zero));
+            XMVECTOR dz = XMVectorAdd(XMVectorMax(XMVectorSubtract(LoadFour(&boxMinZ[first]), centerZ), zero),
+                                      XMVectorMax(XMVectorSubtract(centerZ, LoadFour(&boxMaxZ[first])), zero));
+            XMVECTOR distanceSq = XMVectorMultiplyAdd(dx, dx, XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dz, dz)));
+            XMVECTOR hit = XMVectorLessOrEqual(distanceSq, rangeSq);
+
+            if (isSpot)
+            {
+                // cone against the cluster's bounding sphere: outside the cone's angle, past its tip or behind it
+                XMVECTOR toX = XMVectorSubtract(LoadFour(&sphereX[first]), centerX);
+                XMVECTOR toY = XMVectorSubtract(LoadFour(&sphereY[first]), centerY);
+                XMVECTOR toZ = XMVectorSubtract(LoadFour(&sphereZ[first]), centerZ);
+                XMVECTOR radius = LoadFour(&sphereRadius[first]);
+
+                XMVECTOR lengthSq = XMVectorMultiplyAdd(toX, toX, XMVectorMultiplyAdd(toY, toY, XMVectorMultiply(toZ, toZ)));
+                XMVECTOR along = XMVectorMultiplyAdd(toX, XMVectorReplicate(bounds.direction.x),
+                                                     XMVectorMultiplyAdd(toY, XMVectorReplicate(bounds.direction.y),
+                                                                         XMVectorMultiply(toZ, XMVectorReplicate(bounds.direction.z))));
+                XMVECTOR across = XMVectorSqrt(XMVectorMax(XMVectorSubtract(lengthSq, XMVectorMultiply(along, along)), zero));
+                XMVECTOR closest = XMVectorSubtract(XMVectorMultiply(XMVectorReplicate(bounds.cosAngle), across),
+                                                    XMVectorMultiply(along, XMVectorReplicate(bounds.sinAngle)));
+
+                XMVECTOR outside = XMVectorOrInt(XMVectorGreater(closest, radius),
+                                                 XMVectorOrInt(XMVectorGreater(along, XMVectorAdd(radius, range)),
+                                                               XMVectorLess(along, XMVectorNegate(radius))));
+                hit = XMVectorAndCInt(hit, outside);
+            }
+
+            XMUINT4 hits;
+            XMStoreUInt4(&hits, hit);
+            const std::uint32_t laneHits[4] = {hits.x, hits.y, hits.z, hits.w};
+
+            for (std::uint32_t lane = 0; lane < 4; ++lane)
+            {
+                std::uint32_t x = group * 4 + lane;
+                if (!laneHits[lane] || x < bounds.minX || x > bounds.maxX)
+                    continue;
+
+                std::uint32_t cluster = first + lane;
+                std::uint32_t &count = clusterCounts[cluster];
+                if (count == MAX_LIGHTS_PER_CLUSTER)
+                {
+                    ++dropped;
+                    continue;
+                }
+
+                clusterSlots[static_cast<size_t>(cluster) * MAX_LIGHTS_PER_CLUSTER + count++] = lightIndex;
+            }
+        }
+    }
+
+    rowDropped[slice * GRID_Y + row] = dropped;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "../Core/JobSystem.h"
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class LightClusterer
+ * @brief Assigns point and spot lights to the clusters of a grid over the view frustum, for clustered forward shading
+ *
+ * The frustum is split into GRID_X x GRID_Y screen tiles and GRID_Z depth slices. Slices get exponentially deeper
+ * towards the far plane so clusters stay roughly cube shaped. Each light is tested against the clusters its bounds
+ * cover, four clusters of a row per SIMD test: sphere against the cluster's box, plus the cone against the
+ * cluster's bounding sphere for spot lights. The result is one compact light index list and an {offset, count} range
+ * per cluster. Lights inside a cluster keep their input order, so the output doesn't depend on the thread count.
+ *
+ * Usage per frame: SetProjection (cheap when nothing changed), then Assign.
+ */
+class LightClusterer
+{
+public:
+    static constexpr std::uint32_t GRID_X = 16; // multiple of 4, a row is tested four clusters at a time
+    static constexpr std::uint32_t GRID_Y = 9;
+    static constexpr std::uint32_t GRID_Z = 24;
+    static constexpr std::uint32_t CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+
+    // lights past this in one cluster are dropped (and counted), the scratch space is CLUSTER_COUNT times this
+    static constexpr std::uint32_t MAX_LIGHTS_PER_CLUSTER = 256;
+
+    // world space
+    struct Light
+    {
+        DirectX::XMFLOAT3 position;
+        float range;
+        DirectX::XMFLOAT3 direction; // spot only, normalized
+        float cosOuterCone;          // cosine of the cone's half angle, -1 for point lights
+    };
+
+    // same layout as the shader's uint2
+    struct ClusterRange
+    {
+        std::uint32_t offset;
+        std::uint32_t count;
+    };
+
+    /** @brief Rebuilds the cluster bounds for a left handed perspective projection, does nothing if it didn't change */
+    void SetProjection(DirectX::CXMMATRIX projection);
+
+    /**
+     * @brief Builds the cluster ranges and light index list for the frame
+     *
+     * The indices in the list are positions in lights. Lights with a range of 0 are skipped, so the array can have
+     * holes (free or directional slots) without having to be compacted first.
+     * @param jobSystem Spreads the work over its threads, nullptr runs everything on the calling thread
+     */
+    void Assign(JobSystem *jobSystem, DirectX::FXMMATRIX view, const Light *lights, size_t lightCount);
+
+    /** @brief Cluster index as the shader computes it, x and y are screen tiles from the top left */
+    static std::uint32_t GetClusterIndex(std::uint32_t x, std::uint32_t y, std::uint32_t z) { return (z * GRID_Y + y) * GRID_X + x; }
+
+    const std::vector<ClusterRange> &GetClusterRanges() const { return clusterRanges; }
+    const std::vector<std::uint32_t> &GetLightIndices() const { return lightIndices; }
+
+    // slice = log(viewDepth) * depthScale + depthBias
+    float GetDepthScale() const { return depthScale; }
+    float GetDepthBias() const { return depthBias; }
+
+    /** @brief Light / cluster pairs that didn't fit into MAX_LIGHTS_PER_CLUSTER in the last Assign */
+    std::uint32_t GetDroppedCount() const { return droppedCount; }
+
+private:
+    // the light in view space and the block of clusters its bounds cover
+    struct LightBounds
+    {
+        DirectX::XMFLOAT4 sphere;    // view space center, radius
+        DirectX::XMFLOAT3 direction; // view space
+        float cosAngle;
+        float sinAngle;
+        std::uint16_t minX, maxX, minY, maxY, minZ, maxZ;
+        bool isVisible;
+    };
+
+    void ComputeBounds(const Light &light, DirectX::FXMMATRIX view, LightBounds &bounds) const;
+    std::uint32_t GetSlice(float viewDepth) const;
+    void AssignRow(std::uint32_t slice, std::uint32_t row);
+
+    // projection the bounds were built for
+    DirectX::XMFLOAT4X4 projection = {};
+    bool hasProjection = false;
+
+    float nearZ = 0.0f;
+    float farZ = 0.0f;
+    float tanHalfX = 0.0f;
+    float tanHalfY = 0.0f;
+    float depthScale = 0.0f;
+    float depthBias = 0.0f;
+
+    // SoA per cluster, indexed like GetClusterIndex so four neighbours in a row are contiguous
+    std::vector<float> boxMinX, boxMinY, boxMinZ;
+    std::vector<float> boxMaxX, boxMaxY, boxMaxZ;
+    std::vector<float> sphereX, sphereY, sphereZ, sphereRadius;
+
+    std::vector<LightBounds> lightBounds;
+
+    // lights touching each slice, sliceOffsets[z] .. sliceOffsets[z + 1] in sliceLights
+    std::vector<std::uint32_t> sliceOffsets;
+    std::vector<std::uint32_t> sliceLights;
+
+    std::vector<std::uint32_t> clusterCounts;
+    std::vector<std::uint32_t> clusterSlots; // MAX_LIGHTS_PER_CLUSTER per cluster
+    std::vector<std::uint32_t> rowDropped;   // per slice row, summed into droppedCount
+
+    std::vector<ClusterRange> clusterRanges;
+    std::vector<std::uint32_t> lightIndices;
+    std::uint32_t droppedCount = 0;
+};
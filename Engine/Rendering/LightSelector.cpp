@@ -0,0 +1,123 @@
+#include "LightSelector.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr size_t OBJECTS_PER_JOB = 64;
+
+    XMVECTOR XM_CALLCONV LoadFour(const float *values)
+    {
+        return XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(values));
+    }
+}
+
+void LightSelector::SetLights(const Light *lights, size_t lightCount)
+{
+    size_t paddedCount = (lightCount + 3) & ~size_t(3);
+    positionX.assign(paddedCount, 0.0f);
+    positionY.assign(paddedCount, 0.0f);
+    positionZ.assign(paddedCount, 0.0f);
+    range.assign(paddedCount, 0.0f);
+    inverseRange.assign(paddedCount, 0.0f);
+    intensity.assign(paddedCount, 0.0f);
+
+    for (size_t i = 0; i < lightCount; ++i)
+    {
+        const Light &light = lights[i];
+        if (!(light.range > 0.0f))
+            continue;
+
+        positionX[i] = light.position.x;
+        positionY[i] = light.position.y;
+        positionZ[i] = light.position.z;
+        range[i] = light.range;
+        inverseRange[i] = 1.0f / light.range;
+        intensity[i] = light.intensity;
+    }
+}
+
+void LightSelector::Select(JobSystem *jobSystem, const XMFLOAT4 *spheres, size_t objectCount)
+{
+    selections.resize(objectCount);
+
+    auto selectRange = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            SelectObject(spheres[i], selections[i]);
+    };
+
+    if (jobSystem)
+        jobSystem->ParallelFor(objectCount, OBJECTS_PER_JOB, selectRange);
+    else if (objectCount > 0)
+        selectRange(0, objectCount);
+}
+
+void LightSelector::SelectObject(const XMFLOAT4 &sphere, Selection &selection) const
+{
+    selection.count = 0;
+    if (sphere.w < 0.0f)
+        return;
+
+    // once the list is full a light has to beat the weakest one in it, until then anything that reaches the object
+    float scores[MAX_LIGHTS_PER_OBJECT];
+    std::uint32_t weakest = 0;
+    float threshold = 0.0f;
+    XMVECTOR thresholdVector = XMVectorZero();
+
+    const XMVECTOR centerX = XMVectorReplicate(sphere.x);
+    const XMVECTOR centerY = XMVectorReplicate(sphere.y);
+    const XMVECTOR centerZ = XMVectorReplicate(sphere.z);
+    const XMVECTOR radius = XMVectorReplicate(sphere.w);
+    const XMVECTOR zero = XMVectorZero();
+    const XMVECTOR one = XMVectorReplicate(1.0f);
+
+    XMFLOAT4 blockScores;
+    const size_t lightCount = positionX.size();
+    for (size_t i = 0; i < lightCount; i += 4)
+    {
+        XMVECTOR dx = XMVectorSubtract(LoadFour(&positionX[i]), centerX);
+        XMVECTOR dy = XMVectorSubtract(LoadFour(&positionY[i]), centerY);
+        XMVECTOR dz = XMVectorSubtract(LoadFour(&positionZ[i]), centerZ);
+        XMVECTOR distanceSq = XMVectorMultiplyAdd(dz, dz, XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dx, dx)));
+
+        // most lights don't reach most objects, those blocks are rejected before the square root
+        XMVECTOR reach = XMVectorAdd(LoadFour(&range[i]), radius);
+        if (XMVector4EqualInt(XMVectorLess(distanceSq, XMVectorMultiply(reach, reach)), zero))
+            continue;
+
+        // distance to the closest point of the sphere, 0 inside it
+        XMVECTOR distance = XMVectorMax(XMVectorSubtract(XMVectorSqrt(distanceSq), radius), zero);
+
+        // same falloff as the shader, unused and padding entries have a 0 intensity so they never score
+        XMVECTOR falloff = XMVectorMax(XMVectorSubtract(one, XMVectorMultiply(distance, LoadFour(&inverseRange[i]))), zero);
+        XMVECTOR score = XMVectorMultiply(LoadFour(&intensity[i]), XMVectorMultiply(falloff, falloff));
+
+        // most blocks can't beat the weakest light already picked, they're skipped without looking at the lanes
+        if (XMVector4EqualInt(XMVectorGreater(score, thresholdVector), zero))
+            continue;
+
+        XMStoreFloat4(&blockScores, score);
+        const float *laneScores = &blockScores.x;
+        for (std::uint32_t lane = 0; lane < 4; ++lane)
+        {
+            float laneScore = laneScores[lane];
+            if (!(laneScore > threshold))
+                continue;
+
+            std::uint32_t entry = selection.count < MAX_LIGHTS_PER_OBJECT ? selection.count++ : weakest;
+            scores[entry] = laneScore;
+            selection.lights[entry] = static_cast<std::uint32_t>(i) + lane;
+
+            if (selection.count < MAX_LIGHTS_PER_OBJECT)
+                continue;
+
+            weakest = static_cast<std::uint32_t>(std::min_element(scores, scores + MAX_LIGHTS_PER_OBJECT) - scores);
+            threshold = scores[weakest];
+            thresholdVector = XMVectorReplicate(threshold);
+        }
+    }
+
+    std::sort(selection.lights, selection.lights + selection.count);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "../Core/JobSystem.h"
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class LightSelector
+ * @brief Picks the few most important lights for each object, for short per draw light lists
+ *
+ * Importance is the light's intensity times its attenuation at the object's bounding sphere, using the same falloff
+ * as the shader: (1 - distance / range)^2, with the distance measured to the closest point of the sphere. Lights
+ * that don't reach the sphere are never picked. Lights are scored four at a time from SoA arrays and objects are
+ * spread over the job system, each object keeps its best MAX_LIGHTS_PER_OBJECT.
+ *
+ * Usage: SetLights when the lights changed, then Select with the bounding spheres of the frame's objects.
+ */
+class LightSelector
+{
+public:
+    static constexpr std::uint32_t MAX_LIGHTS_PER_OBJECT = 8;
+
+    // world space, a range of 0 marks an unused entry
+    struct Light
+    {
+        DirectX::XMFLOAT3 position;
+        float range;
+        float intensity;
+    };
+
+    // the picked lights as indices into the SetLights array, in ascending order
+    struct Selection
+    {
+        std::uint32_t count;
+        std::uint32_t lights[MAX_LIGHTS_PER_OBJECT];
+    };
+
+    /** @brief Copies the lights into the SoA arrays the scoring reads */
+    void SetLights(const Light *lights, size_t lightCount);
+
+    /**
+     * @brief Picks the lights of every object
+     * @param spheres World space center in xyz and radius in w, objects with a negative radius get no lights
+     * @param jobSystem Spreads the objects over its threads, nullptr runs everything on the calling thread
+     */
+    void Select(JobSystem *jobSystem, const DirectX::XMFLOAT4 *spheres, size_t objectCount);
+
+    const std::vector<Selection> &GetSelections() const { return selections; }
+
+private:
+    void SelectObject(const DirectX::XMFLOAT4 &sphere, Selection &selection) const;
+
+    // padded to a multiple of four with lights that score 0
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> range;
+    std::vector<float> inverseRange;
+    std::vector<float> intensity;
+
+    std::vector<Selection> selections;
+};
@@ -1,7 +1,52 @@
 #include "LightingManager.h"
 #include "../ECS/Components/TransformComponent.h"
 #include <DirectXMath.h>
-#include "../Resources/ResourceManager.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // a few clean slots between two dirty ones are cheaper to send again than another UpdateSubresource
+    constexpr std::uint32_t MAX_MERGE_GAP = 4;
+
+    // the shader doesn't use the ambient color, only diffuse goes up
+    DirectX::XMFLOAT3 ToColor(const DirectX::XMFLOAT4 &color)
+    {
+        return DirectX::XMFLOAT3(color.x, color.y, color.z);
+    }
+
+    // directional lights aren't clustered, range 0 keeps them out
+    void Pack(const DirectionalLightComponent &light, DirectionalLightData &data, LightClusterer::Light &shape)
+    {
+        data = {};
+        DirectX::XMStoreFloat3(&data.toLight, DirectX::XMVector3Normalize(DirectX::XMVectorNegate(DirectX::XMLoadFloat3(&light.direction))));
+        data.intensity = light.intensity;
+        data.color = ToColor(light.diffuseColor);
+        shape = {};
+    }
+
+    void Pack(const PointLightComponent &light, PointLightData &data, LightClusterer::Light &shape)
+    {
+        data.position = light.position;
+        data.range = light.range;
+        data.color = ToColor(light.diffuseColor);
+        data.intensity = light.intensity;
+        shape = {light.position, light.range, DirectX::XMFLOAT3(0.0f, 0.0f, 1.0f), -1.0f};
+    }
+
+    void Pack(const SpotLightComponent &light, SpotLightData &data, LightClusterer::Light &shape)
+    {
+        data = {};
+        data.position = light.position;
+        data.range = light.range;
+        data.color = ToColor(light.diffuseColor);
+        data.intensity = light.intensity;
+        DirectX::XMStoreFloat3(&data.direction, DirectX::XMVector3Normalize(DirectX::XMLoadFloat3(&light.direction)));
+        data.cosOuterCone = cosf(light.outerConeAngle);
+        data.cosInnerCone = cosf(light.innerConeAngle);
+        shape = {light.position, light.range, data.direction, data.cosOuterCone};
+    }
+}
 
 LightingManager::LightingManager(Microsoft::WRL::ComPtr<ID3D11Device> device,
                                  Microsoft::WRL::ComPtr<ID3D11DeviceContext> context,
@@ -16,103 +61,353 @@ LightingManager::~LightingManager()
 
 bool LightingManager::Initialize()
 {
+    resourceManager = std::make_shared<ResourceManager>(device.Get(), context.Get());
+
     LightBuffer lightData = {};
+    lightConstantBuffer = resourceManager->CreateConstantBuffer(sizeof(LightBuffer), &lightData);
+    if (!lightConstantBuffer)
+        return false;
+
+    // the views have to exist before the first Update, even with no lights in the scene
+    ClusterLightRange noRange = {};
+    std::uint32_t noIndex = 0;
+    return UploadDirtyLights(directionalLights) && UploadDirtyLights(pointLights) && UploadDirtyLights(spotLights) &&
+           UploadStructuredBuffer(&noRange, sizeof(ClusterLightRange), 1, clusterRangeBuffer, clusterRangeView, clusterRangeCapacity) &&
+           UploadStructuredBuffer(&noIndex, sizeof(std::uint32_t), 1, clusterIndexBuffer, clusterIndexView, clusterIndexCapacity);
+}
+
+bool LightingManager::UploadStructuredBuffer(const void *data, UINT elementSize, UINT elementCount,
+                                             Microsoft::WRL::ComPtr<ID3D11Buffer> &buffer,
+                                             Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> &view, UINT &capacity)
+{
+    if (elementCount == 0)
+        return true;
 
-    // set some default values for all lights
-    // not sure if i want them all rn but it's okay
-    for (int i = 0; i < MAX_LIGHTS; i++)
+    if (elementCount > capacity)
     {
-        lightData.lights[i].ambientColor = DirectX::XMFLOAT4(0.1f, 0.1f, 0.1f, 1.0f);
-        lightData.lights[i].diffuseColor = DirectX::XMFLOAT4(0.8f, 0.8f, 0.8f, 1.0f);
-        lightData.lights[i].lightDirection = DirectX::XMFLOAT3(0.0f, -1.0f, 1.0f);
-        lightData.lights[i].padding1 = 0.0f;
-        lightData.lights[i].lightPosition = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
-        lightData.lights[i].lightRange = 100.0f;
-        lightData.lights[i].spotInnerCone = cosf(DirectX::XMConvertToRadians(30.0f));
-        lightData.lights[i].spotOuterCone = cosf(DirectX::XMConvertToRadians(45.0f));
-        lightData.lights[i].lightType = 0;
-        lightData.lights[i].lightIntensity = 1.0f;
-    }
+        UINT newCapacity = std::max<UINT>(capacity, 64);
+        while (newCapacity < elementCount)
+            newCapacity *= 2;
+
+        buffer = resourceManager->CreateDynamicStructuredBuffer(elementSize, newCapacity);
+        view = buffer ? resourceManager->CreateBufferView(buffer, newCapacity) : nullptr;
+        if (!view)
+        {
+            capacity = 0;
+            return false;
+        }
 
-    lightData.activeLightCount = 0;
+        capacity = newCapacity;
+    }
 
-    auto resourceManager = std::make_shared<ResourceManager>(device.Get(), context.Get());
-    lightConstantBuffer = resourceManager->CreateConstantBuffer(sizeof(LightBuffer), &lightData);
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (FAILED(context->Map(buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+        return false;
 
-    return lightConstantBuffer != nullptr;
+    std::memcpy(mapped.pData, data, static_cast<size_t>(elementSize) * elementCount);
+    context->Unmap(buffer.Get(), 0);
+    return true;
 }
 
-void LightingManager::Update()
+template <typename T>
+bool LightingManager::UploadDirtyLights(LightPool<T> &pool)
 {
-    LightBuffer lightData = {};
-    int lightIndex = 0;
-
-    // process each light type separately
+    constexpr UINT stride = static_cast<UINT>(sizeof(T));
+    UINT slotCount = static_cast<UINT>(pool.packed.size());
 
-    auto directionalLights = registry.GetEntitiesWith<DirectionalLightComponent>();
-    for (auto entity : directionalLights)
+    if (!pool.buffer || slotCount > pool.capacity)
     {
-        if (lightIndex >= MAX_LIGHTS)
-            break;
+        UINT newCapacity = std::max<UINT>(pool.capacity, 64);
+        while (newCapacity < slotCount)
+            newCapacity *= 2;
 
-        auto *light = registry.GetComponent<DirectionalLightComponent>(entity);
-        if (light && light->isEnabled)
+        pool.buffer = resourceManager->CreateStructuredBuffer(stride, newCapacity);
+        pool.view = pool.buffer ? resourceManager->CreateBufferView(pool.buffer, newCapacity) : nullptr;
+        if (!pool.view)
         {
-            lightData.lights[lightIndex].ambientColor = light->ambientColor;
-            lightData.lights[lightIndex].diffuseColor = light->diffuseColor;
-            lightData.lights[lightIndex].lightIntensity = light->intensity;
-            lightData.lights[lightIndex].lightType = static_cast<int>(light->GetLightType());
-            lightData.lights[lightIndex].lightDirection = light->direction;
-            lightIndex++;
+            // tries again next frame, and sends everything then
+            pool.buffer = nullptr;
+            pool.capacity = 0;
+            return false;
         }
+
+        pool.capacity = newCapacity;
+
+        // the new buffer starts out empty, so every slot goes up once
+        pool.dirtySlots.clear();
+        if (slotCount != 0)
+        {
+            D3D11_BOX box = {0, 0, 0, slotCount * stride, 1, 1};
+            context->UpdateSubresource(pool.buffer.Get(), 0, &box, pool.packed.data(), 0, 0);
+        }
+        return true;
+    }
+
+    if (pool.dirtySlots.empty())
+        return true;
+
+    std::sort(pool.dirtySlots.begin(), pool.dirtySlots.end());
+
+    for (size_t first = 0; first < pool.dirtySlots.size();)
+    {
+        size_t last = first;
+        while (last + 1 < pool.dirtySlots.size() && pool.dirtySlots[last + 1] - pool.dirtySlots[last] <= MAX_MERGE_GAP)
+            ++last;
+
+        UINT begin = pool.dirtySlots[first];
+        UINT end = pool.dirtySlots[last] + 1;
+        D3D11_BOX box = {begin * stride, 0, 0, end * stride, 1, 1};
+        context->UpdateSubresource(pool.buffer.Get(), 0, &box, &pool.packed[begin], 0, 0);
+
+        first = last + 1;
     }
 
-    auto pointLights = registry.GetEntitiesWith<PointLightComponent>();
-    for (auto entity : pointLights)
+    pool.dirtySlots.clear();
+    return true;
+}
+
+template <typename T>
+std::uint32_t LightingManager::AllocateSlot(LightPool<T> &pool, EntityID owner)
+{
+    std::uint32_t slot;
+    if (!pool.freeSlots.empty())
     {
-        if (lightIndex >= MAX_LIGHTS)
-            break;
+        slot = pool.freeSlots.back();
+        pool.freeSlots.pop_back();
+    }
+    else
+    {
+        slot = static_cast<std::uint32_t>(pool.slots.size());
+        pool.slots.emplace_back();
+        pool.packed.emplace_back();
+        pool.shapes.emplace_back();
+    }
 
-        auto *light = registry.GetComponent<PointLightComponent>(entity);
-        if (light && light->isEnabled)
+    pool.slots[slot].owner = owner;
+    ++pool.liveCount;
+    isLayoutChanged = true;
+    return slot;
+}
+
+template <typename T>
+void LightingManager::FreeUnseenSlots(LightPool<T> &pool)
+{
+    // removed, disabled, or its entity was destroyed
+    for (std::uint32_t slot = 0; slot < static_cast<std::uint32_t>(pool.slots.size()); ++slot)
+    {
+        SlotInfo &info = pool.slots[slot];
+        if (info.owner == INVALID_ENTITY || info.seenFrame == frameIndex)
+            continue;
+
+        info.owner = INVALID_ENTITY;
+        pool.shapes[slot] = {};
+        pool.freeSlots.push_back(slot);
+        --pool.liveCount;
+        isLayoutChanged = true;
+    }
+}
+
+template <typename TComponent, typename T>
+void LightingManager::SyncLights(LightPool<T> &pool)
+{
+    pool.seenCount = 0;
+
+    for (auto [entity, light] : registry.View<TComponent>())
+    {
+        if (!light.isEnabled)
+            continue;
+
+        // the slot stored on the component only counts if the pool still agrees it's this light's
+        std::uint32_t slot = light.lightSlot;
+        bool isOwned = slot < pool.slots.size() && pool.slots[slot].owner == entity;
+        if (!isOwned)
         {
-            lightData.lights[lightIndex].ambientColor = light->ambientColor;
-            lightData.lights[lightIndex].diffuseColor = light->diffuseColor;
-            lightData.lights[lightIndex].lightIntensity = light->intensity;
-            lightData.lights[lightIndex].lightType = static_cast<int>(light->GetLightType());
-            lightData.lights[lightIndex].lightPosition = light->position;
-            lightData.lights[lightIndex].lightRange = light->range;
-            lightIndex++;
+            slot = AllocateSlot(pool, entity);
+            light.lightSlot = slot;
         }
+
+        SlotInfo &info = pool.slots[slot];
+        info.seenFrame = frameIndex;
+        ++pool.seenCount;
+
+        if (isOwned && info.version == light.version)
+            continue;
+
+        info.version = light.version;
+
+        LightClusterer::Light shape;
+        Pack(light, pool.packed[slot], shape);
+        if (std::memcmp(&shape, &pool.shapes[slot], sizeof(shape)) != 0)
+        {
+            pool.shapes[slot] = shape;
+            areShapesChanged = true;
+        }
+
+        pool.dirtySlots.push_back(slot);
+        ++repackedCount;
     }
 
-    auto spotLights = registry.GetEntitiesWith<SpotLightComponent>();
-    for (auto entity : spotLights)
+    if (pool.seenCount != pool.liveCount)
+        FreeUnseenSlots(pool);
+}
+
+void LightingManager::BuildClusterLists()
+{
+    const auto &clusterRanges = clusterer.GetClusterRanges();
+    const auto &lightIndices = clusterer.GetLightIndices();
+
+    // clusterer indices below this are point slots, the rest are spot slots shifted by it
+    const std::uint32_t spotBase = static_cast<std::uint32_t>(pointLights.shapes.size());
+    const std::uint32_t directionalCount = static_cast<std::uint32_t>(directionalSlots.size());
+
+    clusterLightIndices.resize(directionalCount + lightIndices.size());
+    std::copy(directionalSlots.begin(), directionalSlots.end(), clusterLightIndices.begin());
+
+    // a cluster's indices keep the input order, so its point lights all come before its spot lights
+    clusterLightRanges.resize(clusterRanges.size());
+    for (size_t cluster = 0; cluster < clusterRanges.size(); ++cluster)
     {
-        if (lightIndex >= MAX_LIGHTS)
-            break;
+        const LightClusterer::ClusterRange &range = clusterRanges[cluster];
+        const std::uint32_t *first = lightIndices.data() + range.offset;
+        const std::uint32_t *last = first + range.count;
+        const std::uint32_t *spots = std::lower_bound(first, last, spotBase);
+
+        std::uint32_t *out = clusterLightIndices.data() + directionalCount + range.offset;
+        out = std::copy(first, spots, out);
+        for (const std::uint32_t *index = spots; index != last; ++index)
+            *out++ = *index - spotBase;
 
-        auto *light = registry.GetComponent<SpotLightComponent>(entity);
-        if (light && light->isEnabled)
+        std::uint32_t pointCount = static_cast<std::uint32_t>(spots - first);
+        clusterLightRanges[cluster] = {range.offset, pointCount, range.count - pointCount};
+    }
+}
+
+void LightingManager::Update(JobSystem *jobSystem, const DirectX::XMMATRIX &view, const DirectX::XMMATRIX &projection, UINT width, UINT height)
+{
+    ++frameIndex;
+    repackedCount = 0;
+    isLayoutChanged = false;
+    areShapesChanged = false;
+
+    // with nothing changed this only compares versions, nothing is packed or uploaded
+    SyncLights<DirectionalLightComponent>(directionalLights);
+    bool isDirectionalLayoutChanged = isLayoutChanged;
+    SyncLights<PointLightComponent>(pointLights);
+    SyncLights<SpotLightComponent>(spotLights);
+
+    if (isDirectionalLayoutChanged)
+    {
+        directionalSlots.clear();
+        for (std::uint32_t slot = 0; slot < static_cast<std::uint32_t>(directionalLights.slots.size()); ++slot)
         {
-            lightData.lights[lightIndex].ambientColor = light->ambientColor;
-            lightData.lights[lightIndex].diffuseColor = light->diffuseColor;
-            lightData.lights[lightIndex].lightIntensity = light->intensity;
-            lightData.lights[lightIndex].lightType = static_cast<int>(light->GetLightType());
-            lightData.lights[lightIndex].lightPosition = light->position;
-            lightData.lights[lightIndex].lightDirection = light->direction;
-            lightData.lights[lightIndex].lightRange = light->range;
-            lightData.lights[lightIndex].spotInnerCone = cosf(light->innerConeAngle);
-            lightData.lights[lightIndex].spotOuterCone = cosf(light->outerConeAngle);
-            lightIndex++;
+            if (directionalLights.slots[slot].owner != INVALID_ENTITY)
+                directionalSlots.push_back(slot);
         }
     }
 
-    lightData.activeLightCount = lightIndex;
+    // intensity changes matter to the selector as well, not just moves
+    if (isLayoutChanged || !pointLights.dirtySlots.empty() || !spotLights.dirtySlots.empty())
+        areSelectorLightsDirty = true;
+
+    UploadDirtyLights(directionalLights);
+    UploadDirtyLights(pointLights);
+    UploadDirtyLights(spotLights);
+
+    // the clusters only depend on the clustered lights' shapes and the camera
+    DirectX::XMFLOAT4X4 viewMatrix;
+    DirectX::XMFLOAT4X4 projectionMatrix;
+    DirectX::XMStoreFloat4x4(&viewMatrix, view);
+    DirectX::XMStoreFloat4x4(&projectionMatrix, projection);
+
+    bool isCameraChanged = !hasClusters || width != clusterWidth || height != clusterHeight ||
+                           std::memcmp(&viewMatrix, &clusterView, sizeof(viewMatrix)) != 0 ||
+                           std::memcmp(&projectionMatrix, &clusterProjection, sizeof(projectionMatrix)) != 0;
+    if (!isCameraChanged && !isLayoutChanged && !areShapesChanged)
+        return;
+
+    clusterView = viewMatrix;
+    clusterProjection = projectionMatrix;
+    clusterWidth = width;
+    clusterHeight = height;
+
+    clusterShapes.assign(pointLights.shapes.begin(), pointLights.shapes.end());
+    clusterShapes.insert(clusterShapes.end(), spotLights.shapes.begin(), spotLights.shapes.end());
+
+    clusterer.SetProjection(projection);
+    clusterer.Assign(jobSystem, view, clusterShapes.data(), clusterShapes.size());
+    BuildClusterLists();
+
+    hasClusters =
+        UploadStructuredBuffer(clusterLightRanges.data(), sizeof(ClusterLightRange), static_cast<UINT>(clusterLightRanges.size()),
+                               clusterRangeBuffer, clusterRangeView, clusterRangeCapacity) &&
+        UploadStructuredBuffer(clusterLightIndices.data(), sizeof(std::uint32_t), static_cast<UINT>(clusterLightIndices.size()),
+                               clusterIndexBuffer, clusterIndexView, clusterIndexCapacity);
+
+    // the view matrix's third column gives the view space depth of a world position
+    LightBuffer lightData = {};
+    lightData.viewDepthPlane = DirectX::XMFLOAT4(viewMatrix._13, viewMatrix._23, viewMatrix._33, viewMatrix._43);
+    lightData.tileScale = DirectX::XMFLOAT2(static_cast<float>(LightClusterer::GRID_X) / std::max<UINT>(width, 1),
+                                            static_cast<float>(LightClusterer::GRID_Y) / std::max<UINT>(height, 1));
+    lightData.depthScale = clusterer.GetDepthScale();
+    lightData.depthBias = clusterer.GetDepthBias();
+    lightData.directionalLightCount = static_cast<std::uint32_t>(directionalSlots.size());
+    lightData.clusterCountX = LightClusterer::GRID_X;
+    lightData.clusterCountY = LightClusterer::GRID_Y;
+    lightData.clusterCountZ = LightClusterer::GRID_Z;
     context->UpdateSubresource(lightConstantBuffer.Get(), 0, nullptr, &lightData, 0, 0);
 }
 
-void LightingManager::Apply(UINT slot)
+void LightingManager::SelectObjectLights(JobSystem *jobSystem, const DirectX::XMFLOAT4 *spheres, size_t objectCount)
 {
-    context->PSSetConstantBuffers(slot, 1, lightConstantBuffer.GetAddressOf());
-}
\ No newline at end of file
+    static_assert(LightSelector::MAX_LIGHTS_PER_OBJECT == sizeof(ObjectLightData::slots) / sizeof(std::uint32_t),
+                  "an object's light list has to fit ObjectLightData");
+
+    if (areSelectorLightsDirty)
+    {
+        // free slots keep range 0 in their shape, the selector never picks them
+        selectorLights.clear();
+        for (size_t slot = 0; slot < pointLights.shapes.size(); ++slot)
+        {
+            const LightClusterer::Light &shape = pointLights.shapes[slot];
+            selectorLights.push_back({shape.position, shape.range, pointLights.packed[slot].intensity});
+        }
+
+        for (size_t slot = 0; slot < spotLights.shapes.size(); ++slot)
+        {
+            const LightClusterer::Light &shape = spotLights.shapes[slot];
+            selectorLights.push_back({shape.position, shape.range, spotLights.packed[slot].intensity});
+        }
+
+        selector.SetLights(selectorLights.data(), selectorLights.size());
+        areSelectorLightsDirty = false;
+    }
+
+    selector.Select(jobSystem, spheres, objectCount);
+
+    // a selection is sorted, so its point slots come first and the spot slots (shifted by spotBase) after them
+    const std::uint32_t spotBase = static_cast<std::uint32_t>(pointLights.shapes.size());
+    const auto &selections = selector.GetSelections();
+    objectLights.resize(objectCount);
+    for (size_t object = 0; object < objectCount; ++object)
+    {
+        const LightSelector::Selection &selection = selections[object];
+        ObjectLightData &data = objectLights[object];
+        data = {};
+        data.isEnabled = spheres[object].w >= 0.0f ? 1u : 0u;
+
+        for (std::uint32_t i = 0; i < selection.count; ++i)
+        {
+            std::uint32_t light = selection.lights[i];
+            if (light < spotBase)
+            {
+                data.slots[i] = light;
+                ++data.pointCount;
+            }
+            else
+            {
+                data.slots[i] = light - spotBase;
+                ++data.spotCount;
+            }
+        }
+    }
+}
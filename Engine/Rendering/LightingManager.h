@@ -3,26 +3,147 @@
 #include <d3d11.h>
 #include <wrl/client.h>
 #include <DirectXMath.h>
+#include <cstdint>
 #include <memory>
+#include <vector>
 #include "../ECS/Components/LightComponent.h"
 #include "../ECS/Registry.h"
+#include "../Core/JobSystem.h"
+#include "../Resources/ResourceManager.h"
 #include "Buffers.h"
+#include "LightClusterer.h"
+#include "LightSelector.h"
 
+// every enabled light has a stable slot in its type's packed array that lives on the gpu, a light is only re-packed
+// and uploaded when its component's version changed, and the clusters are only rebuilt when a light or the camera moved
 class LightingManager
 {
 public:
+    // shader resource slots of the light data, after the material's diffuse (t0) and normal (t1) maps
+    static constexpr UINT DIRECTIONAL_LIGHT_SLOT = 2;
+    static constexpr UINT POINT_LIGHT_SLOT = 3;
+    static constexpr UINT SPOT_LIGHT_SLOT = 4;
+    static constexpr UINT CLUSTER_RANGE_SLOT = 5;
+    static constexpr UINT CLUSTER_INDEX_SLOT = 6;
+
     LightingManager(Microsoft::WRL::ComPtr<ID3D11Device> device,
                     Microsoft::WRL::ComPtr<ID3D11DeviceContext> context,
                     Registry &registry);
     ~LightingManager();
 
     bool Initialize();
-    void Update();
-    void Apply(UINT slot);
+
+    // syncs the packed lights with the components and sorts the point / spot ones into the clusters of the camera's frustum
+    void Update(JobSystem *jobSystem, const DirectX::XMMATRIX &view, const DirectX::XMMATRIX &projection, UINT width, UINT height);
+
+    // the constant buffer (b1) and the light / cluster lists, bind them all for the pixel shader
+    ID3D11Buffer *GetLightBuffer() const { return lightConstantBuffer.Get(); }
+    ID3D11ShaderResourceView *GetDirectionalLightView() const { return directionalLights.view.Get(); }
+    ID3D11ShaderResourceView *GetPointLightView() const { return pointLights.view.Get(); }
+    ID3D11ShaderResourceView *GetSpotLightView() const { return spotLights.view.Get(); }
+    ID3D11ShaderResourceView *GetClusterRangeView() const { return clusterRangeView.Get(); }
+    ID3D11ShaderResourceView *GetClusterIndexView() const { return clusterIndexView.Get(); }
+
+    /**
+     * @brief Picks each object's most important point and spot lights, for draws that carry their own light list
+     * @param spheres World space bounding spheres (center, radius), a negative radius keeps the object on the clusters
+     */
+    void SelectObjectLights(JobSystem *jobSystem, const DirectX::XMFLOAT4 *spheres, size_t objectCount);
+
+    // the light list of an object from the last SelectObjectLights, same order as the spheres
+    const ObjectLightData &GetObjectLights(size_t object) const { return objectLights[object]; }
+
+    size_t GetLightCount() const { return directionalLights.liveCount + pointLights.liveCount + spotLights.liveCount; }
+    // lights whose component changed since the last Update, 0 for static lighting
+    size_t GetRepackedCount() const { return repackedCount; }
+    std::uint32_t GetDroppedLightCount() const { return clusterer.GetDroppedCount(); }
 
 private:
+    // who owns a slot of a pool
+    struct SlotInfo
+    {
+        EntityID owner = INVALID_ENTITY; // INVALID_ENTITY for a free slot
+        std::uint32_t version = 0;       // component version the slot was packed from
+        std::uint64_t seenFrame = 0;
+    };
+
+    // the packed lights of one type and the structured buffer they're mirrored to
+    template <typename T>
+    struct LightPool
+    {
+        std::vector<T> packed; // indexed by slot, a freed slot keeps its old data until it's handed out again
+        std::vector<LightClusterer::Light> shapes; // range 0 for free slots (and all directional ones), the clusterer skips those
+        std::vector<SlotInfo> slots;
+        std::vector<std::uint32_t> freeSlots;
+        std::vector<std::uint32_t> dirtySlots;
+        size_t liveCount = 0;
+        size_t seenCount = 0; // live slots the current Update found a component for
+
+        // default usage, written a dirty range at a time
+        Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> view;
+        UINT capacity = 0;
+    };
+
+    // one pass per component type, the pool decides the light type without asking the component
+    template <typename TComponent, typename T>
+    void SyncLights(LightPool<T> &pool);
+    template <typename T>
+    std::uint32_t AllocateSlot(LightPool<T> &pool, EntityID owner);
+    template <typename T>
+    void FreeUnseenSlots(LightPool<T> &pool);
+
+    // uploads the dirty slots as merged ranges, or everything when the buffer had to grow
+    template <typename T>
+    bool UploadDirtyLights(LightPool<T> &pool);
+
+    // rewrites a structured buffer, recreating it (doubling) when the data doesn't fit
+    bool UploadStructuredBuffer(const void *data, UINT elementSize, UINT elementCount,
+                                Microsoft::WRL::ComPtr<ID3D11Buffer> &buffer,
+                                Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> &view, UINT &capacity);
+
+    // turns the clusterer's output into per cluster point / spot ranges and the index list the shader reads
+    void BuildClusterLists();
+
     Microsoft::WRL::ComPtr<ID3D11Device> device;
     Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
     Registry &registry;
+    std::shared_ptr<ResourceManager> resourceManager;
+
     Microsoft::WRL::ComPtr<ID3D11Buffer> lightConstantBuffer;
-};
\ No newline at end of file
+
+    LightPool<DirectionalLightData> directionalLights;
+    LightPool<PointLightData> pointLights;
+    LightPool<SpotLightData> spotLights;
+
+    Microsoft::WRL::ComPtr<ID3D11Buffer> clusterRangeBuffer;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> clusterRangeView;
+    UINT clusterRangeCapacity = 0;
+
+    Microsoft::WRL::ComPtr<ID3D11Buffer> clusterIndexBuffer;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> clusterIndexView;
+    UINT clusterIndexCapacity = 0;
+
+    LightClusterer clusterer;
+    std::vector<LightClusterer::Light> clusterShapes; // the point pool's shapes, then the spot pool's
+    std::vector<std::uint32_t> directionalSlots;       // go in front of the cluster index list, lit everywhere
+    std::vector<ClusterLightRange> clusterLightRanges;
+    std::vector<std::uint32_t> clusterLightIndices; // directional slots, then each cluster's point slots and spot slots
+
+    LightSelector selector;
+    std::vector<LightSelector::Light> selectorLights; // point slots then spot slots, like clusterShapes
+    std::vector<ObjectLightData> objectLights;
+    bool areSelectorLightsDirty = true; // a point or spot light changed since they were handed to the selector
+
+    size_t repackedCount = 0;
+    std::uint64_t frameIndex = 0;
+    bool isLayoutChanged = false;  // a slot was handed out or freed
+    bool areShapesChanged = false; // a clustered light moved, turned or changed range
+
+    // camera the clusters were last built for
+    DirectX::XMFLOAT4X4 clusterView = {};
+    DirectX::XMFLOAT4X4 clusterProjection = {};
+    UINT clusterWidth = 0;
+    UINT clusterHeight = 0;
+    bool hasClusters = false;
+};
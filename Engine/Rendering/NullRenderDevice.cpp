@@ -0,0 +1,291 @@
+#include "NullRenderDevice.h"
+#include <algorithm>
+#include <cstring>
+
+// writes commands instead of issuing them, otherwise mirrors D3D11CommandContext (same cache, same skipped binds)
+class NullRenderDevice::Context : public ICommandContext
+{
+public:
+    // immediate: writes straight into the frame, sharing the device's cache
+    Context(CommandStream &frame, RenderStateCache &stateCache)
+        : stream(frame), frame(frame), isDeferred(false), stateCache(stateCache)
+    {
+    }
+
+    // deferred: writes into its own stream, Execute appends that to the frame
+    explicit Context(CommandStream &frame)
+        : stream(ownStream), frame(frame), isDeferred(true), stateCache(ownStateCache)
+    {
+    }
+
+    void Begin() override
+    {
+        if (isDeferred)
+        {
+            stateCache.Invalidate();
+            ownStream.Clear();
+        }
+    }
+
+    bool Finish() override { return true; }
+
+    void Execute() override
+    {
+        if (!isDeferred)
+            return;
+
+        frame.Append(ownStream);
+        ownStream.Clear();
+    }
+
+    void SetRenderTargets(const void *renderTarget, const void *depthStencil) override
+    {
+        if (stateCache.SetRenderTargets(renderTarget, depthStencil))
+            stream.Write(CommandStream::Opcode::SetRenderTargets, {GetResourceID(renderTarget), GetResourceID(depthStencil)});
+    }
+
+    void SetViewport(std::uint32_t width, std::uint32_t height) override
+    {
+        if (stateCache.SetViewport(width, height))
+            stream.Write(CommandStream::Opcode::SetViewport, {width, height});
+    }
+
+    void SetRasterizerState(const void *state) override
+    {
+        if (stateCache.SetRasterizerState(state))
+            stream.Write(CommandStream::Opcode::SetRasterizerState, {GetResourceID(state)});
+    }
+
+    void SetDepthStencilState(const void *state, std::uint32_t stencilRef) override
+    {
+        if (stateCache.SetDepthStencilState(state, stencilRef))
+            stream.Write(CommandStream::Opcode::SetDepthStencilState, {GetResourceID(state), stencilRef});
+    }
+
+    void SetPrimitiveTopology(std::uint32_t topology) override
+    {
+        if (stateCache.SetPrimitiveTopology(topology))
+            stream.Write(CommandStream::Opcode::SetPrimitiveTopology, {topology});
+    }
+
+    void SetInputLayout(const void *layout) override
+    {
+        if (stateCache.SetInputLayout(layout))
+            stream.Write(CommandStream::Opcode::SetInputLayout, {GetResourceID(layout)});
+    }
+
+    void SetVertexShader(const void *shader) override
+    {
+        if (stateCache.SetVertexShader(shader))
+            stream.Write(CommandStream::Opcode::SetVertexShader, {GetResourceID(shader)});
+    }
+
+    void SetPixelShader(const void *shader) override
+    {
+        if (stateCache.SetPixelShader(shader))
+            stream.Write(CommandStream::Opcode::SetPixelShader, {GetResourceID(shader)});
+    }
+
+    void SetVertexBuffer(std::uint32_t slot, const void *buffer, std::uint32_t stride, std::uint32_t offset) override
+    {
+        if (stateCache.SetVertexBuffer(slot, buffer, stride, offset))
+            stream.Write(CommandStream::Opcode::SetVertexBuffer, {slot, GetResourceID(buffer), stride, offset});
+    }
+
+    void SetIndexBuffer(const void *buffer, std::uint32_t format, std::uint32_t offset) override
+    {
+        if (stateCache.SetIndexBuffer(buffer, format, offset))
+            stream.Write(CommandStream::Opcode::SetIndexBuffer, {GetResourceID(buffer), format, offset});
+    }
+
+    void SetConstantBuffer(Stage stage, std::uint32_t slot, const void *buffer,
+                           std::uint32_t firstConstant = 0, std::uint32_t constantCount = 0) override
+    {
+        if (!stateCache.SetConstantBuffer(stage, slot, buffer, firstConstant, constantCount))
+            return;
+
+        stream.Write(stage == Stage::Vertex ? CommandStream::Opcode::SetVertexConstantBuffer
+                                            : CommandStream::Opcode::SetPixelConstantBuffer,
+                     {slot, GetResourceID(buffer), firstConstant, constantCount});
+    }
+
+    void SetTexture(std::uint32_t slot, const void *texture) override
+    {
+        if (stateCache.SetTexture(slot, texture))
+            stream.Write(CommandStream::Opcode::SetTexture, {slot, GetResourceID(texture)});
+    }
+
+    void SetSampler(std::uint32_t slot, const void *sampler) override
+    {
+        if (stateCache.SetSampler(slot, sampler))
+            stream.Write(CommandStream::Opcode::SetSampler, {slot, GetResourceID(sampler)});
+    }
+
+    void DrawIndexed(std::uint32_t indexCount, std::uint32_t startIndex = 0, std::int32_t baseVertex = 0) override
+    {
+        stream.Write(CommandStream::Opcode::DrawIndexed, {indexCount, startIndex, static_cast<std::uint32_t>(baseVertex)});
+    }
+
+    void DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount, std::uint32_t startInstance = 0,
+                              std::uint32_t startIndex = 0, std::int32_t baseVertex = 0) override
+    {
+        stream.Write(CommandStream::Opcode::DrawIndexedInstanced,
+                     {indexCount, instanceCount, startInstance, startIndex, static_cast<std::uint32_t>(baseVertex)});
+    }
+
+private:
+    CommandStream ownStream; // deferred only
+    CommandStream &stream;
+    CommandStream &frame;
+    bool isDeferred;
+
+    RenderStateCache ownStateCache; // deferred only
+    RenderStateCache &stateCache;
+};
+
+NullRenderDevice::NullRenderDevice(std::uint32_t width, std::uint32_t height)
+    : width(width), height(height), immediateContext(std::make_unique<Context>(currentFrame, stateCache))
+{
+    backBufferTarget = AddResource(false, 0, nullptr);
+    depthStencilTarget = AddResource(false, 0, nullptr);
+}
+
+NullRenderDevice::~NullRenderDevice() = default;
+
+const void *NullRenderDevice::AddResource(bool isBuffer, std::uint32_t byteWidth, const void *initialData)
+{
+    auto resource = std::make_unique<Resource>();
+    resource->id = nextResourceID++;
+    resource->isBuffer = isBuffer;
+
+    if (isBuffer)
+    {
+        resource->data.resize(byteWidth);
+        if (initialData)
+            std::memcpy(resource->data.data(), initialData, byteWidth);
+    }
+
+    const Resource *handle = resource.get();
+    resources[handle->id] = std::move(resource);
+    return handle;
+}
+
+const void *NullRenderDevice::CreateBuffer(const BufferDesc &desc)
+{
+    if (desc.byteWidth == 0)
+        return nullptr;
+
+    // same rule as the D3D11 backend, immutable buffers need their data up front
+    if ((desc.usage == BufferUsage::Vertex || desc.usage == BufferUsage::Index) && !desc.initialData)
+        return nullptr;
+
+    return AddResource(true, desc.byteWidth, desc.initialData);
+}
+
+const void *NullRenderDevice::CreateTexture(const TextureDesc &desc)
+{
+    if (desc.width == 0 || desc.height == 0)
+        return nullptr;
+
+    return AddResource(false, 0, nullptr);
+}
+
+const void *NullRenderDevice::CreateSamplerState()
+{
+    return AddResource(false, 0, nullptr);
+}
+
+const void *NullRenderDevice::CreateRasterizerState(bool)
+{
+    return AddResource(false, 0, nullptr);
+}
+
+const void *NullRenderDevice::CreateDepthStencilState()
+{
+    return AddResource(false, 0, nullptr);
+}
+
+const void *NullRenderDevice::CreateVertexShader(const void *bytecode, size_t bytecodeLength)
+{
+    return bytecode && bytecodeLength != 0 ? AddResource(false, 0, nullptr) : nullptr;
+}
+
+const void *NullRenderDevice::CreatePixelShader(const void *bytecode, size_t bytecodeLength)
+{
+    return bytecode && bytecodeLength != 0 ? AddResource(false, 0, nullptr) : nullptr;
+}
+
+const void *NullRenderDevice::CreateInputLayout(const VertexElement *elements, std::uint32_t elementCount,
+                                                const void *, size_t)
+{
+    return elements && elementCount != 0 ? AddResource(false, 0, nullptr) : nullptr;
+}
+
+void NullRenderDevice::ReleaseResource(const void *resource)
+{
+    // the targets belong to the device, like a swap chain's
+    if (resource && resource != backBufferTarget && resource != depthStencilTarget)
+        resources.erase(GetResourceID(resource));
+}
+
+bool NullRenderDevice::WriteBuffer(const void *buffer, std::uint32_t offset, const void *data, std::uint32_t size, WriteMode mode)
+{
+    if (!buffer)
+        return false;
+
+    Resource *resource = const_cast<Resource *>(static_cast<const Resource *>(buffer));
+    if (!resource->isBuffer || offset > resource->data.size() || size > resource->data.size() - offset)
+        return false;
+
+    std::memcpy(resource->data.data() + offset, data, size);
+
+    // only the range goes into the stream, the bytes themselves stay in the buffer
+    currentFrame.Write(CommandStream::Opcode::WriteBuffer, {resource->id, offset, size, static_cast<std::uint32_t>(mode)});
+    return true;
+}
+
+ICommandContext &NullRenderDevice::GetImmediateContext()
+{
+    return *immediateContext;
+}
+
+std::unique_ptr<ICommandContext> NullRenderDevice::CreateDeferredContext()
+{
+    return std::make_unique<Context>(currentFrame);
+}
+
+void NullRenderDevice::Clear(const float color[4])
+{
+    std::uint32_t packed = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        float channel = std::min(std::max(color[i], 0.0f), 1.0f);
+        packed |= static_cast<std::uint32_t>(channel * 255.0f + 0.5f) << (i * 8);
+    }
+
+    currentFrame.Write(CommandStream::Opcode::Clear, {packed});
+}
+
+void NullRenderDevice::Present()
+{
+    ++presentedFrameCount;
+    currentFrame.Write(CommandStream::Opcode::Present, {static_cast<std::uint32_t>(presentedFrameCount)});
+
+    // keeps both allocations around, so a steady frame doesn't allocate
+    lastFrame.Swap(currentFrame);
+    currentFrame.Clear();
+}
+
+std::uint32_t NullRenderDevice::GetResourceID(const void *resource)
+{
+    return resource ? static_cast<const Resource *>(resource)->id : 0;
+}
+
+const std::vector<std::uint8_t> *NullRenderDevice::GetBufferData(const void *buffer) const
+{
+    if (!buffer)
+        return nullptr;
+
+    const Resource *resource = static_cast<const Resource *>(buffer);
+    return resource->isBuffer ? &resource->data : nullptr;
+}
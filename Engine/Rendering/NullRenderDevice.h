@@ -0,0 +1,100 @@
+#pragma once
+
+#include "IRenderDevice.h"
+#include "CommandStream.h"
+#include "RenderStateCache.h"
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class NullRenderDevice
+ * @brief IRenderDevice without a GPU, every command is written to a CommandStream instead
+ *
+ * Meant for the headless builds: the frame is built exactly as it would be for D3D11 (binds filtered through a
+ * RenderStateCache the same way), so the CPU cost can be profiled, and the finished frame's stream can be compared
+ * against an earlier one. Resources get sequential IDs starting at 1 (0 is "nothing bound", 1 and 2 are the back buffer and depth buffer), which is what the
+ * stream stores instead of pointers. Buffers keep a CPU copy of their contents, everything else keeps nothing.
+ */
+class NullRenderDevice : public IRenderDevice
+{
+public:
+    explicit NullRenderDevice(std::uint32_t width = 1280, std::uint32_t height = 720);
+    ~NullRenderDevice() override;
+
+    RenderBackend GetBackend() const override { return RenderBackend::Null; }
+    bool SupportsConstantBufferRanges() const override { return true; }
+
+    const void *CreateBuffer(const BufferDesc &desc) override;
+    const void *CreateTexture(const TextureDesc &desc) override;
+    const void *CreateSamplerState() override;
+    const void *CreateRasterizerState(bool wireframe) override;
+    const void *CreateDepthStencilState() override;
+    const void *CreateVertexShader(const void *bytecode, size_t bytecodeLength) override;
+    const void *CreatePixelShader(const void *bytecode, size_t bytecodeLength) override;
+    const void *CreateInputLayout(const VertexElement *elements, std::uint32_t elementCount,
+                                  const void *shaderBytecode, size_t bytecodeLength) override;
+    void ReleaseResource(const void *resource) override;
+
+    bool WriteBuffer(const void *buffer, std::uint32_t offset, const void *data, std::uint32_t size, WriteMode mode) override;
+
+    const void *GetBackBufferTarget() const override { return backBufferTarget; }
+    const void *GetDepthStencilTarget() const override { return depthStencilTarget; }
+    std::uint32_t GetWidth() const override { return width; }
+    std::uint32_t GetHeight() const override { return height; }
+
+    ICommandContext &GetImmediateContext() override;
+    RenderStateCache &GetStateCache() override { return stateCache; }
+    std::unique_ptr<ICommandContext> CreateDeferredContext() override;
+
+    // there's no GPU to wait for, a fence is done as soon as it's signaled
+    void SignalFence(std::uint64_t fence) override { lastFence = fence; }
+    bool IsFenceComplete(std::uint64_t fence, bool) override { return fence <= lastFence; }
+
+    void Clear(const float color[4]) override;
+    void Present() override;
+
+    /** @brief ID the stream uses for a resource, 0 for nullptr */
+    static std::uint32_t GetResourceID(const void *resource);
+
+    /** @brief CPU copy of a buffer's contents, nullptr for anything that isn't a buffer */
+    const std::vector<std::uint8_t> *GetBufferData(const void *buffer) const;
+
+    // the frame being built, and the last one that was presented
+    const CommandStream &GetCurrentFrame() const { return currentFrame; }
+    const CommandStream &GetLastFrame() const { return lastFrame; }
+    std::uint64_t GetPresentedFrameCount() const { return presentedFrameCount; }
+
+    size_t GetResourceCount() const { return resources.size(); }
+
+private:
+    class Context;
+
+    struct Resource
+    {
+        std::uint32_t id;
+        bool isBuffer;
+        std::vector<std::uint8_t> data;
+    };
+
+    const void *AddResource(bool isBuffer, std::uint32_t byteWidth, const void *initialData);
+
+    std::unordered_map<std::uint32_t, std::unique_ptr<Resource>> resources;
+    std::uint32_t nextResourceID = 1;
+
+    // the "swap chain", IDs 1 and 2
+    const void *backBufferTarget;
+    const void *depthStencilTarget;
+    std::uint32_t width;
+    std::uint32_t height;
+
+    std::uint64_t lastFence = 0;
+
+    CommandStream currentFrame;
+    CommandStream lastFrame;
+    std::uint64_t presentedFrameCount = 0;
+
+    RenderStateCache stateCache; // the immediate context's
+    std::unique_ptr<Context> immediateContext;
+};
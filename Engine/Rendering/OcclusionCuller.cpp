@@ -0,0 +1,230 @@
+#include "OcclusionCuller.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+OcclusionCuller::OcclusionCuller(std::uint32_t width, std::uint32_t height)
+{
+    Resize(width, height);
+}
+
+void OcclusionCuller::Resize(std::uint32_t newWidth, std::uint32_t newHeight)
+{
+    tilesX = std::max<std::uint32_t>(1, (newWidth + TILE_SIZE - 1) / TILE_SIZE);
+    tilesY = std::max<std::uint32_t>(1, (newHeight + TILE_SIZE - 1) / TILE_SIZE);
+    width = tilesX * TILE_SIZE;
+    height = tilesY * TILE_SIZE;
+
+    depth.assign(static_cast<size_t>(width) * height, 1.0f);
+    tileMaxDepth.assign(static_cast<size_t>(tilesX) * tilesY, 1.0f);
+}
+
+void OcclusionCuller::BeginFrame(FXMMATRIX newViewProjection)
+{
+    XMStoreFloat4x4(&viewProjection, newViewProjection);
+
+    std::fill(depth.begin(), depth.end(), 1.0f);
+    std::fill(tileMaxDepth.begin(), tileMaxDepth.end(), 1.0f);
+    rasterizedTriangles = 0;
+}
+
+void OcclusionCuller::RenderOccluder(const OccluderGeometry &geometry, FXMMATRIX world)
+{
+    XMMATRIX worldViewProjection = XMMatrixMultiply(world, XMLoadFloat4x4(&viewProjection));
+
+    clipPositions.resize(geometry.positions.size());
+    for (size_t i = 0; i < geometry.positions.size(); ++i)
+        XMStoreFloat4(&clipPositions[i], XMVector3Transform(XMLoadFloat3(&geometry.positions[i]), worldViewProjection));
+
+    auto toScreen = [this](const XMFLOAT4 &clip)
+    {
+        float inverseW = 1.0f / clip.w;
+        return ScreenVertex{(clip.x * inverseW * 0.5f + 0.5f) * static_cast<float>(width),
+                            (0.5f - clip.y * inverseW * 0.5f) * static_cast<float>(height),
+                            clip.z * inverseW};
+    };
+
+    const std::vector<std::uint32_t> &indices = geometry.indices;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const XMFLOAT4 &a = clipPositions[indices[i]];
+        const XMFLOAT4 &b = clipPositions[indices[i + 1]];
+        const XMFLOAT4 &c = clipPositions[indices[i + 2]];
+
+        // in front of the near plane (z < 0 in D3D clip space), no clipping, the triangle is just dropped
+        if (a.z < 0.0f || b.z < 0.0f || c.z < 0.0f)
+            continue;
+
+        RasterizeTriangle(toScreen(a), toScreen(b), toScreen(c));
+    }
+}
+
+void OcclusionCuller::RasterizeTriangle(const ScreenVertex &v0, const ScreenVertex &v1, const ScreenVertex &v2)
+{
+    // twice the signed area, positive for triangles that are clockwise on screen (y points down)
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    if (area <= 0.0f)
+        return;
+
+    float minX = std::floor(std::min({v0.x, v1.x, v2.x}));
+    float maxX = std::ceil(std::max({v0.x, v1.x, v2.x}));
+    float minY = std::floor(std::min({v0.y, v1.y, v2.y}));
+    float maxY = std::ceil(std::max({v0.y, v1.y, v2.y}));
+    if (maxX < 0.0f || maxY < 0.0f || minX >= static_cast<float>(width) || minY >= static_cast<float>(height))
+        return;
+
+    // blocks of four pixels start on a multiple of four, width is a multiple of the tile size so they never overrun a row
+    auto startX = static_cast<std::uint32_t>(std::max(minX, 0.0f)) & ~3u;
+    auto endX = static_cast<std::uint32_t>(std::min(maxX, static_cast<float>(width - 1)));
+    auto startY = static_cast<std::uint32_t>(std::max(minY, 0.0f));
+    auto endY = static_cast<std::uint32_t>(std::min(maxY, static_cast<float>(height - 1)));
+
+    ++rasterizedTriangles;
+
+    // edge function of a -> b: E(p) = A * p.x + B * p.y + C, positive on the inside
+    struct Edge
+    {
+        float a, b, c;
+    };
+    auto makeEdge = [](const ScreenVertex &from, const ScreenVertex &to)
+    {
+        Edge edge;
+        edge.a = from.y - to.y;
+        edge.b = to.x - from.x;
+        edge.c = -(edge.a * from.x + edge.b * from.y);
+        return edge;
+    };
+
+    // E12 weighs v0, E20 weighs v1, E01 weighs v2
+    Edge edges[3] = {makeEdge(v1, v2), makeEdge(v2, v0), makeEdge(v0, v1)};
+
+    // depth is interpolated with the normalized edge functions (barycentrics), folded into one plane equation
+    float inverseArea = 1.0f / area;
+    float zA = (edges[0].a * v0.z + edges[1].a * v1.z + edges[2].a * v2.z) * inverseArea;
+    float zB = (edges[0].b * v0.z + edges[1].b * v1.z + edges[2].b * v2.z) * inverseArea;
+    float zC = (edges[0].c * v0.z + edges[1].c * v1.z + edges[2].c * v2.z) * inverseArea;
+
+    const XMVECTOR pixelOffsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+    const XMVECTOR zero = XMVectorZero();
+    const XMVECTOR edgeA[3] = {XMVectorReplicate(edges[0].a), XMVectorReplicate(edges[1].a), XMVectorReplicate(edges[2].a)};
+    const XMVECTOR depthA = XMVectorReplicate(zA);
+
+    for (std::uint32_t y = startY; y <= endY; ++y)
+    {
+        float centerY = static_cast<float>(y) + 0.5f;
+
+        // the y part of every equation is constant along the row
+        XMVECTOR edgeRow[3];
+        for (int e = 0; e < 3; ++e)
+            edgeRow[e] = XMVectorReplicate(edges[e].b * centerY + edges[e].c);
+        XMVECTOR depthRow = XMVectorReplicate(zB * centerY + zC);
+
+        float *row = depth.data() + static_cast<size_t>(y) * width;
+        for (std::uint32_t x = startX; x <= endX; x += 4)
+        {
+            XMVECTOR centerX = XMVectorAdd(XMVectorReplicate(static_cast<float>(x)), pixelOffsets);
+
+            XMVECTOR inside = XMVectorGreaterOrEqual(XMVectorMultiplyAdd(edgeA[0], centerX, edgeRow[0]), zero);
+            inside = XMVectorAndInt(inside, XMVectorGreaterOrEqual(XMVectorMultiplyAdd(edgeA[1], centerX, edgeRow[1]), zero));
+            inside = XMVectorAndInt(inside, XMVectorGreaterOrEqual(XMVectorMultiplyAdd(edgeA[2], centerX, edgeRow[2]), zero));
+
+            auto *pixels = reinterpret_cast<XMFLOAT4 *>(row + x);
+            XMVECTOR current = XMLoadFloat4(pixels);
+            XMVECTOR triangleDepth = XMVectorMultiplyAdd(depthA, centerX, depthRow);
+            XMStoreFloat4(pixels, XMVectorSelect(current, XMVectorMin(current, triangleDepth), inside));
+        }
+    }
+}
+
+void OcclusionCuller::BuildHierarchy()
+{
+    for (std::uint32_t tileY = 0; tileY < tilesY; ++tileY)
+    {
+        for (std::uint32_t tileX = 0; tileX < tilesX; ++tileX)
+        {
+            XMVECTOR farthest = XMVectorZero();
+            for (std::uint32_t y = 0; y < TILE_SIZE; ++y)
+            {
+                const float *row = depth.data() + static_cast<size_t>(tileY * TILE_SIZE + y) * width + tileX * TILE_SIZE;
+                for (std::uint32_t x = 0; x < TILE_SIZE; x += 4)
+                    farthest = XMVectorMax(farthest, XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(row + x)));
+            }
+
+            XMFLOAT4 lanes;
+            XMStoreFloat4(&lanes, farthest);
+            tileMaxDepth[static_cast<size_t>(tileY) * tilesX + tileX] = std::max({lanes.x, lanes.y, lanes.z, lanes.w});
+        }
+    }
+}
+
+bool OcclusionCuller::IsVisible(const BoundingBox &worldBounds) const
+{
+    XMMATRIX matrix = XMLoadFloat4x4(&viewProjection);
+    XMVECTOR center = XMLoadFloat3(&worldBounds.Center);
+    XMVECTOR extents = XMLoadFloat3(&worldBounds.Extents);
+
+    float minX = static_cast<float>(width);
+    float minY = static_cast<float>(height);
+    float maxX = 0.0f;
+    float maxY = 0.0f;
+    float nearestDepth = 1.0f;
+
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        XMVECTOR sign = XMVectorSet(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f, 0.0f);
+        XMFLOAT4 clip;
+        XMStoreFloat4(&clip, XMVector3Transform(XMVectorMultiplyAdd(extents, sign, center), matrix));
+
+        // part of the box is in front of the near plane, there's nothing to compare against
+        if (clip.z < 0.0f || clip.w <= 0.0f)
+            return true;
+
+        float inverseW = 1.0f / clip.w;
+        float x = (clip.x * inverseW * 0.5f + 0.5f) * static_cast<float>(width);
+        float y = (0.5f - clip.y * inverseW * 0.5f) * static_cast<float>(height);
+
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearestDepth = std::min(nearestDepth, clip.z * inverseW);
+    }
+
+    if (maxX <= 0.0f || maxY <= 0.0f || minX >= static_cast<float>(width) || minY >= static_cast<float>(height))
+        return true;
+
+    auto startX = static_cast<std::uint32_t>(std::max(std::floor(minX), 0.0f));
+    auto startY = static_cast<std::uint32_t>(std::max(std::floor(minY), 0.0f));
+    auto endX = static_cast<std::uint32_t>(std::min(std::ceil(maxX) - 1.0f, static_cast<float>(width - 1)));
+    auto endY = static_cast<std::uint32_t>(std::min(std::ceil(maxY) - 1.0f, static_cast<float>(height - 1)));
+    endX = std::max(endX, startX);
+    endY = std::max(endY, startY);
+
+    for (std::uint32_t tileY = startY / TILE_SIZE; tileY <= endY / TILE_SIZE; ++tileY)
+    {
+        for (std::uint32_t tileX = startX / TILE_SIZE; tileX <= endX / TILE_SIZE; ++tileX)
+        {
+            // even the farthest occluder pixel of the tile is in front of the box
+            if (tileMaxDepth[static_cast<size_t>(tileY) * tilesX + tileX] < nearestDepth)
+                continue;
+
+            std::uint32_t x0 = std::max(startX, tileX * TILE_SIZE);
+            std::uint32_t x1 = std::min(endX, tileX * TILE_SIZE + TILE_SIZE - 1);
+            std::uint32_t y0 = std::max(startY, tileY * TILE_SIZE);
+            std::uint32_t y1 = std::min(endY, tileY * TILE_SIZE + TILE_SIZE - 1);
+
+            for (std::uint32_t y = y0; y <= y1; ++y)
+            {
+                const float *row = depth.data() + static_cast<size_t>(y) * width;
+                for (std::uint32_t x = x0; x <= x1; ++x)
+                {
+                    if (row[x] >= nearestDepth)
+                        return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct OccluderGeometry
+ * @brief CPU copy of the triangles an occluder is drawn with
+ *
+ * Usually the positions and indices of the mesh itself, but it can be a simpler stand-in (a box inside a wall)
+ * as long as it doesn't stick out of the real mesh, otherwise it would hide things that are actually visible.
+ */
+struct OccluderGeometry
+{
+    std::vector<DirectX::XMFLOAT3> positions;
+    std::vector<std::uint32_t> indices;
+};
+
+/**
+ * @class OcclusionCuller
+ * @brief Software depth rasterizer that finds boxes hidden behind occluders, entirely on the CPU
+ *
+ * Occluders are rasterized four pixels at a time into a small depth buffer, keeping the nearest depth. A coarse
+ * level then stores the farthest depth of every 8x8 tile, so most tests of a box are settled by a few tiles:
+ * when the tile's farthest occluder is still in front of the box's nearest point the whole tile is hidden.
+ * Only tiles that can't be settled that way are checked pixel by pixel.
+ *
+ * Usage per frame: BeginFrame, RenderOccluder for every occluder, BuildHierarchy, then IsVisible per candidate.
+ * Depth follows D3D (0 at the near plane, 1 at the far plane).
+ */
+class OcclusionCuller
+{
+public:
+    static constexpr std::uint32_t TILE_SIZE = 8;
+
+    /** @brief Width and height are rounded up to whole tiles */
+    OcclusionCuller(std::uint32_t width = 256, std::uint32_t height = 144);
+
+    void Resize(std::uint32_t width, std::uint32_t height);
+
+    /** @brief Clears the depth buffer and sets the camera for this frame */
+    void BeginFrame(DirectX::FXMMATRIX viewProjection);
+
+    /**
+     * @brief Draws the triangles of an occluder into the depth buffer
+     *
+     * Triangles are clockwise on screen when they face the camera (the same as the D3D default), back faces are
+     * skipped. Triangles that cross the near plane are skipped too, which only makes the occluder a bit smaller.
+     */
+    void RenderOccluder(const OccluderGeometry &geometry, DirectX::FXMMATRIX world);
+
+    /** @brief Builds the per tile farthest depth, call it after the last occluder and before testing */
+    void BuildHierarchy();
+
+    /**
+     * @brief Tests a world space box against the occluders
+     * @return false only if every pixel the box covers is hidden behind an occluder
+     *
+     * Boxes that cross the near plane or leave the screen count as visible, the frustum culler deals with those.
+     * Safe to call from several threads once BuildHierarchy has run.
+     */
+    bool IsVisible(const DirectX::BoundingBox &worldBounds) const;
+
+    std::uint32_t GetWidth() const { return width; }
+    std::uint32_t GetHeight() const { return height; }
+    const std::vector<float> &GetDepthBuffer() const { return depth; }
+
+    // triangles that reached the rasterizer since BeginFrame
+    size_t GetRasterizedTriangleCount() const { return rasterizedTriangles; }
+
+private:
+    struct ScreenVertex
+    {
+        float x, y, z;
+    };
+
+    void RasterizeTriangle(const ScreenVertex &v0, const ScreenVertex &v1, const ScreenVertex &v2);
+
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::uint32_t tilesX = 0;
+    std::uint32_t tilesY = 0;
+
+    DirectX::XMFLOAT4X4 viewProjection = {};
+
+    std::vector<float> depth;        // width * height, nearest occluder depth per pixel
+    std::vector<float> tileMaxDepth; // tilesX * tilesY, farthest value in each tile of depth
+
+    std::vector<DirectX::XMFLOAT4> clipPositions; // scratch for the current occluder
+
+    size_t rasterizedTriangles = 0;
+};
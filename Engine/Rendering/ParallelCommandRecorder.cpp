@@ -0,0 +1,85 @@
+#include "ParallelCommandRecorder.h"
+#include <algorithm>
+
+ParallelCommandRecorder::ParallelCommandRecorder(ContextFactory factory, size_t minDrawsPerChunk)
+    : factory(std::move(factory)), minDrawsPerChunk(std::max<size_t>(1, minDrawsPerChunk))
+{
+}
+
+void ParallelCommandRecorder::Split(size_t count, size_t maxChunks, size_t minChunkSize, std::vector<Range> &ranges)
+{
+    ranges.clear();
+    if (count == 0)
+        return;
+
+    minChunkSize = std::max<size_t>(1, minChunkSize);
+    size_t chunkCount = std::clamp<size_t>(count / minChunkSize, 1, std::max<size_t>(1, maxChunks));
+
+    // the first (count % chunkCount) chunks take one extra draw
+    size_t baseSize = count / chunkCount;
+    size_t remainder = count % chunkCount;
+
+    size_t begin = 0;
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        size_t size = baseSize + (i < remainder ? 1 : 0);
+        ranges.push_back({begin, begin + size});
+        begin += size;
+    }
+}
+
+bool ParallelCommandRecorder::Record(JobSystem *jobSystem, size_t drawCount, const RecordFunction &record)
+{
+    isRecorded = false;
+
+    size_t threadCount = jobSystem ? jobSystem->GetThreadCount() : 1;
+    Split(drawCount, threadCount, minDrawsPerChunk, chunks);
+
+    // contexts are made here, on the calling thread, the factory doesn't have to be thread safe
+    while (contexts.size() < chunks.size())
+    {
+        std::unique_ptr<ICommandContext> context = factory();
+        if (!context)
+            return false;
+
+        contexts.push_back(std::move(context));
+    }
+
+    finished.assign(chunks.size(), 0);
+    auto recordChunk = [&](size_t chunk)
+    {
+        ICommandContext &context = *contexts[chunk];
+        context.Begin();
+        record(context, chunks[chunk].begin, chunks[chunk].end);
+        finished[chunk] = context.Finish() ? 1 : 0;
+    };
+
+    if (jobSystem && chunks.size() > 1)
+    {
+        jobSystem->ParallelFor(chunks.size(), 1, [&](size_t begin, size_t end)
+                               {
+                                   for (size_t chunk = begin; chunk < end; ++chunk)
+                                       recordChunk(chunk);
+                               });
+    }
+    else
+    {
+        for (size_t chunk = 0; chunk < chunks.size(); ++chunk)
+            recordChunk(chunk);
+    }
+
+    isRecorded = std::all_of(finished.begin(), finished.end(), [](char isFinished)
+                             { return isFinished != 0; });
+    return isRecorded;
+}
+
+void ParallelCommandRecorder::Execute()
+{
+    if (!isRecorded)
+        return;
+
+    for (size_t chunk = 0; chunk < chunks.size(); ++chunk)
+        contexts[chunk]->Execute();
+
+    isRecorded = false;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ICommandContext.h"
+#include "../Core/JobSystem.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * @class ParallelCommandRecorder
+ * @brief Splits a list of draws into contiguous chunks, records each chunk on its own context in a job and
+ * plays the chunks back in their original order
+ *
+ * Chunks are contiguous ranges of the caller's draw list, so executing them one after the other gives exactly the
+ * order a single context would have recorded. Contexts are created on demand through the factory and reused every
+ * frame, one per chunk.
+ */
+class ParallelCommandRecorder
+{
+public:
+    struct Range
+    {
+        size_t begin;
+        size_t end;
+    };
+
+    using ContextFactory = std::function<std::unique_ptr<ICommandContext>()>;
+
+    // records draws [begin, end) into the context, it starts with nothing bound
+    using RecordFunction = std::function<void(ICommandContext &, size_t, size_t)>;
+
+    /**
+     * @param factory Makes a new context, may return nullptr if the backend can't make more
+     * @param minDrawsPerChunk Chunks never get smaller than this unless there are fewer draws in total, small chunks
+     * cost more to set up and execute than they save
+     */
+    ParallelCommandRecorder(ContextFactory factory, size_t minDrawsPerChunk = 256);
+
+    /**
+     * @brief Splits [0, count) into at most maxChunks ranges of nearly equal size, none smaller than minChunkSize
+     * unless count itself is smaller
+     */
+    static void Split(size_t count, size_t maxChunks, size_t minChunkSize, std::vector<Range> &ranges);
+
+    /**
+     * @brief Records drawCount draws, one chunk per thread of the job system (or a single chunk without one)
+     * @return false if a context couldn't be created or finished, nothing is executed then
+     */
+    bool Record(JobSystem *jobSystem, size_t drawCount, const RecordFunction &record);
+
+    /** @brief Plays back the chunks of the last Record in order, on the calling thread */
+    void Execute();
+
+    const std::vector<Range> &GetChunks() const { return chunks; }
+
+private:
+    ContextFactory factory;
+    size_t minDrawsPerChunk;
+
+    std::vector<std::unique_ptr<ICommandContext>> contexts;
+    std::vector<Range> chunks;
+    std::vector<char> finished; // per chunk, char so jobs can write their own entry without sharing bits
+    bool isRecorded = false;
+};
@@ -0,0 +1,113 @@
+#include "RecordingCommandContext.h"
+#include <algorithm>
+
+void RecordingCommandContext::Begin()
+{
+    commands.clear();
+    isFinished = false;
+}
+
+bool RecordingCommandContext::Finish()
+{
+    isFinished = true;
+    return true;
+}
+
+void RecordingCommandContext::Execute()
+{
+    if (!isFinished)
+        return;
+
+    target.insert(target.end(), commands.begin(), commands.end());
+    isFinished = false;
+}
+
+void RecordingCommandContext::Add(RecordedCommand::Type type, std::uint32_t slot, const void *resource, std::initializer_list<std::uint32_t> values)
+{
+    RecordedCommand command;
+    command.type = type;
+    command.slot = slot;
+    command.resource = resource;
+    std::copy_n(values.begin(), std::min<size_t>(values.size(), 5), command.values);
+    commands.push_back(command);
+}
+
+void RecordingCommandContext::SetRenderTargets(const void *renderTarget, const void *depthStencil)
+{
+    Add(RecordedCommand::Type::SetRenderTargets, 0, renderTarget);
+    commands.back().secondResource = depthStencil;
+}
+
+void RecordingCommandContext::SetViewport(std::uint32_t width, std::uint32_t height)
+{
+    Add(RecordedCommand::Type::SetViewport, 0, nullptr, {width, height});
+}
+
+void RecordingCommandContext::SetRasterizerState(const void *state)
+{
+    Add(RecordedCommand::Type::SetRasterizerState, 0, state);
+}
+
+void RecordingCommandContext::SetDepthStencilState(const void *state, std::uint32_t stencilRef)
+{
+    Add(RecordedCommand::Type::SetDepthStencilState, 0, state, {stencilRef});
+}
+
+void RecordingCommandContext::SetPrimitiveTopology(std::uint32_t topology)
+{
+    Add(RecordedCommand::Type::SetPrimitiveTopology, 0, nullptr, {topology});
+}
+
+void RecordingCommandContext::SetInputLayout(const void *layout)
+{
+    Add(RecordedCommand::Type::SetInputLayout, 0, layout);
+}
+
+void RecordingCommandContext::SetVertexShader(const void *shader)
+{
+    Add(RecordedCommand::Type::SetVertexShader, 0, shader);
+}
+
+void RecordingCommandContext::SetPixelShader(const void *shader)
+{
+    Add(RecordedCommand::Type::SetPixelShader, 0, shader);
+}
+
+void RecordingCommandContext::SetVertexBuffer(std::uint32_t slot, const void *buffer, std::uint32_t stride, std::uint32_t offset)
+{
+    Add(RecordedCommand::Type::SetVertexBuffer, slot, buffer, {stride, offset});
+}
+
+void RecordingCommandContext::SetIndexBuffer(const void *buffer, std::uint32_t format, std::uint32_t offset)
+{
+    Add(RecordedCommand::Type::SetIndexBuffer, 0, buffer, {format, offset});
+}
+
+void RecordingCommandContext::SetConstantBuffer(Stage stage, std::uint32_t slot, const void *buffer,
+                                                std::uint32_t firstConstant, std::uint32_t constantCount)
+{
+    auto type = stage == Stage::Vertex ? RecordedCommand::Type::SetVertexConstantBuffer : RecordedCommand::Type::SetPixelConstantBuffer;
+    Add(type, slot, buffer, {firstConstant, constantCount});
+}
+
+void RecordingCommandContext::SetTexture(std::uint32_t slot, const void *texture)
+{
+    Add(RecordedCommand::Type::SetTexture, slot, texture);
+}
+
+void RecordingCommandContext::SetSampler(std::uint32_t slot, const void *sampler)
+{
+    Add(RecordedCommand::Type::SetSampler, slot, sampler);
+}
+
+void RecordingCommandContext::DrawIndexed(std::uint32_t indexCount, std::uint32_t startIndex, std::int32_t baseVertex)
+{
+    Add(RecordedCommand::Type::DrawIndexed, 0, nullptr, {indexCount, startIndex, static_cast<std::uint32_t>(baseVertex)});
+}
+
+void RecordingCommandContext::DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount, std::uint32_t startInstance,
+                                                   std::uint32_t startIndex, std::int32_t baseVertex)
+{
+    Add(RecordedCommand::Type::DrawIndexedInstanced, 0, nullptr,
+        {indexCount, instanceCount, startInstance, startIndex, static_cast<std::uint32_t>(baseVertex)});
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "ICommandContext.h"
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+/**
+ * @struct RecordedCommand
+ * @brief One call made on a RecordingCommandContext, the meaning of the fields depends on the type
+ */
+struct RecordedCommand
+{
+    enum class Type : std::uint8_t
+    {
+        SetRenderTargets,
+        SetViewport,
+        SetRasterizerState,
+        SetDepthStencilState,
+        SetPrimitiveTopology,
+        SetInputLayout,
+        SetVertexShader,
+        SetPixelShader,
+        SetVertexBuffer,
+        SetIndexBuffer,
+        SetVertexConstantBuffer,
+        SetPixelConstantBuffer,
+        SetTexture,
+        SetSampler,
+        DrawIndexed,
+        DrawIndexedInstanced,
+    };
+
+    Type type;
+    std::uint32_t slot = 0;
+    const void *resource = nullptr;
+    const void *secondResource = nullptr; // depth stencil of SetRenderTargets
+    std::uint32_t values[5] = {};         // the remaining arguments, in the order the function takes them
+};
+
+/**
+ * @class RecordingCommandContext
+ * @brief CPU only backend that stores every call, Execute appends them to a shared stream
+ *
+ * Nothing is filtered, so the stream shows exactly what the recording code asked for and in which order.
+ * Handy for checking how draws are split across contexts and merged back, without a device.
+ */
+class RecordingCommandContext : public ICommandContext
+{
+public:
+    /** @param target Stream Execute appends to, shared by every context whose output should be merged */
+    explicit RecordingCommandContext(std::vector<RecordedCommand> &target) : target(target) {}
+
+    void Begin() override;
+    bool Finish() override;
+    void Execute() override;
+
+    void SetRenderTargets(const void *renderTarget, const void *depthStencil) override;
+    void SetViewport(std::uint32_t width, std::uint32_t height) override;
+    void SetRasterizerState(const void *state) override;
+    void SetDepthStencilState(const void *state, std::uint32_t stencilRef) override;
+    void SetPrimitiveTopology(std::uint32_t topology) override;
+    void SetInputLayout(const void *layout) override;
+    void SetVertexShader(const void *shader) override;
+    void SetPixelShader(const void *shader) override;
+
+    void SetVertexBuffer(std::uint32_t slot, const void *buffer, std::uint32_t stride, std::uint32_t offset) override;
+    void SetIndexBuffer(const void *buffer, std::uint32_t format, std::uint32_t offset) override;
+    void SetConstantBuffer(Stage stage, std::uint32_t slot, const void *buffer,
+                           std::uint32_t firstConstant = 0, std::uint32_t constantCount = 0) override;
+    void SetTexture(std::uint32_t slot, const void *texture) override;
+    void SetSampler(std::uint32_t slot, const void *sampler) override;
+
+    void DrawIndexed(std::uint32_t indexCount, std::uint32_t startIndex = 0, std::int32_t baseVertex = 0) override;
+    void DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount, std::uint32_t startInstance = 0,
+                              std::uint32_t startIndex = 0, std::int32_t baseVertex = 0) override;
+
+    // commands since the last Begin
+    const std::vector<RecordedCommand> &GetCommands() const { return commands; }
+
+private:
+    void Add(RecordedCommand::Type type, std::uint32_t slot, const void *resource, std::initializer_list<std::uint32_t> values = {});
+
+    std::vector<RecordedCommand> &target;
+    std::vector<RecordedCommand> commands;
+    bool isFinished = false;
+};
@@ -1,61 +1,157 @@
 #include "RenderPipelineManager.h"
-#include "../Resources/ShaderManager.h"
-#include <d3dcompiler.h>
+#include <algorithm>
+#include <iterator>
+#include <thread>
 
-RenderPipelineManager::RenderPipelineManager(std::shared_ptr<GraphicsDeviceManager> graphicsDevice,
-                                             std::shared_ptr<ResourceManager> resourceManager)
-    : graphicsDevice(graphicsDevice), resourceManager(resourceManager)
+RenderPipelineManager::RenderPipelineManager(std::shared_ptr<IRenderDevice> renderDevice, ShaderCompiler compileShader)
+    : renderDevice(renderDevice), compileShader(std::move(compileShader))
 {
 }
 
+RenderPipelineManager::~RenderPipelineManager()
+{
+    for (const void **resource : {&defaultVertexShader, &defaultPixelShader, &defaultInputLayout, &instancedVertexShader,
+                                  &instancedInputLayout, &solidRasterizerState, &wireframeRasterizerState, &depthStencilState,
+                                  &instanceBuffer, &matrixConstantBuffer, &cameraConstantBuffer, &constantRingBuffer})
+        Release(*resource);
+}
+
+void RenderPipelineManager::Release(const void *&resource)
+{
+    if (resource)
+        renderDevice->ReleaseResource(resource);
+    resource = nullptr;
+}
+
 bool RenderPipelineManager::Initialize()
 {
-    matrixConstantBuffer = resourceManager->CreateConstantBuffer(sizeof(MatrixBuffer));
+    matrixConstantBuffer = renderDevice->CreateBuffer({BufferUsage::DynamicConstant, sizeof(MatrixBuffer)});
     if (!matrixConstantBuffer)
         return false;
 
-    cameraConstantBuffer = resourceManager->CreateConstantBuffer(sizeof(CameraBuffer));
+    cameraConstantBuffer = renderDevice->CreateBuffer({BufferUsage::DynamicConstant, sizeof(CameraBuffer)});
     if (!cameraConstantBuffer)
         return false;
 
+    solidRasterizerState = renderDevice->CreateRasterizerState(false);
+    wireframeRasterizerState = renderDevice->CreateRasterizerState(true);
+    depthStencilState = renderDevice->CreateDepthStencilState();
+    if (!solidRasterizerState || !wireframeRasterizerState || !depthStencilState)
+        return false;
+
     if (!LoadDefaultShaders())
         return false;
 
+    // without ranges the per draw matrices keep going through the one constant buffer
+    if (renderDevice->SupportsConstantBufferRanges() && !CreateConstantRing(CONSTANT_RING_SIZE))
+        return false;
+
+    return true;
+}
+
+bool RenderPipelineManager::CreateConstantRing(std::uint32_t size)
+{
+    Release(constantRingBuffer);
+    constantRingBuffer = renderDevice->CreateBuffer({BufferUsage::DynamicConstant, size});
+    if (!constantRingBuffer)
+        return false;
+
+    constantRing.Reset(size);
+    needsDiscard = true;
     return true;
 }
 
+void RenderPipelineManager::RetireFrames(bool wait)
+{
+    while (constantRing.GetFramesInFlight() > 0)
+    {
+        std::uint64_t fence = constantRing.GetOldestFence();
+
+        bool isComplete = renderDevice->IsFenceComplete(fence, wait);
+        while (!isComplete && wait)
+        {
+            std::this_thread::yield();
+            isComplete = renderDevice->IsFenceComplete(fence, true);
+        }
+
+        if (!isComplete)
+            break;
+
+        constantRing.Retire(fence);
+        if (wait)
+            return;
+    }
+}
+
 bool RenderPipelineManager::LoadDefaultShaders()
 {
-    auto shaderManager = std::make_shared<ShaderManager>(resourceManager);
+    if (!compileShader)
+        return false;
+
+    std::vector<std::uint8_t> vertexBytecode;
+    if (!compileShader(L"Engine/Shaders/vertexShader.hlsl", "vs_5_0", vertexBytecode))
+        return false;
+
+    defaultVertexShader = renderDevice->CreateVertexShader(vertexBytecode.data(), vertexBytecode.size());
+    if (!defaultVertexShader)
+        return false;
+
+    std::vector<std::uint8_t> pixelBytecode;
+    if (!compileShader(L"Engine/Shaders/pixelShader.hlsl", "ps_5_0", pixelBytecode))
+        return false;
 
-    Microsoft::WRL::ComPtr<ID3DBlob> vertexShaderBlob;
-    if (!shaderManager->CompileAndCreateVertexShader(L"Engine/Shaders/vertexShader.hlsl", "main", defaultVertexShader, vertexShaderBlob))
+    defaultPixelShader = renderDevice->CreatePixelShader(pixelBytecode.data(), pixelBytecode.size());
+    if (!defaultPixelShader)
         return false;
 
-    if (!shaderManager->CompileAndCreatePixelShader(L"Engine/Shaders/pixelShader.hlsl", "main", defaultPixelShader))
+    if (!CreateDefaultInputLayout(vertexBytecode.data(), vertexBytecode.size()))
         return false;
 
-    return CreateDefaultInputLayout(vertexShaderBlob.Get()->GetBufferPointer(), vertexShaderBlob.Get()->GetBufferSize());
+    std::vector<std::uint8_t> instancedBytecode;
+    if (!compileShader(L"Engine/Shaders/instancedVertexShader.hlsl", "vs_5_0", instancedBytecode))
+        return false;
+
+    instancedVertexShader = renderDevice->CreateVertexShader(instancedBytecode.data(), instancedBytecode.size());
+    if (!instancedVertexShader)
+        return false;
+
+    return CreateInstancedInputLayout(instancedBytecode.data(), instancedBytecode.size());
 }
 
 bool RenderPipelineManager::CreateDefaultInputLayout(const void *shaderBytecode, size_t bytecodeLength)
 {
-    D3D11_INPUT_ELEMENT_DESC layout[] = {
-        {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 40, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 48, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"BITANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 60, D3D11_INPUT_PER_VERTEX_DATA, 0}};
-
-    HRESULT hr = graphicsDevice->GetDevice()->CreateInputLayout(
-        layout,
-        ARRAYSIZE(layout),
-        shaderBytecode,
-        bytecodeLength,
-        defaultInputLayout.GetAddressOf());
+    const VertexElement layout[] = {
+        {"POSITION", 0, FORMAT_R32G32B32_FLOAT, 0, 0},
+        {"NORMAL", 0, FORMAT_R32G32B32_FLOAT, 0, 12},
+        {"COLOR", 0, FORMAT_R32G32B32A32_FLOAT, 0, 24},
+        {"TEXCOORD", 0, FORMAT_R32G32_FLOAT, 0, 40},
+        {"TANGENT", 0, FORMAT_R32G32B32_FLOAT, 0, 48},
+        {"BITANGENT", 0, FORMAT_R32G32B32_FLOAT, 0, 60}};
+
+    defaultInputLayout = renderDevice->CreateInputLayout(layout, static_cast<std::uint32_t>(std::size(layout)), shaderBytecode, bytecodeLength);
+    return defaultInputLayout != nullptr;
+}
 
-    return SUCCEEDED(hr);
+bool RenderPipelineManager::CreateInstancedInputLayout(const void *shaderBytecode, size_t bytecodeLength)
+{
+    // the vertex stream is the same as the default layout, slot 1 holds one world matrix and light list per instance
+    const VertexElement layout[] = {
+        {"POSITION", 0, FORMAT_R32G32B32_FLOAT, 0, 0},
+        {"NORMAL", 0, FORMAT_R32G32B32_FLOAT, 0, 12},
+        {"COLOR", 0, FORMAT_R32G32B32A32_FLOAT, 0, 24},
+        {"TEXCOORD", 0, FORMAT_R32G32_FLOAT, 0, 40},
+        {"TANGENT", 0, FORMAT_R32G32B32_FLOAT, 0, 48},
+        {"BITANGENT", 0, FORMAT_R32G32B32_FLOAT, 0, 60},
+        {"INSTANCE_WORLD", 0, FORMAT_R32G32B32A32_FLOAT, 1, 0, true},
+        {"INSTANCE_WORLD", 1, FORMAT_R32G32B32A32_FLOAT, 1, 16, true},
+        {"INSTANCE_WORLD", 2, FORMAT_R32G32B32A32_FLOAT, 1, 32, true},
+        {"INSTANCE_WORLD", 3, FORMAT_R32G32B32A32_FLOAT, 1, 48, true},
+        {"INSTANCE_LIGHT_COUNTS", 0, FORMAT_R32G32B32A32_UINT, 1, 64, true},
+        {"INSTANCE_LIGHTS", 0, FORMAT_R32G32B32A32_UINT, 1, 80, true},
+        {"INSTANCE_LIGHTS", 1, FORMAT_R32G32B32A32_UINT, 1, 96, true}};
+
+    instancedInputLayout = renderDevice->CreateInputLayout(layout, static_cast<std::uint32_t>(std::size(layout)), shaderBytecode, bytecodeLength);
+    return instancedInputLayout != nullptr;
 }
 
 void RenderPipelineManager::SetWireframeMode(bool enabled)
@@ -63,63 +159,126 @@ void RenderPipelineManager::SetWireframeMode(bool enabled)
     isWireframeEnabled = enabled;
 }
 
+void RenderPipelineManager::SetInstancingEnabled(bool enabled)
+{
+    isInstancingEnabled = enabled;
+}
+
 void RenderPipelineManager::ResetRenderStates()
 {
-    auto d3dContext = graphicsDevice->GetContext();
+    // the state survives between frames, so most of this is skipped unless something changed (wireframe toggle, ...)
+    RenderStateCache &stateCache = renderDevice->GetStateCache();
+    stateCache.ResetStats();
 
-    d3dContext->OMSetDepthStencilState(graphicsDevice->GetDepthStencilState(), 0);
+    pendingMatrices.clear();
+    if (constantRingBuffer)
+    {
+        RetireFrames(false);
 
-    if (isWireframeEnabled)
-        d3dContext->RSSetState(graphicsDevice->GetWireframeRasterizerState());
-    else
-        d3dContext->RSSetState(graphicsDevice->GetSolidRasterizerState());
+        // imgui puts slot 0 back with VSSetConstantBuffers, which drops the range, so it can't be trusted across frames
+        stateCache.InvalidateConstantBuffer(RenderStateCache::Stage::Vertex, 0);
+    }
 
-    d3dContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    BindPassState(renderDevice->GetImmediateContext());
+}
+
+void RenderPipelineManager::BindPassState(ICommandContext &context)
+{
+    context.SetRenderTargets(renderDevice->GetBackBufferTarget(), renderDevice->GetDepthStencilTarget());
+    context.SetViewport(renderDevice->GetWidth(), renderDevice->GetHeight());
 
-    d3dContext->IASetInputLayout(defaultInputLayout.Get());
-    d3dContext->VSSetShader(defaultVertexShader.Get(), nullptr, 0);
-    d3dContext->PSSetShader(defaultPixelShader.Get(), nullptr, 0);
+    context.SetDepthStencilState(depthStencilState, 0);
+    context.SetRasterizerState(isWireframeEnabled ? wireframeRasterizerState : solidRasterizerState);
+    context.SetPrimitiveTopology(PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-    d3dContext->VSSetConstantBuffers(0, 1, matrixConstantBuffer.GetAddressOf());
+    context.SetInputLayout(isInstancingEnabled ? instancedInputLayout : defaultInputLayout);
+    context.SetVertexShader(isInstancingEnabled ? instancedVertexShader : defaultVertexShader);
+    context.SetPixelShader(defaultPixelShader);
+
+    context.SetConstantBuffer(ICommandContext::Stage::Pixel, 2, cameraConstantBuffer);
+    if (isInstancingEnabled && instanceBuffer)
+        context.SetVertexBuffer(1, instanceBuffer, sizeof(InstanceData), 0);
+}
+
+std::unique_ptr<ICommandContext> RenderPipelineManager::CreateDeferredContext()
+{
+    if (!SupportsDeferredContexts())
+        return nullptr;
+
+    return renderDevice->CreateDeferredContext();
 }
 
 void RenderPipelineManager::ClearBuffers(const float clearColor[4])
 {
-    graphicsDevice->ClearBuffers(clearColor);
+    renderDevice->Clear(clearColor);
 }
 
-void RenderPipelineManager::DrawIndexed(UINT indexCount, UINT startIndex, UINT baseVertex)
+void RenderPipelineManager::DrawIndexed(std::uint32_t indexCount, std::uint32_t startIndex, std::uint32_t baseVertex)
 {
-    graphicsDevice->GetContext()->DrawIndexed(indexCount, startIndex, baseVertex);
+    renderDevice->GetImmediateContext().DrawIndexed(indexCount, startIndex, baseVertex);
 }
 
-void RenderPipelineManager::SetVertexBuffer(ID3D11Buffer *vertexBuffer, UINT stride, UINT offset)
+void RenderPipelineManager::DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount, std::uint32_t startInstance,
+                                                 std::uint32_t startIndex, std::uint32_t baseVertex)
 {
-    graphicsDevice->GetContext()->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+    renderDevice->GetImmediateContext().DrawIndexedInstanced(indexCount, instanceCount, startInstance, startIndex, baseVertex);
 }
 
-void RenderPipelineManager::SetIndexBuffer(ID3D11Buffer *indexBuffer, DXGI_FORMAT format, UINT offset)
+bool RenderPipelineManager::UploadInstances(const InstanceData *instances, std::uint32_t instanceCount)
 {
-    graphicsDevice->GetContext()->IASetIndexBuffer(indexBuffer, format, offset);
+    if (instanceCount == 0)
+        return true;
+
+    if (instanceCount > instanceBufferCapacity)
+    {
+        // grow by doubling so a slowly growing scene doesn't recreate the buffer every frame
+        std::uint32_t capacity = std::max<std::uint32_t>(instanceBufferCapacity, 256);
+        while (capacity < instanceCount)
+            capacity *= 2;
+
+        Release(instanceBuffer);
+        instanceBufferCapacity = 0;
+        instanceBuffer = renderDevice->CreateBuffer({BufferUsage::DynamicVertex, static_cast<std::uint32_t>(capacity * sizeof(InstanceData))});
+        if (!instanceBuffer)
+            return false;
+
+        instanceBufferCapacity = capacity;
+    }
+
+    if (!renderDevice->WriteBuffer(instanceBuffer, 0, instances, static_cast<std::uint32_t>(instanceCount * sizeof(InstanceData)), WriteMode::Discard))
+        return false;
+
+    SetVertexBuffer(instanceBuffer, sizeof(InstanceData), 0, 1);
+    return true;
 }
 
-void RenderPipelineManager::SetConstantBuffer(ID3D11Buffer *constantBuffer, UINT slot, bool vertexShader, bool pixelShader)
+void RenderPipelineManager::SetVertexBuffer(const void *vertexBuffer, std::uint32_t stride, std::uint32_t offset, std::uint32_t slot)
 {
-    if (vertexShader)
-        graphicsDevice->GetContext()->VSSetConstantBuffers(slot, 1, &constantBuffer);
+    renderDevice->GetImmediateContext().SetVertexBuffer(slot, vertexBuffer, stride, offset);
+}
 
+void RenderPipelineManager::SetIndexBuffer(const void *indexBuffer, std::uint32_t format, std::uint32_t offset)
+{
+    renderDevice->GetImmediateContext().SetIndexBuffer(indexBuffer, format, offset);
+}
+
+void RenderPipelineManager::SetConstantBuffer(const void *constantBuffer, std::uint32_t slot, bool vertexShader, bool pixelShader)
+{
+    ICommandContext &context = renderDevice->GetImmediateContext();
+    if (vertexShader)
+        context.SetConstantBuffer(ICommandContext::Stage::Vertex, slot, constantBuffer);
     if (pixelShader)
-        graphicsDevice->GetContext()->PSSetConstantBuffers(slot, 1, &constantBuffer);
+        context.SetConstantBuffer(ICommandContext::Stage::Pixel, slot, constantBuffer);
 }
 
-void RenderPipelineManager::SetTexture(ID3D11ShaderResourceView *texture, UINT slot)
+void RenderPipelineManager::SetTexture(const void *texture, std::uint32_t slot)
 {
-    graphicsDevice->GetContext()->PSSetShaderResources(slot, 1, &texture);
+    renderDevice->GetImmediateContext().SetTexture(slot, texture);
 }
 
-void RenderPipelineManager::SetSampler(ID3D11SamplerState *samplerState, UINT slot)
+void RenderPipelineManager::SetSampler(const void *samplerState, std::uint32_t slot)
 {
-    graphicsDevice->GetContext()->PSSetSamplers(slot, 1, &samplerState);
+    renderDevice->GetImmediateContext().SetSampler(slot, samplerState);
 }
 
 void RenderPipelineManager::UpdateMatrixBuffer(const DirectX::XMMATRIX &world, const DirectX::XMMATRIX &view, const DirectX::XMMATRIX &projection)
@@ -127,8 +286,78 @@ void RenderPipelineManager::UpdateMatrixBuffer(const DirectX::XMMATRIX &world, c
     MatrixBuffer mb;
     mb.world = DirectX::XMMatrixTranspose(world);
     mb.wvp = DirectX::XMMatrixTranspose(world * view * projection);
+    mb.lights = {};
+
+    renderDevice->WriteBuffer(matrixConstantBuffer, 0, &mb, sizeof(MatrixBuffer), WriteMode::Discard);
+    SetConstantBuffer(matrixConstantBuffer, 0);
+}
+
+std::uint32_t RenderPipelineManager::AddMatrixBuffer(const DirectX::XMMATRIX &world, const DirectX::XMMATRIX &view,
+                                                     const DirectX::XMMATRIX &projection, const ObjectLightData *lights)
+{
+    MatrixBlock block = {};
+    block.matrices.world = DirectX::XMMatrixTranspose(world);
+    block.matrices.wvp = DirectX::XMMatrixTranspose(world * view * projection);
+    block.matrices.lights = lights ? *lights : ObjectLightData{};
+
+    pendingMatrices.push_back(block);
+    return static_cast<std::uint32_t>(pendingMatrices.size() - 1);
+}
+
+bool RenderPipelineManager::UploadMatrixBuffers()
+{
+    if (!constantRingBuffer || pendingMatrices.empty())
+        return true;
+
+    // every matrix gets its own 256 byte block, that's the finest a constant buffer range can start at
+    size_t size = pendingMatrices.size() * sizeof(MatrixBlock);
+    size_t offset = constantRing.Allocate(size, CONSTANT_RING_ALIGNMENT);
+
+    // the ring is full of frames the GPU hasn't finished, wait for them one at a time
+    while (offset == UploadRing::INVALID_OFFSET && constantRing.GetFramesInFlight() > 0)
+    {
+        RetireFrames(true);
+        offset = constantRing.Allocate(size, CONSTANT_RING_ALIGNMENT);
+    }
+
+    // more than the whole ring in a single frame, replace it with a bigger one (the old one lives until the GPU lets go)
+    // nothing older is in flight by now, so what's still used is this frame's earlier uploads (the shadow passes),
+    // and the new ring has to hold those as well or it's recreated at the same size every frame
+    if (offset == UploadRing::INVALID_OFFSET)
+    {
+        size_t required = constantRing.GetUsedSize() + size;
+        std::uint32_t newSize = static_cast<std::uint32_t>(constantRing.GetCapacity()) * 2;
+        while (newSize < required)
+            newSize *= 2;
+
+        if (!CreateConstantRing(newSize))
+            return false;
+
+        offset = constantRing.Allocate(size, CONSTANT_RING_ALIGNMENT);
+    }
+
+    // no overwrite promises the driver we won't touch anything the GPU may still read, the ring's fences make sure of that
+    WriteMode mode = needsDiscard ? WriteMode::Discard : WriteMode::NoOverwrite;
+    if (!renderDevice->WriteBuffer(constantRingBuffer, static_cast<std::uint32_t>(offset), pendingMatrices.data(),
+                                   static_cast<std::uint32_t>(size), mode))
+        return false;
 
-    graphicsDevice->GetContext()->UpdateSubresource(matrixConstantBuffer.Get(), 0, nullptr, &mb, 0, 0);
+    needsDiscard = false;
+    pendingFirstConstant = static_cast<std::uint32_t>(offset / 16);
+    return true;
+}
+
+void RenderPipelineManager::BindMatrixBuffer(ICommandContext &context, std::uint32_t index)
+{
+    if (!constantRingBuffer)
+    {
+        renderDevice->WriteBuffer(matrixConstantBuffer, 0, &pendingMatrices[index].matrices, sizeof(MatrixBuffer), WriteMode::Discard);
+        context.SetConstantBuffer(ICommandContext::Stage::Vertex, 0, matrixConstantBuffer);
+        return;
+    }
+
+    context.SetConstantBuffer(ICommandContext::Stage::Vertex, 0, constantRingBuffer,
+                              pendingFirstConstant + index * (CONSTANT_RING_ALIGNMENT / 16), CONSTANT_RING_ALIGNMENT / 16);
 }
 
 void RenderPipelineManager::UpdateCameraBuffer(const DirectX::XMFLOAT3 &cameraPosition)
@@ -137,11 +366,22 @@ void RenderPipelineManager::UpdateCameraBuffer(const DirectX::XMFLOAT3 &cameraPo
     cb.cameraPosition = cameraPosition;
     cb.padding = 0.0f;
 
-    graphicsDevice->GetContext()->UpdateSubresource(cameraConstantBuffer.Get(), 0, nullptr, &cb, 0, 0);
-    graphicsDevice->GetContext()->PSSetConstantBuffers(2, 1, cameraConstantBuffer.GetAddressOf());
+    renderDevice->WriteBuffer(cameraConstantBuffer, 0, &cb, sizeof(CameraBuffer), WriteMode::Discard);
+    SetConstantBuffer(cameraConstantBuffer, 2, false, true);
 }
 
 void RenderPipelineManager::Present()
 {
-    graphicsDevice->Present();
+    // the fence closes the frame's part of the ring, the device only tracks so many of them at once
+    if (constantRingBuffer)
+    {
+        while (constantRing.GetFramesInFlight() >= IRenderDevice::MAX_FENCES_IN_FLIGHT)
+            RetireFrames(true);
+
+        renderDevice->SignalFence(frameNumber);
+        constantRing.EndFrame(frameNumber);
+        ++frameNumber;
+    }
+
+    renderDevice->Present();
 }
@@ -1,59 +1,149 @@
 #pragma once
 
-#include <d3d11.h>
-#include <wrl/client.h>
 #include <DirectXMath.h>
+#include <cstdint>
+#include <functional>
 #include <memory>
-#include "../Resources/ResourceManager.h"
-#include "GraphicsDeviceManager.h"
+#include <string>
+#include <vector>
 #include "Buffers.h"
+#include "IRenderDevice.h"
+#include "RenderStateCache.h"
+#include "InstanceBatcher.h"
+#include "UploadRing.h"
 
-// documentation coming soon i promise
+/**
+ * @class RenderPipelineManager
+ * @brief The main pass' shaders, states and per frame buffers (matrices, camera, instance stream), on any IRenderDevice
+ *
+ * Everything goes through the device and its contexts, so the same frame can be built on D3D11 or headless on the
+ * null backend. Shaders come in as bytecode from the ShaderCompiler the owner passes in.
+ */
 class RenderPipelineManager
 {
 public:
-    RenderPipelineManager(std::shared_ptr<GraphicsDeviceManager> graphicsDevice,
-                          std::shared_ptr<ResourceManager> resourceManager);
-    ~RenderPipelineManager() = default;
+    // compiles the "main" entry point of an HLSL file for a shader model ("vs_5_0", ...), false on failure
+    using ShaderCompiler = std::function<bool(const std::wstring &filename, const std::string &shaderModel, std::vector<std::uint8_t> &bytecode)>;
+
+    RenderPipelineManager(std::shared_ptr<IRenderDevice> renderDevice, ShaderCompiler compileShader);
+    ~RenderPipelineManager();
 
     bool Initialize();
 
     void SetWireframeMode(bool enabled);
+    // picks the vertex shader and input layout ResetRenderStates binds, instanced draws need them
+    void SetInstancingEnabled(bool enabled);
+    bool IsInstancingEnabled() const { return isInstancingEnabled; }
     void ResetRenderStates();
     void ClearBuffers(const float clearColor[4]);
 
     bool LoadDefaultShaders();
     bool CreateDefaultInputLayout(const void *shaderBytecode, size_t bytecodeLength);
+    bool CreateInstancedInputLayout(const void *shaderBytecode, size_t bytecodeLength);
+
+    void DrawIndexed(std::uint32_t indexCount, std::uint32_t startIndex = 0, std::uint32_t baseVertex = 0);
+    void DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount, std::uint32_t startInstance = 0,
+                              std::uint32_t startIndex = 0, std::uint32_t baseVertex = 0);
+
+    // copies the instances of the frame into the instance stream (slot 1), growing it if needed
+    bool UploadInstances(const InstanceData *instances, std::uint32_t instanceCount);
 
-    void DrawIndexed(UINT indexCount, UINT startIndex = 0, UINT baseVertex = 0);
+    void SetVertexBuffer(const void *vertexBuffer, std::uint32_t stride, std::uint32_t offset = 0, std::uint32_t slot = 0);
+    void SetIndexBuffer(const void *indexBuffer, std::uint32_t format = FORMAT_R32_UINT, std::uint32_t offset = 0);
+    void SetConstantBuffer(const void *constantBuffer, std::uint32_t slot, bool vertexShader = true, bool pixelShader = false);
+    void SetTexture(const void *texture, std::uint32_t slot);
+    void SetSampler(const void *samplerState, std::uint32_t slot);
 
-    void SetVertexBuffer(ID3D11Buffer *vertexBuffer, UINT stride, UINT offset = 0);
-    void SetIndexBuffer(ID3D11Buffer *indexBuffer, DXGI_FORMAT format = DXGI_FORMAT_R32_UINT, UINT offset = 0);
-    void SetConstantBuffer(ID3D11Buffer *constantBuffer, UINT slot, bool vertexShader = true, bool pixelShader = false);
-    void SetTexture(ID3D11ShaderResourceView *texture, UINT slot);
-    void SetSampler(ID3D11SamplerState *samplerState, UINT slot);
+    // binds that were issued / skipped because the slot already held the same thing, since the last ResetRenderStates
+    const RenderStateCache::Stats &GetStateStats() const { return renderDevice->GetStateCache().GetStats(); }
+
+    // call after something else bound state on the context directly, the next binds then all go through
+    void InvalidateStateCache() { renderDevice->GetStateCache().Invalidate(); }
 
     void UpdateMatrixBuffer(const DirectX::XMMATRIX &world, const DirectX::XMMATRIX &view, const DirectX::XMMATRIX &projection);
+
+    // per draw matrices for the frame: add them all, upload once, then bind the one each draw needs
+    // when the device can bind constant buffer ranges they go into a ring buffer written once per frame, otherwise
+    // each bind rewrites a single constant buffer (which only works on the immediate context)
+    // the draw's light list rides along in the same block, nullptr leaves the draw to the clustered lights
+    std::uint32_t AddMatrixBuffer(const DirectX::XMMATRIX &world, const DirectX::XMMATRIX &view, const DirectX::XMMATRIX &projection,
+                                  const ObjectLightData *lights = nullptr);
+    bool UploadMatrixBuffers();
+    void BindMatrixBuffer(ICommandContext &context, std::uint32_t index);
+    // starts over for another pass in the same frame, indices handed out before are gone
+    // (draws already recorded with them are fine, their blocks stay in the ring until the frame retires)
+    void ClearMatrixBuffers() { pendingMatrices.clear(); }
+
+    // the device's immediate context, the Set functions above go through it as well
+    ICommandContext &GetImmediateContext() { return renderDevice->GetImmediateContext(); }
+
+    // deferred contexts need the matrix ring, since rewriting one constant buffer can't be recorded per draw
+    bool SupportsDeferredContexts() const { return constantRingBuffer != nullptr; }
+    std::unique_ptr<ICommandContext> CreateDeferredContext();
+
+    // everything the pipeline binds for the whole frame (targets, shaders, states, camera, instance stream)
+    void BindPassState(ICommandContext &context);
     void UpdateCameraBuffer(const DirectX::XMFLOAT3 &cameraPosition);
 
     void Present();
 
-    Microsoft::WRL::ComPtr<ID3D11InputLayout> GetDefaultInputLayout() const { return defaultInputLayout; }
-    Microsoft::WRL::ComPtr<ID3D11VertexShader> GetDefaultVertexShader() const { return defaultVertexShader; }
-    Microsoft::WRL::ComPtr<ID3D11PixelShader> GetDefaultPixelShader() const { return defaultPixelShader; }
-    Microsoft::WRL::ComPtr<ID3D11Buffer> GetMatrixBuffer() const { return matrixConstantBuffer; }
-    Microsoft::WRL::ComPtr<ID3D11Buffer> GetCameraBuffer() const { return cameraConstantBuffer; }
+    const void *GetDefaultInputLayout() const { return defaultInputLayout; }
+    const void *GetDefaultVertexShader() const { return defaultVertexShader; }
+    const void *GetDefaultPixelShader() const { return defaultPixelShader; }
+    const void *GetMatrixBuffer() const { return matrixConstantBuffer; }
+    const void *GetCameraBuffer() const { return cameraConstantBuffer; }
+    const void *GetMatrixRing() const { return constantRingBuffer; }
+    const void *GetInstanceBuffer() const { return instanceBuffer; }
 
 private:
-    std::shared_ptr<GraphicsDeviceManager> graphicsDevice;
-    std::shared_ptr<ResourceManager> resourceManager;
+    // 256 bytes, constant buffer ranges have to start on a multiple of 16 constants
+    static constexpr std::uint32_t CONSTANT_RING_ALIGNMENT = 256;
+    static constexpr std::uint32_t CONSTANT_RING_SIZE = 4 * 1024 * 1024;
+
+    // a draw's matrices padded to the block it gets in the ring, so a frame's worth goes up in one write
+    struct MatrixBlock
+    {
+        MatrixBuffer matrices;
+        std::uint8_t padding[CONSTANT_RING_ALIGNMENT - sizeof(MatrixBuffer)];
+    };
+    static_assert(sizeof(MatrixBlock) == CONSTANT_RING_ALIGNMENT, "a block has to fill its slot of the ring exactly");
+
+    bool CreateConstantRing(std::uint32_t size);
+    void RetireFrames(bool wait);
+
+    // releases a resource made through the device and forgets it
+    void Release(const void *&resource);
+
+    std::shared_ptr<IRenderDevice> renderDevice;
+    ShaderCompiler compileShader;
+
+    const void *defaultVertexShader = nullptr;
+    const void *defaultPixelShader = nullptr;
+    const void *defaultInputLayout = nullptr;
+    const void *instancedVertexShader = nullptr;
+    const void *instancedInputLayout = nullptr;
+
+    const void *solidRasterizerState = nullptr;
+    const void *wireframeRasterizerState = nullptr;
+    const void *depthStencilState = nullptr;
+
+    const void *instanceBuffer = nullptr;
+    std::uint32_t instanceBufferCapacity = 0; // in instances
+
+    const void *matrixConstantBuffer = nullptr;
+    const void *cameraConstantBuffer = nullptr;
+
+    // null if the device can't bind part of a constant buffer
+    const void *constantRingBuffer = nullptr;
+    UploadRing constantRing;
+    bool needsDiscard = true; // the first write to a new buffer has to be a discard
 
-    Microsoft::WRL::ComPtr<ID3D11VertexShader> defaultVertexShader;
-    Microsoft::WRL::ComPtr<ID3D11PixelShader> defaultPixelShader;
-    Microsoft::WRL::ComPtr<ID3D11InputLayout> defaultInputLayout;
+    // the ring's fence values are frame numbers
+    std::uint64_t frameNumber = 1;
 
-    Microsoft::WRL::ComPtr<ID3D11Buffer> matrixConstantBuffer;
-    Microsoft::WRL::ComPtr<ID3D11Buffer> cameraConstantBuffer;
+    std::vector<MatrixBlock> pendingMatrices;
+    std::uint32_t pendingFirstConstant = 0;
 
     bool isWireframeEnabled = false;
+    bool isInstancingEnabled = false;
 };
@@ -0,0 +1,114 @@
+#include "RenderQueue.h"
+#include <algorithm>
+
+namespace
+{
+    constexpr std::uint64_t SHADER_BITS = 10;
+    constexpr std::uint64_t MATERIAL_BITS = 16;
+    constexpr std::uint64_t MESH_BITS = 16;
+    constexpr std::uint64_t DEPTH_BITS = 20;
+
+    constexpr std::uint64_t Mask(std::uint64_t bits) { return (1ull << bits) - 1; }
+
+    // below this a comparison sort beats eight passes over the histograms
+    constexpr size_t RADIX_THRESHOLD = 256;
+}
+
+std::uint64_t RenderQueue::MakeKey(Pass pass, std::uint32_t shader, std::uint32_t material, std::uint32_t mesh, float depth)
+{
+    depth = std::clamp(depth, 0.0f, 1.0f);
+    auto depthBucket = static_cast<std::uint64_t>(depth * static_cast<float>(Mask(DEPTH_BITS)));
+
+    std::uint64_t state = ((shader & Mask(SHADER_BITS)) << (MATERIAL_BITS + MESH_BITS)) |
+                          ((material & Mask(MATERIAL_BITS)) << MESH_BITS) |
+                          (mesh & Mask(MESH_BITS));
+
+    std::uint64_t key = static_cast<std::uint64_t>(pass) << 62;
+    if (pass == Pass::Transparent)
+    {
+        // far to near, so the depth is flipped and placed above the state
+        key |= (Mask(DEPTH_BITS) - depthBucket) << (SHADER_BITS + MATERIAL_BITS + MESH_BITS);
+        key |= state;
+    }
+    else
+    {
+        key |= state << DEPTH_BITS;
+        key |= depthBucket;
+    }
+
+    return key;
+}
+
+void RenderQueue::Clear()
+{
+    entries.clear();
+
+    // released resources keep their IDs, so the tables only grow; once a type's IDs would wrap in the key
+    // its numbering starts over, between frames so the IDs within a frame stay unique as long as possible
+    const std::uint64_t fieldSizes[] = {Mask(MATERIAL_BITS), Mask(MESH_BITS)};
+    for (size_t type = 0; type < static_cast<size_t>(StateType::Count); ++type)
+    {
+        if (stateIDs[type].size() >= fieldSizes[type])
+            stateIDs[type].clear();
+    }
+}
+
+std::uint32_t RenderQueue::GetStateID(StateType type, std::initializer_list<const void *> resources)
+{
+    // the IDs only order the draws, so a hash of the pointers is a good enough key for the lookup
+    std::uint64_t hash = 14695981039346656037ull;
+    bool isEmpty = true;
+    for (const void *resource : resources)
+    {
+        isEmpty = isEmpty && resource == nullptr;
+        hash ^= static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(resource));
+        hash *= 1099511628211ull;
+    }
+
+    if (isEmpty)
+        return 0;
+
+    auto &ids = stateIDs[static_cast<size_t>(type)];
+    auto [it, isNew] = ids.try_emplace(hash, static_cast<std::uint32_t>(ids.size() + 1));
+    return it->second;
+}
+
+void RenderQueue::Sort()
+{
+    if (entries.size() < RADIX_THRESHOLD)
+    {
+        std::stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b)
+                         { return a.key < b.key; });
+        return;
+    }
+
+    // one pass builds the histograms of all eight bytes
+    std::uint32_t counts[8][256] = {};
+    for (const Entry &entry : entries)
+    {
+        for (int byte = 0; byte < 8; ++byte)
+            ++counts[byte][(entry.key >> (byte * 8)) & 0xFF];
+    }
+
+    scratch.resize(entries.size());
+    for (int byte = 0; byte < 8; ++byte)
+    {
+        // every key has the same value in this byte (the pass bits, unused IDs, ...), nothing to do
+        std::uint32_t *count = counts[byte];
+        if (count[(entries.front().key >> (byte * 8)) & 0xFF] == entries.size())
+            continue;
+
+        std::uint32_t offset = 0;
+        for (int digit = 0; digit < 256; ++digit)
+        {
+            std::uint32_t digitCount = count[digit];
+            count[digit] = offset;
+            offset += digitCount;
+        }
+
+        for (const Entry &entry : entries)
+            scratch[count[(entry.key >> (byte * 8)) & 0xFF]++] = entry;
+
+        entries.swap(scratch);
+    }
+}
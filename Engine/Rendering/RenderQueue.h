@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class RenderQueue
+ * @brief Per frame list of draws, sorted by packed 64-bit keys so draws that share state end up next to each other
+ *
+ * Key layout, most significant bits first:
+ *   opaque:      pass (2) | shader (10) | material (16) | mesh (16) | depth (20, near to far)
+ *   transparent: pass (2) | depth (20, far to near) | shader (10) | material (16) | mesh (16)
+ *
+ * Opaque draws are grouped by state first and go front to back inside a group, transparent draws have to be
+ * blended in order, so for them depth wins over state. The queue only stores the key and an index into the
+ * caller's own draw list, the sort is an LSD radix sort over the key bytes.
+ */
+class RenderQueue
+{
+public:
+    enum class Pass : std::uint8_t
+    {
+        Opaque = 0,
+        Transparent = 1,
+    };
+
+    // materials and meshes are numbered separately, each has its own 16-bit field in the key
+    enum class StateType : std::uint8_t
+    {
+        Material = 0,
+        Mesh = 1,
+        Count = 2,
+    };
+
+    struct Entry
+    {
+        std::uint64_t key;
+        std::uint32_t item; // index into the caller's draw list
+    };
+
+    /**
+     * @brief Packs a sort key, IDs that don't fit their field wrap around (which only affects the order)
+     * @param depth View space depth divided by the far plane, clamped to [0, 1]
+     */
+    static std::uint64_t MakeKey(Pass pass, std::uint32_t shader, std::uint32_t material, std::uint32_t mesh, float depth);
+
+    /**
+     * @brief Small ID for a combination of resources (a material's textures, a mesh's buffers, ...), for sorting only
+     * @return 0 if every resource is null, otherwise the same ID every time the same combination is passed,
+     *         until Clear finds the IDs of that type outgrew their key field and starts the numbering over
+     */
+    std::uint32_t GetStateID(StateType type, std::initializer_list<const void *> resources);
+
+    /** @brief Drops the entries of the last frame, and the state IDs of a type once they no longer fit the key */
+    void Clear();
+    void Submit(std::uint64_t key, std::uint32_t item) { entries.push_back({key, item}); }
+
+    /** @brief Sorts the submitted entries by key, entries with equal keys keep their submission order */
+    void Sort();
+
+    const std::vector<Entry> &GetEntries() const { return entries; }
+    size_t GetSize() const { return entries.size(); }
+
+private:
+    std::vector<Entry> entries;
+    std::vector<Entry> scratch;
+
+    std::unordered_map<std::uint64_t, std::uint32_t> stateIDs[static_cast<size_t>(StateType::Count)];
+};
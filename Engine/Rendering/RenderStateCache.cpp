@@ -0,0 +1,149 @@
+#include "RenderStateCache.h"
+
+namespace
+{
+    const char unknownState = 0;
+}
+
+const void *const RenderStateCache::UNKNOWN = &unknownState;
+
+void RenderStateCache::Invalidate()
+{
+    renderTarget = UNKNOWN;
+    depthStencil = UNKNOWN;
+    viewportWidth = UNKNOWN_VALUE;
+    viewportHeight = UNKNOWN_VALUE;
+    vertexBuffers.fill({UNKNOWN, UNKNOWN_VALUE, UNKNOWN_VALUE});
+    indexBuffer = {UNKNOWN, UNKNOWN_VALUE, UNKNOWN_VALUE};
+    inputLayout = UNKNOWN;
+    primitiveTopology = UNKNOWN_VALUE;
+    vertexShader = UNKNOWN;
+    pixelShader = UNKNOWN;
+    rasterizerState = UNKNOWN;
+    depthStencilState = UNKNOWN;
+    stencilRef = UNKNOWN_VALUE;
+
+    for (auto &stage : constantBuffers)
+        stage.fill({UNKNOWN, UNKNOWN_VALUE, UNKNOWN_VALUE});
+    textures.fill(UNKNOWN);
+    samplers.fill(UNKNOWN);
+}
+
+void RenderStateCache::InvalidateConstantBuffer(Stage stage, std::uint32_t slot)
+{
+    if (slot < MAX_CONSTANT_BUFFER_SLOTS)
+        constantBuffers[static_cast<size_t>(stage)][slot] = {UNKNOWN, UNKNOWN_VALUE, UNKNOWN_VALUE};
+}
+
+bool RenderStateCache::Count(bool changed)
+{
+    if (changed)
+        ++stats.issued;
+    else
+        ++stats.skipped;
+
+    return changed;
+}
+
+bool RenderStateCache::Update(const void *&bound, const void *value)
+{
+    bool changed = bound != value;
+    bound = value;
+    return Count(changed);
+}
+
+bool RenderStateCache::SetRenderTargets(const void *newRenderTarget, const void *newDepthStencil)
+{
+    bool changed = renderTarget != newRenderTarget || depthStencil != newDepthStencil;
+    renderTarget = newRenderTarget;
+    depthStencil = newDepthStencil;
+    return Count(changed);
+}
+
+bool RenderStateCache::SetViewport(std::uint32_t width, std::uint32_t height)
+{
+    bool changed = viewportWidth != width || viewportHeight != height;
+    viewportWidth = width;
+    viewportHeight = height;
+    return Count(changed);
+}
+
+bool RenderStateCache::SetVertexBuffer(std::uint32_t slot, const void *buffer, std::uint32_t stride, std::uint32_t offset)
+{
+    if (slot >= MAX_VERTEX_BUFFER_SLOTS)
+        return Count(true);
+
+    VertexBufferBinding &vertexBuffer = vertexBuffers[slot];
+    bool changed = vertexBuffer.buffer != buffer || vertexBuffer.stride != stride || vertexBuffer.offset != offset;
+    vertexBuffer = {buffer, stride, offset};
+    return Count(changed);
+}
+
+bool RenderStateCache::SetIndexBuffer(const void *buffer, std::uint32_t format, std::uint32_t offset)
+{
+    bool changed = indexBuffer.buffer != buffer || indexBuffer.format != format || indexBuffer.offset != offset;
+    indexBuffer = {buffer, format, offset};
+    return Count(changed);
+}
+
+bool RenderStateCache::SetInputLayout(const void *layout)
+{
+    return Update(inputLayout, layout);
+}
+
+bool RenderStateCache::SetPrimitiveTopology(std::uint32_t topology)
+{
+    bool changed = primitiveTopology != topology;
+    primitiveTopology = topology;
+    return Count(changed);
+}
+
+bool RenderStateCache::SetVertexShader(const void *shader)
+{
+    return Update(vertexShader, shader);
+}
+
+bool RenderStateCache::SetPixelShader(const void *shader)
+{
+    return Update(pixelShader, shader);
+}
+
+bool RenderStateCache::SetRasterizerState(const void *state)
+{
+    return Update(rasterizerState, state);
+}
+
+bool RenderStateCache::SetDepthStencilState(const void *state, std::uint32_t newStencilRef)
+{
+    bool changed = depthStencilState != state || stencilRef != newStencilRef;
+    depthStencilState = state;
+    stencilRef = newStencilRef;
+    return Count(changed);
+}
+
+bool RenderStateCache::SetConstantBuffer(Stage stage, std::uint32_t slot, const void *buffer, std::uint32_t firstConstant, std::uint32_t constantCount)
+{
+    if (slot >= MAX_CONSTANT_BUFFER_SLOTS)
+        return Count(true);
+
+    ConstantBufferBinding &binding = constantBuffers[static_cast<size_t>(stage)][slot];
+    bool changed = binding.buffer != buffer || binding.firstConstant != firstConstant || binding.constantCount != constantCount;
+    binding = {buffer, firstConstant, constantCount};
+    return Count(changed);
+}
+
+bool RenderStateCache::SetTexture(std::uint32_t slot, const void *texture)
+{
+    if (slot >= MAX_TEXTURE_SLOTS)
+        return Count(true);
+
+    return Update(textures[slot], texture);
+}
+
+bool RenderStateCache::SetSampler(std::uint32_t slot, const void *sampler)
+{
+    if (slot >= MAX_SAMPLER_SLOTS)
+        return Count(true);
+
+    return Update(samplers[slot], sampler);
+}
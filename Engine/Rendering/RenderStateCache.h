@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class RenderStateCache
+ * @brief Shadow copy of the pipeline state that was last bound, used to drop binds that wouldn't change anything
+ *
+ * Every Set function compares the new value with the one bound in that slot, records it and returns whether the
+ * bind actually has to reach the device. Resources are only compared by address, so the cache knows nothing about
+ * D3D and the same logic works for any backend (or a mock that records the calls it gets).
+ *
+ * The shadow is only right as long as everything goes through the cache, code that binds behind its back has to
+ * call Invalidate afterwards. Slots past the tracked range are never cached and always go through.
+ */
+class RenderStateCache
+{
+public:
+    static constexpr std::uint32_t MAX_VERTEX_BUFFER_SLOTS = 4;
+    static constexpr std::uint32_t MAX_CONSTANT_BUFFER_SLOTS = 14;
+    static constexpr std::uint32_t MAX_TEXTURE_SLOTS = 16;
+    static constexpr std::uint32_t MAX_SAMPLER_SLOTS = 16;
+
+    enum class Stage : std::uint8_t
+    {
+        Vertex = 0,
+        Pixel = 1,
+    };
+
+    struct Stats
+    {
+        size_t issued = 0;
+        size_t skipped = 0;
+    };
+
+    RenderStateCache() { Invalidate(); }
+
+    /** @brief Forgets everything that was bound, the next bind of every slot goes through */
+    void Invalidate();
+
+    /** @brief Forgets a single constant buffer slot, for code that rebinds it without going through the cache */
+    void InvalidateConstantBuffer(Stage stage, std::uint32_t slot);
+
+    /** @brief Starts a new frame of counters, the shadow state itself is kept */
+    void ResetStats() { stats = {}; }
+    const Stats &GetStats() const { return stats; }
+
+    // each of these returns true if the bind has to be issued
+    bool SetRenderTargets(const void *renderTarget, const void *depthStencil);
+    bool SetViewport(std::uint32_t width, std::uint32_t height);
+    bool SetVertexBuffer(std::uint32_t slot, const void *buffer, std::uint32_t stride, std::uint32_t offset);
+    bool SetIndexBuffer(const void *buffer, std::uint32_t format, std::uint32_t offset);
+    bool SetInputLayout(const void *layout);
+    bool SetPrimitiveTopology(std::uint32_t topology);
+    bool SetVertexShader(const void *shader);
+    bool SetPixelShader(const void *shader);
+    bool SetRasterizerState(const void *state);
+    bool SetDepthStencilState(const void *state, std::uint32_t stencilRef);
+    // a range of a larger buffer is given in 16 byte constants, a count of 0 means the whole buffer
+    bool SetConstantBuffer(Stage stage, std::uint32_t slot, const void *buffer, std::uint32_t firstConstant = 0, std::uint32_t constantCount = 0);
+    bool SetTexture(std::uint32_t slot, const void *texture);
+    bool SetSampler(std::uint32_t slot, const void *sampler);
+
+private:
+    // stands in for "unknown", no real resource lives at this address, so the first bind after Invalidate always differs
+    static const void *const UNKNOWN;
+    static constexpr std::uint32_t UNKNOWN_VALUE = ~0u;
+
+    bool Update(const void *&bound, const void *value);
+    bool Count(bool changed);
+
+    struct VertexBufferBinding
+    {
+        const void *buffer;
+        std::uint32_t stride;
+        std::uint32_t offset;
+    };
+
+    struct ConstantBufferBinding
+    {
+        const void *buffer;
+        std::uint32_t firstConstant;
+        std::uint32_t constantCount;
+    };
+
+    struct IndexBufferBinding
+    {
+        const void *buffer;
+        std::uint32_t format;
+        std::uint32_t offset;
+    };
+
+    const void *renderTarget = nullptr;
+    const void *depthStencil = nullptr;
+    std::uint32_t viewportWidth = 0;
+    std::uint32_t viewportHeight = 0;
+    std::array<VertexBufferBinding, MAX_VERTEX_BUFFER_SLOTS> vertexBuffers = {};
+    IndexBufferBinding indexBuffer = {};
+    const void *inputLayout = nullptr;
+    std::uint32_t primitiveTopology = 0;
+    const void *vertexShader = nullptr;
+    const void *pixelShader = nullptr;
+    const void *rasterizerState = nullptr;
+    const void *depthStencilState = nullptr;
+    std::uint32_t stencilRef = 0;
+
+    std::array<std::array<ConstantBufferBinding, MAX_CONSTANT_BUFFER_SLOTS>, 2> constantBuffers = {}; // indexed by Stage
+    std::array<const void *, MAX_TEXTURE_SLOTS> textures = {};
+    std::array<const void *, MAX_SAMPLER_SLOTS> samplers = {};
+
+    Stats stats;
+};
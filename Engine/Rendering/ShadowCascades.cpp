@@ -0,0 +1,268 @@
+#include "ShadowCascades.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+    XMVECTOR XM_CALLCONV LoadFour(const float *values)
+    {
+        return XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(values));
+    }
+
+    void XM_CALLCONV StoreFour(float *values, FXMVECTOR vector)
+    {
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4 *>(values), vector);
+    }
+
+    // 64 bit FNV-1a
+    std::uint64_t HashBytes(std::uint64_t hash, const void *data, size_t size)
+    {
+        const auto *bytes = static_cast<const std::uint8_t *>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+}
+
+void ShadowCascades::Clear()
+{
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    extentX.clear();
+    extentY.clear();
+    extentZ.clear();
+    keys.clear();
+    count = 0;
+}
+
+std::uint32_t ShadowCascades::Add(const BoundingBox &worldBounds, std::uint64_t key)
+{
+    // keep the arrays padded to a multiple of four, the padding boxes are never reported
+    if (count == centerX.size())
+    {
+        size_t padded = centerX.size() + 4;
+        for (auto *values : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ})
+            values->resize(padded, 0.0f);
+        keys.resize(padded, 0);
+    }
+
+    centerX[count] = worldBounds.Center.x;
+    centerY[count] = worldBounds.Center.y;
+    centerZ[count] = worldBounds.Center.z;
+    extentX[count] = worldBounds.Extents.x;
+    extentY[count] = worldBounds.Extents.y;
+    extentZ[count] = worldBounds.Extents.z;
+    keys[count] = key;
+
+    return static_cast<std::uint32_t>(count++);
+}
+
+void ShadowCascades::Fit(FXMMATRIX view, CXMMATRIX projection, const XMFLOAT3 &lightDirection)
+{
+    XMFLOAT4X4 cameraProjection;
+    XMStoreFloat4x4(&cameraProjection, projection);
+
+    // straight from XMMatrixPerspectiveFovLH: m00 = 1 / tan(fovX / 2), m22 = f / (f - n), m32 = -n * f / (f - n)
+    float tanHalfX = 1.0f / cameraProjection.m[0][0];
+    float tanHalfY = 1.0f / cameraProjection.m[1][1];
+    float nearZ = -cameraProjection.m[3][2] / cameraProjection.m[2][2];
+    float farZ = std::min(cameraProjection.m[3][2] / (1.0f - cameraProjection.m[2][2]), maxDistance);
+    farZ = std::max(farZ, nearZ * 2.0f);
+
+    // the light view only rotates, any up works as long as it isn't parallel to the light and stays the same every frame
+    XMVECTOR direction = XMLoadFloat3(&lightDirection);
+    if (XMVectorGetX(XMVector3LengthSq(direction)) < 1e-12f)
+        direction = XMVectorSet(0.0f, -1.0f, 0.0f, 0.0f);
+    direction = XMVector3Normalize(direction);
+
+    XMVECTOR up = std::fabs(XMVectorGetY(direction)) > 0.99f ? XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+    XMMATRIX lightViewMatrix = XMMatrixLookToLH(XMVectorZero(), direction, up);
+    XMStoreFloat4x4(&lightView, lightViewMatrix);
+
+    // every caster box in light space once, shared by all cascades
+    // the center goes through the rotation, the extents through its absolute value (row vectors, so the rows of the matrix)
+    size_t paddedCount = centerX.size();
+    for (auto *values : {&lightMinX, &lightMinY, &lightMinZ, &lightMaxX, &lightMaxY, &lightMaxZ})
+        values->resize(paddedCount);
+
+    XMVECTOR rows[3][3], absRows[3][3];
+    for (int row = 0; row < 3; ++row)
+    {
+        for (int column = 0; column < 3; ++column)
+        {
+            rows[row][column] = XMVectorReplicate(lightView.m[row][column]);
+            absRows[row][column] = XMVectorAbs(rows[row][column]);
+        }
+    }
+
+    for (size_t i = 0; i < paddedCount; i += 4)
+    {
+        XMVECTOR cx = LoadFour(&centerX[i]);
+        XMVECTOR cy = LoadFour(&centerY[i]);
+        XMVECTOR cz = LoadFour(&centerZ[i]);
+        XMVECTOR ex = LoadFour(&extentX[i]);
+        XMVECTOR ey = LoadFour(&extentY[i]);
+        XMVECTOR ez = LoadFour(&extentZ[i]);
+
+        float *minValues[3] = {&lightMinX[i], &lightMinY[i], &lightMinZ[i]};
+        float *maxValues[3] = {&lightMaxX[i], &lightMaxY[i], &lightMaxZ[i]};
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            XMVECTOR center = XMVectorMultiplyAdd(cz, rows[2][axis], XMVectorMultiplyAdd(cy, rows[1][axis], XMVectorMultiply(cx, rows[0][axis])));
+            XMVECTOR extent = XMVectorMultiplyAdd(ez, absRows[2][axis], XMVectorMultiplyAdd(ey, absRows[1][axis], XMVectorMultiply(ex, absRows[0][axis])));
+            StoreFour(minValues[axis], XMVectorSubtract(center, extent));
+            StoreFour(maxValues[axis], XMVectorAdd(center, extent));
+        }
+    }
+
+    XMMATRIX cameraWorld = XMMatrixInverse(nullptr, view);
+    float cornerSlopeSq = tanHalfX * tanHalfX + tanHalfY * tanHalfY;
+
+    float splitNear = nearZ;
+    for (std::uint32_t c = 0; c < CASCADE_COUNT; ++c)
+    {
+        Cascade &cascade = cascades[c];
+
+        float t = static_cast<float>(c + 1) / CASCADE_COUNT;
+        float uniformSplit = nearZ + (farZ - nearZ) * t;
+        float logSplit = nearZ * std::pow(farZ / nearZ, t);
+        float splitFar = c + 1 == CASCADE_COUNT ? farZ : uniformSplit + (logSplit - uniformSplit) * SPLIT_LAMBDA;
+
+        // smallest sphere around the slice, its center is on the view axis where the near and far corners are
+        // equally far away (past the far plane for wide slices, then it's the far plane's circle)
+        float sphereZ = 0.5f * (splitNear + splitFar) * (1.0f + cornerSlopeSq);
+        float radius;
+        if (sphereZ >= splitFar)
+        {
+            sphereZ = splitFar;
+            radius = splitFar * std::sqrt(cornerSlopeSq);
+        }
+        else
+        {
+            radius = std::sqrt((splitFar - sphereZ) * (splitFar - sphereZ) + splitFar * splitFar * cornerSlopeSq);
+        }
+
+        // rounded up so float noise can't change the texel size from frame to frame, and one texel wider on each side
+        // since snapping moves the center by up to a texel
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+        float halfWidth = radius * static_cast<float>(resolution) / static_cast<float>(resolution - 2);
+        float texelSize = 2.0f * halfWidth / static_cast<float>(resolution);
+
+        XMVECTOR worldCenter = XMVector3Transform(XMVectorSet(0.0f, 0.0f, sphereZ, 1.0f), cameraWorld);
+        XMFLOAT3 center;
+        XMStoreFloat3(&center, XMVector3Transform(worldCenter, lightViewMatrix));
+
+        // whole texels only, so the same world position always lands on the same texel
+        center.x = std::floor(center.x / texelSize) * texelSize;
+        center.y = std::floor(center.y / texelSize) * texelSize;
+
+        float minX = center.x - halfWidth;
+        float maxX = center.x + halfWidth;
+        float minY = center.y - halfWidth;
+        float maxY = center.y + halfWidth;
+        float maxZ = center.z + radius;
+
+        // the near plane is pulled back to the closest caster, casters between the light and the slice still shadow it
+        float minZ = center.z - radius;
+        CullCasters(minX, maxX, minY, maxY, maxZ, cascade, minZ);
+
+        // built from the center and the fixed width instead of the box's sides, so the scale is bit for bit the same
+        // in every frame
+        XMMATRIX cascadeProjection = XMMatrixMultiply(XMMatrixTranslation(-center.x, -center.y, 0.0f),
+                                                      XMMatrixOrthographicLH(2.0f * halfWidth, 2.0f * halfWidth, minZ, maxZ));
+        XMStoreFloat4x4(&cascade.projection, cascadeProjection);
+        XMStoreFloat4x4(&cascade.viewProjection, XMMatrixMultiply(lightViewMatrix, cascadeProjection));
+        cascade.splitNear = splitNear;
+        cascade.splitFar = splitFar;
+        cascade.texelSize = texelSize;
+
+        splitNear = splitFar;
+    }
+}
+
+void ShadowCascades::CullCasters(float minX, float maxX, float minY, float maxY, float maxZ, Cascade &cascade, float &minZ) const
+{
+    cascade.casters.clear();
+
+    XMVECTOR boxMinX = XMVectorReplicate(minX);
+    XMVECTOR boxMaxX = XMVectorReplicate(maxX);
+    XMVECTOR boxMinY = XMVectorReplicate(minY);
+    XMVECTOR boxMaxY = XMVectorReplicate(maxY);
+    XMVECTOR boxMaxZ = XMVectorReplicate(maxZ);
+
+    for (size_t i = 0; i < count; i += 4)
+    {
+        // overlaps the slice's box in x and y and starts in front of its far side, there's no near side
+        XMVECTOR inside = XMVectorAndInt(XMVectorGreaterOrEqual(LoadFour(&lightMaxX[i]), boxMinX),
+                                         XMVectorLessOrEqual(LoadFour(&lightMinX[i]), boxMaxX));
+        inside = XMVectorAndInt(inside, XMVectorGreaterOrEqual(LoadFour(&lightMaxY[i]), boxMinY));
+        inside = XMVectorAndInt(inside, XMVectorLessOrEqual(LoadFour(&lightMinY[i]), boxMaxY));
+        inside = XMVectorAndInt(inside, XMVectorLessOrEqual(LoadFour(&lightMinZ[i]), boxMaxZ));
+
+        // none of the four, the common case for the small near cascades
+        if (XMVector4EqualInt(inside, XMVectorFalseInt()))
+            continue;
+
+        XMUINT4 results;
+        XMStoreUInt4(&results, inside);
+        const std::uint32_t lanes[4] = {results.x, results.y, results.z, results.w};
+        for (size_t lane = 0; lane < 4 && i + lane < count; ++lane)
+        {
+            if (!lanes[lane])
+                continue;
+
+            cascade.casters.push_back(static_cast<std::uint32_t>(i + lane));
+            minZ = std::min(minZ, lightMinZ[i + lane]);
+        }
+    }
+}
+
+bool ShadowCascades::IsDirty(std::uint32_t cascade) const
+{
+    const Cascade &current = cascades[cascade];
+    const RenderedState &rendered = renderedStates[cascade];
+    if (!rendered.isValid || rendered.casterKeys.size() != current.casters.size() ||
+        std::memcmp(&rendered.viewProjection, &current.viewProjection, sizeof(XMFLOAT4X4)) != 0)
+        return true;
+
+    for (size_t i = 0; i < current.casters.size(); ++i)
+    {
+        if (rendered.casterKeys[i] != keys[current.casters[i]])
+            return true;
+    }
+
+    return false;
+}
+
+void ShadowCascades::MarkRendered(std::uint32_t cascade)
+{
+    const Cascade &current = cascades[cascade];
+    RenderedState &rendered = renderedStates[cascade];
+
+    rendered.isValid = true;
+    rendered.viewProjection = current.viewProjection;
+    rendered.casterKeys.resize(current.casters.size());
+    for (size_t i = 0; i < current.casters.size(); ++i)
+        rendered.casterKeys[i] = keys[current.casters[i]];
+}
+
+void ShadowCascades::Invalidate()
+{
+    for (RenderedState &rendered : renderedStates)
+        rendered.isValid = false;
+}
+
+std::uint64_t ShadowCascades::HashCaster(std::uint64_t id, const void *mesh, const XMFLOAT4X4 &world)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    hash = HashBytes(hash, &id, sizeof(id));
+    hash = HashBytes(hash, &mesh, sizeof(mesh));
+    return HashBytes(hash, &world, sizeof(world));
+}
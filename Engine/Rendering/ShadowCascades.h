@@ -0,0 +1,116 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class ShadowCascades
+ * @brief Fits cascaded shadow map projections for a directional light and sorts the shadow casters into them
+ *
+ * The camera frustum is cut into CASCADE_COUNT depth slices, a blend of uniform and logarithmic splits. Each slice
+ * gets an orthographic projection around its bounding sphere in a light view that never rotates with the camera.
+ * The sphere only depends on the split depths and the field of view, so the projection keeps its size when the camera
+ * turns, and its center is snapped to whole shadow map texels, so moving the camera slides the map in texel steps
+ * instead of making the shadow edges crawl.
+ *
+ * Casters are culled per cascade against the light space box of the slice, extended towards the light since anything
+ * between the light and the slice can throw a shadow into it. Boxes are stored SoA and tested four at a time.
+ *
+ * Each cascade remembers what it was last drawn with (its matrix and its casters' keys), so a cascade whose
+ * projection didn't move and whose casters didn't change can keep last frame's contents.
+ *
+ * Usage per frame: Clear, Add every caster, Fit, then redraw the cascades that are dirty and MarkRendered them.
+ * None of this touches the GPU.
+ */
+class ShadowCascades
+{
+public:
+    static constexpr std::uint32_t CASCADE_COUNT = 4;
+
+    // 0 is uniform splits, 1 is logarithmic, uniform wastes resolution up close and log far away
+    static constexpr float SPLIT_LAMBDA = 0.75f;
+
+    struct Cascade
+    {
+        DirectX::XMFLOAT4X4 projection;     // orthographic, light view to clip space
+        DirectX::XMFLOAT4X4 viewProjection; // world to the cascade's clip space
+        float splitNear;                    // view depth range of the camera slice it covers
+        float splitFar;
+        float texelSize;                    // world units per shadow map texel
+        std::vector<std::uint32_t> casters; // the Add indices that can shadow the slice, in the order they were added
+    };
+
+    /** @brief Shadow map size in texels along one side, the texel snapping depends on it */
+    void SetResolution(std::uint32_t texels) { resolution = texels > 4 ? texels : 4; }
+
+    /** @brief Shadows end here (or at the camera's far plane if that's closer), the last cascade stops there */
+    void SetMaxDistance(float distance) { maxDistance = distance; }
+
+    /** @brief Removes every caster, keeps the memory */
+    void Clear();
+
+    /**
+     * @brief Adds a shadow caster
+     * @param worldBounds World space box around the caster
+     * @param key Anything that changes when the caster's depth would, see HashCaster
+     * @return Index of the caster, as stored in Cascade::casters
+     */
+    std::uint32_t Add(const DirectX::BoundingBox &worldBounds, std::uint64_t key);
+
+    /**
+     * @brief Fits the cascades to the camera and culls the casters into them
+     * @param projection Left handed perspective projection, the splits are taken from its near and far planes
+     * @param lightDirection Direction the light travels in, doesn't have to be normalized
+     */
+    void Fit(DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection, const DirectX::XMFLOAT3 &lightDirection);
+
+    const Cascade &GetCascade(std::uint32_t cascade) const { return cascades[cascade]; }
+
+    /** @brief World to light view, the same for every cascade and only changes with the light's direction */
+    const DirectX::XMFLOAT4X4 &GetLightView() const { return lightView; }
+
+    size_t GetCasterCount() const { return count; }
+
+    /** @brief True if the cascade has to be redrawn, its projection or casters differ from when it was last rendered */
+    bool IsDirty(std::uint32_t cascade) const;
+
+    /** @brief Remembers the cascade's current projection and casters as what its shadow map holds */
+    void MarkRendered(std::uint32_t cascade);
+
+    /** @brief Forgets what every cascade was drawn with, for when the shadow map's contents are lost */
+    void Invalidate();
+
+    /** @brief Key for Add from what decides a caster's depth: who it is, the mesh it draws and where */
+    static std::uint64_t HashCaster(std::uint64_t id, const void *mesh, const DirectX::XMFLOAT4X4 &world);
+
+private:
+    // what a cascade's slice of the shadow map was last drawn with
+    struct RenderedState
+    {
+        bool isValid = false;
+        DirectX::XMFLOAT4X4 viewProjection = {};
+        std::vector<std::uint64_t> casterKeys;
+    };
+
+    void CullCasters(float minX, float maxX, float minY, float maxY, float maxZ, Cascade &cascade, float &minZ) const;
+
+    std::uint32_t resolution = 2048;
+    float maxDistance = 100.0f;
+
+    Cascade cascades[CASCADE_COUNT] = {};
+    RenderedState renderedStates[CASCADE_COUNT];
+    DirectX::XMFLOAT4X4 lightView = {};
+
+    // SoA world space caster boxes, padded to a multiple of four
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    std::vector<std::uint64_t> keys;
+    size_t count = 0;
+
+    // the same boxes in light view space, filled by Fit
+    std::vector<float> lightMinX, lightMinY, lightMinZ;
+    std::vector<float> lightMaxX, lightMaxY, lightMaxZ;
+};
@@ -0,0 +1,91 @@
+#include "ShadowMapManager.h"
+#include "../Resources/ShaderManager.h"
+
+using namespace DirectX;
+
+ShadowMapManager::ShadowMapManager(std::shared_ptr<ResourceManager> resourceManager)
+    : resourceManager(resourceManager)
+{
+}
+
+bool ShadowMapManager::Initialize()
+{
+    cascades.SetResolution(SHADOW_MAP_SIZE);
+
+    shadowMapTexture = resourceManager->CreateShadowMapTexture(SHADOW_MAP_SIZE, ShadowCascades::CASCADE_COUNT);
+    if (!shadowMapTexture)
+        return false;
+
+    for (UINT cascade = 0; cascade < ShadowCascades::CASCADE_COUNT; ++cascade)
+    {
+        cascadeDepthViews[cascade] = resourceManager->CreateShadowMapDepthView(shadowMapTexture, cascade);
+        if (!cascadeDepthViews[cascade])
+            return false;
+    }
+
+    shadowMapView = resourceManager->CreateShadowMapView(shadowMapTexture, ShadowCascades::CASCADE_COUNT);
+    if (!shadowMapView)
+        return false;
+
+    shadowSampler = resourceManager->CreateShadowSamplerState();
+    if (!shadowSampler)
+        return false;
+
+    shadowRasterizerState = resourceManager->CreateShadowRasterizerState();
+    if (!shadowRasterizerState)
+        return false;
+
+    // no shadows until the first Update finds a light
+    ShadowBuffer shadowData = {};
+    shadowData.shadowLightSlot = BaseLightComponent::NO_LIGHT_SLOT;
+    shadowConstantBuffer = resourceManager->CreateConstantBuffer(sizeof(ShadowBuffer), &shadowData);
+    if (!shadowConstantBuffer)
+        return false;
+
+    ShaderManager shaderManager(resourceManager);
+    Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob;
+    return shaderManager.CompileAndCreateVertexShader(L"Engine/Shaders/shadowVertexShader.hlsl", "main", shadowVertexShader, shaderBlob);
+}
+
+void ShadowMapManager::Update(const XMMATRIX &view, const XMMATRIX &projection, const DirectionalLightComponent *light)
+{
+    ShadowBuffer shadowData = {};
+    shadowData.shadowLightSlot = BaseLightComponent::NO_LIGHT_SLOT;
+
+    if (light)
+    {
+        cascades.Fit(view, projection, light->direction);
+
+        float splits[ShadowCascades::CASCADE_COUNT];
+        float texelSizes[ShadowCascades::CASCADE_COUNT];
+        for (std::uint32_t c = 0; c < ShadowCascades::CASCADE_COUNT; ++c)
+        {
+            const ShadowCascades::Cascade &cascade = cascades.GetCascade(c);
+            shadowData.cascadeViewProjection[c] = XMMatrixTranspose(XMLoadFloat4x4(&cascade.viewProjection));
+            splits[c] = cascade.splitFar;
+            texelSizes[c] = cascade.texelSize;
+        }
+
+        static_assert(ShadowCascades::CASCADE_COUNT == 4, "the shader packs one value per cascade into a float4");
+        shadowData.cascadeSplits = XMFLOAT4(splits[0], splits[1], splits[2], splits[3]);
+        shadowData.cascadeTexelSizes = XMFLOAT4(texelSizes[0], texelSizes[1], texelSizes[2], texelSizes[3]);
+        shadowData.shadowLightSlot = light->lightSlot;
+    }
+
+    resourceManager->GetContext()->UpdateSubresource(shadowConstantBuffer.Get(), 0, nullptr, &shadowData, 0, 0);
+}
+
+void ShadowMapManager::BeginCascade(ICommandContext &context, std::uint32_t cascade, const void *inputLayout)
+{
+    // the main pass reads the map through t7, unbind it first so the device and the state cache agree it's gone
+    context.SetTexture(SHADOW_MAP_SLOT, nullptr);
+
+    resourceManager->GetContext()->ClearDepthStencilView(cascadeDepthViews[cascade].Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+
+    context.SetRenderTargets(nullptr, cascadeDepthViews[cascade].Get());
+    context.SetViewport(SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
+    context.SetRasterizerState(shadowRasterizerState.Get());
+    context.SetInputLayout(inputLayout);
+    context.SetVertexShader(shadowVertexShader.Get());
+    context.SetPixelShader(nullptr);
+}
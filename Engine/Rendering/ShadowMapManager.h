@@ -0,0 +1,59 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <DirectXMath.h>
+#include <cstdint>
+#include <memory>
+#include "../ECS/Components/LightComponent.h"
+#include "../Resources/ResourceManager.h"
+#include "Buffers.h"
+#include "ICommandContext.h"
+#include "ShadowCascades.h"
+
+// cascaded shadow maps for one directional light, one slice of a texture array per cascade
+// the cascades are fitted and their casters picked on the cpu (ShadowCascades), a slice is only cleared and
+// redrawn when its cascade is dirty, otherwise it keeps what an earlier frame drew
+class ShadowMapManager
+{
+public:
+    static constexpr UINT SHADOW_MAP_SIZE = 2048;
+
+    // after the light lists (t2 - t6), the material sampler (s0) and the camera constants (b2)
+    static constexpr UINT SHADOW_MAP_SLOT = 7;
+    static constexpr UINT SHADOW_SAMPLER_SLOT = 1;
+    static constexpr UINT SHADOW_BUFFER_SLOT = 3;
+
+    ShadowMapManager(std::shared_ptr<ResourceManager> resourceManager);
+    ~ShadowMapManager() = default;
+
+    bool Initialize();
+
+    // add the frame's casters here before Update, the indices it returns are what the cascades list
+    ShadowCascades &GetCascades() { return cascades; }
+
+    // fits the cascades to the camera and writes the shadow constants, a null light turns the shadows off for the frame
+    void Update(const DirectX::XMMATRIX &view, const DirectX::XMMATRIX &projection, const DirectionalLightComponent *light);
+
+    // clears the cascade's slice and binds it as the depth target with the depth only shader, on the immediate context
+    // the caller draws the cascade's casters afterwards and binds its own pass state again when it's done
+    void BeginCascade(ICommandContext &context, std::uint32_t cascade, const void *inputLayout);
+
+    // the constant buffer (b3), shadow map (t7) and comparison sampler (s1) for the pixel shader
+    ID3D11Buffer *GetShadowBuffer() const { return shadowConstantBuffer.Get(); }
+    ID3D11ShaderResourceView *GetShadowMapView() const { return shadowMapView.Get(); }
+    ID3D11SamplerState *GetShadowSampler() const { return shadowSampler.Get(); }
+
+private:
+    std::shared_ptr<ResourceManager> resourceManager;
+
+    ShadowCascades cascades;
+
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> shadowMapTexture;
+    Microsoft::WRL::ComPtr<ID3D11DepthStencilView> cascadeDepthViews[ShadowCascades::CASCADE_COUNT];
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shadowMapView;
+    Microsoft::WRL::ComPtr<ID3D11SamplerState> shadowSampler;
+    Microsoft::WRL::ComPtr<ID3D11RasterizerState> shadowRasterizerState;
+    Microsoft::WRL::ComPtr<ID3D11VertexShader> shadowVertexShader;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> shadowConstantBuffer;
+};
@@ -0,0 +1,63 @@
+#include "UploadRing.h"
+
+void UploadRing::Reset(size_t newCapacity)
+{
+    capacity = newCapacity;
+    head = 0;
+    tail = 0;
+    usedSize = 0;
+    frameSize = 0;
+    frames.clear();
+}
+
+size_t UploadRing::Allocate(size_t size, size_t alignment)
+{
+    if (size == 0 || size > capacity)
+        return INVALID_OFFSET;
+
+    size_t offset = (head + alignment - 1) & ~(alignment - 1);
+    size_t padding = offset - head;
+
+    // the block doesn't fit before the end, skip the rest of the buffer and start over at 0
+    if (offset + size > capacity)
+    {
+        padding = capacity - head;
+        offset = 0;
+    }
+
+    // the free space is the stretch from head around to tail, so it's enough to count bytes (skipped ones included)
+    if (usedSize + padding + size > capacity)
+        return INVALID_OFFSET;
+
+    head = offset + size;
+    if (head == capacity)
+        head = 0;
+
+    usedSize += padding + size;
+    frameSize += padding + size;
+    return offset;
+}
+
+void UploadRing::EndFrame(std::uint64_t fenceValue)
+{
+    // empty frames are kept too, so every fence the caller issues has a frame to retire
+    frames.push_back({fenceValue, head, frameSize});
+    frameSize = 0;
+}
+
+void UploadRing::Retire(std::uint64_t completedFenceValue)
+{
+    while (!frames.empty() && frames.front().fence <= completedFenceValue)
+    {
+        tail = frames.front().end;
+        usedSize -= frames.front().size;
+        frames.pop_front();
+    }
+
+    // nothing left in flight, start at the front again so large blocks don't have to wrap
+    if (usedSize == 0 && frameSize == 0)
+    {
+        head = 0;
+        tail = 0;
+    }
+}
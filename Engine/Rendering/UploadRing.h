@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+/**
+ * @class UploadRing
+ * @brief Hands out offsets into a GPU buffer that is written front to back and wraps around, CPU side bookkeeping only
+ *
+ * Everything allocated between two EndFrame calls belongs to that frame. EndFrame tags the frame with a fence
+ * value, and its memory stays reserved until Retire is called with a completed fence at least that large, so the
+ * CPU never overwrites data the GPU may still read. That's what makes mapping with WRITE_NO_OVERWRITE safe.
+ *
+ * The ring never touches memory itself, it only returns offsets, which keeps it usable with any backend (or a plain
+ * array when testing).
+ */
+class UploadRing
+{
+public:
+    static constexpr size_t INVALID_OFFSET = SIZE_MAX;
+
+    explicit UploadRing(size_t capacity = 0) { Reset(capacity); }
+
+    /** @brief Forgets every allocation and frame, only valid once the GPU is done with the old contents */
+    void Reset(size_t capacity);
+
+    /**
+     * @brief Reserves a block for the current frame
+     * @param alignment Power of two
+     * @return Offset of the block, or INVALID_OFFSET if it only fits once older frames are retired
+     */
+    size_t Allocate(size_t size, size_t alignment);
+
+    /** @brief Closes the current frame, its blocks stay reserved until fenceValue is retired */
+    void EndFrame(std::uint64_t fenceValue);
+
+    /** @brief Releases every frame whose fence value is at or below completedFenceValue */
+    void Retire(std::uint64_t completedFenceValue);
+
+    /** @brief Fence of the oldest frame still reserved, 0 if there is none */
+    std::uint64_t GetOldestFence() const { return frames.empty() ? 0 : frames.front().fence; }
+
+    size_t GetCapacity() const { return capacity; }
+    size_t GetUsedSize() const { return usedSize; }
+    size_t GetFramesInFlight() const { return frames.size(); }
+
+private:
+    struct Frame
+    {
+        std::uint64_t fence;
+        size_t end;  // head when the frame was closed, the tail moves here once it's retired
+        size_t size; // bytes it holds, including what was skipped when it wrapped
+    };
+
+    size_t capacity = 0;
+    size_t head = 0; // next free byte
+    size_t tail = 0; // oldest byte still in use
+    size_t usedSize = 0;
+    size_t frameSize = 0; // bytes of the frame being recorded
+
+    std::deque<Frame> frames;
+};
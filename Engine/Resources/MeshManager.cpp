@@ -103,6 +103,8 @@ MeshData MeshManager::CreateCubeMesh()
     meshData.indexBuffer = resourceManager->CreateIndexBuffer(indices, sizeof(indices));
     meshData.indexCount = 36;
     meshData.vertexStride = sizeof(Vertex);
+    ComputeBounds(meshData, vertices, sizeof(vertices) / sizeof(Vertex));
+    KeepOccluderGeometry(meshData, vertices, sizeof(vertices) / sizeof(Vertex), indices, sizeof(indices) / sizeof(UINT));
 
     return meshData;
 }
@@ -224,6 +226,8 @@ MeshData MeshManager::CreateSphereMesh(float radius, int slices, int stacks)
     meshData.indexBuffer = resourceManager->CreateIndexBuffer(indices.data(), static_cast<UINT>(indices.size() * sizeof(UINT)));
     meshData.indexCount = static_cast<UINT>(indices.size());
     meshData.vertexStride = sizeof(Vertex);
+    ComputeBounds(meshData, vertices.data(), vertices.size());
+    KeepOccluderGeometry(meshData, vertices.data(), vertices.size(), indices.data(), indices.size());
 
     return meshData;
 }
@@ -289,10 +293,30 @@ MeshData MeshManager::CreatePlaneMesh(float width, float depth, int xDivs, int z
     meshData.indexBuffer = resourceManager->CreateIndexBuffer(indices.data(), static_cast<UINT>(indices.size() * sizeof(UINT)));
     meshData.indexCount = static_cast<UINT>(indices.size());
     meshData.vertexStride = sizeof(Vertex);
+    ComputeBounds(meshData, vertices.data(), vertices.size());
+    KeepOccluderGeometry(meshData, vertices.data(), vertices.size(), indices.data(), indices.size());
 
     return meshData;
 }
 
+void MeshManager::ComputeBounds(MeshData &meshData, const Vertex *vertices, size_t vertexCount)
+{
+    DirectX::BoundingBox::CreateFromPoints(meshData.boundingBox, vertexCount, &vertices[0].position, sizeof(Vertex));
+    DirectX::BoundingSphere::CreateFromPoints(meshData.boundingSphere, vertexCount, &vertices[0].position, sizeof(Vertex));
+}
+
+void MeshManager::KeepOccluderGeometry(MeshData &meshData, const Vertex *vertices, size_t vertexCount,
+                                       const UINT *indices, size_t indexCount)
+{
+    auto geometry = std::make_shared<OccluderGeometry>();
+    geometry->positions.reserve(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+        geometry->positions.push_back(vertices[i].position);
+
+    geometry->indices.assign(indices, indices + indexCount);
+    meshData.occluderGeometry = std::move(geometry);
+}
+
 void MeshManager::CalculateTangentBitangent(
     const DirectX::XMFLOAT3 &v0, const DirectX::XMFLOAT3 &v1, const DirectX::XMFLOAT3 &v2,
     const DirectX::XMFLOAT2 &uv0, const DirectX::XMFLOAT2 &uv1, const DirectX::XMFLOAT2 &uv2,
@@ -3,9 +3,11 @@
 #include <d3d11.h>
 #include <wrl/client.h>
 #include <DirectXMath.h>
+#include <DirectXCollision.h>
 #include <vector>
 #include <memory>
 #include "../Rendering/Vertex.h"
+#include "../Rendering/OcclusionCuller.h"
 #include "ResourceManager.h"
 
 struct MeshData
@@ -14,6 +16,13 @@ struct MeshData
     Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
     UINT indexCount;
     UINT vertexStride;
+
+    // object space bounds, computed once from the vertices when the mesh is created
+    DirectX::BoundingBox boundingBox;
+    DirectX::BoundingSphere boundingSphere;
+
+    // CPU copy of the positions and indices, only used when the mesh is drawn as an occluder
+    std::shared_ptr<const OccluderGeometry> occluderGeometry;
 };
 
 class MeshManager
@@ -32,5 +41,9 @@ public:
         DirectX::XMFLOAT3 &tangent, DirectX::XMFLOAT3 &bitangent);
 
 private:
+    void ComputeBounds(MeshData &meshData, const Vertex *vertices, size_t vertexCount);
+    void KeepOccluderGeometry(MeshData &meshData, const Vertex *vertices, size_t vertexCount,
+                              const UINT *indices, size_t indexCount);
+
     std::shared_ptr<ResourceManager> resourceManager;
 };
\ No newline at end of file
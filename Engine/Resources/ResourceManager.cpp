@@ -35,6 +35,44 @@ Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ResourceManager::LoadTexture(co
     return textureView;
 }
 
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ResourceManager::CreateTexture(UINT width, UINT height, DXGI_FORMAT format,
+                                                                                const void *data, UINT rowPitch)
+{
+    D3D11_TEXTURE2D_DESC textureDesc = {};
+    textureDesc.Width = width;
+    textureDesc.Height = height;
+    textureDesc.MipLevels = 1;
+    textureDesc.ArraySize = 1;
+    textureDesc.Format = format;
+    textureDesc.SampleDesc.Count = 1;
+    textureDesc.Usage = D3D11_USAGE_DEFAULT;
+    textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    D3D11_SUBRESOURCE_DATA textureData = {};
+    textureData.pSysMem = data;
+    textureData.SysMemPitch = rowPitch;
+
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+    HRESULT hr = device->CreateTexture2D(&textureDesc, data ? &textureData : nullptr, texture.GetAddressOf());
+
+    if (FAILED(hr))
+    {
+        OutputDebugString(L"[ResourceManager] Failed to create texture\n");
+        return nullptr;
+    }
+
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> textureView;
+    hr = device->CreateShaderResourceView(texture.Get(), nullptr, textureView.GetAddressOf());
+
+    if (FAILED(hr))
+    {
+        OutputDebugString(L"[ResourceManager] Failed to create texture view\n");
+        return nullptr;
+    }
+
+    return textureView;
+}
+
 Microsoft::WRL::ComPtr<ID3D11Buffer> ResourceManager::CreateVertexBuffer(const void *data, UINT byteWidth)
 {
     D3D11_BUFFER_DESC vbDesc = {};
@@ -57,6 +95,26 @@ Microsoft::WRL::ComPtr<ID3D11Buffer> ResourceManager::CreateVertexBuffer(const v
     return buffer;
 }
 
+Microsoft::WRL::ComPtr<ID3D11Buffer> ResourceManager::CreateDynamicVertexBuffer(UINT byteWidth)
+{
+    D3D11_BUFFER_DESC vbDesc = {};
+    vbDesc.Usage = D3D11_USAGE_DYNAMIC;
+    vbDesc.ByteWidth = byteWidth;
+    vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    vbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+    Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+    HRESULT hr = device->CreateBuffer(&vbDesc, nullptr, buffer.GetAddressOf());
+
+    if (FAILED(hr))
+    {
+        OutputDebugString(L"[ResourceManager] Failed to create dynamic vertex buffer\n");
+        return nullptr;
+    }
+
+    return buffer;
+}
+
 Microsoft::WRL::ComPtr<ID3D11Buffer> ResourceManager::CreateIndexBuffer(const void *data, UINT byteWidth)
 {
     D3D11_BUFFER_DESC ibDesc = {};
@@ -110,6 +168,106 @@ Microsoft::WRL::ComPtr<ID3D11Buffer> ResourceManager::CreateConstantBuffer(UINT
     return buffer;
 }
 
+Microsoft::WRL::ComPtr<ID3D11Buffer> ResourceManager::CreateDynamicConstantBuffer(UINT byteWidth)
+{
+    D3D11_BUFFER_DESC cbDesc = {};
+    cbDesc.Usage = D3D11_USAGE_DYNAMIC;
+    cbDesc.ByteWidth = byteWidth;
+    cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    cbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+    Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+    HRESULT hr = device->CreateBuffer(&cbDesc, nullptr, buffer.GetAddressOf());
+
+    if (FAILED(hr))
+    {
+        OutputDebugString(L"[ResourceManager] Failed to create dynamic constant buffer\n");
+        return nullptr;
+    }
+
+    return buffer;
+}
+
+Microsoft::WRL::ComPtr<ID3D11Buffer> ResourceManager::CreateDynamicStructuredBuffer(UINT elementSize, UINT elementCount)
+{
+    D3D11_BUFFER_DESC sbDesc = {};
+    sbDesc.Usage = D3D11_USAGE_DYNAMIC;
+    sbDesc.ByteWidth = elementSize * elementCount;
+    sbDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    sbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    sbDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    sbDesc.StructureByteStride = elementSize;
+
+    Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+    HRESULT hr = device->CreateBuffer(&sbDesc, nullptr, buffer.GetAddressOf());
+
+    if (FAILED(hr))
+    {
+        OutputDebugString(L"[ResourceManager] Failed to create structured buffer\n");
+        return nullptr;
+    }
+
+    return buffer;
+}
+
+Microsoft::WRL::ComPtr<ID3D11Buffer> ResourceManager::CreateStructuredBuffer(UINT elementSize, UINT elementCount)
+{
+    D3D11_BUFFER_DESC sbDesc = {};
+    sbDesc.Usage = D3D11_USAGE_DEFAULT;
+    sbDesc.ByteWidth = elementSize * elementCount;
+    sbDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    sbDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    sbDesc.StructureByteStride = elementSize;
+
+    Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+    HRESULT hr = device->CreateBuffer(&sbDesc, nullptr, buffer.GetAddressOf());
+
+    if (FAILED(hr))
+    {
+        OutputDebugString(L"[ResourceManager] Failed to create structured buffer\n");
+        return nullptr;
+    }
+
+    return buffer;
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ResourceManager::CreateBufferView(Microsoft::WRL::ComPtr<ID3D11Buffer> buffer, UINT elementCount)
+{
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = DXGI_FORMAT_UNKNOWN;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+    viewDesc.Buffer.FirstElement = 0;
+    viewDesc.Buffer.NumElements = elementCount;
+
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> bufferView;
+    HRESULT hr = device->CreateShaderResourceView(buffer.Get(), &viewDesc, bufferView.GetAddressOf());
+
+    if (FAILED(hr))
+    {
+        OutputDebugString(L"[ResourceManager] Failed to create buffer view\n");
+        return nullptr;
+    }
+
+    return bufferView;
+}
+
+Microsoft::WRL::ComPtr<ID3D11Query> ResourceManager::CreateEventQuery()
+{
+    D3D11_QUERY_DESC queryDesc = {};
+    queryDesc.Query = D3D11_QUERY_EVENT;
+
+    Microsoft::WRL::ComPtr<ID3D11Query> query;
+    HRESULT hr = device->CreateQuery(&queryDesc, query.GetAddressOf());
+
+    if (FAILED(hr))
+    {
+        OutputDebugString(L"[ResourceManager] Failed to create event query\n");
+        return nullptr;
+    }
+
+    return query;
+}
+
 Microsoft::WRL::ComPtr<ID3D11RenderTargetView> ResourceManager::CreateRenderTargetView(Microsoft::WRL::ComPtr<ID3D11Texture2D> backBuffer)
 {
     Microsoft::WRL::ComPtr<ID3D11RenderTargetView> renderTargetView;
@@ -163,6 +321,75 @@ Microsoft::WRL::ComPtr<ID3D11DepthStencilView> ResourceManager::CreateDepthStenc
     return depthStencilView;
 }
 
+Microsoft::WRL::ComPtr<ID3D11Texture2D> ResourceManager::CreateShadowMapTexture(UINT size, UINT arraySize)
+{
+    // typeless so it can be written as depth and read as a float
+    D3D11_TEXTURE2D_DESC shadowMapDesc = {};
+    shadowMapDesc.Width = size;
+    shadowMapDesc.Height = size;
+    shadowMapDesc.MipLevels = 1;
+    shadowMapDesc.ArraySize = arraySize;
+    shadowMapDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    shadowMapDesc.SampleDesc.Count = 1;
+    shadowMapDesc.SampleDesc.Quality = 0;
+    shadowMapDesc.Usage = D3D11_USAGE_DEFAULT;
+    shadowMapDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
+
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> shadowMapTexture;
+    HRESULT hr = device->CreateTexture2D(&shadowMapDesc, nullptr, shadowMapTexture.GetAddressOf());
+
+    if (FAILED(hr))
+    {
+        OutputDebugString(L"[ResourceManager] Failed to create shadow map texture\n");
+        return nullptr;
+    }
+
+    return shadowMapTexture;
+}
+
+Microsoft::WRL::ComPtr<ID3D11DepthStencilView> ResourceManager::CreateShadowMapDepthView(Microsoft::WRL::ComPtr<ID3D11Texture2D> shadowMapTexture, UINT slice)
+{
+    D3D11_DEPTH_STENCIL_VIEW_DESC depthViewDesc = {};
+    depthViewDesc.Format = DXGI_FORMAT_D32_FLOAT;
+    depthViewDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2DARRAY;
+    depthViewDesc.Texture2DArray.MipSlice = 0;
+    depthViewDesc.Texture2DArray.FirstArraySlice = slice;
+    depthViewDesc.Texture2DArray.ArraySize = 1;
+
+    Microsoft::WRL::ComPtr<ID3D11DepthStencilView> depthView;
+    HRESULT hr = device->CreateDepthStencilView(shadowMapTexture.Get(), &depthViewDesc, depthView.GetAddressOf());
+
+    if (FAILED(hr))
+    {
+        OutputDebugString(L"[ResourceManager] Failed to create shadow map depth view\n");
+        return nullptr;
+    }
+
+    return depthView;
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ResourceManager::CreateShadowMapView(Microsoft::WRL::ComPtr<ID3D11Texture2D> shadowMapTexture, UINT arraySize)
+{
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = DXGI_FORMAT_R32_FLOAT;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+    viewDesc.Texture2DArray.MostDetailedMip = 0;
+    viewDesc.Texture2DArray.MipLevels = 1;
+    viewDesc.Texture2DArray.FirstArraySlice = 0;
+    viewDesc.Texture2DArray.ArraySize = arraySize;
+
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shadowMapView;
+    HRESULT hr = device->CreateShaderResourceView(shadowMapTexture.Get(), &viewDesc, shadowMapView.GetAddressOf());
+
+    if (FAILED(hr))
+    {
+        OutputDebugString(L"[ResourceManager] Failed to create shadow map view\n");
+        return nullptr;
+    }
+
+    return shadowMapView;
+}
+
 Microsoft::WRL::ComPtr<ID3D11SamplerState> ResourceManager::CreateSamplerState()
 {
     D3D11_SAMPLER_DESC sampDesc = {};
@@ -226,6 +453,57 @@ Microsoft::WRL::ComPtr<ID3D11DepthStencilState> ResourceManager::CreateDepthSten
     return depthStencilState;
 }
 
+Microsoft::WRL::ComPtr<ID3D11SamplerState> ResourceManager::CreateShadowSamplerState()
+{
+    // outside the map counts as lit, the border depth is the far plane
+    D3D11_SAMPLER_DESC sampDesc = {};
+    sampDesc.Filter = D3D11_FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT;
+    sampDesc.AddressU = D3D11_TEXTURE_ADDRESS_BORDER;
+    sampDesc.AddressV = D3D11_TEXTURE_ADDRESS_BORDER;
+    sampDesc.AddressW = D3D11_TEXTURE_ADDRESS_BORDER;
+    sampDesc.BorderColor[0] = 1.0f;
+    sampDesc.BorderColor[1] = 1.0f;
+    sampDesc.BorderColor[2] = 1.0f;
+    sampDesc.BorderColor[3] = 1.0f;
+    sampDesc.ComparisonFunc = D3D11_COMPARISON_LESS_EQUAL;
+    sampDesc.MinLOD = 0;
+    sampDesc.MaxLOD = D3D11_FLOAT32_MAX;
+
+    Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState;
+    HRESULT hr = device->CreateSamplerState(&sampDesc, samplerState.GetAddressOf());
+
+    if (FAILED(hr))
+    {
+        OutputDebugString(L"[ResourceManager] Failed to create shadow sampler state\n");
+        return nullptr;
+    }
+
+    return samplerState;
+}
+
+Microsoft::WRL::ComPtr<ID3D11RasterizerState> ResourceManager::CreateShadowRasterizerState()
+{
+    D3D11_RASTERIZER_DESC rasterizerDesc = {};
+    rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+    rasterizerDesc.CullMode = D3D11_CULL_BACK;
+    rasterizerDesc.FrontCounterClockwise = FALSE;
+    rasterizerDesc.DepthBias = 0;
+    rasterizerDesc.DepthBiasClamp = 0.0f;
+    rasterizerDesc.SlopeScaledDepthBias = 2.0f;
+    rasterizerDesc.DepthClipEnable = FALSE;
+
+    Microsoft::WRL::ComPtr<ID3D11RasterizerState> rasterizerState;
+    HRESULT hr = device->CreateRasterizerState(&rasterizerDesc, rasterizerState.GetAddressOf());
+
+    if (FAILED(hr))
+    {
+        OutputDebugString(L"[ResourceManager] Failed to create shadow rasterizer state\n");
+        return nullptr;
+    }
+
+    return rasterizerState;
+}
+
 void ResourceManager::Release()
 {
     textures.clear();
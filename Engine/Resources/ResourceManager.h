@@ -15,18 +15,39 @@ public:
     ~ResourceManager();
 
     Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> LoadTexture(const std::wstring &filename);
+    // single mip texture from memory, not cached like the loaded ones
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateTexture(UINT width, UINT height, DXGI_FORMAT format,
+                                                                   const void *data, UINT rowPitch);
 
     Microsoft::WRL::ComPtr<ID3D11Buffer> CreateVertexBuffer(const void *data, UINT byteWidth);
+    // written by the CPU with Map(WRITE_DISCARD), for per instance data that changes every frame
+    Microsoft::WRL::ComPtr<ID3D11Buffer> CreateDynamicVertexBuffer(UINT byteWidth);
     Microsoft::WRL::ComPtr<ID3D11Buffer> CreateIndexBuffer(const void *data, UINT byteWidth);
     Microsoft::WRL::ComPtr<ID3D11Buffer> CreateConstantBuffer(UINT byteWidth, const void *initialData = nullptr);
+    // written with Map, bound a range at a time through VSSetConstantBuffers1
+    Microsoft::WRL::ComPtr<ID3D11Buffer> CreateDynamicConstantBuffer(UINT byteWidth);
+    // StructuredBuffer<T> for shaders, rewritten with Map(WRITE_DISCARD), read through a view from CreateBufferView
+    Microsoft::WRL::ComPtr<ID3D11Buffer> CreateDynamicStructuredBuffer(UINT elementSize, UINT elementCount);
+    // StructuredBuffer<T> in default memory, for data that changes in small ranges through UpdateSubresource
+    Microsoft::WRL::ComPtr<ID3D11Buffer> CreateStructuredBuffer(UINT elementSize, UINT elementCount);
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateBufferView(Microsoft::WRL::ComPtr<ID3D11Buffer> buffer, UINT elementCount);
+    Microsoft::WRL::ComPtr<ID3D11Query> CreateEventQuery();
 
     Microsoft::WRL::ComPtr<ID3D11RenderTargetView> CreateRenderTargetView(Microsoft::WRL::ComPtr<ID3D11Texture2D> backBuffer);
     Microsoft::WRL::ComPtr<ID3D11Texture2D> CreateDepthStencilTexture(UINT width, UINT height);
     Microsoft::WRL::ComPtr<ID3D11DepthStencilView> CreateDepthStencilView(Microsoft::WRL::ComPtr<ID3D11Texture2D> depthStencilTexture);
+    // depth only texture array, each slice is drawn through its own depth view and the whole array is read through one view
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> CreateShadowMapTexture(UINT size, UINT arraySize);
+    Microsoft::WRL::ComPtr<ID3D11DepthStencilView> CreateShadowMapDepthView(Microsoft::WRL::ComPtr<ID3D11Texture2D> shadowMapTexture, UINT slice);
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateShadowMapView(Microsoft::WRL::ComPtr<ID3D11Texture2D> shadowMapTexture, UINT arraySize);
 
     Microsoft::WRL::ComPtr<ID3D11SamplerState> CreateSamplerState();
     Microsoft::WRL::ComPtr<ID3D11RasterizerState> CreateRasterizerState(bool wireframe = false);
     Microsoft::WRL::ComPtr<ID3D11DepthStencilState> CreateDepthStencilState();
+    // comparison sampler for SampleCmp, bilinear so every tap is already a 2x2 filtered lookup
+    Microsoft::WRL::ComPtr<ID3D11SamplerState> CreateShadowSamplerState();
+    // slope scaled depth bias against acne, no depth clipping so casters in front of the near plane still land on it
+    Microsoft::WRL::ComPtr<ID3D11RasterizerState> CreateShadowRasterizerState();
 
     void Release();
 
@@ -29,12 +29,13 @@ public:
                            ID3DBlob *shaderBlob,
                            Microsoft::WRL::ComPtr<ID3D11InputLayout> &inputLayout);
 
-private:
-    Microsoft::WRL::ComPtr<ID3D11Device> device;
-    std::shared_ptr<ResourceManager> resourceManager = nullptr;
-
+    // only compiles, for code that creates its shaders through an IRenderDevice
     bool CompileShaderFromFile(const std::wstring &filename,
                                const std::string &entryPoint,
                                const std::string &shaderModel,
                                Microsoft::WRL::ComPtr<ID3DBlob> &shaderBlob);
+
+private:
+    Microsoft::WRL::ComPtr<ID3D11Device> device;
+    std::shared_ptr<ResourceManager> resourceManager = nullptr;
 };
\ No newline at end of file
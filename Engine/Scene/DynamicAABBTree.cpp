@@ -0,0 +1,504 @@
+#include "DynamicAABBTree.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    // how a node's box relates to a query volume
+    enum class Overlap
+    {
+        Outside,
+        Intersects,
+        Inside, // everything below the node is a hit, no more tests needed
+    };
+}
+
+DynamicAABBTree::DynamicAABBTree(float margin) : margin(margin)
+{
+}
+
+std::int32_t DynamicAABBTree::CreateProxy(const BoundingBox &bounds, EntityID entity)
+{
+    std::int32_t proxy = AllocateNode();
+    nodes[proxy].box = FromBounds(bounds, margin);
+    nodes[proxy].entity = entity;
+    nodes[proxy].height = 0;
+
+    InsertLeaf(proxy);
+    ++proxyCount;
+    return proxy;
+}
+
+void DynamicAABBTree::DestroyProxy(std::int32_t proxy)
+{
+    assert(proxy >= 0 && proxy < static_cast<std::int32_t>(nodes.size()) && nodes[proxy].IsLeaf());
+
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    --proxyCount;
+}
+
+bool DynamicAABBTree::MoveProxy(std::int32_t proxy, const BoundingBox &bounds)
+{
+    assert(proxy >= 0 && proxy < static_cast<std::int32_t>(nodes.size()) && nodes[proxy].IsLeaf());
+
+    // still inside the fat box, nothing to do
+    if (Contains(nodes[proxy].box, FromBounds(bounds, 0.0f)))
+        return false;
+
+    RemoveLeaf(proxy);
+    nodes[proxy].box = FromBounds(bounds, margin);
+    InsertLeaf(proxy);
+    return true;
+}
+
+BoundingBox DynamicAABBTree::GetFatBounds(std::int32_t proxy) const
+{
+    const AABB &box = nodes[proxy].box;
+
+    BoundingBox bounds;
+    bounds.Center = {(box.lower.x + box.upper.x) * 0.5f, (box.lower.y + box.upper.y) * 0.5f, (box.lower.z + box.upper.z) * 0.5f};
+    bounds.Extents = {(box.upper.x - box.lower.x) * 0.5f, (box.upper.y - box.lower.y) * 0.5f, (box.upper.z - box.lower.z) * 0.5f};
+    return bounds;
+}
+
+void DynamicAABBTree::Clear()
+{
+    nodes.clear();
+    root = NULL_NODE;
+    freeList = NULL_NODE;
+    proxyCount = 0;
+}
+
+void DynamicAABBTree::QueryFrustum(const XMFLOAT4 (&planes)[6], std::vector<EntityID> &results) const
+{
+    Query([&planes](const AABB &box)
+          {
+              XMFLOAT3 center = {(box.lower.x + box.upper.x) * 0.5f, (box.lower.y + box.upper.y) * 0.5f, (box.lower.z + box.upper.z) * 0.5f};
+              XMFLOAT3 extents = {box.upper.x - center.x, box.upper.y - center.y, box.upper.z - center.z};
+
+              Overlap result = Overlap::Inside;
+              for (const XMFLOAT4 &plane : planes)
+              {
+                  float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+                  float radius = std::fabs(plane.x) * extents.x + std::fabs(plane.y) * extents.y + std::fabs(plane.z) * extents.z;
+
+                  if (distance + radius < 0.0f)
+                      return Overlap::Outside;
+                  if (distance - radius < 0.0f)
+                      result = Overlap::Intersects;
+              }
+              return result;
+          },
+          results);
+}
+
+void DynamicAABBTree::QuerySphere(const BoundingSphere &sphere, std::vector<EntityID> &results) const
+{
+    Query([&sphere](const AABB &box)
+          {
+              // squared distance from the center to the closest point of the box
+              const float center[3] = {sphere.Center.x, sphere.Center.y, sphere.Center.z};
+              const float lower[3] = {box.lower.x, box.lower.y, box.lower.z};
+              const float upper[3] = {box.upper.x, box.upper.y, box.upper.z};
+
+              float distanceSquared = 0.0f;
+              for (int axis = 0; axis < 3; ++axis)
+              {
+                  float closest = std::clamp(center[axis], lower[axis], upper[axis]);
+                  distanceSquared += (center[axis] - closest) * (center[axis] - closest);
+              }
+
+              return distanceSquared <= sphere.Radius * sphere.Radius ? Overlap::Intersects : Overlap::Outside;
+          },
+          results);
+}
+
+void DynamicAABBTree::QueryBox(const BoundingBox &box, std::vector<EntityID> &results) const
+{
+    AABB query = FromBounds(box, 0.0f);
+    Query([&query](const AABB &nodeBox)
+          {
+              if (!Overlaps(query, nodeBox))
+                  return Overlap::Outside;
+              return Contains(query, nodeBox) ? Overlap::Inside : Overlap::Intersects;
+          },
+          results);
+}
+
+void DynamicAABBTree::QueryRay(const XMFLOAT3 &origin, const XMFLOAT3 &direction, float maxDistance,
+                               std::vector<EntityID> &results) const
+{
+    const float start[3] = {origin.x, origin.y, origin.z};
+    const float step[3] = {direction.x, direction.y, direction.z};
+
+    Query([&](const AABB &box)
+          {
+              // slab test, clipped to [0, maxDistance]
+              const float lower[3] = {box.lower.x, box.lower.y, box.lower.z};
+              const float upper[3] = {box.upper.x, box.upper.y, box.upper.z};
+
+              float entry = 0.0f;
+              float exit = maxDistance;
+              for (int axis = 0; axis < 3; ++axis)
+              {
+                  if (std::fabs(step[axis]) < 1e-8f)
+                  {
+                      if (start[axis] < lower[axis] || start[axis] > upper[axis])
+                          return Overlap::Outside;
+                      continue;
+                  }
+
+                  float inverse = 1.0f / step[axis];
+                  float slabEntry = (lower[axis] - start[axis]) * inverse;
+                  float slabExit = (upper[axis] - start[axis]) * inverse;
+                  if (slabEntry > slabExit)
+                      std::swap(slabEntry, slabExit);
+
+                  entry = std::max(entry, slabEntry);
+                  exit = std::min(exit, slabExit);
+                  if (entry > exit)
+                      return Overlap::Outside;
+              }
+
+              return Overlap::Intersects;
+          },
+          results);
+}
+
+template <typename Classify>
+void DynamicAABBTree::Query(Classify &&classify, std::vector<EntityID> &results) const
+{
+    results.clear();
+    if (root == NULL_NODE)
+        return;
+
+    // (node, already known to be fully inside)
+    std::vector<std::pair<std::int32_t, bool>> stack;
+    stack.reserve(64);
+    stack.emplace_back(root, false);
+
+    while (!stack.empty())
+    {
+        auto [index, isInside] = stack.back();
+        stack.pop_back();
+
+        const Node &node = nodes[index];
+        if (!isInside)
+        {
+            Overlap overlap = classify(node.box);
+            if (overlap == Overlap::Outside)
+                continue;
+            isInside = overlap == Overlap::Inside;
+        }
+
+        if (node.IsLeaf())
+        {
+            results.push_back(node.entity);
+            continue;
+        }
+
+        stack.emplace_back(node.child1, isInside);
+        stack.emplace_back(node.child2, isInside);
+    }
+}
+
+std::int32_t DynamicAABBTree::AllocateNode()
+{
+    if (freeList == NULL_NODE)
+    {
+        nodes.emplace_back();
+        return static_cast<std::int32_t>(nodes.size() - 1);
+    }
+
+    std::int32_t node = freeList;
+    freeList = nodes[node].parent;
+    nodes[node] = Node();
+    return node;
+}
+
+void DynamicAABBTree::FreeNode(std::int32_t node)
+{
+    nodes[node] = Node();
+    nodes[node].parent = freeList;
+    freeList = node;
+}
+
+void DynamicAABBTree::InsertLeaf(std::int32_t leaf)
+{
+    if (root == NULL_NODE)
+    {
+        root = leaf;
+        nodes[root].parent = NULL_NODE;
+        return;
+    }
+
+    // walk down to the sibling that adds the least surface area to the tree
+    AABB leafBox = nodes[leaf].box;
+    std::int32_t index = root;
+    while (!nodes[index].IsLeaf())
+    {
+        const Node &node = nodes[index];
+
+        float area = SurfaceArea(node.box);
+        float combinedArea = SurfaceArea(Combine(node.box, leafBox));
+
+        // cost of making a new parent for this node and the leaf
+        float cost = 2.0f * combinedArea;
+
+        // minimum cost of pushing the leaf further down, every ancestor grows as well
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](std::int32_t child)
+        {
+            float childArea = SurfaceArea(Combine(leafBox, nodes[child].box));
+            if (nodes[child].IsLeaf())
+                return childArea + inheritanceCost;
+            return childArea - SurfaceArea(nodes[child].box) + inheritanceCost;
+        };
+
+        float cost1 = descendCost(node.child1);
+        float cost2 = descendCost(node.child2);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    std::int32_t sibling = index;
+    std::int32_t oldParent = nodes[sibling].parent;
+
+    // allocating can grow the node array, so no references are held across it
+    std::int32_t newParent = AllocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = Combine(leafBox, nodes[sibling].box);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+
+    if (oldParent != NULL_NODE)
+    {
+        if (nodes[oldParent].child1 == sibling)
+            nodes[oldParent].child1 = newParent;
+        else
+            nodes[oldParent].child2 = newParent;
+    }
+    else
+    {
+        root = newParent;
+    }
+
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    FixUpwards(newParent);
+}
+
+void DynamicAABBTree::RemoveLeaf(std::int32_t leaf)
+{
+    if (leaf == root)
+    {
+        root = NULL_NODE;
+        return;
+    }
+
+    std::int32_t parent = nodes[leaf].parent;
+    std::int32_t grandParent = nodes[parent].parent;
+    std::int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    // the sibling takes the parent's place
+    if (grandParent != NULL_NODE)
+    {
+        if (nodes[grandParent].child1 == parent)
+            nodes[grandParent].child1 = sibling;
+        else
+            nodes[grandParent].child2 = sibling;
+
+        nodes[sibling].parent = grandParent;
+        FreeNode(parent);
+        FixUpwards(grandParent);
+    }
+    else
+    {
+        root = sibling;
+        nodes[sibling].parent = NULL_NODE;
+        FreeNode(parent);
+    }
+
+    nodes[leaf].parent = NULL_NODE;
+}
+
+void DynamicAABBTree::FixUpwards(std::int32_t index)
+{
+    while (index != NULL_NODE)
+    {
+        index = Balance(index);
+
+        Node &node = nodes[index];
+        const Node &child1 = nodes[node.child1];
+        const Node &child2 = nodes[node.child2];
+
+        node.height = 1 + std::max(child1.height, child2.height);
+        node.box = Combine(child1.box, child2.box);
+
+        index = node.parent;
+    }
+}
+
+std::int32_t DynamicAABBTree::Balance(std::int32_t iA)
+{
+    Node &A = nodes[iA];
+    if (A.IsLeaf() || A.height < 2)
+        return iA;
+
+    std::int32_t iB = A.child1;
+    std::int32_t iC = A.child2;
+    Node &B = nodes[iB];
+    Node &C = nodes[iC];
+
+    int balance = C.height - B.height;
+
+    // C is too tall, rotate it up
+    if (balance > 1)
+    {
+        std::int32_t iF = C.child1;
+        std::int32_t iG = C.child2;
+        Node &F = nodes[iF];
+        Node &G = nodes[iG];
+
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+
+        if (C.parent != NULL_NODE)
+        {
+            if (nodes[C.parent].child1 == iA)
+                nodes[C.parent].child1 = iC;
+            else
+                nodes[C.parent].child2 = iC;
+        }
+        else
+        {
+            root = iC;
+        }
+
+        // keep the taller of C's children next to C
+        if (F.height > G.height)
+        {
+            C.child2 = iF;
+            A.child2 = iG;
+            G.parent = iA;
+            A.box = Combine(B.box, G.box);
+            C.box = Combine(A.box, F.box);
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
+        }
+        else
+        {
+            C.child2 = iG;
+            A.child2 = iF;
+            F.parent = iA;
+            A.box = Combine(B.box, F.box);
+            C.box = Combine(A.box, G.box);
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+
+        return iC;
+    }
+
+    // B is too tall, rotate it up
+    if (balance < -1)
+    {
+        std::int32_t iD = B.child1;
+        std::int32_t iE = B.child2;
+        Node &D = nodes[iD];
+        Node &E = nodes[iE];
+
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+
+        if (B.parent != NULL_NODE)
+        {
+            if (nodes[B.parent].child1 == iA)
+                nodes[B.parent].child1 = iB;
+            else
+                nodes[B.parent].child2 = iB;
+        }
+        else
+        {
+            root = iB;
+        }
+
+        if (D.height > E.height)
+        {
+            B.child2 = iD;
+            A.child1 = iE;
+            E.parent = iA;
+            A.box = Combine(C.box, E.box);
+            B.box = Combine(A.box, D.box);
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        }
+        else
+        {
+            B.child2 = iE;
+            A.child1 = iD;
+            D.parent = iA;
+            A.box = Combine(C.box, D.box);
+            B.box = Combine(A.box, E.box);
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+
+        return iB;
+    }
+
+    return iA;
+}
+
+DynamicAABBTree::AABB DynamicAABBTree::FromBounds(const BoundingBox &bounds, float margin)
+{
+    AABB box;
+    box.lower = {bounds.Center.x - bounds.Extents.x - margin,
+                 bounds.Center.y - bounds.Extents.y - margin,
+                 bounds.Center.z - bounds.Extents.z - margin};
+    box.upper = {bounds.Center.x + bounds.Extents.x + margin,
+                 bounds.Center.y + bounds.Extents.y + margin,
+                 bounds.Center.z + bounds.Extents.z + margin};
+    return box;
+}
+
+DynamicAABBTree::AABB DynamicAABBTree::Combine(const AABB &a, const AABB &b)
+{
+    AABB box;
+    box.lower = {std::min(a.lower.x, b.lower.x), std::min(a.lower.y, b.lower.y), std::min(a.lower.z, b.lower.z)};
+    box.upper = {std::max(a.upper.x, b.upper.x), std::max(a.upper.y, b.upper.y), std::max(a.upper.z, b.upper.z)};
+    return box;
+}
+
+bool DynamicAABBTree::Contains(const AABB &outer, const AABB &inner)
+{
+    return outer.lower.x <= inner.lower.x && outer.lower.y <= inner.lower.y && outer.lower.z <= inner.lower.z &&
+           inner.upper.x <= outer.upper.x && inner.upper.y <= outer.upper.y && inner.upper.z <= outer.upper.z;
+}
+
+bool DynamicAABBTree::Overlaps(const AABB &a, const AABB &b)
+{
+    return a.lower.x <= b.upper.x && b.lower.x <= a.upper.x &&
+           a.lower.y <= b.upper.y && b.lower.y <= a.upper.y &&
+           a.lower.z <= b.upper.z && b.lower.z <= a.upper.z;
+}
+
+float DynamicAABBTree::SurfaceArea(const AABB &box)
+{
+    float x = box.upper.x - box.lower.x;
+    float y = box.upper.y - box.lower.y;
+    float z = box.upper.z - box.lower.z;
+    return 2.0f * (x * y + y * z + z * x);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "ISpatialIndex.h"
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class DynamicAABBTree
+ * @brief Bounding volume hierarchy of axis-aligned boxes that supports inserting, moving and removing entries
+ *
+ * Every entry (proxy) is stored with a "fat" box that is a bit larger than the real one, so small movements
+ * don't touch the tree at all. When an entry leaves its fat box it's removed and reinserted, which is O(log n)
+ * thanks to the tree being kept balanced with rotations.
+ *
+ * Queries walk the tree from the root and skip every subtree whose box misses, so they cost O(log n + k) rather
+ * than a walk over every entity. Results are conservative (fat boxes), callers that need exact answers should
+ * test the real bounds of what comes back.
+ */
+class DynamicAABBTree : public ISpatialIndex
+{
+public:
+    static constexpr std::int32_t NULL_NODE = NULL_PROXY;
+
+    /** @param margin How much every box is grown on each side when it's inserted */
+    explicit DynamicAABBTree(float margin = 0.1f);
+
+    std::int32_t CreateProxy(const DirectX::BoundingBox &bounds, EntityID entity) override;
+    void DestroyProxy(std::int32_t proxy) override;
+
+    /** @return true if the entry had to be reinserted, false if it still fits in its fat box */
+    bool MoveProxy(std::int32_t proxy, const DirectX::BoundingBox &bounds) override;
+
+    EntityID GetEntity(std::int32_t proxy) const { return nodes[proxy].entity; }
+    DirectX::BoundingBox GetFatBounds(std::int32_t proxy) const;
+
+    void Clear() override;
+    size_t GetProxyCount() const override { return proxyCount; }
+    SpatialIndexType GetType() const override { return SpatialIndexType::BoundingVolumeHierarchy; }
+    int GetHeight() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+
+    void QueryFrustum(const DirectX::XMFLOAT4 (&planes)[6], std::vector<EntityID> &results) const override;
+    void QuerySphere(const DirectX::BoundingSphere &sphere, std::vector<EntityID> &results) const override;
+    void QueryBox(const DirectX::BoundingBox &box, std::vector<EntityID> &results) const override;
+    void QueryRay(const DirectX::XMFLOAT3 &origin, const DirectX::XMFLOAT3 &direction, float maxDistance,
+                  std::vector<EntityID> &results) const override;
+
+private:
+    struct AABB
+    {
+        DirectX::XMFLOAT3 lower;
+        DirectX::XMFLOAT3 upper;
+    };
+
+    struct Node
+    {
+        AABB box;
+        EntityID entity = INVALID_ENTITY;
+        std::int32_t parent = NULL_NODE; // next free node while the node is on the free list
+        std::int32_t child1 = NULL_NODE;
+        std::int32_t child2 = NULL_NODE;
+        std::int32_t height = -1; // 0 for leaves, -1 for free nodes
+
+        bool IsLeaf() const { return child1 == NULL_NODE; }
+    };
+
+    std::int32_t AllocateNode();
+    void FreeNode(std::int32_t node);
+
+    void InsertLeaf(std::int32_t leaf);
+    void RemoveLeaf(std::int32_t leaf);
+
+    // rotates the subtree at node if it's out of balance, returns the new subtree root
+    std::int32_t Balance(std::int32_t node);
+
+    // refits boxes and heights from node up to the root, balancing on the way
+    void FixUpwards(std::int32_t node);
+
+    template <typename Overlaps>
+    void Query(Overlaps &&overlaps, std::vector<EntityID> &results) const;
+
+    static AABB FromBounds(const DirectX::BoundingBox &bounds, float margin);
+    static AABB Combine(const AABB &a, const AABB &b);
+    static bool Contains(const AABB &outer, const AABB &inner);
+    static bool Overlaps(const AABB &a, const AABB &b);
+    static float SurfaceArea(const AABB &box);
+
+    std::vector<Node> nodes;
+    std::int32_t root = NULL_NODE;
+    std::int32_t freeList = NULL_NODE;
+    size_t proxyCount = 0;
+    float margin;
+};
@@ -0,0 +1,16 @@
+#include "ISpatialIndex.h"
+#include "DynamicAABBTree.h"
+#include "SpatialHashGrid.h"
+
+std::unique_ptr<ISpatialIndex> ISpatialIndex::Create(SpatialIndexType type)
+{
+    switch (type)
+    {
+    case SpatialIndexType::HashGrid:
+        return std::make_unique<SpatialHashGrid>();
+
+    case SpatialIndexType::BoundingVolumeHierarchy:
+    default:
+        return std::make_unique<DynamicAABBTree>();
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../ECS/Component.h"
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @enum SpatialIndexType
+ * @brief The spatial index implementations a scene can pick from
+ */
+enum class SpatialIndexType
+{
+    BoundingVolumeHierarchy, // DynamicAABBTree, best for mostly static scenes and long or selective queries
+    HashGrid,                // SpatialHashGrid, constant time moves for scenes where most things move every frame
+};
+
+/**
+ * @class ISpatialIndex
+ * @brief Common interface of the structures that find entities by their world space bounds
+ *
+ * Every entry (proxy) is an entity with a box. Queries are conservative: they can return entries that only
+ * come close to the query volume, but never miss one that touches it.
+ */
+class ISpatialIndex
+{
+public:
+    static constexpr std::int32_t NULL_PROXY = -1;
+
+    virtual ~ISpatialIndex() = default;
+
+    /** @brief Creates the index for the given type */
+    static std::unique_ptr<ISpatialIndex> Create(SpatialIndexType type);
+
+    /**
+     * @brief Inserts an entry
+     * @return Proxy ID used to move or remove the entry later
+     */
+    virtual std::int32_t CreateProxy(const DirectX::BoundingBox &bounds, EntityID entity) = 0;
+    virtual void DestroyProxy(std::int32_t proxy) = 0;
+
+    /**
+     * @brief Updates the bounds of an entry
+     * @return true if the entry had to be moved inside the structure, false if only its bounds changed
+     */
+    virtual bool MoveProxy(std::int32_t proxy, const DirectX::BoundingBox &bounds) = 0;
+
+    virtual void Clear() = 0;
+    virtual size_t GetProxyCount() const = 0;
+    virtual SpatialIndexType GetType() const = 0;
+
+    /**
+     * @brief Entities whose box is at least partly inside the frustum
+     * @param planes Frustum planes with normals pointing inwards (see FrustumCuller)
+     */
+    virtual void QueryFrustum(const DirectX::XMFLOAT4 (&planes)[6], std::vector<EntityID> &results) const = 0;
+    virtual void QuerySphere(const DirectX::BoundingSphere &sphere, std::vector<EntityID> &results) const = 0;
+    virtual void QueryBox(const DirectX::BoundingBox &box, std::vector<EntityID> &results) const = 0;
+
+    /**
+     * @brief Entities whose box is hit by a ray
+     * @param origin Start of the ray
+     * @param direction Direction of the ray, doesn't need to be normalized (maxDistance is in units of its length)
+     * @param maxDistance Where the ray stops
+     */
+    virtual void QueryRay(const DirectX::XMFLOAT3 &origin, const DirectX::XMFLOAT3 &direction, float maxDistance,
+                          std::vector<EntityID> &results) const = 0;
+};
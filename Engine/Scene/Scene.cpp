@@ -53,6 +53,10 @@ EntityID Scene::CreateCube(const DirectX::XMFLOAT3 &position, const DirectX::XMF
         mesh->indexBuffer = cubeMeshData.indexBuffer;
         mesh->indexCount = cubeMeshData.indexCount;
         mesh->vertexStride = cubeMeshData.vertexStride;
+        mesh->localBounds = cubeMeshData.boundingBox;
+        mesh->localSphere = cubeMeshData.boundingSphere;
+        mesh->hasBounds = true;
+        mesh->occluderGeometry = cubeMeshData.occluderGeometry;
     }
 
     auto *material = registry.AddComponent<MaterialComponent>(entity);
@@ -144,6 +148,10 @@ EntityID Scene::CreateSphere(float radius, int slices, int stacks,
         mesh->indexBuffer = sphereMeshData.indexBuffer;
         mesh->indexCount = sphereMeshData.indexCount;
         mesh->vertexStride = sphereMeshData.vertexStride;
+        mesh->localBounds = sphereMeshData.boundingBox;
+        mesh->localSphere = sphereMeshData.boundingSphere;
+        mesh->hasBounds = true;
+        mesh->occluderGeometry = sphereMeshData.occluderGeometry;
     }
 
     // Add material component
@@ -175,6 +183,10 @@ EntityID Scene::CreateGroundPlane(float width, float depth, int xDivs, int zDivs
         mesh->indexBuffer = planeMeshData.indexBuffer;
         mesh->indexCount = planeMeshData.indexCount;
         mesh->vertexStride = planeMeshData.vertexStride;
+        mesh->localBounds = planeMeshData.boundingBox;
+        mesh->localSphere = planeMeshData.boundingSphere;
+        mesh->hasBounds = true;
+        mesh->occluderGeometry = planeMeshData.occluderGeometry;
     }
 
     // add material component
@@ -4,6 +4,7 @@
 #include "../Engine/Resources/MeshManager.h"
 #include "../Engine/Resources/ShaderManager.h"
 #include "../Engine/Resources/ResourceManager.h"
+#include "ISpatialIndex.h"
 #include <DirectXMath.h>
 #include <string>
 #include <memory>
@@ -37,9 +38,14 @@ public:
 
     std::string GetName() const { return name; }
 
+    // which spatial index the scene's meshes should go in, scenes where most things move every frame want the hash grid
+    void SetSpatialIndexType(SpatialIndexType type) { spatialIndexType = type; }
+    SpatialIndexType GetSpatialIndexType() const { return spatialIndexType; }
+
 private:
     Registry &registry;
     std::string name;
+    SpatialIndexType spatialIndexType = SpatialIndexType::BoundingVolumeHierarchy;
 
     // ??? nullptrs??????????????????????????
     std::shared_ptr<MeshManager> meshManager = nullptr;
@@ -0,0 +1,377 @@
+#include "SpatialHashGrid.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    // cell coordinates are packed into 21 bits each for the hash key
+    constexpr std::int32_t COORD_LIMIT = 1 << 20;
+    constexpr std::uint64_t COORD_MASK = (1ull << 21) - 1;
+
+    enum class Overlap
+    {
+        Outside,
+        Intersects,
+        Inside,
+    };
+
+    float LargestExtent(const BoundingBox &box)
+    {
+        return std::max({box.Extents.x, box.Extents.y, box.Extents.z});
+    }
+
+    Overlap ClassifyFrustum(const XMFLOAT4 (&planes)[6], const BoundingBox &box)
+    {
+        Overlap result = Overlap::Inside;
+        for (const XMFLOAT4 &plane : planes)
+        {
+            float distance = plane.x * box.Center.x + plane.y * box.Center.y + plane.z * box.Center.z + plane.w;
+            float radius = std::fabs(plane.x) * box.Extents.x + std::fabs(plane.y) * box.Extents.y + std::fabs(plane.z) * box.Extents.z;
+
+            if (distance + radius < 0.0f)
+                return Overlap::Outside;
+            if (distance - radius < 0.0f)
+                result = Overlap::Intersects;
+        }
+        return result;
+    }
+
+    bool SphereOverlaps(const BoundingSphere &sphere, const BoundingBox &box)
+    {
+        const float center[3] = {sphere.Center.x, sphere.Center.y, sphere.Center.z};
+        const float boxCenter[3] = {box.Center.x, box.Center.y, box.Center.z};
+        const float extents[3] = {box.Extents.x, box.Extents.y, box.Extents.z};
+
+        float distanceSquared = 0.0f;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float closest = std::clamp(center[axis], boxCenter[axis] - extents[axis], boxCenter[axis] + extents[axis]);
+            distanceSquared += (center[axis] - closest) * (center[axis] - closest);
+        }
+        return distanceSquared <= sphere.Radius * sphere.Radius;
+    }
+
+    Overlap ClassifyBox(const BoundingBox &query, const BoundingBox &box)
+    {
+        const float queryCenter[3] = {query.Center.x, query.Center.y, query.Center.z};
+        const float queryExtents[3] = {query.Extents.x, query.Extents.y, query.Extents.z};
+        const float boxCenter[3] = {box.Center.x, box.Center.y, box.Center.z};
+        const float boxExtents[3] = {box.Extents.x, box.Extents.y, box.Extents.z};
+
+        Overlap result = Overlap::Inside;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float distance = std::fabs(queryCenter[axis] - boxCenter[axis]);
+            if (distance > queryExtents[axis] + boxExtents[axis])
+                return Overlap::Outside;
+            if (distance + boxExtents[axis] > queryExtents[axis])
+                result = Overlap::Intersects;
+        }
+        return result;
+    }
+
+    bool RayHits(const float (&start)[3], const float (&step)[3], float maxDistance, const BoundingBox &box)
+    {
+        const float center[3] = {box.Center.x, box.Center.y, box.Center.z};
+        const float extents[3] = {box.Extents.x, box.Extents.y, box.Extents.z};
+
+        float entry = 0.0f;
+        float exit = maxDistance;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float lower = center[axis] - extents[axis];
+            float upper = center[axis] + extents[axis];
+
+            if (std::fabs(step[axis]) < 1e-8f)
+            {
+                if (start[axis] < lower || start[axis] > upper)
+                    return false;
+                continue;
+            }
+
+            float inverse = 1.0f / step[axis];
+            float slabEntry = (lower - start[axis]) * inverse;
+            float slabExit = (upper - start[axis]) * inverse;
+            if (slabEntry > slabExit)
+                std::swap(slabEntry, slabExit);
+
+            entry = std::max(entry, slabEntry);
+            exit = std::min(exit, slabExit);
+            if (entry > exit)
+                return false;
+        }
+        return true;
+    }
+}
+
+SpatialHashGrid::SpatialHashGrid(float cellSize) : cellSize(cellSize), inverseCellSize(1.0f / cellSize)
+{
+}
+
+std::int32_t SpatialHashGrid::CreateProxy(const BoundingBox &bounds, EntityID entity)
+{
+    std::int32_t proxy;
+    if (freeProxies.empty())
+    {
+        proxy = static_cast<std::int32_t>(proxies.size());
+        proxies.emplace_back();
+    }
+    else
+    {
+        proxy = freeProxies.back();
+        freeProxies.pop_back();
+    }
+
+    proxies[proxy].bounds = bounds;
+    proxies[proxy].entity = entity;
+    AddToCell(proxy);
+
+    ++proxyCount;
+    return proxy;
+}
+
+void SpatialHashGrid::DestroyProxy(std::int32_t proxy)
+{
+    assert(proxy >= 0 && proxy < static_cast<std::int32_t>(proxies.size()) && proxies[proxy].cell != NULL_PROXY);
+
+    RemoveFromCell(proxy);
+    proxies[proxy] = Proxy();
+    freeProxies.push_back(proxy);
+    --proxyCount;
+}
+
+bool SpatialHashGrid::MoveProxy(std::int32_t proxy, const BoundingBox &bounds)
+{
+    assert(proxy >= 0 && proxy < static_cast<std::int32_t>(proxies.size()) && proxies[proxy].cell != NULL_PROXY);
+
+    Proxy &entry = proxies[proxy];
+    Cell &cell = cells[entry.cell];
+
+    // same cell, the cell only has to be loose enough for the new size
+    if (KeyOf(CoordOf(bounds.Center)) == cell.key)
+    {
+        entry.bounds = bounds;
+        cell.looseness = std::max(cell.looseness, LargestExtent(bounds));
+        maxLooseness = std::max(maxLooseness, cell.looseness);
+        return false;
+    }
+
+    RemoveFromCell(proxy);
+    proxies[proxy].bounds = bounds;
+    AddToCell(proxy);
+    return true;
+}
+
+void SpatialHashGrid::Clear()
+{
+    proxies.clear();
+    freeProxies.clear();
+    cells.clear();
+    cellLookup.clear();
+    proxyCount = 0;
+    maxLooseness = 0.0f;
+}
+
+void SpatialHashGrid::QueryFrustum(const XMFLOAT4 (&planes)[6], std::vector<EntityID> &results) const
+{
+    results.clear();
+
+    // the frustum can't be turned into a cell range cheaply, so every occupied cell is tested instead
+    for (const Cell &cell : cells)
+    {
+        Overlap overlap = ClassifyFrustum(planes, CellBounds(cell));
+        if (overlap == Overlap::Outside)
+            continue;
+
+        for (std::int32_t proxy : cell.proxies)
+        {
+            if (overlap == Overlap::Inside || ClassifyFrustum(planes, proxies[proxy].bounds) != Overlap::Outside)
+                results.push_back(proxies[proxy].entity);
+        }
+    }
+}
+
+void SpatialHashGrid::QuerySphere(const BoundingSphere &sphere, std::vector<EntityID> &results) const
+{
+    results.clear();
+
+    BoundingBox box;
+    box.Center = sphere.Center;
+    box.Extents = {sphere.Radius, sphere.Radius, sphere.Radius};
+
+    ForEachCellNear(box, [&](const Cell &cell)
+                    {
+                        if (!SphereOverlaps(sphere, CellBounds(cell)))
+                            return;
+
+                        for (std::int32_t proxy : cell.proxies)
+                        {
+                            if (SphereOverlaps(sphere, proxies[proxy].bounds))
+                                results.push_back(proxies[proxy].entity);
+                        }
+                    });
+}
+
+void SpatialHashGrid::QueryBox(const BoundingBox &box, std::vector<EntityID> &results) const
+{
+    results.clear();
+
+    ForEachCellNear(box, [&](const Cell &cell)
+                    {
+                        Overlap overlap = ClassifyBox(box, CellBounds(cell));
+                        if (overlap == Overlap::Outside)
+                            return;
+
+                        for (std::int32_t proxy : cell.proxies)
+                        {
+                            if (overlap == Overlap::Inside || ClassifyBox(box, proxies[proxy].bounds) != Overlap::Outside)
+                                results.push_back(proxies[proxy].entity);
+                        }
+                    });
+}
+
+void SpatialHashGrid::QueryRay(const XMFLOAT3 &origin, const XMFLOAT3 &direction, float maxDistance,
+                               std::vector<EntityID> &results) const
+{
+    results.clear();
+
+    const float start[3] = {origin.x, origin.y, origin.z};
+    const float step[3] = {direction.x, direction.y, direction.z};
+
+    // the box around the segment limits the cells for short rays, long ones end up walking every occupied cell
+    XMFLOAT3 end = {origin.x + direction.x * maxDistance, origin.y + direction.y * maxDistance, origin.z + direction.z * maxDistance};
+    BoundingBox segment;
+    segment.Center = {(origin.x + end.x) * 0.5f, (origin.y + end.y) * 0.5f, (origin.z + end.z) * 0.5f};
+    segment.Extents = {std::fabs(end.x - origin.x) * 0.5f, std::fabs(end.y - origin.y) * 0.5f, std::fabs(end.z - origin.z) * 0.5f};
+
+    ForEachCellNear(segment, [&](const Cell &cell)
+                    {
+                        if (!RayHits(start, step, maxDistance, CellBounds(cell)))
+                            return;
+
+                        for (std::int32_t proxy : cell.proxies)
+                        {
+                            if (RayHits(start, step, maxDistance, proxies[proxy].bounds))
+                                results.push_back(proxies[proxy].entity);
+                        }
+                    });
+}
+
+SpatialHashGrid::CellCoord SpatialHashGrid::CoordOf(const XMFLOAT3 &point) const
+{
+    // clamped before the cast so far away (or infinite) points land in the outermost cells
+    auto toCell = [this](float value)
+    {
+        float cell = std::floor(value * inverseCellSize);
+        cell = std::clamp(cell, static_cast<float>(-COORD_LIMIT), static_cast<float>(COORD_LIMIT - 1));
+        return static_cast<std::int32_t>(cell);
+    };
+
+    return {toCell(point.x), toCell(point.y), toCell(point.z)};
+}
+
+std::uint64_t SpatialHashGrid::KeyOf(const CellCoord &coord)
+{
+    return ((static_cast<std::uint64_t>(coord.x) & COORD_MASK) << 42) |
+           ((static_cast<std::uint64_t>(coord.y) & COORD_MASK) << 21) |
+           (static_cast<std::uint64_t>(coord.z) & COORD_MASK);
+}
+
+BoundingBox SpatialHashGrid::CellBounds(const Cell &cell) const
+{
+    float halfSize = cellSize * 0.5f;
+    float extent = halfSize + cell.looseness;
+
+    BoundingBox bounds;
+    bounds.Center = {cell.coord.x * cellSize + halfSize, cell.coord.y * cellSize + halfSize, cell.coord.z * cellSize + halfSize};
+    bounds.Extents = {extent, extent, extent};
+    return bounds;
+}
+
+void SpatialHashGrid::AddToCell(std::int32_t proxy)
+{
+    Proxy &entry = proxies[proxy];
+    CellCoord coord = CoordOf(entry.bounds.Center);
+    std::uint64_t key = KeyOf(coord);
+
+    auto [it, isNew] = cellLookup.try_emplace(key, static_cast<std::int32_t>(cells.size()));
+    if (isNew)
+    {
+        cells.emplace_back();
+        cells.back().coord = coord;
+        cells.back().key = key;
+    }
+
+    Cell &cell = cells[it->second];
+    entry.cell = it->second;
+    entry.slotInCell = static_cast<std::uint32_t>(cell.proxies.size());
+    cell.proxies.push_back(proxy);
+
+    cell.looseness = std::max(cell.looseness, LargestExtent(entry.bounds));
+    maxLooseness = std::max(maxLooseness, cell.looseness);
+}
+
+void SpatialHashGrid::RemoveFromCell(std::int32_t proxy)
+{
+    Proxy &entry = proxies[proxy];
+    std::int32_t cellIndex = entry.cell;
+    Cell &cell = cells[cellIndex];
+
+    // swap with the last proxy of the cell
+    std::int32_t last = cell.proxies.back();
+    cell.proxies[entry.slotInCell] = last;
+    proxies[last].slotInCell = entry.slotInCell;
+    cell.proxies.pop_back();
+    entry.cell = NULL_PROXY;
+
+    if (!cell.proxies.empty())
+        return;
+
+    // empty cells are dropped so queries only ever walk occupied ones, the last cell takes its place
+    cellLookup.erase(cell.key);
+    if (cellIndex != static_cast<std::int32_t>(cells.size()) - 1)
+    {
+        cells[cellIndex] = std::move(cells.back());
+        cellLookup[cells[cellIndex].key] = cellIndex;
+        for (std::int32_t moved : cells[cellIndex].proxies)
+            proxies[moved].cell = cellIndex;
+    }
+    cells.pop_back();
+}
+
+template <typename Visit>
+void SpatialHashGrid::ForEachCellNear(const BoundingBox &box, Visit &&visit) const
+{
+    // entries reach out of their cell by at most maxLooseness, so the range is grown by that much
+    float reach = maxLooseness;
+    CellCoord lower = CoordOf({box.Center.x - box.Extents.x - reach, box.Center.y - box.Extents.y - reach, box.Center.z - box.Extents.z - reach});
+    CellCoord upper = CoordOf({box.Center.x + box.Extents.x + reach, box.Center.y + box.Extents.y + reach, box.Center.z + box.Extents.z + reach});
+
+    double rangeSize = (static_cast<double>(upper.x) - lower.x + 1.0) *
+                       (static_cast<double>(upper.y) - lower.y + 1.0) *
+                       (static_cast<double>(upper.z) - lower.z + 1.0);
+
+    // looking up more cells than are occupied is slower than just walking the occupied ones
+    if (rangeSize > static_cast<double>(cells.size()))
+    {
+        for (const Cell &cell : cells)
+            visit(cell);
+        return;
+    }
+
+    for (std::int32_t z = lower.z; z <= upper.z; ++z)
+    {
+        for (std::int32_t y = lower.y; y <= upper.y; ++y)
+        {
+            for (std::int32_t x = lower.x; x <= upper.x; ++x)
+            {
+                auto it = cellLookup.find(KeyOf({x, y, z}));
+                if (it != cellLookup.end())
+                    visit(cells[it->second]);
+            }
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ISpatialIndex.h"
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class SpatialHashGrid
+ * @brief Loose uniform grid stored in a hash map keyed by cell coordinates
+ *
+ * Every entry lives in exactly one cell, the one that contains the center of its box. A cell is "loose": its
+ * bounds are grown by the largest half-size of the entries in it, so entries can stick out of the cell without
+ * being stored in several cells. Moving an entry is O(1): it either stays in its cell (only the box is updated)
+ * or is swapped out of one cell's list and appended to another.
+ *
+ * Only occupied cells exist. Queries either look up the cells a query box covers or, when that's more cells than
+ * are occupied, walk the occupied cells. There is no tree to refit, so updates stay cheap even when everything
+ * moves, at the cost of queries that are less selective than DynamicAABBTree's for very uneven scenes.
+ */
+class SpatialHashGrid : public ISpatialIndex
+{
+public:
+    /** @param cellSize Edge length of a cell, a few times the size of a typical entry works well */
+    explicit SpatialHashGrid(float cellSize = 4.0f);
+
+    std::int32_t CreateProxy(const DirectX::BoundingBox &bounds, EntityID entity) override;
+    void DestroyProxy(std::int32_t proxy) override;
+
+    /** @return true if the entry moved to another cell, false if it stayed in its cell */
+    bool MoveProxy(std::int32_t proxy, const DirectX::BoundingBox &bounds) override;
+
+    void Clear() override;
+    size_t GetProxyCount() const override { return proxyCount; }
+    SpatialIndexType GetType() const override { return SpatialIndexType::HashGrid; }
+    size_t GetCellCount() const { return cells.size(); }
+
+    void QueryFrustum(const DirectX::XMFLOAT4 (&planes)[6], std::vector<EntityID> &results) const override;
+    void QuerySphere(const DirectX::BoundingSphere &sphere, std::vector<EntityID> &results) const override;
+    void QueryBox(const DirectX::BoundingBox &box, std::vector<EntityID> &results) const override;
+    void QueryRay(const DirectX::XMFLOAT3 &origin, const DirectX::XMFLOAT3 &direction, float maxDistance,
+                  std::vector<EntityID> &results) const override;
+
+private:
+    struct CellCoord
+    {
+        std::int32_t x, y, z;
+    };
+
+    struct Proxy
+    {
+        DirectX::BoundingBox bounds;
+        EntityID entity = INVALID_ENTITY;
+        std::int32_t cell = NULL_PROXY;   // index into cells, NULL_PROXY while the proxy is free
+        std::uint32_t slotInCell = 0;     // position in the cell's proxy list
+    };
+
+    struct Cell
+    {
+        CellCoord coord;
+        std::uint64_t key;
+        std::vector<std::int32_t> proxies;
+        float looseness = 0.0f; // largest half-size of anything that was in the cell since it was created
+    };
+
+    CellCoord CoordOf(const DirectX::XMFLOAT3 &point) const;
+    static std::uint64_t KeyOf(const CellCoord &coord);
+
+    // loose bounds of a cell, everything stored in it is inside
+    DirectX::BoundingBox CellBounds(const Cell &cell) const;
+
+    void AddToCell(std::int32_t proxy);
+    void RemoveFromCell(std::int32_t proxy);
+
+    // calls visit(cell) for every cell whose loose bounds can overlap the box
+    template <typename Visit>
+    void ForEachCellNear(const DirectX::BoundingBox &box, Visit &&visit) const;
+
+    float cellSize;
+    float inverseCellSize;
+    float maxLooseness = 0.0f; // largest looseness of any cell, bounds how far entries reach out of their cell
+
+    std::vector<Proxy> proxies;
+    std::vector<std::int32_t> freeProxies;
+    size_t proxyCount = 0;
+
+    std::vector<Cell> cells; // occupied cells only
+    std::unordered_map<std::uint64_t, std::int32_t> cellLookup;
+};
@@ -0,0 +1,72 @@
+// same as vertexShader.hlsl, but the world matrix comes from the per instance stream (slot 1)
+// the constant buffer is shared with the normal shader, for instanced draws world is the identity and wvp is view * projection
+// the light list comes from the instance stream too, the one in the constant buffer is ignored
+cbuffer MatrixBuffer : register(b0)
+{
+    matrix world;
+    matrix wvp;
+};
+
+struct VS_INPUT
+{
+    float3 position : POSITION;
+    float3 normal   : NORMAL;
+    float4 color    : COLOR;
+    float2 texCoord : TEXCOORD0;
+    float3 tangent  : TANGENT;
+    float3 bitangent : BITANGENT;
+
+    // rows of the instance's world matrix
+    float4 instanceWorld0 : INSTANCE_WORLD0;
+    float4 instanceWorld1 : INSTANCE_WORLD1;
+    float4 instanceWorld2 : INSTANCE_WORLD2;
+    float4 instanceWorld3 : INSTANCE_WORLD3;
+
+    // the instance's light list
+    uint4 instanceLightCounts : INSTANCE_LIGHT_COUNTS;
+    uint4 instanceLights0     : INSTANCE_LIGHTS0;
+    uint4 instanceLights1     : INSTANCE_LIGHTS1;
+};
+
+struct PS_INPUT
+{
+    float4 position     : SV_POSITION;
+    float4 color        : COLOR;
+    float2 texCoord     : TEXCOORD0;
+    float3 normal       : NORMAL;
+    float3 tangent      : TANGENT;
+    float3 bitangent    : BITANGENT;
+    float3 worldPos     : TEXCOORD1;
+
+    // same for every vertex of the instance
+    nointerpolation uint4 lightCounts : OBJECT_LIGHT_COUNTS;
+    nointerpolation uint4 lights0     : OBJECT_LIGHTS0;
+    nointerpolation uint4 lights1     : OBJECT_LIGHTS1;
+};
+
+PS_INPUT main(VS_INPUT input)
+{
+    PS_INPUT output;
+
+    float4x4 instanceWorld = float4x4(input.instanceWorld0, input.instanceWorld1, input.instanceWorld2, input.instanceWorld3);
+    float4 worldPos = mul(mul(float4(input.position, 1.0f), instanceWorld), world);
+
+    // transform vertex position to clip space
+    output.position = mul(mul(float4(input.position, 1.0f), instanceWorld), wvp);
+    output.worldPos = worldPos.xyz;
+
+    // pass color and texture coordinates through
+    output.color = input.color;
+    output.texCoord = input.texCoord;
+
+    // transform normal vectors to world space
+    output.normal = normalize(mul(mul(float4(input.normal, 0.0f), instanceWorld), world).xyz);
+    output.tangent = normalize(mul(mul(float4(input.tangent, 0.0f), instanceWorld), world).xyz);
+    output.bitangent = normalize(mul(mul(float4(input.bitangent, 0.0f), instanceWorld), world).xyz);
+
+    output.lightCounts = input.instanceLightCounts;
+    output.lights0 = input.instanceLights0;
+    output.lights1 = input.instanceLights1;
+
+    return output;
+}
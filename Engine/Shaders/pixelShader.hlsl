@@ -5,47 +5,82 @@ Texture2D diffuseTexture : register(t0);
 Texture2D normalTexture : register(t1);
 SamplerState textureSampler : register(s0);
 
-// light types
 // might need to fix this because my lights dont work like they should
 // also i really wanna add debug boxes for the lights
 
-// support for multiple lights
-#define LIGHT_DIRECTIONAL 0
-#define LIGHT_POINT 1
-#define LIGHT_SPOT 2
+// one struct per light type, so each list only carries what its type needs
+// same layouts as the cpu side in Buffers.h
+struct DirectionalLight
+{
+    float3 toLight; // normalized
+    float intensity;
+    float3 color;
+    float padding;
+};
 
-// maximum number of lights
-#define MAX_LIGHTS 8
+struct PointLight
+{
+    float3 position;
+    float range;
+    float3 color;
+    float intensity;
+};
 
-// so instead of a buffer, convert to a struct for light data
-struct LightData
+struct SpotLight
 {
-    float4 ambientColor;
-    float4 diffuseColor;
-    float3 lightDirection;
-    float padding1;
-    float3 lightPosition;
-    float lightRange;
-    float spotInnerCone;
-    float spotOuterCone;
-    int lightType;
-    float lightIntensity;
+    float3 position;
+    float range;
+    float3 color;
+    float intensity;
+    float3 direction; // normalized
+    float cosOuterCone;
+    float cosInnerCone;
+    float3 padding;
 };
 
-// modified light buffer to support multiple lights
+// clustered lighting, the cpu sorts the point and spot lights into a grid over the view frustum
+// so each pixel only looks at the lights of its own cluster instead of all of them
 cbuffer LightBuffer : register(b1)
 {
-    LightData lights[MAX_LIGHTS];
-    int activeLightCount;
-    float3 padding;
+    float4 viewDepthPlane; // dot with (worldPos, 1) gives the view depth
+    float2 tileScale;      // pixel position to cluster x / y
+    float depthScale;      // depth slice = log(depth) * depthScale + depthBias
+    float depthBias;
+    uint directionalLightCount;
+    uint clusterCountX;
+    uint clusterCountY;
+    uint clusterCountZ;
 }
 
+// every light in a stable slot of its type's list, only the cpu's index lists say which slots are in use
+StructuredBuffer<DirectionalLight> directionalLights : register(t2);
+StructuredBuffer<PointLight> pointLights : register(t3);
+StructuredBuffer<SpotLight> spotLights : register(t4);
+// per cluster offset, point light count and spot light count in clusterLightIndices
+StructuredBuffer<uint3> clusterRanges : register(t5);
+// the directional slots first, then per cluster its point slots followed by its spot slots
+// cluster offsets count from after the directional ones
+StructuredBuffer<uint> clusterLightIndices : register(t6);
+
 cbuffer CameraBuffer : register(b2)
 {
     float3 cameraPosition;
     float padding2;
 }
 
+// cascaded shadow map of one directional light, one array slice per cascade (see ShadowCascades on the cpu)
+Texture2DArray shadowMap : register(t7);
+SamplerComparisonState shadowSampler : register(s1);
+
+cbuffer ShadowBuffer : register(b3)
+{
+    matrix cascadeViewProjection[4];
+    float4 cascadeSplits;     // far view depth of each cascade
+    float4 cascadeTexelSizes; // world size of a shadow map texel
+    uint shadowLightSlot;     // directional light slot that gets the shadows, 0xffffffff for none
+    float3 padding3;
+}
+
 struct PS_INPUT
 {
     float4 position  : SV_POSITION;
@@ -55,6 +90,11 @@ struct PS_INPUT
     float3 tangent   : TANGENT;
     float3 bitangent : BITANGENT;
     float3 worldPos  : TEXCOORD1;
+
+    // the draw's own light list, lightCounts.z is 0 when it uses the clusters instead
+    nointerpolation uint4 lightCounts : OBJECT_LIGHT_COUNTS;
+    nointerpolation uint4 lights0     : OBJECT_LIGHTS0;
+    nointerpolation uint4 lights1     : OBJECT_LIGHTS1;
 };
 
 // apply fresnel effect for a stylized rim lighting
@@ -100,86 +140,130 @@ float3 CalculateStylizedSpecular(float3 normal, float3 lightDir, float3 viewDir,
     return specularColor * specular;
 }
 
-// so now we're using that light data struct
-// to determine the light contribution based on light type
-float3 CalculateDirectionalLight(LightData light, float3 normal, float3 viewDir, float3 baseColor, float roughness)
+// each light type has its own function and its own loop in main, so nothing branches on the type
+// the contributions are already scaled by the light's intensity
+float3 CalculateDirectionalLight(DirectionalLight light, float3 normal, float3 viewDir, float3 baseColor, float roughness)
 {
-    float3 lightDir = normalize(-light.lightDirection);
+    float3 lightDir = light.toLight;
     
     // stylized diffuse
-    float3 diffuse = CalculateStylizedDiffuse(normal, lightDir, light.diffuseColor.rgb);
+    float3 diffuse = CalculateStylizedDiffuse(normal, lightDir, light.color);
 
     // stylized specular
     // new specular power calculation using roughness
     float specPower = max(1.0f, 64.0f * (1.0f - roughness));
     float3 specular = CalculateStylizedSpecular(normal, lightDir, viewDir, float3(0.3f, 0.3f, 0.3f), specPower);
     
-    return (diffuse + specular) * baseColor;
+    return (diffuse + specular) * baseColor * light.intensity;
 }
 
-float3 CalculatePointLight(LightData light, float3 normal, float3 worldPos, float3 viewDir, float3 baseColor, float roughness)
+float3 CalculatePointLight(PointLight light, float3 normal, float3 worldPos, float3 viewDir, float3 baseColor, float roughness)
 {
-    float3 lightVec = light.lightPosition - worldPos;
+    float3 lightVec = light.position - worldPos;
     float distance = length(lightVec);
     
     // early out if beyond range with soft falloff
-    float rangeCheck = 1.0f - smoothstep(light.lightRange * 0.8f, light.lightRange, distance);
+    float rangeCheck = 1.0f - smoothstep(light.range * 0.8f, light.range, distance);
     if (rangeCheck <= 0.0f)
         return float3(0.0f, 0.0f, 0.0f);
     
     float3 lightDir = normalize(lightVec);
     
     // stylized diffuse
-    float3 diffuse = CalculateStylizedDiffuse(normal, lightDir, light.diffuseColor.rgb);
+    float3 diffuse = CalculateStylizedDiffuse(normal, lightDir, light.color);
     // stylized specular
     float specPower = max(1.0f, 64.0f * (1.0f - roughness));
     float3 specular = CalculateStylizedSpecular(normal, lightDir, viewDir, float3(0.3f, 0.3f, 0.3f), specPower);
     
     // new phys based attenuation with inverse square falloff
-    float attenFactor = saturate(1.0f - (distance / light.lightRange));
+    float attenFactor = saturate(1.0f - (distance / light.range));
     float attenuation = attenFactor * attenFactor;
 
     // subtle distance based color shift
     float3 colorShift = lerp(float3(1.0f, 0.9f, 1.0f), float3(1.0f, 1.0f, 1.0f), attenFactor);
     
-    return (diffuse + specular) * baseColor * attenuation * colorShift;
+    return (diffuse + specular) * baseColor * attenuation * colorShift * light.intensity;
 }
 
-float3 CalculateSpotLight(LightData light, float3 normal, float3 worldPos, float3 viewDir, float3 baseColor, float roughness)
+float3 CalculateSpotLight(SpotLight light, float3 normal, float3 worldPos, float3 viewDir, float3 baseColor, float roughness)
 {
-    float3 lightVec = light.lightPosition - worldPos;
+    float3 lightVec = light.position - worldPos;
     float distance = length(lightVec);
     
     // early out if beyond range
-    if (distance > light.lightRange)
+    if (distance > light.range)
         return float3(0.0f, 0.0f, 0.0f);
     
     float3 lightDir = normalize(lightVec);
     
     // spot cone calculation with stylized falloff
-    float spotFactor = dot(-lightDir, normalize(light.lightDirection));
+    float spotFactor = dot(-lightDir, light.direction);
     // soft spotfactor transition between inner and outer cone
-    float spotEdge = smoothstep(light.spotOuterCone, lerp(light.spotOuterCone, light.spotInnerCone, 0.5f), spotFactor);
+    float spotEdge = smoothstep(light.cosOuterCone, lerp(light.cosOuterCone, light.cosInnerCone, 0.5f), spotFactor);
     if (spotEdge <= 0.0f)
         return float3(0.0f, 0.0f, 0.0f);
     
     // stylized diffuse
-    float3 diffuse = CalculateStylizedDiffuse(normal, lightDir, light.diffuseColor.rgb);
+    float3 diffuse = CalculateStylizedDiffuse(normal, lightDir, light.color);
 
     // stylized specular
     float specPower = max(1.0f, 64.0f * (1.0f - roughness));
     float3 specular = CalculateStylizedSpecular(normal, lightDir, viewDir, float3(0.3f, 0.3f, 0.3f), specPower);
     
     // distance attenuation
-    float attenFactor = saturate(1.0f - (distance / light.lightRange));
+    float attenFactor = saturate(1.0f - (distance / light.range));
     float attenuation = attenFactor * attenFactor;
     
     // spot cone attenuation with improved inner-outer cone falloff
-    float spotRatio = smoothstep(light.spotOuterCone, light.spotInnerCone, spotFactor);
+    float spotRatio = smoothstep(light.cosOuterCone, light.cosInnerCone, spotFactor);
     spotRatio = pow(spotRatio, 1.5f); // add more contrast to spotlight edge
     attenuation *= spotRatio;
     
-    return (diffuse + specular) * baseColor * attenuation;
+    return (diffuse + specular) * baseColor * attenuation * light.intensity;
+}
+
+// 1 is lit and 0 in shadow, 3x3 taps of the bilinear comparison sampler
+float CalculateShadow(float3 worldPos, float3 geometryNormal)
+{
+    // nothing past the last cascade was drawn into the map, count it as lit
+    float viewDepth = dot(float4(worldPos, 1.0f), viewDepthPlane);
+    if (viewDepth >= cascadeSplits.w)
+        return 1.0f;
+
+    uint cascade = (uint)dot(float4(viewDepth >= cascadeSplits), float4(1.0f, 1.0f, 1.0f, 1.0f));
+
+    // pushed out along the surface normal by about a texel so the surface doesn't shadow itself (acne)
+    float3 offsetPos = worldPos + geometryNormal * cascadeTexelSizes[cascade] * 1.5f;
+    float4 shadowPos = mul(float4(offsetPos, 1.0f), cascadeViewProjection[cascade]);
+    float2 shadowUV = shadowPos.xy * float2(0.5f, -0.5f) + 0.5f;
+
+    float shadow = 0.0f;
+    [unroll]
+    for (int y = -1; y <= 1; y++)
+    {
+        [unroll]
+        for (int x = -1; x <= 1; x++)
+            shadow += shadowMap.SampleCmpLevelZero(shadowSampler, float3(shadowUV, cascade), shadowPos.z, int2(x, y));
+    }
+
+    return shadow / 9.0f;
+}
+
+// entry of the draw's light list, point slots first and then spot slots
+uint GetObjectLight(PS_INPUT input, uint index)
+{
+    return index < 4 ? input.lights0[index] : input.lights1[index - 4];
+}
+
+// same cluster the cpu put the lights in, x / y from the pixel and z from the view depth
+uint GetClusterIndex(float2 pixelPosition, float3 worldPos)
+{
+    uint2 tile = min(uint2(pixelPosition * tileScale), uint2(clusterCountX, clusterCountY) - 1);
+
+    float viewDepth = max(dot(float4(worldPos, 1.0f), viewDepthPlane), 1e-4f);
+    uint slice = (uint)clamp(log(viewDepth) * depthScale + depthBias, 0.0f, (float)(clusterCountZ - 1));
+
+    return (slice * clusterCountY + tile.y) * clusterCountX + tile.x;
 }
 
 float4 main(PS_INPUT input) : SV_Target
@@ -215,29 +299,47 @@ float4 main(PS_INPUT input) : SV_Target
     float3 globalAmbient = float3(0.1f, 0.1f, 0.1f) * baseColor;
     float3 finalColor = globalAmbient;
 
-    // iterate through active lights
-    for (int i = 0; i < activeLightCount; i++)
+    // directional lights reach every pixel, one of them can have shadows
+    for (uint i = 0; i < directionalLightCount; i++)
     {
-        float3 lightContribution = float3(0, 0, 0);
+        uint slot = clusterLightIndices[i];
+        DirectionalLight light = directionalLights[slot];
+        float shadow = slot == shadowLightSlot ? CalculateShadow(input.worldPos, N) : 1.0f;
+        finalColor += shadow * CalculateDirectionalLight(light, normal, viewDir, baseColor, roughness);
+    }
 
-        // add appropriate light contribution based on light type
-        if (lights[i].lightType == LIGHT_DIRECTIONAL)
+    if (input.lightCounts.z != 0)
+    {
+        // the few lights the cpu picked for this draw, the same for the whole draw so the branch is coherent
+        for (uint j = 0; j < input.lightCounts.x; j++)
         {
-            lightContribution += CalculateDirectionalLight(lights[i], normal, viewDir, baseColor, roughness);
+            PointLight light = pointLights[GetObjectLight(input, j)];
+            finalColor += CalculatePointLight(light, normal, input.worldPos, viewDir, baseColor, roughness);
         }
-        else if (lights[i].lightType == LIGHT_POINT)
+
+        for (uint k = 0; k < input.lightCounts.y; k++)
         {
-            lightContribution += CalculatePointLight(lights[i], normal, input.worldPos, viewDir, baseColor, roughness);
+            SpotLight light = spotLights[GetObjectLight(input, input.lightCounts.x + k)];
+            finalColor += CalculateSpotLight(light, normal, input.worldPos, viewDir, baseColor, roughness);
         }
-        else if (lights[i].lightType == LIGHT_SPOT)
+    }
+    else
+    {
+        // otherwise only the point and spot lights of this pixel's cluster, point ones first
+        uint3 cluster = clusterRanges[GetClusterIndex(input.position.xy, input.worldPos)];
+        uint first = directionalLightCount + cluster.x;
+        for (uint j = 0; j < cluster.y; j++)
         {
-            lightContribution += CalculateSpotLight(lights[i], normal, input.worldPos, viewDir, baseColor, roughness);
+            PointLight light = pointLights[clusterLightIndices[first + j]];
+            finalColor += CalculatePointLight(light, normal, input.worldPos, viewDir, baseColor, roughness);
         }
 
-        // apply light intensity
-        lightContribution *= lights[i].lightIntensity;
-        // add to final color
-        finalColor += lightContribution;
+        first += cluster.y;
+        for (uint k = 0; k < cluster.z; k++)
+        {
+            SpotLight light = spotLights[clusterLightIndices[first + k]];
+            finalColor += CalculateSpotLight(light, normal, input.worldPos, viewDir, baseColor, roughness);
+        }
     }
     
     // add stylized rim lighting
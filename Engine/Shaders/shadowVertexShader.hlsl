@@ -0,0 +1,18 @@
+// depth only, draws the shadow casters into a cascade of the shadow map
+// wvp is world * light view * cascade projection, there's no pixel shader
+cbuffer MatrixBuffer : register(b0)
+{
+    matrix world;
+    matrix wvp;
+};
+
+// only the position of the regular vertex layout
+struct VS_INPUT
+{
+    float3 position : POSITION;
+};
+
+float4 main(VS_INPUT input) : SV_POSITION
+{
+    return mul(float4(input.position, 1.0f), wvp);
+}
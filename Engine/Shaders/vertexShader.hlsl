@@ -2,6 +2,10 @@ cbuffer MatrixBuffer : register(b0)
 {
     matrix world;
     matrix wvp;
+
+    // the draw's own light list, passed through to the pixel shader
+    uint4 objectLightCounts; // point count, spot count, enabled
+    uint4 objectLights[2];   // point slots, then spot slots
 };
 
 struct VS_INPUT
@@ -23,6 +27,11 @@ struct PS_INPUT
     float3 tangent      : TANGENT;
     float3 bitangent    : BITANGENT;
     float3 worldPos     : TEXCOORD1;
+
+    // same for every vertex of the draw
+    nointerpolation uint4 lightCounts : OBJECT_LIGHT_COUNTS;
+    nointerpolation uint4 lights0     : OBJECT_LIGHTS0;
+    nointerpolation uint4 lights1     : OBJECT_LIGHTS1;
 };
 
 PS_INPUT main(VS_INPUT input)
@@ -42,6 +51,10 @@ PS_INPUT main(VS_INPUT input)
     output.normal = normalize(mul(float4(input.normal, 0.0f), world).xyz);
     output.tangent = normalize(mul(float4(input.tangent, 0.0f), world).xyz);
     output.bitangent = normalize(mul(float4(input.bitangent, 0.0f), world).xyz);
+
+    output.lightCounts = objectLightCounts;
+    output.lights0 = objectLights[0];
+    output.lights1 = objectLights[1];
     
     return output;
 }
\ No newline at end of file
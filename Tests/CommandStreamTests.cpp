@@ -0,0 +1,137 @@
+#include "TestFramework.h"
+#include "Rendering/CommandStream.h"
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Opcode = CommandStream::Opcode;
+
+    bool SameOperands(const CommandStream::Command &command, Opcode opcode, const std::vector<std::uint32_t> &operands)
+    {
+        if (command.opcode != opcode || operands.size() != CommandStream::GetOperandCount(opcode))
+            return false;
+
+        for (size_t i = 0; i < operands.size(); ++i)
+        {
+            if (command.operands[i] != operands[i])
+                return false;
+        }
+        return true;
+    }
+}
+
+TEST_CASE(CommandStreamRoundTripsEveryVarintLength)
+{
+    // the values on both sides of every byte boundary of the encoding, 1 to 5 bytes
+    const std::uint32_t values[] = {0, 1, 127, 128, 16383, 16384, 2097151, 2097152, 268435455, 268435456, 0xFFFFFFFFu};
+    const size_t lengths[] = {1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5};
+
+    CommandStream stream;
+    size_t expectedSize = 0;
+    bool isSizeRight = true;
+    for (size_t i = 0; i < std::size(values); ++i)
+    {
+        size_t before = stream.GetSize();
+        stream.Write(Opcode::SetViewport, {values[i], values[std::size(values) - 1 - i]});
+        expectedSize += 1 + lengths[i] + lengths[std::size(values) - 1 - i];
+        isSizeRight = isSizeRight && stream.GetSize() - before == 1 + lengths[i] + lengths[std::size(values) - 1 - i];
+    }
+    CHECK(isSizeRight);
+    CHECK(stream.GetSize() == expectedSize);
+
+    std::vector<CommandStream::Command> commands;
+    CHECK(CommandStream::Decode(stream.GetBytes(), commands));
+    CHECK(commands.size() == std::size(values));
+
+    bool isSame = commands.size() == std::size(values);
+    for (size_t i = 0; isSame && i < commands.size(); ++i)
+        isSame = SameOperands(commands[i], Opcode::SetViewport, {values[i], values[std::size(values) - 1 - i]});
+    CHECK(isSame);
+
+    // the bytes themselves, low 7 bits first with the top bit set on every byte but the last
+    CommandStream small;
+    small.Write(Opcode::SetPrimitiveTopology, {300});
+    CHECK(small.GetBytes() == std::vector<std::uint8_t>({static_cast<std::uint8_t>(Opcode::SetPrimitiveTopology), 0xAC, 0x02}));
+}
+
+TEST_CASE(CommandStreamRoundTripsRandomCommands)
+{
+    // every opcode with its own operand count, values spread over every length
+    std::mt19937 random(17);
+    std::uniform_int_distribution<int> opcode(0, static_cast<int>(Opcode::Count) - 1);
+    std::uniform_int_distribution<int> bits(0, 32);
+
+    std::vector<std::pair<Opcode, std::vector<std::uint32_t>>> written;
+    CommandStream stream;
+    for (int i = 0; i < 5000; ++i)
+    {
+        auto code = static_cast<Opcode>(opcode(random));
+        std::uint32_t operands[CommandStream::MAX_OPERANDS];
+        for (std::uint32_t &operand : operands)
+        {
+            int width = bits(random);
+            operand = width == 0 ? 0 : static_cast<std::uint32_t>(random()) >> (32 - width);
+        }
+
+        // Write takes an initializer list, so spell out each operand count
+        size_t count = CommandStream::GetOperandCount(code);
+        switch (count)
+        {
+        case 1: stream.Write(code, {operands[0]}); break;
+        case 2: stream.Write(code, {operands[0], operands[1]}); break;
+        case 3: stream.Write(code, {operands[0], operands[1], operands[2]}); break;
+        case 4: stream.Write(code, {operands[0], operands[1], operands[2], operands[3]}); break;
+        default: stream.Write(code, {operands[0], operands[1], operands[2], operands[3], operands[4]}); break;
+        }
+        written.push_back({code, std::vector<std::uint32_t>(operands, operands + count)});
+    }
+
+    std::vector<CommandStream::Command> commands;
+    CHECK(CommandStream::Decode(stream.GetBytes(), commands));
+
+    bool isSame = commands.size() == written.size();
+    for (size_t i = 0; isSame && i < commands.size(); ++i)
+        isSame = SameOperands(commands[i], written[i].first, written[i].second);
+    CHECK(isSame);
+
+    // appending streams is the same as writing everything into one
+    CommandStream first, second, both;
+    first.Write(Opcode::DrawIndexed, {36, 0, 0});
+    second.Write(Opcode::Present, {1});
+    both.Write(Opcode::DrawIndexed, {36, 0, 0});
+    both.Write(Opcode::Present, {1});
+    first.Append(second);
+    CHECK(first.GetBytes() == both.GetBytes());
+}
+
+TEST_CASE(CommandStreamRejectsMalformedBytes)
+{
+    CommandStream stream;
+    stream.Write(Opcode::DrawIndexed, {36, 0, 0});
+    stream.Write(Opcode::SetTexture, {0, 200});
+    std::vector<CommandStream::Command> commands;
+
+    // cut off in the middle of a varint, what came before is still decoded
+    std::vector<std::uint8_t> truncated(stream.GetBytes().begin(), stream.GetBytes().end() - 1);
+    CHECK(!CommandStream::Decode(truncated, commands));
+    CHECK(commands.size() == 1 && SameOperands(commands[0], Opcode::DrawIndexed, {36, 0, 0}));
+
+    // an opcode that doesn't exist
+    std::vector<std::uint8_t> badOpcode = stream.GetBytes();
+    badOpcode.push_back(static_cast<std::uint8_t>(Opcode::Count));
+    CHECK(!CommandStream::Decode(badOpcode, commands));
+    CHECK(commands.size() == 2);
+
+    // a varint longer than any uint32 needs
+    std::vector<std::uint8_t> tooLong = {static_cast<std::uint8_t>(Opcode::Present), 0x80, 0x80, 0x80, 0x80, 0x80, 0x01};
+    CHECK(!CommandStream::Decode(tooLong, commands));
+    CHECK(commands.empty());
+
+    // the disassembly lists what decoded and flags the rest
+    CHECK(CommandStream::Disassemble(stream.GetBytes()) == "DrawIndexed 36 0 0\nSetTexture 0 200\n");
+    CHECK(CommandStream::Disassemble(truncated) == "DrawIndexed 36 0 0\n<malformed>\n");
+}
@@ -0,0 +1,213 @@
+#include "TestFramework.h"
+#include "TestComponents.h"
+#include "ECS/ComponentPool.h"
+#include "ECS/Registry.h"
+#include <memory>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+
+namespace
+{
+    // the registry's storage before the sparse-set pools: type → (entity → heap allocated component)
+    // kept here as the baseline for the benchmark
+    class LegacyRegistry
+    {
+    public:
+        EntityID CreateEntity() { return nextEntityId++; }
+
+        template <typename T, typename... Args>
+        T *AddComponent(EntityID entity, Args &&...args)
+        {
+            auto &entityMap = componentMaps[std::type_index(typeid(T))];
+            auto component = std::make_unique<Boxed<T>>(std::forward<Args>(args)...);
+            T *componentPtr = &component->value;
+            entityMap[entity] = std::move(component);
+            return componentPtr;
+        }
+
+        template <typename T>
+        T *GetComponent(EntityID entity)
+        {
+            auto mapIt = componentMaps.find(std::type_index(typeid(T)));
+            if (mapIt == componentMaps.end())
+                return nullptr;
+
+            auto componentIt = mapIt->second.find(entity);
+            if (componentIt == mapIt->second.end())
+                return nullptr;
+
+            return &static_cast<Boxed<T> *>(componentIt->second.get())->value;
+        }
+
+        void DestroyEntity(EntityID entity)
+        {
+            for (auto &[type, entityMap] : componentMaps)
+                entityMap.erase(entity);
+        }
+
+    private:
+        // the old Component base had a virtual destructor, the boxes bring it back
+        struct BoxBase
+        {
+            virtual ~BoxBase() = default;
+        };
+
+        template <typename T>
+        struct Boxed : BoxBase
+        {
+            template <typename... Args>
+            explicit Boxed(Args &&...args) : value(std::forward<Args>(args)...) {}
+            T value;
+        };
+
+        EntityID nextEntityId = 1;
+        std::unordered_map<std::type_index, std::unordered_map<EntityID, std::unique_ptr<BoxBase>>> componentMaps;
+    };
+
+    // what a frame does with the components, the same for both registries
+    template <typename RegistryType>
+    float Integrate(RegistryType &registry, const std::vector<EntityID> &entities)
+    {
+        float sum = 0.0f;
+        for (EntityID entity : entities)
+        {
+            Position *position = registry.template GetComponent<Position>(entity);
+            Velocity *velocity = registry.template GetComponent<Velocity>(entity);
+            position->x += velocity->x;
+            position->y += velocity->y;
+            position->z += velocity->z;
+            sum += position->y;
+        }
+        return sum;
+    }
+
+    template <typename RegistryType>
+    void Populate(RegistryType &registry, std::vector<EntityID> &entities, size_t count)
+    {
+        entities.clear();
+        for (size_t i = 0; i < count; ++i)
+        {
+            EntityID entity = registry.CreateEntity();
+            registry.template AddComponent<Position>(entity, 0.0f, static_cast<float>(i % 7), 0.0f);
+            registry.template AddComponent<Velocity>(entity, 1.0f, 0.5f, 0.25f);
+            entities.push_back(entity);
+        }
+    }
+
+    // fastest of a few runs, tearing the registry down again isn't timed
+    template <typename RegistryType>
+    double MeasurePopulate(std::vector<EntityID> &entities, size_t count)
+    {
+        double best = 0.0;
+        for (int i = 0; i < 3; ++i)
+        {
+            RegistryType registry;
+            Stopwatch stopwatch;
+            Populate(registry, entities, count);
+            double elapsed = stopwatch.GetMilliseconds();
+            if (i == 0 || elapsed < best)
+                best = elapsed;
+        }
+        return best;
+    }
+}
+
+TEST_CASE(ComponentPoolSwapAndPopKeepsLookups)
+{
+    ComponentPool<Position> pool;
+    for (std::uint32_t i = 1; i <= 5; ++i)
+        pool.Emplace(MakeEntityID(i, 0), static_cast<float>(i), 0.0f, 0.0f);
+
+    // removing from the middle moves the last component into the hole
+    pool.Remove(MakeEntityID(2, 0));
+    CHECK(pool.Size() == 4);
+    CHECK(!pool.Contains(MakeEntityID(2, 0)));
+    CHECK(pool.Get(MakeEntityID(5, 0)) && pool.Get(MakeEntityID(5, 0))->x == 5.0f);
+
+    for (std::uint32_t i : {1u, 3u, 4u, 5u})
+        CHECK(pool.Get(MakeEntityID(i, 0)) && pool.Get(MakeEntityID(i, 0))->x == static_cast<float>(i));
+
+    // dense arrays stay parallel
+    const auto &entities = pool.GetEntities();
+    for (size_t i = 0; i < entities.size(); ++i)
+        CHECK(pool.GetComponents()[i].x == static_cast<float>(GetEntityIndex(entities[i])));
+}
+
+TEST_CASE(ComponentPoolIgnoresStaleHandles)
+{
+    ComponentPool<Position> pool;
+    pool.Emplace(MakeEntityID(3, 1), 1.0f, 2.0f, 3.0f);
+
+    // same slot, different generation
+    CHECK(!pool.Contains(MakeEntityID(3, 0)));
+    CHECK(pool.Get(MakeEntityID(3, 2)) == nullptr);
+    pool.Remove(MakeEntityID(3, 0));
+    CHECK(pool.Size() == 1);
+}
+
+TEST_CASE(RegistryRecyclesSlotsWithNewGenerations)
+{
+    Registry registry;
+    EntityID first = registry.CreateEntity();
+    registry.AddComponent<Position>(first, 1.0f, 0.0f, 0.0f);
+    registry.DestroyEntity(first);
+
+    EntityID second = registry.CreateEntity();
+    CHECK(GetEntityIndex(second) == GetEntityIndex(first));
+    CHECK(second != first);
+    CHECK(!registry.IsAlive(first));
+    CHECK(registry.GetComponent<Position>(first) == nullptr);
+    CHECK(registry.GetComponent<Position>(second) == nullptr);
+    CHECK(registry.GetEntityCount() == 1);
+}
+
+BENCHMARK(SparseSetVersusNestedUnorderedMap)
+{
+    for (size_t baseCount : {1000, 10000, 100000, 1000000})
+    {
+        size_t count = BenchmarkSize(baseCount);
+        std::vector<EntityID> entities;
+
+        // adding two components to every entity, from an empty registry
+        double legacyAdd = MeasurePopulate<LegacyRegistry>(entities, count);
+        double sparseAdd = MeasurePopulate<Registry>(entities, count);
+
+        // two GetComponent calls per entity
+        LegacyRegistry legacy;
+        Populate(legacy, entities, count);
+        std::vector<EntityID> legacyEntities = entities;
+
+        Registry registry;
+        Populate(registry, entities, count);
+
+        float legacySum = 0.0f, sparseSum = 0.0f;
+        double legacyLookup = MeasureMilliseconds([&]()
+                                                  { legacySum = Integrate(legacy, legacyEntities); });
+        double sparseLookup = MeasureMilliseconds([&]()
+                                                  { sparseSum = Integrate(registry, entities); });
+        CHECK(legacySum == sparseSum);
+
+        // destroying every other entity
+        double legacyDestroy = MeasureMilliseconds([&]()
+                                                   {
+                                                       for (size_t i = 0; i < legacyEntities.size(); i += 2)
+                                                           legacy.DestroyEntity(legacyEntities[i]);
+                                                   },
+                                                   1);
+        double sparseDestroy = MeasureMilliseconds([&]()
+                                                   {
+                                                       for (size_t i = 0; i < entities.size(); i += 2)
+                                                           registry.DestroyEntity(entities[i]);
+                                                   },
+                                                   1);
+        CHECK(registry.GetEntityCount() == count / 2);
+
+        PrintBenchmarkResult("add, nested unordered_map", count, legacyAdd);
+        PrintBenchmarkResult("add, sparse set", count, sparseAdd);
+        PrintBenchmarkResult("2x GetComponent, nested unordered_map", count, legacyLookup);
+        PrintBenchmarkResult("2x GetComponent, sparse set", count, sparseLookup);
+        PrintBenchmarkResult("destroy half, nested unordered_map", count, legacyDestroy);
+        PrintBenchmarkResult("destroy half, sparse set", count, sparseDestroy);
+    }
+}
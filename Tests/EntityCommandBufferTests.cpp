@@ -0,0 +1,148 @@
+#include "TestFramework.h"
+#include "TestComponents.h"
+#include "ECS/EntityCommandBuffer.h"
+#include <algorithm>
+#include <thread>
+
+TEST_CASE(CommandBufferEightThreadsSpawn100kEntities)
+{
+    constexpr size_t THREAD_COUNT = 8;
+    constexpr size_t ENTITY_COUNT = 100000;
+    constexpr size_t PER_THREAD = ENTITY_COUNT / THREAD_COUNT;
+
+    Registry registry;
+    EntityCommandBuffer commandBuffer;
+
+    std::vector<std::thread> threads;
+    for (size_t thread = 0; thread < THREAD_COUNT; ++thread)
+    {
+        threads.emplace_back([&commandBuffer, thread]()
+                             {
+                                 EntityCommandBuffer::Recorder &recorder = commandBuffer.GetRecorder();
+                                 for (size_t i = 0; i < PER_THREAD; ++i)
+                                 {
+                                     EntityID entity = recorder.CreateEntity();
+                                     recorder.AddComponent<Position>(entity, static_cast<float>(thread), static_cast<float>(i), 0.0f);
+                                     Tag tag;
+                                     tag.value = static_cast<std::uint32_t>(thread * PER_THREAD + i);
+                                     recorder.AddComponent<Tag>(entity, tag);
+                                 }
+                             });
+    }
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    CHECK(!commandBuffer.IsEmpty());
+    CHECK(registry.GetEntityCount() == 0);
+
+    commandBuffer.Playback(registry);
+    CHECK(commandBuffer.IsEmpty());
+    CHECK(registry.GetEntityCount() == ENTITY_COUNT);
+
+    // every recorded entity made it, once, with the components it was recorded with
+    std::vector<bool> seen(ENTITY_COUNT, false);
+    size_t count = 0;
+    for (auto [entity, position, tag] : registry.View<Position, Tag>())
+    {
+        CHECK(tag.value < ENTITY_COUNT);
+        if (tag.value >= ENTITY_COUNT)
+            continue;
+
+        CHECK(!seen[tag.value]);
+        seen[tag.value] = true;
+        CHECK(static_cast<size_t>(position.x) * PER_THREAD + static_cast<size_t>(position.y) == tag.value);
+        ++count;
+    }
+    CHECK(count == ENTITY_COUNT);
+}
+
+TEST_CASE(CommandBufferAppliesDestroysLast)
+{
+    Registry registry;
+    EntityID existing = registry.CreateEntity();
+    registry.AddComponent<Position>(existing);
+
+    EntityCommandBuffer commandBuffer;
+    EntityCommandBuffer::Recorder &recorder = commandBuffer.GetRecorder();
+    recorder.DestroyEntity(existing);
+    recorder.AddComponent<Velocity>(existing, 1.0f, 0.0f, 0.0f);
+    recorder.SetComponent<Position>(existing, Position(5.0f, 0.0f, 0.0f));
+
+    EntityID spawned = recorder.CreateEntity();
+    recorder.AddComponent<Position>(spawned, 2.0f, 0.0f, 0.0f);
+    recorder.RemoveComponent<Position>(spawned);
+    recorder.AddComponent<Velocity>(spawned, 3.0f, 0.0f, 0.0f);
+
+    commandBuffer.Playback(registry);
+    CHECK(!registry.IsAlive(existing));
+    CHECK(registry.GetEntityCount() == 1);
+
+    // adds and removes of one type keep their recorded order
+    auto velocities = registry.View<Velocity>();
+    CHECK(velocities.SizeHint() == 1);
+    for (auto [entity, velocity] : velocities)
+    {
+        CHECK(velocity.x == 3.0f);
+        CHECK(!registry.HasComponent<Position>(entity));
+    }
+}
+
+TEST_CASE(CommandBufferDropsForeignPlaceholders)
+{
+    Registry registry;
+    EntityCommandBuffer first;
+    EntityCommandBuffer second;
+
+    // both buffers hand out index 0 first, only the epoch tells the placeholders apart
+    EntityCommandBuffer::Recorder &other = second.GetRecorder();
+    EntityID foreign = other.CreateEntity();
+
+    EntityCommandBuffer::Recorder &recorder = first.GetRecorder();
+    EntityID own = recorder.CreateEntity();
+    CHECK(EntityCommandBuffer::IsPending(own) && EntityCommandBuffer::IsPending(foreign));
+    CHECK(GetEntityIndex(own) == GetEntityIndex(foreign));
+    CHECK(own != foreign);
+
+    recorder.AddComponent<Position>(own, 1.0f, 0.0f, 0.0f);
+    recorder.AddComponent<Velocity>(foreign, 2.0f, 0.0f, 0.0f);
+    recorder.DestroyEntity(foreign);
+
+    first.Playback(registry);
+    CHECK(registry.GetEntityCount() == 1);
+    CHECK(registry.View<Position>().SizeHint() == 1);
+    CHECK(registry.View<Velocity>().SizeHint() == 0);
+
+    // a placeholder kept past its playback doesn't land on the entity the next playback creates at the same index
+    EntityCommandBuffer::Recorder &next = first.GetRecorder();
+    EntityID fresh = next.CreateEntity();
+    CHECK(GetEntityIndex(fresh) == GetEntityIndex(own));
+    next.AddComponent<Velocity>(own, 1.0f, 0.0f, 0.0f);
+    next.DestroyEntity(own);
+    next.AddComponent<Tag>(fresh);
+    first.Playback(registry);
+    CHECK(registry.GetEntityCount() == 2);
+    CHECK(registry.View<Velocity>().SizeHint() == 0);
+    CHECK(registry.View<Tag>().SizeHint() == 1);
+
+    // the second buffer still resolves its own
+    second.Playback(registry);
+    CHECK(registry.GetEntityCount() == 3);
+}
+
+TEST_CASE(CommandBufferPlaceholdersNeverLookAlive)
+{
+    // destroying and recreating in one slot walks through every generation the registry hands out,
+    // none of them may read as a placeholder
+    Registry registry;
+    EntityID entity = registry.CreateEntity();
+    bool isNeverPending = true;
+    for (std::uint32_t i = 0; i < 2 * ENTITY_GENERATION_MASK; ++i)
+    {
+        isNeverPending = isNeverPending && !EntityCommandBuffer::IsPending(entity);
+        registry.DestroyEntity(entity);
+        entity = registry.CreateEntity();
+    }
+    CHECK(isNeverPending);
+    CHECK(GetEntityIndex(entity) == 1);
+}
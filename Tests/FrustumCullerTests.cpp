@@ -0,0 +1,217 @@
+#include "TestFramework.h"
+#include "Rendering/FrustumCuller.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    enum class Side
+    {
+        Inside,
+        Outside,
+        OnPlane, // within rounding of a plane, either answer is fine
+    };
+
+    // the same test as Cull, one box and one plane at a time, in double precision
+    Side ClassifyBox(const XMFLOAT4 (&planes)[6], const BoundingBox &box)
+    {
+        bool isNearPlane = false;
+        for (const XMFLOAT4 &plane : planes)
+        {
+            double distance = static_cast<double>(plane.x) * box.Center.x + static_cast<double>(plane.y) * box.Center.y +
+                              static_cast<double>(plane.z) * box.Center.z + plane.w;
+            double radius = std::fabs(static_cast<double>(plane.x)) * box.Extents.x +
+                            std::fabs(static_cast<double>(plane.y)) * box.Extents.y +
+                            std::fabs(static_cast<double>(plane.z)) * box.Extents.z;
+
+            double margin = distance + radius;
+            if (std::fabs(margin) < 1e-3)
+                isNearPlane = true;
+            else if (margin < 0.0)
+                return Side::Outside;
+        }
+        return isNearPlane ? Side::OnPlane : Side::Inside;
+    }
+
+    void SetTestFrustum(FrustumCuller &culler)
+    {
+        XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f),
+                                         XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f);
+        culler.SetFrustum(view, projection);
+    }
+
+    // boxes all around the camera, roughly a tenth of them end up in view
+    std::vector<BoundingBox> RandomBoxes(size_t count)
+    {
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+        std::uniform_real_distribution<float> extent(0.5f, 20.0f);
+
+        std::vector<BoundingBox> boxes(count);
+        for (BoundingBox &box : boxes)
+        {
+            box.Center = {position(random), position(random), position(random)};
+            box.Extents = {extent(random), extent(random), extent(random)};
+        }
+        return boxes;
+    }
+}
+
+TEST_CASE(FrustumCullerMatchesScalarPlaneTest)
+{
+    FrustumCuller culler;
+    SetTestFrustum(culler);
+
+    // not a multiple of four, so the padding lanes get exercised too
+    std::vector<BoundingBox> boxes = RandomBoxes(100003);
+    for (const BoundingBox &box : boxes)
+        culler.Add(box);
+
+    std::vector<std::uint32_t> visible;
+    culler.Cull(visible);
+
+    std::vector<bool> isVisible(boxes.size(), false);
+    bool isOrdered = true;
+    for (size_t i = 0; i < visible.size(); ++i)
+    {
+        isOrdered = isOrdered && visible[i] < boxes.size() && (i == 0 || visible[i - 1] < visible[i]);
+        if (visible[i] < boxes.size())
+            isVisible[visible[i]] = true;
+    }
+    CHECK(isOrdered);
+
+    size_t mismatches = 0;
+    size_t insideCount = 0;
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+        Side side = ClassifyBox(culler.GetPlanes(), boxes[i]);
+        insideCount += side == Side::Inside ? 1 : 0;
+        if ((side == Side::Inside && !isVisible[i]) || (side == Side::Outside && isVisible[i]))
+            ++mismatches;
+    }
+    CHECK(mismatches == 0);
+    CHECK(insideCount > 0 && insideCount < boxes.size());
+}
+
+TEST_CASE(FrustumCullerKeepsWhatTheCameraSees)
+{
+    FrustumCuller culler;
+    SetTestFrustum(culler);
+
+    BoundingBox box;
+    box.Extents = {1.0f, 1.0f, 1.0f};
+    box.Center = {0.0f, 0.0f, 10.0f}; // straight ahead
+    culler.Add(box);
+    box.Center = {0.0f, 0.0f, -10.0f}; // behind the camera
+    culler.Add(box);
+    box.Center = {0.0f, 0.0f, 1010.0f}; // past the far plane
+    culler.Add(box);
+    box.Center = {0.0f, 0.0f, 1000.5f}; // straddling the far plane
+    culler.Add(box);
+    box.Center = {200.0f, 0.0f, 10.0f}; // off to the side
+    culler.Add(box);
+
+    std::vector<std::uint32_t> visible;
+    culler.Cull(visible);
+    CHECK(visible == std::vector<std::uint32_t>{0, 3});
+}
+
+TEST_CASE(FrustumCullerTransformBoundsContainsEveryCorner)
+{
+    BoundingBox local;
+    local.Center = {1.0f, 2.0f, 3.0f};
+    local.Extents = {1.0f, 2.0f, 0.5f};
+    XMMATRIX world = XMMatrixScaling(2.0f, 1.0f, 3.0f) * XMMatrixRotationRollPitchYaw(0.3f, 1.1f, -0.7f) *
+                     XMMatrixTranslation(-5.0f, 4.0f, 20.0f);
+
+    BoundingBox bounds = FrustumCuller::TransformBounds(local, world);
+
+    // the transformed corners touch the box on every side, but never stick out of it
+    float lowest[3] = {1e30f, 1e30f, 1e30f};
+    float highest[3] = {-1e30f, -1e30f, -1e30f};
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        XMVECTOR point = XMVectorSet(local.Center.x + ((corner & 1) ? local.Extents.x : -local.Extents.x),
+                                     local.Center.y + ((corner & 2) ? local.Extents.y : -local.Extents.y),
+                                     local.Center.z + ((corner & 4) ? local.Extents.z : -local.Extents.z), 1.0f);
+        XMFLOAT3 transformed;
+        XMStoreFloat3(&transformed, XMVector3Transform(point, world));
+        const float coordinates[3] = {transformed.x, transformed.y, transformed.z};
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            lowest[axis] = std::fmin(lowest[axis], coordinates[axis]);
+            highest[axis] = std::fmax(highest[axis], coordinates[axis]);
+        }
+    }
+
+    const float center[3] = {bounds.Center.x, bounds.Center.y, bounds.Center.z};
+    const float extents[3] = {bounds.Extents.x, bounds.Extents.y, bounds.Extents.z};
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        CHECK(std::fabs(center[axis] - extents[axis] - lowest[axis]) < 1e-3f);
+        CHECK(std::fabs(center[axis] + extents[axis] - highest[axis]) < 1e-3f);
+    }
+}
+
+BENCHMARK(FrustumCullerMillionBoxes)
+{
+    size_t count = BenchmarkSize(1000000);
+    std::vector<BoundingBox> boxes = RandomBoxes(count);
+
+    FrustumCuller culler;
+    SetTestFrustum(culler);
+
+    // what RenderSystem does every frame, refill the candidates then cull them
+    double add = MeasureMilliseconds([&]()
+                                     {
+                                         culler.Clear();
+                                         for (const BoundingBox &box : boxes)
+                                             culler.Add(box);
+                                     });
+
+    std::vector<std::uint32_t> visible;
+    visible.reserve(count);
+    double simd = MeasureMilliseconds([&]()
+                                      { culler.Cull(visible); });
+
+    // one box and one plane at a time over the array of boxes, the way it's done without the SoA layout
+    std::vector<std::uint32_t> scalarVisible;
+    scalarVisible.reserve(count);
+    const XMFLOAT4(&planes)[6] = culler.GetPlanes();
+    double scalar = MeasureMilliseconds([&]()
+                                        {
+                                            scalarVisible.clear();
+                                            for (size_t i = 0; i < boxes.size(); ++i)
+                                            {
+                                                const BoundingBox &box = boxes[i];
+                                                bool isOutside = false;
+                                                for (int p = 0; p < 6 && !isOutside; ++p)
+                                                {
+                                                    float distance = planes[p].x * box.Center.x + planes[p].y * box.Center.y +
+                                                                     planes[p].z * box.Center.z + planes[p].w;
+                                                    float radius = std::fabs(planes[p].x) * box.Extents.x +
+                                                                   std::fabs(planes[p].y) * box.Extents.y +
+                                                                   std::fabs(planes[p].z) * box.Extents.z;
+                                                    isOutside = distance + radius < 0.0f;
+                                                }
+                                                if (!isOutside)
+                                                    scalarVisible.push_back(static_cast<std::uint32_t>(i));
+                                            }
+                                        });
+
+    // both sides see the same thing, give or take a box grazing a plane
+    size_t difference = visible.size() > scalarVisible.size() ? visible.size() - scalarVisible.size()
+                                                              : scalarVisible.size() - visible.size();
+    CHECK(difference <= count / 10000);
+
+    char label[64];
+    std::snprintf(label, sizeof(label), "Add (%zu visible)", visible.size());
+    PrintBenchmarkResult(label, count, add);
+    PrintBenchmarkResult("Cull, SoA four boxes at a time", count, simd);
+    PrintBenchmarkResult("scalar loop, one box at a time", count, scalar);
+}
@@ -0,0 +1,125 @@
+#include "TestFramework.h"
+#include "Rendering/InstanceBatcher.h"
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // stand-ins for D3D objects, only their addresses matter
+    struct Resources
+    {
+        char vertexBuffer, otherVertexBuffer, indexBuffer;
+        char diffuse, otherDiffuse, normal, sampler;
+    };
+
+    InstanceBatcher::DrawState State(const Resources &r, const void *vertexBuffer, const void *diffuse)
+    {
+        InstanceBatcher::DrawState state;
+        state.vertexBuffer = vertexBuffer;
+        state.indexBuffer = &r.indexBuffer;
+        state.indexCount = 36;
+        state.diffuseTexture = diffuse;
+        state.normalTexture = &r.normal;
+        state.sampler = &r.sampler;
+        return state;
+    }
+
+    // a translation, so every instance's matrix can be told apart by its item
+    XMFLOAT4X4 World(std::uint32_t item)
+    {
+        XMFLOAT4X4 world;
+        XMStoreFloat4x4(&world, XMMatrixTranslation(static_cast<float>(item), 0.0f, 0.0f));
+        return world;
+    }
+}
+
+TEST_CASE(InstanceBatcherSplitsRunsOnState)
+{
+    Resources r = {};
+    InstanceBatcher::DrawState a = State(r, &r.vertexBuffer, &r.diffuse);
+    InstanceBatcher::DrawState otherMesh = State(r, &r.otherVertexBuffer, &r.diffuse);
+    InstanceBatcher::DrawState otherMaterial = State(r, &r.vertexBuffer, &r.otherDiffuse);
+    InstanceBatcher::DrawState fewerIndices = a;
+    fewerIndices.indexCount = 12;
+
+    // a a | mesh | a | material material | a | fewer indices, a state that comes back later is a new batch
+    const InstanceBatcher::DrawState draws[] = {a, a, otherMesh, a, otherMaterial, otherMaterial, a, fewerIndices};
+    InstanceBatcher batcher;
+    for (std::uint32_t item = 0; item < 8; ++item)
+        batcher.Add(draws[item], item + 10, World(item));
+
+    const std::vector<InstanceBatcher::Batch> &batches = batcher.GetBatches();
+    CHECK(batches.size() == 6);
+    CHECK(batcher.GetInstances().size() == 8);
+
+    const std::uint32_t firstItems[] = {10, 12, 13, 14, 16, 17};
+    const std::uint32_t counts[] = {2, 1, 1, 2, 1, 1};
+    bool isExpected = batches.size() == 6;
+    std::uint32_t firstInstance = 0;
+    for (size_t i = 0; isExpected && i < batches.size(); ++i)
+    {
+        isExpected = batches[i].firstItem == firstItems[i] && batches[i].instanceCount == counts[i] &&
+                     batches[i].firstInstance == firstInstance && batches[i].state == draws[firstItems[i] - 10];
+        firstInstance += counts[i];
+    }
+    CHECK(isExpected);
+
+    // the instances keep the order they were added in
+    bool isInOrder = true;
+    for (std::uint32_t item = 0; item < 8; ++item)
+        isInOrder = isInOrder && batcher.GetInstances()[item].world.m[3][0] == static_cast<float>(item);
+    CHECK(isInOrder);
+
+    // Clear starts over, a state that matched the last batch still opens a new one
+    batcher.Clear();
+    CHECK(batcher.GetBatches().empty() && batcher.GetInstances().empty());
+    batcher.Add(fewerIndices, 0, World(0));
+    CHECK(batcher.GetBatches().size() == 1 && batcher.GetBatches()[0].firstInstance == 0);
+}
+
+TEST_CASE(InstanceBatcherCapsBatchSize)
+{
+    Resources r = {};
+    InstanceBatcher::DrawState a = State(r, &r.vertexBuffer, &r.diffuse);
+    InstanceBatcher::DrawState b = State(r, &r.otherVertexBuffer, &r.diffuse);
+
+    // ten of a split into 4 + 4 + 2, then three of b into 3, the cap counts per batch rather than per run
+    InstanceBatcher batcher(4);
+    for (std::uint32_t item = 0; item < 13; ++item)
+        batcher.Add(item < 10 ? a : b, item, World(item));
+
+    const std::vector<InstanceBatcher::Batch> &batches = batcher.GetBatches();
+    CHECK(batches.size() == 4);
+    CHECK(batches.size() == 4 && batches[0].instanceCount == 4 && batches[1].instanceCount == 4 && batches[2].instanceCount == 2 &&
+          batches[3].instanceCount == 3);
+    CHECK(batches.size() == 4 && batches[1].firstItem == 4 && batches[1].firstInstance == 4 && batches[3].firstItem == 10);
+
+    // without a cap the same draws make one batch per run
+    InstanceBatcher unlimited;
+    for (std::uint32_t item = 0; item < 13; ++item)
+        unlimited.Add(item < 10 ? a : b, item, World(item));
+    CHECK(unlimited.GetBatches().size() == 2 && unlimited.GetBatches()[0].instanceCount == 10);
+}
+
+TEST_CASE(InstanceBatcherKeepsEachInstancesLights)
+{
+    Resources r = {};
+    InstanceBatcher::DrawState a = State(r, &r.vertexBuffer, &r.diffuse);
+
+    // instances of one batch with different light lists, and one that leaves it to the clustered lights
+    ObjectLightData first = {2, 1, 1, 0, {4, 9, 7}};
+    ObjectLightData second = {1, 0, 1, 0, {3}};
+    InstanceBatcher batcher;
+    batcher.Add(a, 0, World(0), &first);
+    batcher.Add(a, 1, World(1));
+    batcher.Add(a, 2, World(2), &second);
+    CHECK(batcher.GetBatches().size() == 1);
+
+    const std::vector<InstanceData> &instances = batcher.GetInstances();
+    CHECK(instances[0].lights.pointCount == 2 && instances[0].lights.spotCount == 1 && instances[0].lights.isEnabled == 1);
+    CHECK(instances[0].lights.slots[0] == 4 && instances[0].lights.slots[1] == 9 && instances[0].lights.slots[2] == 7);
+    CHECK(instances[1].lights.isEnabled == 0 && instances[1].lights.pointCount == 0 && instances[1].lights.spotCount == 0);
+    CHECK(instances[2].lights.pointCount == 1 && instances[2].lights.isEnabled == 1 && instances[2].lights.slots[0] == 3);
+    CHECK(instances[2].world.m[3][0] == 2.0f);
+}
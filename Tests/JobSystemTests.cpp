@@ -0,0 +1,269 @@
+#include "TestFramework.h"
+#include "TestComponents.h"
+#include "Core/JobSystem.h"
+#include "ECS/SystemScheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace
+{
+    // a few hundred nanoseconds of arithmetic that the compiler can't fold away
+    float Work(size_t seed, int iterations)
+    {
+        float value = static_cast<float>(seed % 1024) * 0.001f;
+        for (int i = 0; i < iterations; ++i)
+            value = value * 0.999f + std::sqrt(value + 1.0f);
+        return value;
+    }
+
+    class WorkSystem : public System
+    {
+    public:
+        WorkSystem(Registry &registry, ComponentAccess access, int iterations)
+            : System(registry), access(access), iterations(iterations)
+        {
+        }
+
+        bool Initialize() override { return true; }
+
+        void Update(float) override
+        {
+            result = Work(static_cast<size_t>(iterations), iterations);
+            ++updateCount;
+        }
+
+        ComponentAccess GetComponentAccess() const override { return access; }
+
+        ComponentAccess access;
+        int iterations;
+        float result = 0.0f;
+        int updateCount = 0;
+    };
+}
+
+TEST_CASE(ParallelForCoversEveryIndexOnce)
+{
+    JobSystem jobSystem;
+    jobSystem.Initialize(3);
+
+    constexpr size_t COUNT = 100000;
+    std::vector<std::atomic<int>> visits(COUNT);
+    jobSystem.ParallelFor(COUNT, 97, [&visits](size_t begin, size_t end)
+                          {
+                              for (size_t i = begin; i < end; ++i)
+                                  visits[i].fetch_add(1, std::memory_order_relaxed);
+                          });
+
+    bool allOnce = true;
+    for (const auto &visit : visits)
+        allOnce = allOnce && visit.load() == 1;
+    CHECK(allOnce);
+}
+
+TEST_CASE(NestedJobsWaitWithoutDeadlock)
+{
+    JobSystem jobSystem;
+    jobSystem.Initialize(2);
+
+    std::atomic<int> leaves{0};
+    JobCounter outer;
+    for (int i = 0; i < 32; ++i)
+    {
+        jobSystem.Schedule([&jobSystem, &leaves]()
+                           {
+                               // waiting inside a job runs other jobs instead of blocking the worker
+                               JobCounter inner;
+                               for (int j = 0; j < 32; ++j)
+                                   jobSystem.Schedule([&leaves]()
+                                                      { leaves.fetch_add(1, std::memory_order_relaxed); },
+                                                      &inner);
+                               jobSystem.Wait(inner);
+                           },
+                           &outer);
+    }
+
+    jobSystem.Wait(outer);
+    CHECK(leaves.load() == 32 * 32);
+}
+
+TEST_CASE(ShutdownRunsQueuedJobs)
+{
+    JobSystem jobSystem;
+    jobSystem.Initialize(2);
+
+    std::atomic<int> finished{0};
+    JobCounter counter;
+    for (int i = 0; i < 2000; ++i)
+    {
+        jobSystem.Schedule([&finished, i]()
+                           {
+                               volatile float sink = Work(static_cast<size_t>(i), 200);
+                               (void)sink;
+                               finished.fetch_add(1, std::memory_order_relaxed);
+                           },
+                           &counter);
+    }
+
+    // most of those are still queued, they have to run (not vanish) or the Wait below never returns
+    jobSystem.Shutdown();
+    CHECK(counter.IsDone());
+    jobSystem.Wait(counter);
+    CHECK(finished.load() == 2000);
+}
+
+TEST_CASE(SchedulerBatchesSystemsByAccess)
+{
+    Registry registry;
+    JobSystem jobSystem;
+    jobSystem.Initialize(2);
+    SystemScheduler scheduler(jobSystem);
+
+    WorkSystem writesPosition(registry, ComponentAccess().Write<Position>(), 10);
+    WorkSystem writesVelocity(registry, ComponentAccess().Write<Velocity>().Read<Tag>(), 10);
+    WorkSystem readsPosition(registry, ComponentAccess().Read<Position, Tag>(), 10);
+    WorkSystem exclusive(registry, ComponentAccess::Exclusive(), 10);
+
+    scheduler.AddSystem(&writesPosition);
+    scheduler.AddSystem(&writesVelocity);
+    scheduler.AddSystem(&readsPosition);
+    scheduler.AddSystem(&exclusive);
+
+    // [position writer, velocity writer] [position reader] [exclusive]
+    CHECK(scheduler.GetBatchCount() == 3);
+
+    scheduler.Update(0.0f);
+    CHECK(writesPosition.updateCount == 1 && writesVelocity.updateCount == 1);
+    CHECK(readsPosition.updateCount == 1 && exclusive.updateCount == 1);
+}
+
+BENCHMARK(JobSystemStress)
+{
+    size_t itemCount = BenchmarkSize(4000000);
+    size_t tinyJobCount = BenchmarkSize(200000);
+    size_t nestedItemCount = BenchmarkSize(64 * 16384);
+
+    std::vector<float> results(itemCount);
+    for (unsigned int threads : BenchmarkThreadCounts())
+    {
+        char label[64];
+
+        // one thread is the plain loop, no job system at all
+        std::unique_ptr<JobSystem> jobSystem;
+        if (threads > 1)
+        {
+            jobSystem = std::make_unique<JobSystem>();
+            jobSystem->Initialize(threads - 1);
+        }
+
+        // wide, even data parallel work
+        auto fill = [&results](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                results[i] = Work(i, 16);
+        };
+        double parallelFor = MeasureMilliseconds([&]()
+                                                 {
+                                                     if (jobSystem)
+                                                         jobSystem->ParallelFor(itemCount, 4096, fill);
+                                                     else
+                                                         fill(0, itemCount);
+                                                 });
+        CHECK(results[itemCount - 1] == Work(itemCount - 1, 16));
+
+        // scheduling overhead, jobs that do next to nothing
+        std::atomic<size_t> ran{0};
+        double tinyJobs = MeasureMilliseconds([&]()
+                                              {
+                                                  ran = 0;
+                                                  if (!jobSystem)
+                                                  {
+                                                      for (size_t i = 0; i < tinyJobCount; ++i)
+                                                          ran.fetch_add(1, std::memory_order_relaxed);
+                                                      return;
+                                                  }
+
+                                                  JobCounter counter;
+                                                  for (size_t i = 0; i < tinyJobCount; ++i)
+                                                      jobSystem->Schedule([&ran]()
+                                                                          { ran.fetch_add(1, std::memory_order_relaxed); },
+                                                                          &counter);
+                                                  jobSystem->Wait(counter);
+                                              },
+                                              3);
+        CHECK(ran.load() == tinyJobCount);
+
+        // jobs that fork and wait on their own ParallelFor, which is where stealing matters
+        std::atomic<size_t> nestedItems{0};
+        double nested = MeasureMilliseconds([&]()
+                                            {
+                                                nestedItems = 0;
+                                                auto inner = [&nestedItems](size_t begin, size_t end)
+                                                {
+                                                    float sum = 0.0f;
+                                                    for (size_t i = begin; i < end; ++i)
+                                                        sum += Work(i, 4);
+                                                    if (sum >= 0.0f)
+                                                        nestedItems.fetch_add(end - begin, std::memory_order_relaxed);
+                                                };
+
+                                                size_t perJob = nestedItemCount / 64;
+                                                if (!jobSystem)
+                                                {
+                                                    for (int i = 0; i < 64; ++i)
+                                                        inner(0, perJob);
+                                                    return;
+                                                }
+
+                                                jobSystem->ParallelFor(64, 1, [&](size_t begin, size_t end)
+                                                                       {
+                                                                           for (size_t i = begin; i < end; ++i)
+                                                                               jobSystem->ParallelFor(perJob, 1024, inner);
+                                                                       });
+                                            },
+                                            3);
+        CHECK(nestedItems.load() == nestedItemCount / 64 * 64);
+
+        // a frame of eight systems, four of which can run side by side
+        Registry registry;
+        int systemWork = static_cast<int>(BenchmarkSize(200000));
+        std::vector<std::unique_ptr<WorkSystem>> systems;
+        systems.push_back(std::make_unique<WorkSystem>(registry, ComponentAccess().Write<Position>(), systemWork));
+        systems.push_back(std::make_unique<WorkSystem>(registry, ComponentAccess().Write<Velocity>(), systemWork));
+        systems.push_back(std::make_unique<WorkSystem>(registry, ComponentAccess().Write<Tag>(), systemWork));
+        systems.push_back(std::make_unique<WorkSystem>(registry, ComponentAccess().Write<Transform>(), systemWork));
+        systems.push_back(std::make_unique<WorkSystem>(registry, ComponentAccess().Read<Position, Velocity>(), systemWork));
+        systems.push_back(std::make_unique<WorkSystem>(registry, ComponentAccess().Read<Position, Tag>(), systemWork));
+        systems.push_back(std::make_unique<WorkSystem>(registry, ComponentAccess().Read<Transform>(), systemWork));
+        systems.push_back(std::make_unique<WorkSystem>(registry, ComponentAccess::Exclusive(), systemWork));
+
+        double scheduled = 0.0;
+        if (jobSystem)
+        {
+            SystemScheduler scheduler(*jobSystem);
+            for (auto &system : systems)
+                scheduler.AddSystem(system.get());
+            scheduled = MeasureMilliseconds([&]()
+                                            { scheduler.Update(0.0f); });
+        }
+        else
+        {
+            scheduled = MeasureMilliseconds([&]()
+                                            {
+                                                for (auto &system : systems)
+                                                    system->Update(0.0f);
+                                            });
+        }
+        for (auto &system : systems)
+            CHECK(system->updateCount == 5);
+
+        std::snprintf(label, sizeof(label), "ParallelFor, %u threads", threads);
+        PrintBenchmarkResult(label, itemCount, parallelFor);
+        std::snprintf(label, sizeof(label), "tiny jobs, %u threads", threads);
+        PrintBenchmarkResult(label, tinyJobCount, tinyJobs);
+        std::snprintf(label, sizeof(label), "nested ParallelFor, %u threads", threads);
+        PrintBenchmarkResult(label, nestedItemCount, nested);
+        std::snprintf(label, sizeof(label), "8 systems, %u threads", threads);
+        PrintBenchmarkResult(label, systems.size(), scheduled);
+    }
+}
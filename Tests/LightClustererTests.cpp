@@ -0,0 +1,256 @@
+#include "TestFramework.h"
+#include "Rendering/LightClusterer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr float NEAR_Z = 0.1f;
+    constexpr float FAR_Z = 500.0f;
+
+    XMMATRIX TestProjection()
+    {
+        return XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, NEAR_Z, FAR_Z);
+    }
+
+    // a street of lights in front of the camera, point lights and spots pointing down
+    std::vector<LightClusterer::Light> RandomLights(size_t count, float spotShare, unsigned int seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> x(-200.0f, 200.0f);
+        std::uniform_real_distribution<float> y(-20.0f, 20.0f);
+        std::uniform_real_distribution<float> z(0.0f, 450.0f);
+        std::uniform_real_distribution<float> range(2.0f, 10.0f);
+        std::uniform_real_distribution<float> share(0.0f, 1.0f);
+
+        std::vector<LightClusterer::Light> lights(count);
+        for (LightClusterer::Light &light : lights)
+        {
+            light.position = {x(random), y(random), z(random)};
+            light.range = range(random);
+            light.direction = {0.0f, -1.0f, 0.0f};
+            light.cosOuterCone = share(random) < spotShare ? std::cos(0.6f) : -1.0f;
+        }
+        return lights;
+    }
+
+    // the piece of the view frustum cluster (x, y, z) covers, built the same way SetProjection does it
+    struct ClusterCell
+    {
+        float tanLeft, tanRight, tanBottom, tanTop;
+        float sliceNear, sliceFar;
+
+        ClusterCell(float tanHalfX, float tanHalfY, std::uint32_t x, std::uint32_t y, std::uint32_t z)
+        {
+            using Clusterer = LightClusterer;
+            sliceNear = NEAR_Z * std::pow(FAR_Z / NEAR_Z, static_cast<float>(z) / Clusterer::GRID_Z);
+            sliceFar = z + 1 == Clusterer::GRID_Z ? FAR_Z : NEAR_Z * std::pow(FAR_Z / NEAR_Z, static_cast<float>(z + 1) / Clusterer::GRID_Z);
+            tanTop = tanHalfY * (1.0f - 2.0f * y / Clusterer::GRID_Y);
+            tanBottom = tanHalfY * (1.0f - 2.0f * (y + 1) / Clusterer::GRID_Y);
+            tanLeft = tanHalfX * (2.0f * x / Clusterer::GRID_X - 1.0f);
+            tanRight = tanHalfX * (2.0f * (x + 1) / Clusterer::GRID_X - 1.0f);
+        }
+
+        // squared distance from a point to the box around the cell, which is what the clusterer tests against
+        double BoxDistanceSq(const XMFLOAT3 &point) const
+        {
+            const double minimum[3] = {std::min(tanLeft * sliceNear, tanLeft * sliceFar),
+                                       std::min(tanBottom * sliceNear, tanBottom * sliceFar), sliceNear};
+            const double maximum[3] = {std::max(tanRight * sliceNear, tanRight * sliceFar),
+                                       std::max(tanTop * sliceNear, tanTop * sliceFar), sliceFar};
+            const double coordinates[3] = {point.x, point.y, point.z};
+
+            double distanceSq = 0.0;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                double outside = std::max({0.0, minimum[axis] - coordinates[axis], coordinates[axis] - maximum[axis]});
+                distanceSq += outside * outside;
+            }
+            return distanceSq;
+        }
+
+        // closest of a 5 x 5 x 5 set of points spread through the cell itself, a lower bound on what the light reaches
+        double SampledDistanceSq(const XMFLOAT3 &point) const
+        {
+            double closest = 1e30;
+            for (int w = 0; w <= 4; ++w)
+            {
+                double depth = sliceNear + (sliceFar - sliceNear) * w / 4.0;
+                for (int v = 0; v <= 4; ++v)
+                {
+                    double y = depth * (tanBottom + (tanTop - tanBottom) * v / 4.0);
+                    for (int u = 0; u <= 4; ++u)
+                    {
+                        double x = depth * (tanLeft + (tanRight - tanLeft) * u / 4.0);
+                        double dx = x - point.x, dy = y - point.y, dz = depth - point.z;
+                        closest = std::min(closest, dx * dx + dy * dy + dz * dz);
+                    }
+                }
+            }
+            return closest;
+        }
+    };
+
+    bool SameAssignment(const LightClusterer &a, const LightClusterer &b)
+    {
+        if (a.GetLightIndices() != b.GetLightIndices() || a.GetDroppedCount() != b.GetDroppedCount())
+            return false;
+
+        for (std::uint32_t cluster = 0; cluster < LightClusterer::CLUSTER_COUNT; ++cluster)
+        {
+            if (a.GetClusterRanges()[cluster].offset != b.GetClusterRanges()[cluster].offset ||
+                a.GetClusterRanges()[cluster].count != b.GetClusterRanges()[cluster].count)
+                return false;
+        }
+        return true;
+    }
+}
+
+TEST_CASE(LightClustererMatchesBruteForcePointLights)
+{
+    // identity view, so world space is view space and the reference doesn't need to transform anything
+    std::vector<LightClusterer::Light> lights = RandomLights(2000, 0.0f, 4);
+    lights[7].range = 0.0f; // an empty slot, never assigned
+
+    LightClusterer clusterer;
+    clusterer.SetProjection(TestProjection());
+    clusterer.Assign(nullptr, XMMatrixIdentity(), lights.data(), lights.size());
+    CHECK(clusterer.GetDroppedCount() == 0);
+
+    XMFLOAT4X4 projection;
+    XMStoreFloat4x4(&projection, TestProjection());
+    float tanHalfX = 1.0f / projection.m[0][0];
+    float tanHalfY = 1.0f / projection.m[1][1];
+
+    // a light has to be listed wherever it reaches into the cell, and may only be listed where it reaches the box
+    // around the cell (the box sticks out of the frustum, so the clusterer can skip those corners)
+    size_t missing = 0;
+    size_t extra = 0;
+    size_t pairs = 0;
+    std::vector<bool> isListed(lights.size());
+    for (std::uint32_t z = 0; z < LightClusterer::GRID_Z; ++z)
+    {
+        for (std::uint32_t y = 0; y < LightClusterer::GRID_Y; ++y)
+        {
+            for (std::uint32_t x = 0; x < LightClusterer::GRID_X; ++x)
+            {
+                LightClusterer::ClusterRange range = clusterer.GetClusterRanges()[LightClusterer::GetClusterIndex(x, y, z)];
+                std::fill(isListed.begin(), isListed.end(), false);
+                for (std::uint32_t i = range.offset; i < range.offset + range.count; ++i)
+                    isListed[clusterer.GetLightIndices()[i]] = true;
+
+                ClusterCell cell(tanHalfX, tanHalfY, x, y, z);
+                for (size_t light = 0; light < lights.size(); ++light)
+                {
+                    // within rounding of the range either answer is fine
+                    double reach = lights[light].range;
+                    double boxDistance = std::sqrt(cell.BoxDistanceSq(lights[light].position));
+                    if (!(reach > 0.0) || boxDistance > reach + 1e-3)
+                    {
+                        extra += isListed[light] ? 1 : 0;
+                        continue;
+                    }
+
+                    pairs += isListed[light] ? 1 : 0;
+                    if (!isListed[light] && std::sqrt(cell.SampledDistanceSq(lights[light].position)) < reach - 1e-3)
+                        ++missing;
+                }
+            }
+        }
+    }
+
+    CHECK(missing == 0);
+    CHECK(extra == 0);
+    CHECK(pairs > lights.size());
+}
+
+TEST_CASE(LightClustererSameResultOnEveryThreadCount)
+{
+    std::vector<LightClusterer::Light> lights = RandomLights(5000, 0.3f, 8);
+    XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 10.0f, -20.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 100.0f, 1.0f),
+                                     XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+
+    LightClusterer serial;
+    serial.SetProjection(TestProjection());
+    serial.Assign(nullptr, view, lights.data(), lights.size());
+    CHECK(!serial.GetLightIndices().empty());
+
+    JobSystem jobSystem;
+    jobSystem.Initialize(3);
+    LightClusterer parallel;
+    parallel.SetProjection(TestProjection());
+    parallel.Assign(&jobSystem, view, lights.data(), lights.size());
+    CHECK(SameAssignment(serial, parallel));
+}
+
+TEST_CASE(LightClustererCountsDroppedLights)
+{
+    // more lights on one spot than a cluster can list
+    std::vector<LightClusterer::Light> lights(LightClusterer::MAX_LIGHTS_PER_CLUSTER + 50);
+    for (LightClusterer::Light &light : lights)
+    {
+        light.position = {0.0f, 0.0f, 50.0f};
+        light.range = 0.01f;
+        light.direction = {0.0f, 0.0f, 1.0f};
+        light.cosOuterCone = -1.0f;
+    }
+
+    LightClusterer clusterer;
+    clusterer.SetProjection(TestProjection());
+    clusterer.Assign(nullptr, XMMatrixIdentity(), lights.data(), lights.size());
+
+    // the light is small enough to touch one cluster, maybe a neighbour when it sits on a boundary
+    CHECK(clusterer.GetDroppedCount() >= 50);
+    CHECK(clusterer.GetDroppedCount() % 50 == 0);
+
+    // the first ones in input order are the ones that made it
+    bool isInOrder = true;
+    for (const LightClusterer::ClusterRange &range : clusterer.GetClusterRanges())
+    {
+        for (std::uint32_t i = 0; i < range.count; ++i)
+            isInOrder = isInOrder && clusterer.GetLightIndices()[range.offset + i] == i;
+    }
+    CHECK(isInOrder);
+}
+
+BENCHMARK(LightClustererTenThousandLights)
+{
+    size_t count = BenchmarkSize(10000);
+    std::vector<LightClusterer::Light> lights = RandomLights(count, 0.3f, 2);
+    XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 10.0f, -20.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 100.0f, 1.0f),
+                                     XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+
+    LightClusterer serial;
+    serial.SetProjection(TestProjection());
+
+    char label[64];
+    for (unsigned int threads : BenchmarkThreadCounts())
+    {
+        std::unique_ptr<JobSystem> jobSystem;
+        if (threads > 1)
+        {
+            jobSystem = std::make_unique<JobSystem>();
+            jobSystem->Initialize(threads - 1);
+        }
+
+        LightClusterer clusterer;
+        clusterer.SetProjection(TestProjection());
+        double milliseconds = MeasureMilliseconds([&]()
+                                                  { clusterer.Assign(jobSystem.get(), view, lights.data(), lights.size()); });
+
+        if (threads == 1)
+            serial.Assign(nullptr, view, lights.data(), lights.size());
+        CHECK(SameAssignment(serial, clusterer));
+
+        std::snprintf(label, sizeof(label), "Assign, %u threads", threads);
+        PrintBenchmarkResult(label, count, milliseconds);
+    }
+
+    std::printf("    %zu light/cluster pairs, %u dropped\n", serial.GetLightIndices().size(), serial.GetDroppedCount());
+}
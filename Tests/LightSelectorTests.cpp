@@ -0,0 +1,215 @@
+#include "TestFramework.h"
+#include "Rendering/LightSelector.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct Scene
+    {
+        std::vector<LightSelector::Light> lights;
+        std::vector<XMFLOAT4> spheres;
+    };
+
+    // lights and objects mixed through the same stretch of level, a few dozen lights reach a typical object
+    Scene RandomScene(size_t lightCount, size_t objectCount, unsigned int seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> x(-200.0f, 200.0f);
+        std::uniform_real_distribution<float> y(0.0f, 40.0f);
+        std::uniform_real_distribution<float> z(-200.0f, 200.0f);
+        std::uniform_real_distribution<float> range(5.0f, 30.0f);
+        std::uniform_real_distribution<float> intensity(0.5f, 3.0f);
+        std::uniform_real_distribution<float> radius(0.5f, 3.0f);
+
+        Scene scene;
+        scene.lights.resize(lightCount);
+        for (LightSelector::Light &light : scene.lights)
+        {
+            light.position = {x(random), y(random), z(random)};
+            light.range = range(random);
+            light.intensity = intensity(random);
+        }
+
+        scene.spheres.resize(objectCount);
+        for (XMFLOAT4 &sphere : scene.spheres)
+            sphere = {x(random), y(random), z(random), radius(random)};
+        return scene;
+    }
+
+    // the selector's score, one light at a time in double precision
+    double Score(const LightSelector::Light &light, const XMFLOAT4 &sphere)
+    {
+        if (!(light.range > 0.0f))
+            return 0.0;
+
+        double dx = light.position.x - sphere.x;
+        double dy = light.position.y - sphere.y;
+        double dz = light.position.z - sphere.z;
+        double distance = std::max(0.0, std::sqrt(dx * dx + dy * dy + dz * dz) - sphere.w);
+        double falloff = std::max(0.0, 1.0 - distance / light.range);
+        return light.intensity * falloff * falloff;
+    }
+
+    // sorts every light by score and takes the top ones, what Select does without the SIMD and the early outs
+    void SelectBruteForce(const Scene &scene, size_t object, std::vector<std::pair<double, std::uint32_t>> &ranked)
+    {
+        ranked.clear();
+        const XMFLOAT4 &sphere = scene.spheres[object];
+        if (sphere.w < 0.0f)
+            return;
+
+        for (size_t light = 0; light < scene.lights.size(); ++light)
+        {
+            double score = Score(scene.lights[light], sphere);
+            if (score > 0.0)
+                ranked.emplace_back(score, static_cast<std::uint32_t>(light));
+        }
+
+        size_t keep = std::min<size_t>(ranked.size(), LightSelector::MAX_LIGHTS_PER_OBJECT);
+        std::partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end(),
+                          [](const auto &a, const auto &b)
+                          { return a.first > b.first; });
+        ranked.resize(keep);
+    }
+
+    // objects whose selection differs from the brute force one by more than a rounding tie at the cut off
+    size_t CountMismatches(const Scene &scene, const LightSelector &selector)
+    {
+        constexpr double TOLERANCE = 1e-5;
+
+        size_t mismatches = 0;
+        std::vector<std::pair<double, std::uint32_t>> ranked;
+        for (size_t object = 0; object < scene.spheres.size(); ++object)
+        {
+            SelectBruteForce(scene, object, ranked);
+            const LightSelector::Selection &selection = selector.GetSelections()[object];
+
+            bool isSorted = std::is_sorted(selection.lights, selection.lights + selection.count);
+            if (!isSorted || selection.count != ranked.size())
+            {
+                // a light that barely reaches the object can go either way
+                bool isTie = isSorted && !ranked.empty() && ranked.back().first < TOLERANCE;
+                mismatches += isTie ? 0 : 1;
+                continue;
+            }
+
+            // everything picked scores at least as well as the weakest brute force pick
+            double cutOff = ranked.empty() ? 0.0 : ranked.back().first;
+            for (std::uint32_t i = 0; i < selection.count; ++i)
+            {
+                if (Score(scene.lights[selection.lights[i]], scene.spheres[object]) < cutOff - TOLERANCE)
+                {
+                    ++mismatches;
+                    break;
+                }
+            }
+        }
+        return mismatches;
+    }
+}
+
+TEST_CASE(LightSelectorMatchesBruteForceTopEight)
+{
+    Scene scene = RandomScene(3000, 500, 6);
+
+    // unused light slots and objects that opted out of per object lights
+    for (size_t i = 0; i < scene.lights.size(); i += 17)
+        scene.lights[i].range = 0.0f;
+    scene.spheres[3].w = -1.0f;
+
+    // a light count that isn't a multiple of four, so the padding gets scored too
+    scene.lights.resize(2999);
+
+    LightSelector selector;
+    selector.SetLights(scene.lights.data(), scene.lights.size());
+    selector.Select(nullptr, scene.spheres.data(), scene.spheres.size());
+
+    CHECK(selector.GetSelections().size() == scene.spheres.size());
+    CHECK(selector.GetSelections()[3].count == 0);
+    CHECK(CountMismatches(scene, selector) == 0);
+
+    // full lists and partly filled ones both show up, otherwise the test isn't saying much
+    size_t full = 0;
+    size_t partial = 0;
+    for (const LightSelector::Selection &selection : selector.GetSelections())
+    {
+        full += selection.count == LightSelector::MAX_LIGHTS_PER_OBJECT ? 1 : 0;
+        partial += selection.count > 0 && selection.count < LightSelector::MAX_LIGHTS_PER_OBJECT ? 1 : 0;
+    }
+    CHECK(full > 0 && partial > 0);
+
+    // the job system only splits the objects, it can't change any list
+    JobSystem jobSystem;
+    jobSystem.Initialize(3);
+    LightSelector parallel;
+    parallel.SetLights(scene.lights.data(), scene.lights.size());
+    parallel.Select(&jobSystem, scene.spheres.data(), scene.spheres.size());
+
+    bool isSame = true;
+    for (size_t object = 0; object < scene.spheres.size(); ++object)
+    {
+        const LightSelector::Selection &a = selector.GetSelections()[object];
+        const LightSelector::Selection &b = parallel.GetSelections()[object];
+        isSame = isSame && a.count == b.count && std::equal(a.lights, a.lights + a.count, b.lights);
+    }
+    CHECK(isSame);
+}
+
+BENCHMARK(LightSelectorTopEight)
+{
+    // many lights and few objects, and the other way around
+    const size_t sizes[][2] = {{10000, 1000}, {1000, 10000}};
+
+    char label[64];
+    for (const auto &size : sizes)
+    {
+        size_t lightCount = BenchmarkSize(size[0]);
+        size_t objectCount = BenchmarkSize(size[1]);
+        Scene scene = RandomScene(lightCount, objectCount, 3);
+
+        LightSelector selector;
+        selector.SetLights(scene.lights.data(), scene.lights.size());
+
+        for (unsigned int threads : BenchmarkThreadCounts())
+        {
+            std::unique_ptr<JobSystem> jobSystem;
+            if (threads > 1)
+            {
+                jobSystem = std::make_unique<JobSystem>();
+                jobSystem->Initialize(threads - 1);
+            }
+
+            double milliseconds = MeasureMilliseconds([&]()
+                                                      { selector.Select(jobSystem.get(), scene.spheres.data(), objectCount); });
+            CHECK(CountMismatches(scene, selector) == 0);
+
+            std::snprintf(label, sizeof(label), "%zu lights, Select, %u threads", lightCount, threads);
+            PrintBenchmarkResult(label, objectCount, milliseconds);
+        }
+
+        // scoring every light and sorting, what the selector saves over
+        std::vector<std::pair<double, std::uint32_t>> ranked;
+        size_t picked = 0;
+        double bruteForce = MeasureMilliseconds([&]()
+                                                {
+                                                    picked = 0;
+                                                    for (size_t object = 0; object < objectCount; ++object)
+                                                    {
+                                                        SelectBruteForce(scene, object, ranked);
+                                                        picked += ranked.size();
+                                                    }
+                                                },
+                                                1);
+        CHECK(picked > 0);
+
+        std::snprintf(label, sizeof(label), "%zu lights, score all and sort", lightCount);
+        PrintBenchmarkResult(label, objectCount, bruteForce);
+    }
+}
@@ -0,0 +1,199 @@
+#include "TestFramework.h"
+#include "Rendering/OcclusionCuller.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // the camera at the origin looking down +z, like the frustum culler tests
+    XMMATRIX TestViewProjection()
+    {
+        XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f),
+                                         XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        return XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f));
+    }
+
+    // a square facing the camera at depth z, clockwise on screen unless it's flipped
+    OccluderGeometry Quad(float halfSize, float z, bool isFlipped = false)
+    {
+        OccluderGeometry quad;
+        quad.positions = {{-halfSize, halfSize, z}, {halfSize, halfSize, z}, {halfSize, -halfSize, z}, {-halfSize, -halfSize, z}};
+        quad.indices = isFlipped ? std::vector<std::uint32_t>{0, 2, 1, 0, 3, 2} : std::vector<std::uint32_t>{0, 1, 2, 0, 2, 3};
+        return quad;
+    }
+
+    // a unit cube around the origin, every face wound clockwise seen from outside
+    OccluderGeometry Cube()
+    {
+        OccluderGeometry cube;
+        for (int corner = 0; corner < 8; ++corner)
+            cube.positions.push_back({corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f});
+
+        const std::uint32_t faces[6][4] = {{0, 2, 3, 1}, {4, 5, 7, 6}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 4, 6, 2}, {1, 3, 7, 5}};
+        for (const auto &face : faces)
+        {
+            // wind each triangle so its normal points away from the center
+            XMVECTOR a = XMLoadFloat3(&cube.positions[face[0]]);
+            XMVECTOR b = XMLoadFloat3(&cube.positions[face[1]]);
+            XMVECTOR c = XMLoadFloat3(&cube.positions[face[2]]);
+            bool isOutward = XMVectorGetX(XMVector3Dot(XMVector3Cross(XMVectorSubtract(b, a), XMVectorSubtract(c, a)), a)) > 0.0f;
+
+            std::uint32_t quad[4] = {face[0], face[1], face[2], face[3]};
+            if (!isOutward)
+                std::swap(quad[1], quad[3]);
+            cube.indices.insert(cube.indices.end(), {quad[0], quad[1], quad[2], quad[0], quad[2], quad[3]});
+        }
+        return cube;
+    }
+
+    BoundingBox Box(float x, float y, float z, float extent)
+    {
+        BoundingBox box;
+        box.Center = {x, y, z};
+        box.Extents = {extent, extent, extent};
+        return box;
+    }
+}
+
+TEST_CASE(OcclusionCullerHidesBoxesBehindAWall)
+{
+    OcclusionCuller culler;
+    culler.BeginFrame(TestViewProjection());
+    culler.RenderOccluder(Quad(1000.0f, 10.0f), XMMatrixIdentity());
+    culler.BuildHierarchy();
+    CHECK(culler.GetRasterizedTriangleCount() == 2);
+
+    // the wall covers the whole screen at the depth the projection puts z = 10 at
+    XMFLOAT4 clip;
+    XMStoreFloat4(&clip, XMVector3Transform(XMVectorSet(0.0f, 0.0f, 10.0f, 1.0f), TestViewProjection()));
+    float wallDepth = clip.z / clip.w;
+    const std::vector<float> &depth = culler.GetDepthBuffer();
+    bool isCovered = std::all_of(depth.begin(), depth.end(), [wallDepth](float value)
+                                 { return std::fabs(value - wallDepth) < 1e-4f; });
+    CHECK(isCovered);
+
+    // behind it, wherever on screen, is hidden
+    CHECK(!culler.IsVisible(Box(0.0f, 0.0f, 20.0f, 1.0f)));
+    CHECK(!culler.IsVisible(Box(12.0f, -5.0f, 40.0f, 3.0f)));
+    CHECK(!culler.IsVisible(Box(0.0f, 0.0f, 500.0f, 100.0f)));
+
+    // in front of it, or reaching through it, is not
+    CHECK(culler.IsVisible(Box(0.0f, 0.0f, 5.0f, 1.0f)));
+    CHECK(culler.IsVisible(Box(1.0f, 1.0f, 10.5f, 1.0f)));
+
+    // crossing the near plane (or behind the camera) there's nothing to compare against
+    CHECK(culler.IsVisible(Box(0.0f, 0.0f, 0.0f, 1.0f)));
+    CHECK(culler.IsVisible(Box(0.0f, 0.0f, -20.0f, 1.0f)));
+}
+
+TEST_CASE(OcclusionCullerKeepsBoxesBesideAnOccluder)
+{
+    OcclusionCuller culler;
+    culler.BeginFrame(TestViewProjection());
+    culler.RenderOccluder(Quad(2.0f, 10.0f), XMMatrixIdentity());
+    culler.BuildHierarchy();
+
+    // straight behind the small square and well inside its shadow
+    CHECK(!culler.IsVisible(Box(0.0f, 0.0f, 20.0f, 1.0f)));
+
+    // beside it, or behind it but sticking out past its edge
+    CHECK(culler.IsVisible(Box(8.0f, 0.0f, 20.0f, 1.0f)));
+    CHECK(culler.IsVisible(Box(0.0f, -6.0f, 20.0f, 1.0f)));
+    CHECK(culler.IsVisible(Box(3.0f, 0.0f, 20.0f, 1.0f)));
+
+    // the same square moved off to the side by its world matrix hides what's behind it there instead
+    culler.BeginFrame(TestViewProjection());
+    culler.RenderOccluder(Quad(2.0f, 10.0f), XMMatrixTranslation(8.0f, 0.0f, 0.0f));
+    culler.BuildHierarchy();
+    CHECK(!culler.IsVisible(Box(16.0f, 0.0f, 20.0f, 1.0f)));
+    CHECK(culler.IsVisible(Box(0.0f, 0.0f, 20.0f, 1.0f)));
+}
+
+TEST_CASE(OcclusionCullerSkipsBackFacesAndNearPlaneTriangles)
+{
+    OcclusionCuller culler;
+
+    // wound the other way round the wall faces away from the camera, it mustn't write any depth
+    culler.BeginFrame(TestViewProjection());
+    culler.RenderOccluder(Quad(1000.0f, 10.0f, true), XMMatrixIdentity());
+    culler.BuildHierarchy();
+    CHECK(culler.GetRasterizedTriangleCount() == 0);
+    CHECK(std::all_of(culler.GetDepthBuffer().begin(), culler.GetDepthBuffer().end(), [](float value)
+                      { return value == 1.0f; }));
+    CHECK(culler.IsVisible(Box(0.0f, 0.0f, 20.0f, 1.0f)));
+
+    // a closed cube only draws the faces towards the camera, the front one is what hides things
+    culler.BeginFrame(TestViewProjection());
+    culler.RenderOccluder(Cube(), XMMatrixScaling(5.0f, 5.0f, 5.0f) * XMMatrixTranslation(0.0f, 0.0f, 20.0f));
+    culler.BuildHierarchy();
+    CHECK(culler.GetRasterizedTriangleCount() == 2);
+    CHECK(!culler.IsVisible(Box(0.0f, 0.0f, 40.0f, 1.0f)));
+    CHECK(culler.IsVisible(Box(0.0f, 0.0f, 10.0f, 1.0f)));
+
+    // a slanted wall whose top edge is closer than the near plane is dropped rather than clipped, so it hides
+    // nothing (drawn anyway it would cover the middle of the screen at about z = 15)
+    OccluderGeometry slanted;
+    slanted.positions = {{-50.0f, 50.0f, 0.05f}, {50.0f, 50.0f, 0.05f}, {50.0f, -50.0f, 30.0f}, {-50.0f, -50.0f, 30.0f}};
+    slanted.indices = {0, 1, 2, 0, 2, 3};
+    culler.BeginFrame(TestViewProjection());
+    culler.RenderOccluder(slanted, XMMatrixIdentity());
+    culler.BuildHierarchy();
+    CHECK(culler.GetRasterizedTriangleCount() == 0);
+    CHECK(culler.IsVisible(Box(0.0f, 0.0f, 50.0f, 1.0f)));
+}
+
+BENCHMARK(OcclusionCullerCityBlock)
+{
+    // a street of buildings in front of the camera, and a crowd of boxes among and behind them
+    std::mt19937 random(21);
+    std::uniform_real_distribution<float> x(-150.0f, 150.0f);
+    std::uniform_real_distribution<float> z(15.0f, 400.0f);
+    std::uniform_real_distribution<float> height(5.0f, 40.0f);
+    std::uniform_real_distribution<float> width(3.0f, 15.0f);
+
+    OccluderGeometry cube = Cube();
+    std::vector<XMFLOAT4X4> buildings(200);
+    for (XMFLOAT4X4 &building : buildings)
+    {
+        float buildingHeight = height(random);
+        XMStoreFloat4x4(&building, XMMatrixScaling(width(random), buildingHeight, width(random)) *
+                                       XMMatrixTranslation(x(random), buildingHeight - 10.0f, z(random)));
+    }
+
+    size_t count = BenchmarkSize(100000);
+    std::uniform_real_distribution<float> y(-10.0f, 20.0f);
+    std::uniform_real_distribution<float> extent(0.5f, 3.0f);
+    std::vector<BoundingBox> boxes(count);
+    for (BoundingBox &box : boxes)
+        box = Box(x(random), y(random), z(random), extent(random));
+
+    OcclusionCuller culler;
+    double rasterize = MeasureMilliseconds([&]()
+                                           {
+                                               culler.BeginFrame(TestViewProjection());
+                                               for (const XMFLOAT4X4 &building : buildings)
+                                                   culler.RenderOccluder(cube, XMLoadFloat4x4(&building));
+                                               culler.BuildHierarchy();
+                                           });
+    CHECK(culler.GetRasterizedTriangleCount() > 0);
+
+    size_t hidden = 0;
+    double test = MeasureMilliseconds([&]()
+                                      {
+                                          hidden = 0;
+                                          for (const BoundingBox &box : boxes)
+                                              hidden += culler.IsVisible(box) ? 0 : 1;
+                                      });
+    CHECK(hidden > 0 && hidden < count);
+
+    char label[64];
+    std::snprintf(label, sizeof(label), "rasterize %zu occluders (%zu triangles)", buildings.size(), culler.GetRasterizedTriangleCount());
+    PrintBenchmarkResult(label, buildings.size(), rasterize);
+    std::snprintf(label, sizeof(label), "IsVisible (%zu hidden)", hidden);
+    PrintBenchmarkResult(label, count, test);
+}
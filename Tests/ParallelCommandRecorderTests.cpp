@@ -0,0 +1,152 @@
+#include "TestFramework.h"
+#include "Rendering/ParallelCommandRecorder.h"
+#include "Rendering/RecordingCommandContext.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    using Range = ParallelCommandRecorder::Range;
+    using Type = RecordedCommand::Type;
+
+    // the ranges have to cover [0, count) in order without gaps, and differ in size by one at most
+    bool IsEvenSplit(const std::vector<Range> &ranges, size_t count)
+    {
+        size_t begin = 0;
+        size_t smallest = count;
+        size_t largest = 0;
+        for (const Range &range : ranges)
+        {
+            if (range.begin != begin || range.end <= range.begin)
+                return false;
+
+            smallest = std::min(smallest, range.end - range.begin);
+            largest = std::max(largest, range.end - range.begin);
+            begin = range.end;
+        }
+        return begin == count && largest - smallest <= 1;
+    }
+
+    // what RenderSystem does per chunk: the frame state first (a viewport stands in for it), then one draw per item
+    void RecordDraws(ICommandContext &context, size_t begin, size_t end)
+    {
+        context.SetViewport(1280, 720);
+        for (size_t i = begin; i < end; ++i)
+            context.DrawIndexed(static_cast<std::uint32_t>(i));
+    }
+}
+
+TEST_CASE(ParallelCommandRecorderSplitsEvenly)
+{
+    std::vector<Range> ranges;
+
+    ParallelCommandRecorder::Split(0, 4, 256, ranges);
+    CHECK(ranges.empty());
+
+    // too few draws for a second chunk
+    ParallelCommandRecorder::Split(300, 4, 256, ranges);
+    CHECK(ranges.size() == 1 && IsEvenSplit(ranges, 300));
+    ParallelCommandRecorder::Split(10, 4, 256, ranges);
+    CHECK(ranges.size() == 1 && IsEvenSplit(ranges, 10));
+
+    // as many chunks as fit the minimum size, the first ones take the remainder
+    ParallelCommandRecorder::Split(1000, 4, 256, ranges);
+    CHECK(ranges.size() == 3 && IsEvenSplit(ranges, 1000));
+    CHECK(ranges.size() == 3 && ranges[0].end == 334 && ranges[1].end == 667);
+
+    // never more chunks than asked for, and a zero limit or minimum still gives a valid split
+    ParallelCommandRecorder::Split(100000, 4, 256, ranges);
+    CHECK(ranges.size() == 4 && IsEvenSplit(ranges, 100000));
+    ParallelCommandRecorder::Split(7, 0, 0, ranges);
+    CHECK(ranges.size() == 1 && IsEvenSplit(ranges, 7));
+    ParallelCommandRecorder::Split(7, 16, 0, ranges);
+    CHECK(ranges.size() == 7 && IsEvenSplit(ranges, 7));
+}
+
+TEST_CASE(ParallelCommandRecorderPlaysChunksBackInOrder)
+{
+    std::vector<RecordedCommand> stream;
+    size_t contextCount = 0;
+    ParallelCommandRecorder recorder([&]()
+                                     {
+                                         ++contextCount;
+                                         return std::make_unique<RecordingCommandContext>(stream);
+                                     },
+                                     64);
+
+    JobSystem jobSystem;
+    jobSystem.Initialize(3);
+
+    // recorded in parallel, a chunk at a time, the draws still come out as 0, 1, 2, ... with each chunk's
+    // frame state right before its first draw
+    for (int frame = 0; frame < 20; ++frame)
+    {
+        stream.clear();
+        CHECK(recorder.Record(&jobSystem, 1000, RecordDraws));
+        CHECK(stream.empty());
+        recorder.Execute();
+
+        const std::vector<Range> &chunks = recorder.GetChunks();
+        CHECK(chunks.size() == jobSystem.GetThreadCount() && IsEvenSplit(chunks, 1000));
+
+        bool isInOrder = stream.size() == 1000 + chunks.size();
+        size_t next = 0;
+        size_t chunk = 0;
+        for (const RecordedCommand &command : stream)
+        {
+            if (!isInOrder)
+                break;
+
+            if (command.type == Type::SetViewport)
+            {
+                isInOrder = chunk < chunks.size() && chunks[chunk].begin == next;
+                ++chunk;
+                continue;
+            }
+            isInOrder = command.type == Type::DrawIndexed && command.values[0] == next;
+            ++next;
+        }
+        CHECK(isInOrder);
+
+        // executing again without recording plays nothing back twice
+        recorder.Execute();
+        CHECK(stream.size() == 1000 + chunks.size());
+    }
+
+    // the contexts are kept from frame to frame
+    CHECK(contextCount == jobSystem.GetThreadCount());
+
+    // without a job system it's a single chunk on the calling thread
+    stream.clear();
+    CHECK(recorder.Record(nullptr, 1000, RecordDraws));
+    recorder.Execute();
+    CHECK(recorder.GetChunks().size() == 1 && stream.size() == 1001);
+}
+
+TEST_CASE(ParallelCommandRecorderExecutesNothingWithoutAllContexts)
+{
+    // the backend runs out of contexts after two
+    std::vector<RecordedCommand> stream;
+    size_t contextCount = 0;
+    ParallelCommandRecorder recorder([&]() -> std::unique_ptr<ICommandContext>
+                                     {
+                                         if (contextCount == 2)
+                                             return nullptr;
+
+                                         ++contextCount;
+                                         return std::make_unique<RecordingCommandContext>(stream);
+                                     },
+                                     16);
+
+    JobSystem jobSystem;
+    jobSystem.Initialize(3);
+    CHECK(!recorder.Record(&jobSystem, 1000, RecordDraws));
+    recorder.Execute();
+    CHECK(stream.empty());
+
+    // few enough draws for the contexts there are works
+    CHECK(recorder.Record(&jobSystem, 40, RecordDraws));
+    recorder.Execute();
+    CHECK(stream.size() == 40 + 2);
+}
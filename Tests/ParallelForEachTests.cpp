@@ -0,0 +1,88 @@
+#include "TestFramework.h"
+#include "TestComponents.h"
+#include "Core/JobSystem.h"
+#include "ECS/Registry.h"
+#include <atomic>
+#include <cstdio>
+#include <memory>
+
+TEST_CASE(ParallelForEachVisitsEveryMatchOnce)
+{
+    Registry registry;
+    constexpr size_t COUNT = 20000;
+    for (size_t i = 0; i < COUNT; ++i)
+    {
+        EntityID entity = registry.CreateEntity();
+        registry.AddComponent<Position>(entity);
+        if (i % 3 == 0)
+            registry.AddComponent<Velocity>(entity, 1.0f, 0.0f, 0.0f);
+    }
+
+    JobSystem jobSystem;
+    jobSystem.Initialize(3);
+
+    std::atomic<size_t> visits{0};
+    registry.ParallelForEach<Position, Velocity>(jobSystem, [&visits](EntityID, Position &position, Velocity &velocity)
+                                                 {
+                                                     position.x += velocity.x;
+                                                     visits.fetch_add(1, std::memory_order_relaxed);
+                                                 });
+
+    CHECK(visits.load() == (COUNT + 2) / 3);
+
+    // once each, so every moved position went up by exactly one
+    bool allOnce = true;
+    for (auto [entity, position] : registry.View<Position>())
+        allOnce = allOnce && position.x == (registry.HasComponent<Velocity>(entity) ? 1.0f : 0.0f);
+    CHECK(allOnce);
+}
+
+BENCHMARK(ParallelForEachScaling)
+{
+    size_t count = BenchmarkSize(1000000);
+
+    Registry registry;
+    for (size_t i = 0; i < count; ++i)
+    {
+        EntityID entity = registry.CreateEntity();
+        Transform *transform = registry.AddComponent<Transform>(entity);
+        transform->position[0] = static_cast<float>(i % 1000);
+    }
+
+    double serialSum = 0.0;
+    for (unsigned int threads : BenchmarkThreadCounts())
+    {
+        // one thread is the plain view, no job system at all
+        std::unique_ptr<JobSystem> jobSystem;
+        if (threads > 1)
+        {
+            jobSystem = std::make_unique<JobSystem>();
+            jobSystem->Initialize(threads - 1);
+        }
+
+        auto rebuild = [](EntityID, Transform &transform)
+        {
+            transform.ComputeWorld();
+        };
+
+        double milliseconds = MeasureMilliseconds([&]()
+                                                  {
+                                                      if (jobSystem)
+                                                          registry.ParallelForEach<Transform>(*jobSystem, rebuild);
+                                                      else
+                                                          registry.View<Transform>().Each(rebuild);
+                                                  });
+
+        double sum = 0.0;
+        for (auto [entity, transform] : registry.View<Transform>())
+            sum += transform.world[12];
+
+        if (threads == 1)
+            serialSum = sum;
+        CHECK(sum == serialSum);
+
+        char label[64];
+        std::snprintf(label, sizeof(label), "rebuild world matrices, %u threads", threads);
+        PrintBenchmarkResult(label, count, milliseconds);
+    }
+}
@@ -0,0 +1,315 @@
+#include "TestFramework.h"
+#include "Rendering/RenderPipelineManager.h"
+#include "Rendering/NullRenderDevice.h"
+#include "Rendering/ParallelCommandRecorder.h"
+#include "Rendering/InstanceBatcher.h"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    using Opcode = CommandStream::Opcode;
+
+    // the null device only wants the bytecode to be there
+    bool CompileStub(const std::wstring &, const std::string &shaderModel, std::vector<std::uint8_t> &bytecode)
+    {
+        bytecode.assign(shaderModel.begin(), shaderModel.end());
+        return true;
+    }
+
+    // a cube's worth of buffers, one texture and a sampler, all the draws share them
+    struct Scene
+    {
+        const void *vertexBuffer;
+        const void *indexBuffer;
+        const void *texture;
+        const void *sampler;
+    };
+
+    constexpr std::uint32_t VERTEX_STRIDE = 72; // position, normal, color, texcoord, tangent, bitangent
+    constexpr std::uint32_t INDEX_COUNT = 36;
+
+    Scene CreateScene(IRenderDevice &device)
+    {
+        std::vector<std::uint8_t> vertices(24 * VERTEX_STRIDE);
+        std::vector<std::uint32_t> indices(INDEX_COUNT);
+        std::uint32_t texel = 0xFFFFFFFF;
+
+        Scene scene;
+        scene.vertexBuffer = device.CreateBuffer({BufferUsage::Vertex, static_cast<std::uint32_t>(vertices.size()), vertices.data()});
+        scene.indexBuffer = device.CreateBuffer({BufferUsage::Index, INDEX_COUNT * 4, indices.data()});
+        scene.texture = device.CreateTexture({1, 1, FORMAT_R32G32B32A32_UINT, &texel, 4});
+        scene.sampler = device.CreateSamplerState();
+        return scene;
+    }
+
+    XMMATRIX View()
+    {
+        return XMMatrixLookAtLH(XMVectorSet(0.0f, 2.0f, -10.0f, 1.0f), XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    }
+
+    XMMATRIX Projection()
+    {
+        return XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 100.0f);
+    }
+
+    void BindDraw(ICommandContext &context, RenderPipelineManager &pipeline, const Scene &scene, std::uint32_t item)
+    {
+        pipeline.BindMatrixBuffer(context, item);
+        context.SetVertexBuffer(0, scene.vertexBuffer, VERTEX_STRIDE, 0);
+        context.SetIndexBuffer(scene.indexBuffer, FORMAT_R32_UINT, 0);
+        context.SetTexture(0, scene.texture);
+        context.SetSampler(0, scene.sampler);
+        context.DrawIndexed(INDEX_COUNT);
+    }
+
+    // one frame the way RenderSystem builds it: clear, pass state, camera, every draw's matrices up front, then the draws
+    void RecordFrame(RenderPipelineManager &pipeline, const Scene &scene, std::uint32_t drawCount)
+    {
+        const float clearColor[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        pipeline.ClearBuffers(clearColor);
+        pipeline.ResetRenderStates();
+        pipeline.UpdateCameraBuffer({0.0f, 2.0f, -10.0f});
+
+        for (std::uint32_t i = 0; i < drawCount; ++i)
+            pipeline.AddMatrixBuffer(XMMatrixTranslation(static_cast<float>(i), 0.0f, 0.0f), View(), Projection());
+        pipeline.UploadMatrixBuffers();
+
+        for (std::uint32_t i = 0; i < drawCount; ++i)
+            BindDraw(pipeline.GetImmediateContext(), pipeline, scene, i);
+
+        pipeline.Present();
+    }
+
+    // a golden listing that doesn't match prints what came out instead, so it can be diffed
+    bool MatchesListing(const CommandStream &frame, const char *expected)
+    {
+        std::string listing = CommandStream::Disassemble(frame.GetBytes());
+        if (listing == expected)
+            return true;
+
+        std::printf("    recorded frame:\n%s", listing.c_str());
+        return false;
+    }
+
+    // every draw with the matrix range it was drawn with, what has to match however the draws were recorded
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> DrawsWithMatrices(const CommandStream &frame)
+    {
+        std::vector<CommandStream::Command> commands;
+        CommandStream::Decode(frame.GetBytes(), commands);
+
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> draws;
+        std::uint32_t firstConstant = ~0u;
+        for (const CommandStream::Command &command : commands)
+        {
+            if (command.opcode == Opcode::SetVertexConstantBuffer && command.operands[0] == 0)
+                firstConstant = command.operands[2];
+            else if (command.opcode == Opcode::DrawIndexed)
+                draws.push_back({firstConstant, command.operands[0]});
+        }
+        return draws;
+    }
+}
+
+TEST_CASE(RenderPipelineRecordsFrameOnNullDevice)
+{
+    auto device = std::make_shared<NullRenderDevice>(1280, 720);
+    RenderPipelineManager pipeline(device, CompileStub);
+    CHECK(pipeline.Initialize());
+    CHECK(pipeline.SupportsDeferredContexts());
+    Scene scene = CreateScene(*device);
+
+    // IDs 1 and 2 are the targets, then the pipeline's buffers, states and shaders in the order Initialize makes
+    // them (3 matrices, 4 camera, 5 solid, 6 wireframe, 7 depth, 8 vs, 9 ps, 10 layout, 11 instanced vs,
+    // 12 instanced layout, 13 matrix ring), then the scene's (14 vertices, 15 indices, 16 texture, 17 sampler)
+    RecordFrame(pipeline, scene, 3);
+    CHECK(device->GetPresentedFrameCount() == 1);
+    CHECK(MatchesListing(device->GetLastFrame(),
+                         "Clear 4278190080\n"
+                         "SetRenderTargets 1 2\n"
+                         "SetViewport 1280 720\n"
+                         "SetDepthStencilState 7 0\n"
+                         "SetRasterizerState 5\n"
+                         "SetPrimitiveTopology 4\n"
+                         "SetInputLayout 10\n"
+                         "SetVertexShader 8\n"
+                         "SetPixelShader 9\n"
+                         "SetPixelConstantBuffer 2 4 0 0\n"
+                         "WriteBuffer 4 0 16 0\n"
+                         "WriteBuffer 13 0 768 0\n"
+                         "SetVertexConstantBuffer 0 13 0 16\n"
+                         "SetVertexBuffer 0 14 72 0\n"
+                         "SetIndexBuffer 15 42 0\n"
+                         "SetTexture 0 16\n"
+                         "SetSampler 0 17\n"
+                         "DrawIndexed 36 0 0\n"
+                         "SetVertexConstantBuffer 0 13 16 16\n"
+                         "DrawIndexed 36 0 0\n"
+                         "SetVertexConstantBuffer 0 13 32 16\n"
+                         "DrawIndexed 36 0 0\n"
+                         "Present 1\n"));
+
+    // each draw's block holds its own transposed world matrix, the translation ends up in the first row's w
+    const std::vector<std::uint8_t> *ring = device->GetBufferData(pipeline.GetMatrixRing());
+    bool isTranslated = ring != nullptr;
+    for (std::uint32_t i = 0; isTranslated && i < 3; ++i)
+    {
+        float x;
+        std::memcpy(&x, ring->data() + i * 256 + 3 * sizeof(float), sizeof(float));
+        isTranslated = x == static_cast<float>(i);
+    }
+    CHECK(isTranslated);
+
+    // the next frame only rebinds what the cache can't vouch for: the matrix slot (imgui may have reset it) and the
+    // draws' ranges; the null device's fences are done as soon as they're signaled, so the first frame has retired
+    // and its part of the ring is reused from the start, without a discard this time
+    RecordFrame(pipeline, scene, 3);
+    CHECK(MatchesListing(device->GetLastFrame(),
+                         "Clear 4278190080\n"
+                         "WriteBuffer 4 0 16 0\n"
+                         "WriteBuffer 13 0 768 1\n"
+                         "SetVertexConstantBuffer 0 13 0 16\n"
+                         "DrawIndexed 36 0 0\n"
+                         "SetVertexConstantBuffer 0 13 16 16\n"
+                         "DrawIndexed 36 0 0\n"
+                         "SetVertexConstantBuffer 0 13 32 16\n"
+                         "DrawIndexed 36 0 0\n"
+                         "Present 2\n"));
+}
+
+TEST_CASE(RenderPipelineFramesAreDeterministic)
+{
+    // two devices fed the same frames write the same bytes, frame after frame
+    auto first = std::make_shared<NullRenderDevice>();
+    auto second = std::make_shared<NullRenderDevice>();
+    RenderPipelineManager firstPipeline(first, CompileStub);
+    RenderPipelineManager secondPipeline(second, CompileStub);
+    CHECK(firstPipeline.Initialize() && secondPipeline.Initialize());
+    Scene firstScene = CreateScene(*first);
+    Scene secondScene = CreateScene(*second);
+
+    bool isSame = true;
+    for (std::uint32_t frame = 0; frame < 10; ++frame)
+    {
+        RecordFrame(firstPipeline, firstScene, 50 + frame);
+        RecordFrame(secondPipeline, secondScene, 50 + frame);
+        isSame = isSame && !first->GetLastFrame().GetBytes().empty() &&
+                 first->GetLastFrame().GetBytes() == second->GetLastFrame().GetBytes();
+    }
+    CHECK(isSame);
+
+    // and a wireframe toggle on one of them shows up as exactly one more command
+    firstPipeline.SetWireframeMode(true);
+    RecordFrame(firstPipeline, firstScene, 10);
+    RecordFrame(secondPipeline, secondScene, 10);
+    CHECK(first->GetLastFrame().GetSize() == second->GetLastFrame().GetSize() + 2);
+    CHECK(CommandStream::Disassemble(first->GetLastFrame().GetBytes()).find("SetRasterizerState 6\n") != std::string::npos);
+}
+
+TEST_CASE(RenderPipelineDeferredFrameMatchesImmediate)
+{
+    auto immediate = std::make_shared<NullRenderDevice>();
+    auto deferred = std::make_shared<NullRenderDevice>();
+    RenderPipelineManager immediatePipeline(immediate, CompileStub);
+    RenderPipelineManager deferredPipeline(deferred, CompileStub);
+    CHECK(immediatePipeline.Initialize() && deferredPipeline.Initialize());
+    Scene immediateScene = CreateScene(*immediate);
+    Scene deferredScene = CreateScene(*deferred);
+
+    // chunks recorded in parallel, each starting from nothing bound, and played back in order
+    ParallelCommandRecorder recorder([&]() { return deferredPipeline.CreateDeferredContext(); }, 8);
+    JobSystem jobSystem;
+    jobSystem.Initialize(3);
+
+    for (int frame = 0; frame < 5; ++frame)
+    {
+        RecordFrame(immediatePipeline, immediateScene, 100);
+
+        const float clearColor[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        deferredPipeline.ClearBuffers(clearColor);
+        deferredPipeline.ResetRenderStates();
+        deferredPipeline.UpdateCameraBuffer({0.0f, 2.0f, -10.0f});
+        for (std::uint32_t i = 0; i < 100; ++i)
+            deferredPipeline.AddMatrixBuffer(XMMatrixTranslation(static_cast<float>(i), 0.0f, 0.0f), View(), Projection());
+        CHECK(deferredPipeline.UploadMatrixBuffers());
+
+        CHECK(recorder.Record(&jobSystem, 100, [&](ICommandContext &context, size_t begin, size_t end)
+                              {
+                                  deferredPipeline.BindPassState(context);
+                                  for (size_t i = begin; i < end; ++i)
+                                      BindDraw(context, deferredPipeline, deferredScene, static_cast<std::uint32_t>(i));
+                              }));
+        recorder.Execute();
+        deferredPipeline.Present();
+
+        // the chunks repeat the pass state, but every draw sees the same matrices as the immediate frame
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> expected = DrawsWithMatrices(immediate->GetLastFrame());
+        CHECK(expected.size() == 100);
+        CHECK(DrawsWithMatrices(deferred->GetLastFrame()) == expected);
+        CHECK(recorder.GetChunks().size() == jobSystem.GetThreadCount());
+    }
+}
+
+TEST_CASE(RenderPipelineUploadsInstances)
+{
+    auto device = std::make_shared<NullRenderDevice>();
+    RenderPipelineManager pipeline(device, CompileStub);
+    CHECK(pipeline.Initialize());
+    Scene scene = CreateScene(*device);
+
+    InstanceBatcher::DrawState state;
+    state.vertexBuffer = scene.vertexBuffer;
+    state.indexBuffer = scene.indexBuffer;
+    state.indexCount = INDEX_COUNT;
+    state.diffuseTexture = scene.texture;
+    state.sampler = scene.sampler;
+
+    // more instances than the buffer starts with, it has to grow
+    InstanceBatcher batcher;
+    for (std::uint32_t item = 0; item < 300; ++item)
+    {
+        XMFLOAT4X4 world;
+        XMStoreFloat4x4(&world, XMMatrixTranslation(static_cast<float>(item), 0.0f, 0.0f));
+        batcher.Add(state, item, world);
+    }
+    const std::vector<InstanceData> &instances = batcher.GetInstances();
+
+    pipeline.SetInstancingEnabled(true);
+    const float clearColor[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+    pipeline.ClearBuffers(clearColor);
+    pipeline.ResetRenderStates();
+    CHECK(pipeline.UploadInstances(instances.data(), static_cast<std::uint32_t>(instances.size())));
+    pipeline.SetVertexBuffer(scene.vertexBuffer, VERTEX_STRIDE);
+    pipeline.SetIndexBuffer(scene.indexBuffer);
+    pipeline.DrawIndexedInstanced(INDEX_COUNT, static_cast<std::uint32_t>(instances.size()));
+    pipeline.Present();
+
+    // the buffer holds the instances as they were, and slot 1 streams them with the instanced shader and layout
+    const std::vector<std::uint8_t> *data = device->GetBufferData(pipeline.GetInstanceBuffer());
+    CHECK(data && data->size() == 512 * sizeof(InstanceData));
+    CHECK(data && std::memcmp(data->data(), instances.data(), instances.size() * sizeof(InstanceData)) == 0);
+
+    std::uint32_t instanceBufferID = NullRenderDevice::GetResourceID(pipeline.GetInstanceBuffer());
+    std::string listing = CommandStream::Disassemble(device->GetLastFrame().GetBytes());
+    CHECK(listing.find("SetInputLayout 12\nSetVertexShader 11\n") != std::string::npos);
+    CHECK(listing.find("WriteBuffer " + std::to_string(instanceBufferID) + " 0 " +
+                       std::to_string(instances.size() * sizeof(InstanceData)) + " 0\n") != std::string::npos);
+    CHECK(listing.find("SetVertexBuffer 1 " + std::to_string(instanceBufferID) + " " + std::to_string(sizeof(InstanceData)) +
+                       " 0\n") != std::string::npos);
+    CHECK(listing.find("DrawIndexedInstanced 36 300 0 0 0\n") != std::string::npos);
+
+    // a smaller frame keeps the buffer, and doesn't rebind it
+    size_t resourceCount = device->GetResourceCount();
+    pipeline.ResetRenderStates();
+    CHECK(pipeline.UploadInstances(instances.data(), 10));
+    pipeline.Present();
+    CHECK(device->GetResourceCount() == resourceCount);
+    CHECK(NullRenderDevice::GetResourceID(pipeline.GetInstanceBuffer()) == instanceBufferID);
+    CHECK(CommandStream::Disassemble(device->GetLastFrame().GetBytes()).find("SetVertexBuffer") == std::string::npos);
+}
@@ -0,0 +1,159 @@
+#include "TestFramework.h"
+#include "Rendering/RenderQueue.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // a frame's worth of draws: a few shaders, a few hundred materials and meshes, one in ten transparent
+    std::vector<RenderQueue::Entry> RandomDraws(size_t count, unsigned int seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<std::uint32_t> shader(1, 8);
+        std::uniform_int_distribution<std::uint32_t> material(1, 300);
+        std::uniform_int_distribution<std::uint32_t> mesh(1, 500);
+        std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+        std::uniform_int_distribution<int> percent(0, 99);
+
+        std::vector<RenderQueue::Entry> draws(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            RenderQueue::Pass pass = percent(random) < 10 ? RenderQueue::Pass::Transparent : RenderQueue::Pass::Opaque;
+            draws[i].key = RenderQueue::MakeKey(pass, shader(random), material(random), mesh(random), depth(random));
+            draws[i].item = static_cast<std::uint32_t>(i);
+        }
+        return draws;
+    }
+
+    void StableSortByKey(std::vector<RenderQueue::Entry> &entries)
+    {
+        std::stable_sort(entries.begin(), entries.end(), [](const RenderQueue::Entry &a, const RenderQueue::Entry &b)
+                         { return a.key < b.key; });
+    }
+
+    bool SameOrder(const std::vector<RenderQueue::Entry> &a, const std::vector<RenderQueue::Entry> &b)
+    {
+        if (a.size() != b.size())
+            return false;
+
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (a[i].key != b[i].key || a[i].item != b[i].item)
+                return false;
+        }
+        return true;
+    }
+}
+
+TEST_CASE(RenderQueueKeyOrder)
+{
+    using Pass = RenderQueue::Pass;
+
+    // opaque: state first, then near to far
+    CHECK(RenderQueue::MakeKey(Pass::Opaque, 1, 1, 1, 0.9f) < RenderQueue::MakeKey(Pass::Opaque, 1, 1, 2, 0.1f));
+    CHECK(RenderQueue::MakeKey(Pass::Opaque, 1, 1, 1, 0.1f) < RenderQueue::MakeKey(Pass::Opaque, 1, 1, 1, 0.9f));
+    CHECK(RenderQueue::MakeKey(Pass::Opaque, 1, 9, 9, 0.5f) < RenderQueue::MakeKey(Pass::Opaque, 2, 1, 1, 0.5f));
+
+    // transparent: after every opaque draw, far to near whatever the state
+    CHECK(RenderQueue::MakeKey(Pass::Opaque, 1023, 9, 9, 1.0f) < RenderQueue::MakeKey(Pass::Transparent, 0, 0, 0, 0.0f));
+    CHECK(RenderQueue::MakeKey(Pass::Transparent, 5, 5, 5, 0.9f) < RenderQueue::MakeKey(Pass::Transparent, 1, 1, 1, 0.1f));
+
+    // depth outside [0, 1] is clamped instead of spilling into the state bits
+    CHECK(RenderQueue::MakeKey(Pass::Opaque, 1, 1, 1, 5.0f) == RenderQueue::MakeKey(Pass::Opaque, 1, 1, 1, 1.0f));
+    CHECK(RenderQueue::MakeKey(Pass::Opaque, 1, 1, 1, -5.0f) == RenderQueue::MakeKey(Pass::Opaque, 1, 1, 1, 0.0f));
+}
+
+TEST_CASE(RenderQueueSortIsStable)
+{
+    // both sides of the radix threshold, and keys that repeat a lot so stability matters
+    for (size_t count : {0, 1, 100, 255, 256, 5000})
+    {
+        std::vector<RenderQueue::Entry> draws = RandomDraws(count, static_cast<unsigned int>(count));
+        for (size_t i = 0; i < draws.size(); i += 2)
+            draws[i].key = draws[i / 4].key;
+
+        RenderQueue queue;
+        for (const RenderQueue::Entry &draw : draws)
+            queue.Submit(draw.key, draw.item);
+        queue.Sort();
+
+        StableSortByKey(draws);
+        CHECK(SameOrder(queue.GetEntries(), draws));
+    }
+}
+
+TEST_CASE(RenderQueueStateIDsStayInTheirField)
+{
+    using StateType = RenderQueue::StateType;
+
+    // stand-ins for resources, only the addresses matter
+    std::vector<char> resources(70000);
+    RenderQueue queue;
+
+    // materials and meshes are numbered separately, both start at 1 and null is always 0
+    CHECK(queue.GetStateID(StateType::Material, {&resources[0], &resources[1]}) == 1);
+    CHECK(queue.GetStateID(StateType::Mesh, {&resources[2], &resources[3]}) == 1);
+    CHECK(queue.GetStateID(StateType::Mesh, {&resources[4], &resources[3]}) == 2);
+    CHECK(queue.GetStateID(StateType::Material, {&resources[0], &resources[1]}) == 1);
+    CHECK(queue.GetStateID(StateType::Mesh, {nullptr, nullptr}) == 0);
+
+    // a frame's IDs are distinct until they run out of the 16 bits, and they survive Clear until then
+    std::uint32_t largest = 0;
+    for (size_t i = 0; i < 65533; ++i)
+        largest = std::max(largest, queue.GetStateID(StateType::Mesh, {&resources[i]}));
+    CHECK(largest == 65535);
+    CHECK(queue.GetStateID(StateType::Mesh, {&resources[65533]}) == 65536);
+
+    // Clear starts the outgrown mesh numbering over, the materials keep theirs
+    queue.Clear();
+    CHECK(queue.GetStateID(StateType::Mesh, {&resources[65533]}) == 1);
+    CHECK(queue.GetStateID(StateType::Material, {&resources[0], &resources[1]}) == 1);
+    CHECK(queue.GetStateID(StateType::Material, {&resources[5]}) == 2);
+
+    queue.Clear();
+    CHECK(queue.GetStateID(StateType::Mesh, {&resources[65533]}) == 1);
+    CHECK(queue.GetStateID(StateType::Mesh, {&resources[69999]}) == 2);
+}
+
+BENCHMARK(RenderQueueRadixVersusStdSort)
+{
+    size_t count = BenchmarkSize(100000);
+    std::vector<RenderQueue::Entry> draws = RandomDraws(count, 1);
+
+    // every run starts from the same unsorted frame, refilling it is part of every timing
+    RenderQueue queue;
+    double radix = MeasureMilliseconds([&]()
+                                       {
+                                           queue.Clear();
+                                           for (const RenderQueue::Entry &draw : draws)
+                                               queue.Submit(draw.key, draw.item);
+                                           queue.Sort();
+                                       });
+
+    std::vector<RenderQueue::Entry> sorted;
+    double stdSort = MeasureMilliseconds([&]()
+                                         {
+                                             sorted = draws;
+                                             std::sort(sorted.begin(), sorted.end(), [](const RenderQueue::Entry &a, const RenderQueue::Entry &b)
+                                                       { return a.key < b.key; });
+                                         });
+
+    // std::sort isn't stable, compare it by key only
+    bool isSameKeys = sorted.size() == queue.GetSize();
+    for (size_t i = 0; isSameKeys && i < sorted.size(); ++i)
+        isSameKeys = sorted[i].key == queue.GetEntries()[i].key;
+    CHECK(isSameKeys);
+
+    std::vector<RenderQueue::Entry> stableSorted;
+    double stableSort = MeasureMilliseconds([&]()
+                                            {
+                                                stableSorted = draws;
+                                                StableSortByKey(stableSorted);
+                                            });
+    CHECK(SameOrder(stableSorted, queue.GetEntries()));
+
+    PrintBenchmarkResult("RenderQueue::Sort (radix)", count, radix);
+    PrintBenchmarkResult("std::sort", count, stdSort);
+    PrintBenchmarkResult("std::stable_sort", count, stableSort);
+}
@@ -0,0 +1,254 @@
+#include "TestFramework.h"
+#include "Rendering/RecordingCommandContext.h"
+#include "Rendering/RenderStateCache.h"
+#include <vector>
+
+namespace
+{
+    using Type = RecordedCommand::Type;
+    using Stage = ICommandContext::Stage;
+
+    // what D3D11CommandContext does with its cache, with a recording context standing in for the device:
+    // only the binds the cache lets through reach it, draws always do
+    class CachedContext : public ICommandContext
+    {
+    public:
+        CachedContext(RenderStateCache &cache, RecordingCommandContext &device) : cache(cache), device(device) {}
+
+        void Begin() override { device.Begin(); }
+        bool Finish() override { return device.Finish(); }
+        void Execute() override { device.Execute(); }
+
+        void SetRenderTargets(const void *renderTarget, const void *depthStencil) override
+        {
+            if (cache.SetRenderTargets(renderTarget, depthStencil))
+                device.SetRenderTargets(renderTarget, depthStencil);
+        }
+
+        void SetViewport(std::uint32_t width, std::uint32_t height) override
+        {
+            if (cache.SetViewport(width, height))
+                device.SetViewport(width, height);
+        }
+
+        void SetRasterizerState(const void *state) override
+        {
+            if (cache.SetRasterizerState(state))
+                device.SetRasterizerState(state);
+        }
+
+        void SetDepthStencilState(const void *state, std::uint32_t stencilRef) override
+        {
+            if (cache.SetDepthStencilState(state, stencilRef))
+                device.SetDepthStencilState(state, stencilRef);
+        }
+
+        void SetPrimitiveTopology(std::uint32_t topology) override
+        {
+            if (cache.SetPrimitiveTopology(topology))
+                device.SetPrimitiveTopology(topology);
+        }
+
+        void SetInputLayout(const void *layout) override
+        {
+            if (cache.SetInputLayout(layout))
+                device.SetInputLayout(layout);
+        }
+
+        void SetVertexShader(const void *shader) override
+        {
+            if (cache.SetVertexShader(shader))
+                device.SetVertexShader(shader);
+        }
+
+        void SetPixelShader(const void *shader) override
+        {
+            if (cache.SetPixelShader(shader))
+                device.SetPixelShader(shader);
+        }
+
+        void SetVertexBuffer(std::uint32_t slot, const void *buffer, std::uint32_t stride, std::uint32_t offset) override
+        {
+            if (cache.SetVertexBuffer(slot, buffer, stride, offset))
+                device.SetVertexBuffer(slot, buffer, stride, offset);
+        }
+
+        void SetIndexBuffer(const void *buffer, std::uint32_t format, std::uint32_t offset) override
+        {
+            if (cache.SetIndexBuffer(buffer, format, offset))
+                device.SetIndexBuffer(buffer, format, offset);
+        }
+
+        void SetConstantBuffer(Stage stage, std::uint32_t slot, const void *buffer,
+                               std::uint32_t firstConstant = 0, std::uint32_t constantCount = 0) override
+        {
+            if (cache.SetConstantBuffer(stage, slot, buffer, firstConstant, constantCount))
+                device.SetConstantBuffer(stage, slot, buffer, firstConstant, constantCount);
+        }
+
+        void SetTexture(std::uint32_t slot, const void *texture) override
+        {
+            if (cache.SetTexture(slot, texture))
+                device.SetTexture(slot, texture);
+        }
+
+        void SetSampler(std::uint32_t slot, const void *sampler) override
+        {
+            if (cache.SetSampler(slot, sampler))
+                device.SetSampler(slot, sampler);
+        }
+
+        void DrawIndexed(std::uint32_t indexCount, std::uint32_t startIndex = 0, std::int32_t baseVertex = 0) override
+        {
+            device.DrawIndexed(indexCount, startIndex, baseVertex);
+        }
+
+        void DrawIndexedInstanced(std::uint32_t indexCount, std::uint32_t instanceCount, std::uint32_t startInstance = 0,
+                                  std::uint32_t startIndex = 0, std::int32_t baseVertex = 0) override
+        {
+            device.DrawIndexedInstanced(indexCount, instanceCount, startInstance, startIndex, baseVertex);
+        }
+
+    private:
+        RenderStateCache &cache;
+        RecordingCommandContext &device;
+    };
+
+    // stand-ins for D3D objects, only their addresses matter
+    struct Resources
+    {
+        char vertexShader, pixelShader, layout, rasterizer, depthState, target, depth;
+        char vertexBuffer, otherVertexBuffer, indexBuffer, constants, otherConstants;
+        char texture, otherTexture, sampler;
+    };
+
+    // everything a draw of the default pipeline binds
+    void BindDraw(ICommandContext &context, const Resources &r, const void *texture, std::uint32_t firstConstant)
+    {
+        context.SetRenderTargets(&r.target, &r.depth);
+        context.SetViewport(1280, 720);
+        context.SetRasterizerState(&r.rasterizer);
+        context.SetDepthStencilState(&r.depthState, 0);
+        context.SetPrimitiveTopology(4);
+        context.SetInputLayout(&r.layout);
+        context.SetVertexShader(&r.vertexShader);
+        context.SetPixelShader(&r.pixelShader);
+        context.SetVertexBuffer(0, &r.vertexBuffer, 32, 0);
+        context.SetIndexBuffer(&r.indexBuffer, 42, 0);
+        context.SetConstantBuffer(Stage::Vertex, 0, &r.constants, firstConstant, 16);
+        context.SetTexture(0, texture);
+        context.SetSampler(0, &r.sampler);
+        context.DrawIndexed(36);
+    }
+
+    std::vector<Type> Types(const std::vector<RecordedCommand> &commands)
+    {
+        std::vector<Type> types;
+        for (const RecordedCommand &command : commands)
+            types.push_back(command.type);
+        return types;
+    }
+}
+
+TEST_CASE(RenderStateCacheDropsRedundantBinds)
+{
+    Resources r;
+    RenderStateCache cache;
+    std::vector<RecordedCommand> stream;
+    RecordingCommandContext device(stream);
+    CachedContext context(cache, device);
+
+    // the first draw binds everything, the second only what changed, the third nothing
+    context.Begin();
+    BindDraw(context, r, &r.texture, 0);
+    CHECK(device.GetCommands().size() == 14);
+    CHECK(cache.GetStats().issued == 13 && cache.GetStats().skipped == 0);
+
+    context.Begin();
+    BindDraw(context, r, &r.otherTexture, 16);
+    CHECK(Types(device.GetCommands()) == std::vector<Type>({Type::SetVertexConstantBuffer, Type::SetTexture, Type::DrawIndexed}));
+    CHECK(device.GetCommands()[0].values[0] == 16 && device.GetCommands()[0].values[1] == 16);
+    CHECK(device.GetCommands()[1].resource == &r.otherTexture);
+
+    context.Begin();
+    BindDraw(context, r, &r.otherTexture, 16);
+    CHECK(Types(device.GetCommands()) == std::vector<Type>({Type::DrawIndexed}));
+    CHECK(cache.GetStats().issued == 15 && cache.GetStats().skipped == 24);
+
+    // every argument of a bind counts, not just the resource
+    context.Begin();
+    context.SetVertexBuffer(0, &r.vertexBuffer, 48, 0);
+    context.SetVertexBuffer(0, &r.vertexBuffer, 48, 64);
+    context.SetIndexBuffer(&r.indexBuffer, 57, 0);
+    context.SetDepthStencilState(&r.depthState, 1);
+    context.SetViewport(1280, 800);
+    context.SetRenderTargets(&r.target, nullptr);
+    CHECK(device.GetCommands().size() == 6);
+
+    // and the vertex and pixel constant buffer slots are separate, as are the slots of one stage
+    context.Begin();
+    context.SetConstantBuffer(Stage::Pixel, 0, &r.constants, 16, 16);
+    context.SetConstantBuffer(Stage::Vertex, 1, &r.constants, 16, 16);
+    context.SetConstantBuffer(Stage::Vertex, 0, &r.constants, 16, 16);
+    context.SetConstantBuffer(Stage::Vertex, 0, &r.otherConstants, 16, 16);
+    CHECK(Types(device.GetCommands()) ==
+          std::vector<Type>({Type::SetPixelConstantBuffer, Type::SetVertexConstantBuffer, Type::SetVertexConstantBuffer}));
+    CHECK(device.GetCommands()[1].slot == 1 && device.GetCommands()[2].resource == &r.otherConstants);
+
+    // slots the cache doesn't track always go through
+    context.Begin();
+    context.SetTexture(RenderStateCache::MAX_TEXTURE_SLOTS, &r.texture);
+    context.SetTexture(RenderStateCache::MAX_TEXTURE_SLOTS, &r.texture);
+    context.SetConstantBuffer(Stage::Vertex, RenderStateCache::MAX_CONSTANT_BUFFER_SLOTS, &r.constants);
+    context.SetConstantBuffer(Stage::Vertex, RenderStateCache::MAX_CONSTANT_BUFFER_SLOTS, &r.constants);
+    CHECK(device.GetCommands().size() == 4);
+}
+
+TEST_CASE(RenderStateCacheInvalidateLetsEverythingThrough)
+{
+    Resources r;
+    RenderStateCache cache;
+    std::vector<RecordedCommand> stream;
+    RecordingCommandContext device(stream);
+    CachedContext context(cache, device);
+
+    // a fresh cache doesn't know what's bound, so even unbinding (null) goes through the first time
+    context.Begin();
+    context.SetTexture(0, nullptr);
+    context.SetPixelShader(nullptr);
+    context.SetRenderTargets(nullptr, nullptr);
+    context.SetPrimitiveTopology(0);
+    CHECK(device.GetCommands().size() == 4);
+
+    context.Begin();
+    BindDraw(context, r, &r.texture, 0);
+    BindDraw(context, r, &r.texture, 0);
+    CHECK(device.GetCommands().size() == 13 + 2);
+
+    // after Invalidate the same draw binds everything again
+    cache.Invalidate();
+    context.Begin();
+    BindDraw(context, r, &r.texture, 0);
+    CHECK(device.GetCommands().size() == 14);
+
+    // InvalidateConstantBuffer forgets that one slot of that one stage
+    context.SetConstantBuffer(Stage::Pixel, 0, &r.constants, 0, 16);
+    cache.InvalidateConstantBuffer(Stage::Vertex, 0);
+    context.Begin();
+    BindDraw(context, r, &r.texture, 0);
+    context.SetConstantBuffer(Stage::Pixel, 0, &r.constants, 0, 16);
+    CHECK(Types(device.GetCommands()) == std::vector<Type>({Type::SetVertexConstantBuffer, Type::DrawIndexed}));
+
+    // ResetStats starts the counters over but keeps the shadow state
+    cache.ResetStats();
+    context.Begin();
+    BindDraw(context, r, &r.texture, 0);
+    CHECK(Types(device.GetCommands()) == std::vector<Type>({Type::DrawIndexed}));
+    CHECK(cache.GetStats().issued == 0 && cache.GetStats().skipped == 13);
+
+    // only what was finished reaches the shared stream
+    CHECK(stream.empty());
+    CHECK(context.Finish());
+    context.Execute();
+    CHECK(stream.size() == 1 && stream[0].type == Type::DrawIndexed);
+}
@@ -0,0 +1,385 @@
+#include "TestFramework.h"
+#include "Rendering/ShadowCascades.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr float FIELD_OF_VIEW = XM_PIDIV4;
+    constexpr float ASPECT_RATIO = 16.0f / 9.0f;
+    constexpr float NEAR_Z = 0.5f;
+    constexpr float FAR_Z = 500.0f;
+    constexpr float MAX_DISTANCE = 150.0f; // closer than the far plane, so the last cascade ends here
+
+    const XMFLOAT3 LIGHT_DIRECTION = {0.4f, -1.0f, 0.3f};
+
+    XMMATRIX Projection()
+    {
+        return XMMatrixPerspectiveFovLH(FIELD_OF_VIEW, ASPECT_RATIO, NEAR_Z, FAR_Z);
+    }
+
+    // yaw around y, then pitch up or down
+    XMMATRIX View(const XMFLOAT3 &eye, float yaw, float pitch)
+    {
+        XMVECTOR forward = XMVectorSet(std::sin(yaw) * std::cos(pitch), std::sin(pitch), std::cos(yaw) * std::cos(pitch), 0.0f);
+        return XMMatrixLookToLH(XMVectorSet(eye.x, eye.y, eye.z, 1.0f), forward, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    }
+
+    void Fit(ShadowCascades &cascades, const XMFLOAT3 &eye, float yaw, float pitch)
+    {
+        cascades.Fit(View(eye, yaw, pitch), Projection(), LIGHT_DIRECTION);
+    }
+
+    // the cascades are orthographic, so w stays 1
+    XMFLOAT3 ToClip(const ShadowCascades::Cascade &cascade, FXMVECTOR world)
+    {
+        XMFLOAT3 clip;
+        XMStoreFloat3(&clip, XMVector3Transform(world, XMLoadFloat4x4(&cascade.viewProjection)));
+        return clip;
+    }
+
+    // light view space box of a world box from its eight corners, in double precision
+    void LightSpaceBounds(const XMFLOAT4X4 &lightView, const BoundingBox &box, double (&minimum)[3], double (&maximum)[3])
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            minimum[axis] = 1e30;
+            maximum[axis] = -1e30;
+        }
+
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            double x = box.Center.x + ((corner & 1) ? box.Extents.x : -box.Extents.x);
+            double y = box.Center.y + ((corner & 2) ? box.Extents.y : -box.Extents.y);
+            double z = box.Center.z + ((corner & 4) ? box.Extents.z : -box.Extents.z);
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                double value = x * lightView.m[0][axis] + y * lightView.m[1][axis] + z * lightView.m[2][axis] + lightView.m[3][axis];
+                minimum[axis] = std::min(minimum[axis], value);
+                maximum[axis] = std::max(maximum[axis], value);
+            }
+        }
+    }
+
+    enum class Side
+    {
+        Inside,
+        Outside,
+        OnEdge, // within rounding of a side of the cascade's box, either answer is fine
+    };
+
+    // the cascade's box in light space comes back out of its projection: x and y map to [-1, 1], the far side to 1,
+    // and there's no near side, anything towards the light can shadow the slice
+    Side ClassifyCaster(const ShadowCascades::Cascade &cascade, const double (&minimum)[3], const double (&maximum)[3])
+    {
+        const XMFLOAT4X4 &projection = cascade.projection;
+        double boxMin[2], boxMax[2];
+        for (int axis = 0; axis < 2; ++axis)
+        {
+            boxMin[axis] = (-1.0 - projection.m[3][axis]) / projection.m[axis][axis];
+            boxMax[axis] = (1.0 - projection.m[3][axis]) / projection.m[axis][axis];
+        }
+        double boxMaxZ = (1.0 - projection.m[3][2]) / projection.m[2][2];
+
+        const double margins[] = {maximum[0] - boxMin[0], boxMax[0] - minimum[0], maximum[1] - boxMin[1],
+                                  boxMax[1] - minimum[1], boxMaxZ - minimum[2]};
+        bool isOnEdge = false;
+        for (double margin : margins)
+        {
+            if (std::fabs(margin) < 1e-3)
+                isOnEdge = true;
+            else if (margin < 0.0)
+                return Side::Outside;
+        }
+        return isOnEdge ? Side::OnEdge : Side::Inside;
+    }
+
+    BoundingBox UnitBox(float x, float z)
+    {
+        BoundingBox box;
+        box.Center = {x, 1.0f, z};
+        box.Extents = {1.0f, 1.0f, 1.0f};
+        return box;
+    }
+
+    bool Contains(const ShadowCascades::Cascade &cascade, std::uint32_t caster)
+    {
+        return std::find(cascade.casters.begin(), cascade.casters.end(), caster) != cascade.casters.end();
+    }
+}
+
+TEST_CASE(ShadowCascadesCoverTheirSlices)
+{
+    ShadowCascades cascades;
+    cascades.SetMaxDistance(MAX_DISTANCE);
+
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> side(-1.0f, 1.0f);
+    float tanHalfY = std::tan(FIELD_OF_VIEW * 0.5f);
+    float tanHalfX = tanHalfY * ASPECT_RATIO;
+
+    const float yaws[] = {0.0f, 0.7f, 2.5f, -1.9f};
+    const float pitches[] = {0.0f, -0.6f, 0.4f, -1.2f};
+    bool isContiguous = true;
+    bool isInside = true;
+    for (int pose = 0; pose < 4; ++pose)
+    {
+        XMFLOAT3 eye = {pose * 13.0f - 20.0f, 2.0f + pose, pose * -7.0f};
+        XMMATRIX view = View(eye, yaws[pose], pitches[pose]);
+        cascades.Fit(view, Projection(), LIGHT_DIRECTION);
+
+        // the slices run from the near plane to the shadow distance without gaps
+        isContiguous = isContiguous && std::fabs(cascades.GetCascade(0).splitNear - NEAR_Z) < 1e-3f &&
+                       std::fabs(cascades.GetCascade(ShadowCascades::CASCADE_COUNT - 1).splitFar - MAX_DISTANCE) < 1e-2f;
+        for (std::uint32_t c = 0; c + 1 < ShadowCascades::CASCADE_COUNT; ++c)
+        {
+            isContiguous = isContiguous && cascades.GetCascade(c).splitFar == cascades.GetCascade(c + 1).splitNear &&
+                           cascades.GetCascade(c).splitNear < cascades.GetCascade(c).splitFar;
+        }
+
+        // any point of the camera's slice lands inside its cascade's clip volume, corners and edges included
+        XMMATRIX cameraWorld = XMMatrixInverse(nullptr, view);
+        for (std::uint32_t c = 0; c < ShadowCascades::CASCADE_COUNT; ++c)
+        {
+            const ShadowCascades::Cascade &cascade = cascades.GetCascade(c);
+            for (int i = 0; i < 2000; ++i)
+            {
+                float z = cascade.splitNear + (cascade.splitFar - cascade.splitNear) * (i < 8 ? static_cast<float>(i & 1) : unit(random));
+                float x = (i < 8 ? ((i & 2) ? 1.0f : -1.0f) : side(random)) * z * tanHalfX;
+                float y = (i < 8 ? ((i & 4) ? 1.0f : -1.0f) : side(random)) * z * tanHalfY;
+
+                XMFLOAT3 clip = ToClip(cascade, XMVector3Transform(XMVectorSet(x, y, z, 1.0f), cameraWorld));
+                isInside = isInside && std::fabs(clip.x) <= 1.0f + 1e-4f && std::fabs(clip.y) <= 1.0f + 1e-4f &&
+                           clip.z >= -1e-4f && clip.z <= 1.0f + 1e-4f;
+            }
+        }
+    }
+    CHECK(isContiguous);
+    CHECK(isInside);
+}
+
+TEST_CASE(ShadowCascadesCullingMatchesCornerTest)
+{
+    ShadowCascades cascades;
+    cascades.SetMaxDistance(MAX_DISTANCE);
+
+    // not a multiple of four, so the padding lanes get exercised too
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+    std::uniform_real_distribution<float> extent(0.2f, 6.0f);
+    std::vector<BoundingBox> boxes(10003);
+    for (std::uint32_t i = 0; i < boxes.size(); ++i)
+    {
+        boxes[i].Center = {position(random), position(random) * 0.1f, position(random)};
+        boxes[i].Extents = {extent(random), extent(random), extent(random)};
+        cascades.Add(boxes[i], i);
+    }
+
+    bool isMatching = true;
+    bool isOrdered = true;
+    bool isInFrontOfNearPlane = true;
+    size_t insideCount = 0;
+    for (int pose = 0; pose < 3; ++pose)
+    {
+        Fit(cascades, {pose * 20.0f, 5.0f, -pose * 10.0f}, pose * 1.3f, -0.2f * pose);
+
+        for (std::uint32_t c = 0; c < ShadowCascades::CASCADE_COUNT; ++c)
+        {
+            const ShadowCascades::Cascade &cascade = cascades.GetCascade(c);
+            isOrdered = isOrdered && std::is_sorted(cascade.casters.begin(), cascade.casters.end());
+
+            std::vector<bool> isListed(boxes.size(), false);
+            for (std::uint32_t caster : cascade.casters)
+                isListed[caster] = true;
+
+            for (std::uint32_t i = 0; i < boxes.size(); ++i)
+            {
+                double minimum[3], maximum[3];
+                LightSpaceBounds(cascades.GetLightView(), boxes[i], minimum, maximum);
+
+                Side side = ClassifyCaster(cascade, minimum, maximum);
+                if (side == Side::Inside)
+                    ++insideCount;
+                if (side != Side::OnEdge && isListed[i] != (side == Side::Inside))
+                    isMatching = false;
+
+                // the near plane is pulled back far enough for every caster the cascade draws
+                double nearZ = minimum[2] * cascade.projection.m[2][2] + cascade.projection.m[3][2];
+                if (isListed[i] && nearZ < -1e-4)
+                    isInFrontOfNearPlane = false;
+            }
+        }
+    }
+    CHECK(isMatching);
+    CHECK(isOrdered);
+    CHECK(isInFrontOfNearPlane);
+    CHECK(insideCount > 0);
+}
+
+TEST_CASE(ShadowCascadesKeepTheirSizeWhenTheCameraTurns)
+{
+    ShadowCascades cascades;
+    cascades.SetMaxDistance(MAX_DISTANCE);
+    Fit(cascades, {10.0f, 3.0f, -7.0f}, 0.0f, 0.0f);
+
+    ShadowCascades::Cascade first[ShadowCascades::CASCADE_COUNT];
+    for (std::uint32_t c = 0; c < ShadowCascades::CASCADE_COUNT; ++c)
+        first[c] = cascades.GetCascade(c);
+
+    // the scale and the texel size have to be bit for bit the same, any turn or step of the camera
+    bool isSameSize = true;
+    for (int step = 1; step < 200; ++step)
+    {
+        float yaw = step * 0.173f;
+        float pitch = std::sin(step * 0.31f) * 1.3f;
+        Fit(cascades, {10.0f + step * 0.37f, 3.0f, -7.0f + step * 0.11f}, yaw, pitch);
+
+        for (std::uint32_t c = 0; c < ShadowCascades::CASCADE_COUNT; ++c)
+        {
+            const ShadowCascades::Cascade &cascade = cascades.GetCascade(c);
+            isSameSize = isSameSize && cascade.projection.m[0][0] == first[c].projection.m[0][0] &&
+                         cascade.projection.m[1][1] == first[c].projection.m[1][1] && cascade.texelSize == first[c].texelSize;
+        }
+    }
+    CHECK(isSameSize);
+}
+
+TEST_CASE(ShadowCascadesMoveInWholeTexels)
+{
+    ShadowCascades cascades;
+    cascades.SetMaxDistance(MAX_DISTANCE);
+    cascades.SetResolution(1024);
+
+    // a fixed point's texel in every cascade, frame after frame while the camera drifts
+    XMVECTOR point = XMVectorSet(3.0f, 1.0f, 12.0f, 1.0f);
+    auto texel = [&](std::uint32_t c)
+    {
+        XMFLOAT3 clip = ToClip(cascades.GetCascade(c), point);
+        return XMFLOAT2{(clip.x * 0.5f + 0.5f) * 1024.0f, (clip.y * 0.5f + 0.5f) * 1024.0f};
+    };
+
+    Fit(cascades, {0.0f, 4.0f, -10.0f}, 0.3f, -0.2f);
+    XMFLOAT2 first[ShadowCascades::CASCADE_COUNT];
+    for (std::uint32_t c = 0; c < ShadowCascades::CASCADE_COUNT; ++c)
+        first[c] = texel(c);
+
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> drift(-0.2f, 0.2f);
+    XMFLOAT3 eye = {0.0f, 4.0f, -10.0f};
+    bool isWholeTexels = true;
+    bool hasMoved = false;
+    for (int frame = 0; frame < 300; ++frame)
+    {
+        eye = {eye.x + drift(random), eye.y + drift(random) * 0.1f, eye.z + drift(random)};
+        Fit(cascades, eye, 0.3f, -0.2f);
+
+        for (std::uint32_t c = 0; c < ShadowCascades::CASCADE_COUNT; ++c)
+        {
+            XMFLOAT2 current = texel(c);
+            float dx = current.x - first[c].x;
+            float dy = current.y - first[c].y;
+            isWholeTexels = isWholeTexels && std::fabs(dx - std::round(dx)) < 0.01f && std::fabs(dy - std::round(dy)) < 0.01f;
+            hasMoved = hasMoved || std::fabs(dx) >= 1.0f || std::fabs(dy) >= 1.0f;
+        }
+    }
+    CHECK(isWholeTexels);
+    CHECK(hasMoved);
+}
+
+TEST_CASE(ShadowCascadesOnlyRedrawWhatAMovedCasterTouches)
+{
+    // a field of boxes in front of the camera, a few of them moving from frame to frame
+    std::vector<BoundingBox> boxes;
+    for (int x = -20; x <= 20; x += 5)
+    {
+        for (int z = -5; z <= 95; z += 5)
+            boxes.push_back(UnitBox(static_cast<float>(x), static_cast<float>(z)));
+    }
+    // and one far off to the side that no cascade sees
+    boxes.push_back(UnitBox(900.0f, -900.0f));
+    const std::uint32_t hidden = static_cast<std::uint32_t>(boxes.size() - 1);
+
+    char mesh = 0;
+    ShadowCascades cascades;
+    cascades.SetMaxDistance(MAX_DISTANCE);
+    auto fitFrame = [&]()
+    {
+        cascades.Clear();
+        for (std::uint32_t i = 0; i < boxes.size(); ++i)
+        {
+            XMFLOAT4X4 world;
+            XMStoreFloat4x4(&world, XMMatrixTranslation(boxes[i].Center.x, boxes[i].Center.y, boxes[i].Center.z));
+            cascades.Add(boxes[i], ShadowCascades::HashCaster(i, &mesh, world));
+        }
+        Fit(cascades, {0.0f, 4.0f, -10.0f}, 0.0f, -0.15f);
+    };
+    auto markAllRendered = [&]()
+    {
+        for (std::uint32_t c = 0; c < ShadowCascades::CASCADE_COUNT; ++c)
+            cascades.MarkRendered(c);
+    };
+    auto countDirty = [&]()
+    {
+        std::uint32_t dirty = 0;
+        for (std::uint32_t c = 0; c < ShadowCascades::CASCADE_COUNT; ++c)
+            dirty += cascades.IsDirty(c) ? 1 : 0;
+        return dirty;
+    };
+
+    // nothing drawn yet, then nothing changed
+    fitFrame();
+    CHECK(countDirty() == ShadowCascades::CASCADE_COUNT);
+    markAllRendered();
+    fitFrame();
+    CHECK(countDirty() == 0);
+
+    // the caster in the fewest cascades (but at least one), so there are cascades that must stay clean
+    std::uint32_t moved = hidden;
+    std::uint32_t fewest = ShadowCascades::CASCADE_COUNT + 1;
+    for (std::uint32_t i = 0; i < hidden; ++i)
+    {
+        std::uint32_t count = 0;
+        for (std::uint32_t c = 0; c < ShadowCascades::CASCADE_COUNT; ++c)
+            count += Contains(cascades.GetCascade(c), i) ? 1 : 0;
+
+        if (count > 0 && count < fewest)
+        {
+            moved = i;
+            fewest = count;
+        }
+    }
+    CHECK(fewest < ShadowCascades::CASCADE_COUNT);
+
+    bool wasIn[ShadowCascades::CASCADE_COUNT];
+    for (std::uint32_t c = 0; c < ShadowCascades::CASCADE_COUNT; ++c)
+        wasIn[c] = Contains(cascades.GetCascade(c), moved);
+
+    boxes[moved].Center.x += 0.01f;
+    fitFrame();
+
+    bool isExpected = true;
+    for (std::uint32_t c = 0; c < ShadowCascades::CASCADE_COUNT; ++c)
+        isExpected = isExpected && cascades.IsDirty(c) == (wasIn[c] || Contains(cascades.GetCascade(c), moved));
+    CHECK(isExpected);
+    CHECK(countDirty() > 0 && countDirty() < ShadowCascades::CASCADE_COUNT);
+
+    // a caster none of them draws can move all it wants
+    markAllRendered();
+    bool isHiddenAnywhere = false;
+    for (std::uint32_t c = 0; c < ShadowCascades::CASCADE_COUNT; ++c)
+        isHiddenAnywhere = isHiddenAnywhere || Contains(cascades.GetCascade(c), hidden);
+    CHECK(!isHiddenAnywhere);
+
+    boxes[hidden].Center.z += 3.0f;
+    fitFrame();
+    CHECK(countDirty() == 0);
+
+    // losing the shadow map redraws everything
+    cascades.Invalidate();
+    CHECK(countDirty() == ShadowCascades::CASCADE_COUNT);
+}
@@ -0,0 +1,251 @@
+#include "TestFramework.h"
+#include "Scene/ISpatialIndex.h"
+#include "Rendering/FrustumCuller.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    const SpatialIndexType INDEX_TYPES[] = {SpatialIndexType::BoundingVolumeHierarchy, SpatialIndexType::HashGrid};
+
+    const char *GetTypeName(SpatialIndexType type)
+    {
+        return type == SpatialIndexType::HashGrid ? "grid" : "BVH";
+    }
+
+    bool BoxesOverlap(const BoundingBox &a, const BoundingBox &b)
+    {
+        return std::fabs(a.Center.x - b.Center.x) <= a.Extents.x + b.Extents.x &&
+               std::fabs(a.Center.y - b.Center.y) <= a.Extents.y + b.Extents.y &&
+               std::fabs(a.Center.z - b.Center.z) <= a.Extents.z + b.Extents.z;
+    }
+
+    bool BoxInsideFrustum(const XMFLOAT4 (&planes)[6], const BoundingBox &box)
+    {
+        for (const XMFLOAT4 &plane : planes)
+        {
+            float distance = plane.x * box.Center.x + plane.y * box.Center.y + plane.z * box.Center.z + plane.w;
+            float radius = std::fabs(plane.x) * box.Extents.x + std::fabs(plane.y) * box.Extents.y +
+                           std::fabs(plane.z) * box.Extents.z;
+            if (distance + radius < 0.0f)
+                return false;
+        }
+        return true;
+    }
+
+    // a field of boxes moving in straight lines, bouncing off the edges of a cube
+    // the cube grows with the count so the density (and the size of query results) stays the same
+    struct MovingBoxes
+    {
+        std::vector<BoundingBox> bounds;
+        std::vector<XMFLOAT3> velocities;
+        float halfSize = 0.0f;
+
+        MovingBoxes(size_t count, float speed, unsigned int seed)
+        {
+            halfSize = 4.0f * std::cbrt(static_cast<float>(count));
+
+            std::mt19937 random(seed);
+            std::uniform_real_distribution<float> position(-halfSize, halfSize);
+            std::uniform_real_distribution<float> extent(0.25f, 2.0f);
+            std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+            bounds.resize(count);
+            velocities.resize(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                bounds[i].Center = {position(random), position(random), position(random)};
+                bounds[i].Extents = {extent(random), extent(random), extent(random)};
+                velocities[i] = {direction(random) * speed, direction(random) * speed, direction(random) * speed};
+            }
+        }
+
+        void Step()
+        {
+            auto step = [this](float &center, float &velocity)
+            {
+                center += velocity;
+                if (center < -halfSize || center > halfSize)
+                    velocity = -velocity;
+            };
+
+            for (size_t i = 0; i < bounds.size(); ++i)
+            {
+                step(bounds[i].Center.x, velocities[i].x);
+                step(bounds[i].Center.y, velocities[i].y);
+                step(bounds[i].Center.z, velocities[i].z);
+            }
+        }
+    };
+
+    void SetCameraFrustum(FrustumCuller &culler, float farPlane)
+    {
+        XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.3f, 0.1f, 1.0f, 1.0f),
+                                         XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        culler.SetFrustum(view, XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, farPlane));
+    }
+}
+
+TEST_CASE(SpatialIndexQueriesNeverMissAnEntry)
+{
+    for (SpatialIndexType type : INDEX_TYPES)
+    {
+        std::unique_ptr<ISpatialIndex> index = ISpatialIndex::Create(type);
+        MovingBoxes boxes(5000, 1.5f, 3);
+
+        std::vector<std::int32_t> proxies;
+        for (size_t i = 0; i < boxes.bounds.size(); ++i)
+            proxies.push_back(index->CreateProxy(boxes.bounds[i], static_cast<EntityID>(i + 1)));
+
+        // move everything a few times, far enough that entries change cells and leave their fat boxes
+        for (int frame = 0; frame < 4; ++frame)
+        {
+            boxes.Step();
+            for (size_t i = 0; i < proxies.size(); ++i)
+                index->MoveProxy(proxies[i], boxes.bounds[i]);
+        }
+
+        // and drop every third one
+        std::vector<bool> isAlive(proxies.size(), true);
+        for (size_t i = 0; i < proxies.size(); i += 3)
+        {
+            index->DestroyProxy(proxies[i]);
+            isAlive[i] = false;
+        }
+        CHECK(index->GetProxyCount() == proxies.size() - (proxies.size() + 2) / 3);
+
+        // results may hold extra entries, but every entry that really touches the query has to be there, once
+        auto checkQuery = [&](const std::vector<EntityID> &results, auto &&touches)
+        {
+            std::vector<int> found(proxies.size(), 0);
+            for (EntityID entity : results)
+            {
+                CHECK(entity >= 1 && entity <= proxies.size() && isAlive[entity - 1]);
+                if (entity >= 1 && entity <= proxies.size())
+                    ++found[entity - 1];
+            }
+
+            size_t missed = 0;
+            size_t duplicates = 0;
+            for (size_t i = 0; i < proxies.size(); ++i)
+            {
+                missed += isAlive[i] && found[i] == 0 && touches(boxes.bounds[i]) ? 1 : 0;
+                duplicates += found[i] > 1 ? 1 : 0;
+            }
+            CHECK(missed == 0);
+            CHECK(duplicates == 0);
+        };
+
+        std::vector<EntityID> results;
+        BoundingBox queryBox;
+        queryBox.Center = {3.0f, -5.0f, 10.0f};
+        queryBox.Extents = {15.0f, 10.0f, 8.0f};
+        index->QueryBox(queryBox, results);
+        CHECK(!results.empty());
+        checkQuery(results, [&](const BoundingBox &box)
+                   { return BoxesOverlap(box, queryBox); });
+
+        BoundingSphere sphere;
+        sphere.Center = {-10.0f, 4.0f, 0.0f};
+        sphere.Radius = 12.0f;
+        results.clear();
+        index->QuerySphere(sphere, results);
+        checkQuery(results, [&](const BoundingBox &box)
+                   {
+                       // distance from the sphere's center to the closest point of the box
+                       float dx = std::max(0.0f, std::fabs(box.Center.x - sphere.Center.x) - box.Extents.x);
+                       float dy = std::max(0.0f, std::fabs(box.Center.y - sphere.Center.y) - box.Extents.y);
+                       float dz = std::max(0.0f, std::fabs(box.Center.z - sphere.Center.z) - box.Extents.z);
+                       return dx * dx + dy * dy + dz * dz <= sphere.Radius * sphere.Radius;
+                   });
+
+        FrustumCuller culler;
+        SetCameraFrustum(culler, 40.0f);
+        results.clear();
+        index->QueryFrustum(culler.GetPlanes(), results);
+        CHECK(!results.empty());
+        checkQuery(results, [&](const BoundingBox &box)
+                   { return BoxInsideFrustum(culler.GetPlanes(), box); });
+    }
+}
+
+BENCHMARK(SpatialIndexGridVersusBVH)
+{
+    char label[64];
+    for (size_t size : {10000, 100000, 1000000})
+    {
+        size_t count = BenchmarkSize(size);
+        for (SpatialIndexType type : INDEX_TYPES)
+        {
+            // about half a unit per frame, faster than the tree's margin so moves aren't free for either of them
+            MovingBoxes boxes(count, 0.5f, 11);
+            std::unique_ptr<ISpatialIndex> index = ISpatialIndex::Create(type);
+            std::vector<std::int32_t> proxies(count);
+
+            Stopwatch stopwatch;
+            for (size_t i = 0; i < count; ++i)
+                proxies[i] = index->CreateProxy(boxes.bounds[i], static_cast<EntityID>(i + 1));
+            double build = stopwatch.GetMilliseconds();
+
+            size_t relocated = 0;
+            double move = MeasureMilliseconds([&]()
+                                              {
+                                                  boxes.Step();
+                                                  relocated = 0;
+                                                  for (size_t i = 0; i < count; ++i)
+                                                      relocated += index->MoveProxy(proxies[i], boxes.bounds[i]) ? 1 : 0;
+                                              },
+                                              3);
+
+            // a camera in the middle of the field, about the same number of entries in view at every size
+            FrustumCuller culler;
+            SetCameraFrustum(culler, 60.0f);
+            std::vector<EntityID> results;
+            double frustum = MeasureMilliseconds([&]()
+                                                 {
+                                                     results.clear();
+                                                     index->QueryFrustum(culler.GetPlanes(), results);
+                                                 });
+            size_t inView = results.size();
+
+            // a hundred small box queries, like gameplay code looking for neighbours
+            std::mt19937 random(5);
+            std::uniform_real_distribution<float> position(-boxes.halfSize, boxes.halfSize);
+            std::vector<BoundingBox> queries(100);
+            for (BoundingBox &query : queries)
+            {
+                query.Center = {position(random), position(random), position(random)};
+                query.Extents = {8.0f, 8.0f, 8.0f};
+            }
+
+            size_t neighbours = 0;
+            double boxQueries = MeasureMilliseconds([&]()
+                                                    {
+                                                        neighbours = 0;
+                                                        for (const BoundingBox &query : queries)
+                                                        {
+                                                            results.clear();
+                                                            index->QueryBox(query, results);
+                                                            neighbours += results.size();
+                                                        }
+                                                    });
+
+            CHECK(index->GetProxyCount() == count);
+            CHECK(inView > 0);
+
+            std::snprintf(label, sizeof(label), "%s, insert", GetTypeName(type));
+            PrintBenchmarkResult(label, count, build);
+            std::snprintf(label, sizeof(label), "%s, move all (%zu relocated)", GetTypeName(type), relocated);
+            PrintBenchmarkResult(label, count, move);
+            std::snprintf(label, sizeof(label), "%s, frustum query (%zu found)", GetTypeName(type), inView);
+            PrintBenchmarkResult(label, count, frustum);
+            std::snprintf(label, sizeof(label), "%s, 100 box queries (%zu found)", GetTypeName(type), neighbours);
+            PrintBenchmarkResult(label, count, boxQueries);
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#include "TestFramework.h"
+#include "TestComponents.h"
+#include "ECS/ArchetypeStorage.h"
+#include "ECS/SparseSetStorage.h"
+
+// both backends are used directly here, the Registry only ever compiles one of them (ECS_ARCHETYPE_STORAGE)
+
+namespace
+{
+    // every entity gets a Transform, every other one a Velocity as well, so the archetype backend has two archetypes
+    template <typename Storage>
+    void Populate(Storage &storage, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            EntityID entity = MakeEntityID(static_cast<std::uint32_t>(i + 1), 0);
+            Transform *transform = storage.template Add<Transform>(entity);
+            transform->position[0] = static_cast<float>(i % 100);
+            transform->scale[1] = 2.0f;
+
+            if (i % 2 == 0)
+                storage.template Add<Velocity>(entity, 1.0f, 0.0f, 0.0f);
+        }
+    }
+
+    template <typename Storage>
+    double UpdateTransforms(Storage &storage)
+    {
+        double sum = 0.0;
+        storage.template View<Transform>().Each([&sum](EntityID, Transform &transform)
+                                                {
+                                                    transform.ComputeWorld();
+                                                    sum += transform.world[12];
+                                                });
+        return sum;
+    }
+
+    template <typename Storage>
+    double MoveTransforms(Storage &storage)
+    {
+        double sum = 0.0;
+        storage.template View<Transform, Velocity>().Each([&sum](EntityID, Transform &transform, Velocity &velocity)
+                                                          {
+                                                              transform.position[0] += velocity.x;
+                                                              transform.ComputeWorld();
+                                                              sum += transform.world[12];
+                                                          });
+        return sum;
+    }
+}
+
+TEST_CASE(ArchetypeStorageKeepsComponentsWhenMoving)
+{
+    ArchetypeStorage storage;
+    EntityID first = MakeEntityID(1, 0);
+    EntityID second = MakeEntityID(2, 0);
+
+    storage.Add<Position>(first, 1.0f, 2.0f, 3.0f);
+    storage.Add<Position>(second, 4.0f, 5.0f, 6.0f);
+
+    // moves the first entity to the (Position, Velocity) archetype and the second into its old row
+    storage.Add<Velocity>(first, 7.0f, 8.0f, 9.0f);
+    CHECK(storage.Get<Position>(first) && storage.Get<Position>(first)->z == 3.0f);
+    CHECK(storage.Get<Velocity>(first) && storage.Get<Velocity>(first)->x == 7.0f);
+    CHECK(storage.Get<Position>(second) && storage.Get<Position>(second)->x == 4.0f);
+    CHECK(!storage.Has<Velocity>(second));
+
+    storage.Remove<Position>(first);
+    CHECK(!storage.Has<Position>(first));
+    CHECK(storage.Get<Velocity>(first) && storage.Get<Velocity>(first)->y == 8.0f);
+    CHECK(storage.View<Position>().SizeHint() == 1);
+
+    // stale handle to the same slot
+    CHECK(storage.Get<Velocity>(MakeEntityID(1, 1)) == nullptr);
+}
+
+BENCHMARK(ArchetypeVersusSparseSetTransforms)
+{
+    size_t count = BenchmarkSize(1000000);
+
+    SparseSetStorage sparseSets;
+    ArchetypeStorage archetypes;
+
+    Stopwatch stopwatch;
+    Populate(sparseSets, count);
+    double sparseAdd = stopwatch.GetMilliseconds();
+
+    stopwatch.Restart();
+    Populate(archetypes, count);
+    double archetypeAdd = stopwatch.GetMilliseconds();
+
+    double sparseSum = 0.0, archetypeSum = 0.0;
+    double sparseUpdate = MeasureMilliseconds([&]()
+                                              { sparseSum = UpdateTransforms(sparseSets); });
+    double archetypeUpdate = MeasureMilliseconds([&]()
+                                                 { archetypeSum = UpdateTransforms(archetypes); });
+    CHECK(sparseSum == archetypeSum);
+
+    // two components, the sparse sets probe the second pool per entity, archetypes walk both columns
+    double sparseMove = MeasureMilliseconds([&]()
+                                            { sparseSum = MoveTransforms(sparseSets); });
+    double archetypeMove = MeasureMilliseconds([&]()
+                                               { archetypeSum = MoveTransforms(archetypes); });
+    CHECK(sparseSum == archetypeSum);
+
+    PrintBenchmarkResult("add Transform (+ Velocity), sparse set", count, sparseAdd);
+    PrintBenchmarkResult("add Transform (+ Velocity), archetype", count, archetypeAdd);
+    PrintBenchmarkResult("rebuild world, sparse set", count, sparseUpdate);
+    PrintBenchmarkResult("rebuild world, archetype", count, archetypeUpdate);
+    PrintBenchmarkResult("move + rebuild, sparse set", count / 2, sparseMove);
+    PrintBenchmarkResult("move + rebuild, archetype", count / 2, archetypeMove);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ECS/Component.h"
+
+// plain components for the ECS tests, so they don't need DirectXMath like the engine's own components do
+
+class Position : public Component
+{
+public:
+    Position() = default;
+    Position(float x, float y, float z) : x(x), y(y), z(z) {}
+
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+};
+
+class Velocity : public Component
+{
+public:
+    Velocity() = default;
+    Velocity(float x, float y, float z) : x(x), y(y), z(z) {}
+
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+};
+
+class Tag : public Component
+{
+public:
+    std::uint32_t value = 0;
+};
+
+// laid out like TransformComponent (position, rotation, scale, cached world matrix, dirty flag)
+class Transform : public Component
+{
+public:
+    float position[3] = {0.0f, 0.0f, 0.0f};
+    float rotation[3] = {0.0f, 0.0f, 0.0f};
+    float scale[3] = {1.0f, 1.0f, 1.0f};
+    float world[16] = {1.0f, 0.0f, 0.0f, 0.0f,
+                       0.0f, 1.0f, 0.0f, 0.0f,
+                       0.0f, 0.0f, 1.0f, 0.0f,
+                       0.0f, 0.0f, 0.0f, 1.0f};
+    bool isDirty = true;
+
+    // scale then translate, enough work per transform to be a fair stand-in for the real matrix rebuild
+    void ComputeWorld()
+    {
+        for (int i = 0; i < 16; ++i)
+            world[i] = 0.0f;
+        world[0] = scale[0];
+        world[5] = scale[1];
+        world[10] = scale[2];
+        world[12] = position[0];
+        world[13] = position[1];
+        world[14] = position[2];
+        world[15] = 1.0f;
+        isDirty = false;
+    }
+};
@@ -0,0 +1,96 @@
+#include "TestFramework.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    int failureCount = 0;
+    bool isQuickRun = false;
+}
+
+std::vector<TestCase> &GetTestCases()
+{
+    // function local so registration from other files' static initializers can't run before it exists
+    static std::vector<TestCase> testCases;
+    return testCases;
+}
+
+void ReportFailure(const char *expression, const char *file, int line)
+{
+    std::printf("    %s(%d): CHECK(%s) failed\n", file, line, expression);
+    ++failureCount;
+}
+
+size_t BenchmarkSize(size_t size)
+{
+    if (!isQuickRun)
+        return size;
+
+    return size >= 100 ? size / 100 : 1;
+}
+
+bool IsQuickRun()
+{
+    return isQuickRun;
+}
+
+std::vector<unsigned int> BenchmarkThreadCounts()
+{
+    // at least 2 so the job system path is always timed, even on a single core
+    unsigned int maxThreads = std::max(2u, std::thread::hardware_concurrency());
+    std::vector<unsigned int> counts;
+    for (unsigned int threads = 1; threads < maxThreads; threads *= 2)
+        counts.push_back(threads);
+    counts.push_back(maxThreads);
+    return counts;
+}
+
+void PrintBenchmarkResult(const char *label, size_t size, double milliseconds)
+{
+    std::printf("    %-40s %10zu %12.3f ms\n", label, size, milliseconds);
+}
+
+int main(int argc, char **argv)
+{
+    bool runBenchmarks = false;
+    const char *filter = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--bench") == 0)
+            runBenchmarks = true;
+        else if (std::strcmp(argv[i], "--quick") == 0)
+            isQuickRun = true;
+        else
+            filter = argv[i];
+    }
+
+#ifndef NDEBUG
+    if (runBenchmarks)
+        std::printf("not an optimized build, the timings below don't mean much\n");
+#endif
+
+    int runCount = 0;
+    int failedCount = 0;
+    for (const TestCase &testCase : GetTestCases())
+    {
+        if (testCase.isBenchmark != runBenchmarks || (filter && !std::strstr(testCase.name, filter)))
+            continue;
+
+        std::printf("%s\n", testCase.name);
+        std::fflush(stdout);
+
+        int failuresBefore = failureCount;
+        testCase.function();
+        ++runCount;
+
+        if (failureCount != failuresBefore)
+        {
+            std::printf("    FAILED\n");
+            ++failedCount;
+        }
+    }
+
+    std::printf("%d run, %d failed\n", runCount, failedCount);
+    return failedCount == 0 ? 0 : 1;
+}
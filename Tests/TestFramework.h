@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// tiny test harness, no third party framework so the tests build anywhere the engine's CPU code does
+//
+// TEST_CASE functions run by default (that's what ctest runs), BENCHMARK functions only with --bench
+// benchmarks should still CHECK that every variant they time computes the same result
+//
+// EngineTests [--bench] [--quick] [name filter]
+//   --bench  run the benchmarks instead of the tests
+//   --quick  shrink the benchmark sizes (BenchmarkSize) so they finish in seconds, ctest runs them like that
+
+struct TestCase
+{
+    const char *name;
+    void (*function)();
+    bool isBenchmark;
+};
+
+std::vector<TestCase> &GetTestCases();
+
+struct TestRegistrar
+{
+    TestRegistrar(const char *name, void (*function)(), bool isBenchmark)
+    {
+        GetTestCases().push_back({name, function, isBenchmark});
+    }
+};
+
+#define TEST_CASE(name)                                           \
+    static void name();                                           \
+    static TestRegistrar name##Registrar(#name, &name, false);    \
+    static void name()
+
+#define BENCHMARK(name)                                           \
+    static void name();                                           \
+    static TestRegistrar name##Registrar(#name, &name, true);     \
+    static void name()
+
+// records the failure and keeps going, so one run reports every broken check
+// variadic so expressions with template argument commas in them work
+#define CHECK(...) ((__VA_ARGS__) ? (void)0 : ReportFailure(#__VA_ARGS__, __FILE__, __LINE__))
+
+void ReportFailure(const char *expression, const char *file, int line);
+
+/** @brief Benchmark problem size, divided by 100 with --quick (but never below 1) */
+size_t BenchmarkSize(size_t size);
+
+/** @brief true with --quick, for benchmarks that want to skip their largest configurations */
+bool IsQuickRun();
+
+/** @brief Thread counts for scaling benchmarks: 1, 2, 4, ... up to the hardware thread count, and at least 2 */
+std::vector<unsigned int> BenchmarkThreadCounts();
+
+/** @brief Prints one line of a benchmark's results, "label    size    time ms" */
+void PrintBenchmarkResult(const char *label, size_t size, double milliseconds);
+
+class Stopwatch
+{
+public:
+    Stopwatch() : start(std::chrono::steady_clock::now()) {}
+
+    void Restart() { start = std::chrono::steady_clock::now(); }
+
+    double GetMilliseconds() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * @brief Runs func a few times and returns the fastest run in milliseconds
+ *
+ * The fastest run is the one least disturbed by the rest of the machine, which is what comparisons want.
+ */
+template <typename Func>
+double MeasureMilliseconds(Func &&func, int repeats = 5)
+{
+    double best = 0.0;
+    for (int i = 0; i < repeats; ++i)
+    {
+        Stopwatch stopwatch;
+        func();
+        double elapsed = stopwatch.GetMilliseconds();
+        if (i == 0 || elapsed < best)
+            best = elapsed;
+    }
+    return best;
+}
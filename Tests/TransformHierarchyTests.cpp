@@ -0,0 +1,254 @@
+#include "TestFramework.h"
+#include "ECS/TransformHierarchy.h"
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    EntityID Entity(size_t index)
+    {
+        return MakeEntityID(static_cast<std::uint32_t>(index), 1);
+    }
+
+    // every parent ahead of its children, one level deeper than its parent, and findable through IndexOf
+    // and laid out depth first: a node's parent is the node right before it or one of that node's ancestors,
+    // otherwise some subtree got split up
+    bool IsDepthFirst(const TransformHierarchy &hierarchy)
+    {
+        const auto &nodes = hierarchy.GetNodes();
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            const TransformHierarchy::Node &node = nodes[i];
+            if (hierarchy.IndexOf(node.entity) != static_cast<std::int32_t>(i))
+                return false;
+
+            if (node.parent == TransformHierarchy::NO_PARENT)
+            {
+                if (node.depth != 0)
+                    return false;
+                continue;
+            }
+
+            if (node.parent >= static_cast<std::int32_t>(i) || node.depth != nodes[node.parent].depth + 1)
+                return false;
+
+            std::int32_t ancestor = static_cast<std::int32_t>(i) - 1;
+            while (ancestor != TransformHierarchy::NO_PARENT && ancestor != node.parent)
+                ancestor = nodes[ancestor].parent;
+            if (ancestor != node.parent)
+                return false;
+        }
+        return true;
+    }
+
+    // root (1) → chain of 'length' entities, built one SetParent at a time
+    void BuildChain(TransformHierarchy &hierarchy, size_t length)
+    {
+        for (size_t i = 1; i <= length; ++i)
+            hierarchy.SetParent(Entity(i + 1), Entity(i));
+    }
+
+    // root (1) → 'count' direct children
+    std::vector<std::pair<EntityID, EntityID>> FanLinks(size_t count)
+    {
+        std::vector<std::pair<EntityID, EntityID>> links;
+        links.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+            links.emplace_back(Entity(i + 2), Entity(1));
+        return links;
+    }
+}
+
+TEST_CASE(HierarchyKeepsParentsAheadOfChildren)
+{
+    TransformHierarchy hierarchy;
+
+    // children attached before their parents are, subtrees moved around afterwards
+    CHECK(hierarchy.SetParent(Entity(4), Entity(3)));
+    CHECK(hierarchy.SetParent(Entity(5), Entity(4)));
+    CHECK(hierarchy.SetParent(Entity(3), Entity(2)));
+    CHECK(hierarchy.SetParent(Entity(2), Entity(1)));
+    CHECK(hierarchy.SetParent(Entity(6), Entity(1)));
+    CHECK(IsDepthFirst(hierarchy));
+    CHECK(hierarchy.GetNodes()[hierarchy.IndexOf(Entity(5))].depth == 4);
+
+    CHECK(hierarchy.SetParent(Entity(3), Entity(6)));
+    CHECK(IsDepthFirst(hierarchy));
+    CHECK(hierarchy.GetParent(Entity(3)) == Entity(6));
+    CHECK(hierarchy.GetNodes()[hierarchy.IndexOf(Entity(5))].depth == 4);
+
+    CHECK(hierarchy.SetParent(Entity(4), INVALID_ENTITY));
+    CHECK(IsDepthFirst(hierarchy));
+    CHECK(hierarchy.GetParent(Entity(4)) == INVALID_ENTITY);
+    CHECK(hierarchy.GetNodes()[hierarchy.IndexOf(Entity(5))].depth == 1);
+}
+
+TEST_CASE(HierarchyRejectsCycles)
+{
+    TransformHierarchy hierarchy;
+    BuildChain(hierarchy, 3);
+
+    // 1 → 2 → 3 → 4, none of those may end up below their own descendant
+    CHECK(!hierarchy.SetParent(Entity(1), Entity(4)));
+    CHECK(!hierarchy.SetParent(Entity(2), Entity(3)));
+    CHECK(!hierarchy.SetParent(Entity(3), Entity(3)));
+    CHECK(hierarchy.GetParent(Entity(1)) == INVALID_ENTITY);
+    CHECK(hierarchy.GetParent(Entity(2)) == Entity(1));
+    CHECK(IsDepthFirst(hierarchy));
+
+    // Build drops the link that closes the loop instead
+    std::vector<std::pair<EntityID, EntityID>> links = {
+        {Entity(2), Entity(1)}, {Entity(3), Entity(2)}, {Entity(1), Entity(3)}, {Entity(4), Entity(3)}};
+    hierarchy.Build(links);
+    CHECK(hierarchy.GetNodes().size() == 4);
+    CHECK(IsDepthFirst(hierarchy));
+
+    size_t roots = 0;
+    for (const auto &node : hierarchy.GetNodes())
+        roots += node.parent == TransformHierarchy::NO_PARENT ? 1 : 0;
+    CHECK(roots == 1);
+}
+
+TEST_CASE(HierarchyMatchesReferenceAfterRandomReparents)
+{
+    // a plain parent table next to the hierarchy, every accepted move is mirrored there
+    constexpr size_t COUNT = 300;
+    std::vector<size_t> parentOf(COUNT + 1, 0);
+    auto isBelow = [&parentOf](size_t node, size_t ancestor)
+    {
+        for (; node != 0; node = parentOf[node])
+        {
+            if (node == ancestor)
+                return true;
+        }
+        return false;
+    };
+
+    std::mt19937 random(12);
+    std::uniform_int_distribution<size_t> pick(1, COUNT);
+    std::uniform_int_distribution<int> percent(0, 99);
+
+    TransformHierarchy hierarchy;
+    bool isConsistent = true;
+    size_t accepted = 0;
+    size_t rejected = 0;
+    for (int step = 0; step < 20000; ++step)
+    {
+        size_t child = pick(random);
+        size_t parent = percent(random) < 10 ? 0 : pick(random);
+        bool expected = child != parent && (parent == 0 || !isBelow(parent, child));
+
+        bool result = hierarchy.SetParent(Entity(child), parent == 0 ? INVALID_ENTITY : Entity(parent));
+        isConsistent = isConsistent && result == expected;
+        if (result)
+        {
+            parentOf[child] = parent;
+            ++accepted;
+        }
+        else
+        {
+            ++rejected;
+        }
+
+        if (step % 97 == 0)
+            isConsistent = isConsistent && IsDepthFirst(hierarchy);
+    }
+
+    CHECK(isConsistent);
+    CHECK(IsDepthFirst(hierarchy));
+    CHECK(accepted > 1000 && rejected > 100);
+
+    bool isSameParents = true;
+    for (size_t i = 1; i <= COUNT; ++i)
+    {
+        if (hierarchy.Contains(Entity(i)))
+            isSameParents = isSameParents && hierarchy.GetParent(Entity(i)) == (parentOf[i] == 0 ? INVALID_ENTITY : Entity(parentOf[i]));
+    }
+    CHECK(isSameParents);
+}
+
+BENCHMARK(HierarchyDeepChainAndWideFan)
+{
+    char label[64];
+
+    // a deep chain, every reparent near the top drags the whole rest of the chain with it
+    size_t depth = 1000;
+    TransformHierarchy chain;
+    double chainBuild = MeasureMilliseconds([&]()
+                                            {
+                                                chain.Clear();
+                                                BuildChain(chain, depth);
+                                            });
+    CHECK(chain.GetNodes().size() == depth + 1);
+    CHECK(chain.GetNodes().back().depth == depth);
+
+    std::vector<std::pair<EntityID, EntityID>> chainLinks;
+    for (size_t i = 1; i <= depth; ++i)
+        chainLinks.emplace_back(Entity(i + 1), Entity(i));
+    double chainRebuild = MeasureMilliseconds([&]()
+                                              { chain.Build(chainLinks); });
+
+    // move the chain's second half to the root and back
+    EntityID middle = Entity(depth / 2 + 1);
+    EntityID middleParent = Entity(depth / 2);
+    double chainReparent = MeasureMilliseconds([&]()
+                                               {
+                                                   chain.SetParent(middle, Entity(1));
+                                                   chain.SetParent(middle, middleParent);
+                                               });
+    CHECK(IsDepthFirst(chain));
+    CHECK(chain.GetNodes().back().depth == depth);
+
+    std::snprintf(label, sizeof(label), "deep chain, SetParent each level");
+    PrintBenchmarkResult(label, depth, chainBuild);
+    std::snprintf(label, sizeof(label), "deep chain, Build");
+    PrintBenchmarkResult(label, depth, chainRebuild);
+    std::snprintf(label, sizeof(label), "deep chain, move half there and back");
+    PrintBenchmarkResult(label, depth, chainReparent);
+
+    // a wide fan, every child appended through SetParent lands at the end of the root's block, so nothing moves
+    size_t width = BenchmarkSize(100000);
+    TransformHierarchy fan;
+    double fanSetParent = MeasureMilliseconds([&]()
+                                              {
+                                                  fan.Clear();
+                                                  for (size_t i = 0; i < width; ++i)
+                                                      fan.SetParent(Entity(i + 2), Entity(1));
+                                              });
+    CHECK(fan.GetNodes().size() == width + 1);
+    CHECK(IsDepthFirst(fan));
+
+    std::vector<std::pair<EntityID, EntityID>> fanLinks = FanLinks(width);
+    double fanBuild = MeasureMilliseconds([&]()
+                                          { fan.Build(fanLinks); });
+    CHECK(fan.GetNodes().size() == width + 1);
+
+    // nest the first sibling under the last one and put it back, the first move passes over every sibling
+    // (only once, putting it back leaves it next to the last one)
+    double fanFarReparent = MeasureMilliseconds([&]()
+                                                {
+                                                    fan.SetParent(Entity(2), Entity(width + 1));
+                                                    fan.SetParent(Entity(2), Entity(1));
+                                                },
+                                                1);
+    CHECK(IsDepthFirst(fan));
+
+    // and two neighbours, which only swaps a couple of nodes
+    double fanNearReparent = MeasureMilliseconds([&]()
+                                                 {
+                                                     fan.SetParent(Entity(width), Entity(width + 1));
+                                                     fan.SetParent(Entity(width), Entity(1));
+                                                 });
+    CHECK(IsDepthFirst(fan));
+
+    std::snprintf(label, sizeof(label), "wide fan, SetParent each child");
+    PrintBenchmarkResult(label, width, fanSetParent);
+    std::snprintf(label, sizeof(label), "wide fan, Build");
+    PrintBenchmarkResult(label, width, fanBuild);
+    std::snprintf(label, sizeof(label), "wide fan, move the first sibling and back");
+    PrintBenchmarkResult(label, width, fanFarReparent);
+    std::snprintf(label, sizeof(label), "wide fan, move a neighbour and back");
+    PrintBenchmarkResult(label, width, fanNearReparent);
+}
@@ -0,0 +1,230 @@
+#include "TestFramework.h"
+#include "ECS/Systems/TransformSystem.h"
+#include "ECS/Components/TransformComponent.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    bool IsNear(float a, float b)
+    {
+        return std::fabs(a - b) <= 1e-3f * std::max(1.0f, std::fabs(b));
+    }
+
+    bool MatchesComputedMatrix(const TransformComponent &transform)
+    {
+        XMFLOAT4X4 expected;
+        XMStoreFloat4x4(&expected, transform.ComputeWorldMatrix());
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                if (!IsNear(transform.world.m[row][column], expected.m[row][column]))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    TransformComponent *AddTransform(Registry &registry, EntityID entity, float x)
+    {
+        TransformComponent *transform = registry.AddComponent<TransformComponent>(entity);
+        transform->position = {x, 0.0f, 0.0f};
+        return transform;
+    }
+}
+
+TEST_CASE(TransformSystemPropagatesThroughHierarchy)
+{
+    Registry registry;
+    JobSystem jobSystem;
+    jobSystem.Initialize(1);
+    TransformSystem transformSystem(registry, jobSystem);
+
+    EntityID root = registry.CreateEntity();
+    EntityID child = registry.CreateEntity();
+    EntityID grandchild = registry.CreateEntity();
+    AddTransform(registry, root, 10.0f)->scale = {2.0f, 2.0f, 2.0f};
+    AddTransform(registry, child, 1.0f);
+    AddTransform(registry, grandchild, 1.0f);
+
+    CHECK(transformSystem.SetParent(child, root));
+    CHECK(transformSystem.SetParent(grandchild, child));
+    CHECK(!transformSystem.SetParent(root, grandchild));
+
+    // adding components can move the others around, so look these up last
+    TransformComponent *rootTransform = registry.GetComponent<TransformComponent>(root);
+    TransformComponent *grandchildTransform = registry.GetComponent<TransformComponent>(grandchild);
+
+    // local offsets are scaled by the root, then moved by it
+    transformSystem.Update(0.0f);
+    CHECK(transformSystem.GetRecomputedCount() == 3);
+    CHECK(IsNear(grandchildTransform->world.m[3][0], 14.0f));
+
+    // only the root is dirty, its children follow anyway
+    rootTransform->position.x = 20.0f;
+    rootTransform->MarkDirty();
+    transformSystem.Update(0.0f);
+    CHECK(transformSystem.GetRecomputedCount() == 3);
+    CHECK(IsNear(grandchildTransform->world.m[3][0], 24.0f));
+
+    transformSystem.Update(0.0f);
+    CHECK(transformSystem.GetRecomputedCount() == 0);
+}
+
+TEST_CASE(TransformSystemParallelPathRebuildsEveryDirtyMatrix)
+{
+    Registry registry;
+    JobSystem jobSystem;
+    jobSystem.Initialize(3);
+    TransformSystem transformSystem(registry, jobSystem);
+
+    // well past the point where the system hands the matrices out as jobs
+    constexpr size_t COUNT = 20000;
+    for (size_t i = 0; i < COUNT; ++i)
+    {
+        TransformComponent *transform = AddTransform(registry, registry.CreateEntity(), static_cast<float>(i));
+        transform->rotation = {0.0f, static_cast<float>(i % 360) * 0.01f, 0.0f};
+    }
+
+    transformSystem.Update(0.0f);
+    CHECK(transformSystem.GetRecomputedCount() == COUNT);
+
+    bool allRebuilt = true;
+    for (auto [entity, transform] : registry.View<TransformComponent>())
+        allRebuilt = allRebuilt && !transform.isDirty && MatchesComputedMatrix(transform);
+    CHECK(allRebuilt);
+
+    // half of them move, the other half have to keep their matrix
+    size_t index = 0;
+    for (auto [entity, transform] : registry.View<TransformComponent>())
+    {
+        if (index++ % 2 == 0)
+        {
+            transform.position.y = 5.0f;
+            transform.MarkDirty();
+        }
+    }
+
+    transformSystem.Update(0.0f);
+    CHECK(transformSystem.GetRecomputedCount() == COUNT / 2);
+
+    allRebuilt = true;
+    for (auto [entity, transform] : registry.View<TransformComponent>())
+        allRebuilt = allRebuilt && !transform.isDirty && MatchesComputedMatrix(transform);
+    CHECK(allRebuilt);
+}
+
+BENCHMARK(TransformSystemDeepChainAndWideFan)
+{
+    char label[64];
+    JobSystem jobSystem;
+    jobSystem.Initialize(1);
+
+    // 1000 levels, every level one unit further along x than its parent
+    {
+        size_t depth = 1000;
+        Registry registry;
+        TransformSystem transformSystem(registry, jobSystem);
+
+        std::vector<EntityID> chain;
+        for (size_t i = 0; i <= depth; ++i)
+        {
+            chain.push_back(registry.CreateEntity());
+            AddTransform(registry, chain.back(), 1.0f);
+        }
+
+        Stopwatch stopwatch;
+        for (size_t i = 1; i <= depth; ++i)
+            transformSystem.SetParent(chain[i], chain[i - 1]);
+        transformSystem.Update(0.0f);
+        double build = stopwatch.GetMilliseconds();
+
+        TransformComponent *root = registry.GetComponent<TransformComponent>(chain.front());
+        TransformComponent *leaf = registry.GetComponent<TransformComponent>(chain.back());
+        CHECK(IsNear(leaf->world.m[3][0], static_cast<float>(depth + 1)));
+
+        double rootMoved = MeasureMilliseconds([&]()
+                                               {
+                                                   root->MarkDirty();
+                                                   transformSystem.Update(0.0f);
+                                               });
+        CHECK(transformSystem.GetRecomputedCount() == depth + 1);
+
+        double leafMoved = MeasureMilliseconds([&]()
+                                               {
+                                                   leaf->MarkDirty();
+                                                   transformSystem.Update(0.0f);
+                                               });
+        CHECK(transformSystem.GetRecomputedCount() == 1);
+
+        std::snprintf(label, sizeof(label), "deep chain, SetParent + first update");
+        PrintBenchmarkResult(label, depth, build);
+        std::snprintf(label, sizeof(label), "deep chain, root moved");
+        PrintBenchmarkResult(label, depth, rootMoved);
+        std::snprintf(label, sizeof(label), "deep chain, leaf moved");
+        PrintBenchmarkResult(label, depth, leafMoved);
+    }
+
+    // one root, 100k children attached one SetParent at a time
+    {
+        size_t width = BenchmarkSize(100000);
+        Registry registry;
+        TransformSystem transformSystem(registry, jobSystem);
+
+        EntityID rootEntity = registry.CreateEntity();
+        AddTransform(registry, rootEntity, 1000.0f);
+        std::vector<EntityID> children;
+        for (size_t i = 0; i < width; ++i)
+        {
+            children.push_back(registry.CreateEntity());
+            AddTransform(registry, children.back(), static_cast<float>(i % 1000));
+        }
+
+        Stopwatch stopwatch;
+        for (EntityID child : children)
+            transformSystem.SetParent(child, rootEntity);
+        transformSystem.Update(0.0f);
+        double build = stopwatch.GetMilliseconds();
+        CHECK(transformSystem.GetRecomputedCount() == width + 1);
+
+        TransformComponent *root = registry.GetComponent<TransformComponent>(rootEntity);
+
+        double rootMoved = MeasureMilliseconds([&]()
+                                               {
+                                                   root->MarkDirty();
+                                                   transformSystem.Update(0.0f);
+                                               });
+        CHECK(transformSystem.GetRecomputedCount() == width + 1);
+
+        TransformComponent *sibling = registry.GetComponent<TransformComponent>(children.back());
+        CHECK(IsNear(sibling->world.m[3][0], 1000.0f + static_cast<float>((width - 1) % 1000)));
+
+        double siblingMoved = MeasureMilliseconds([&]()
+                                                  {
+                                                      sibling->MarkDirty();
+                                                      transformSystem.Update(0.0f);
+                                                  });
+        CHECK(transformSystem.GetRecomputedCount() == 1);
+
+        // the last sibling under the first one and back, both moves pass over every sibling in between
+        double reparent = MeasureMilliseconds([&]()
+                                              {
+                                                  transformSystem.SetParent(children.back(), children.front());
+                                                  transformSystem.SetParent(children.back(), rootEntity);
+                                              });
+
+        std::snprintf(label, sizeof(label), "wide fan, SetParent + first update");
+        PrintBenchmarkResult(label, width, build);
+        std::snprintf(label, sizeof(label), "wide fan, root moved");
+        PrintBenchmarkResult(label, width, rootMoved);
+        std::snprintf(label, sizeof(label), "wide fan, one sibling moved");
+        PrintBenchmarkResult(label, width, siblingMoved);
+        std::snprintf(label, sizeof(label), "wide fan, move a sibling there and back");
+        PrintBenchmarkResult(label, width, reparent);
+    }
+}
@@ -0,0 +1,138 @@
+#include "TestFramework.h"
+#include "Rendering/UploadRing.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // what a frame wrote into the fake buffer, so the "GPU" can check it's still there when it reads it
+    struct FrameBlocks
+    {
+        std::uint64_t fence;
+        std::vector<std::pair<size_t, size_t>> blocks; // offset, size
+    };
+
+    bool HoldsPattern(const std::vector<std::uint8_t> &memory, const FrameBlocks &frame)
+    {
+        auto pattern = static_cast<std::uint8_t>(frame.fence);
+        for (auto [offset, size] : frame.blocks)
+        {
+            for (size_t i = offset; i < offset + size; ++i)
+            {
+                if (memory[i] != pattern)
+                    return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE(UploadRingAllocatesWrapsAndRetires)
+{
+    UploadRing ring(1024);
+
+    // offsets are aligned, the bytes skipped for alignment count as used
+    CHECK(ring.Allocate(100, 256) == 0);
+    CHECK(ring.Allocate(100, 256) == 256);
+    CHECK(ring.GetUsedSize() == 356);
+    ring.EndFrame(1);
+
+    CHECK(ring.Allocate(400, 256) == 512);
+    ring.EndFrame(2);
+
+    // 112 bytes left at the end, the tail (frame 1) is still in flight, so nothing fits
+    CHECK(ring.Allocate(200, 16) == UploadRing::INVALID_OFFSET);
+    CHECK(ring.GetOldestFence() == 1);
+
+    // frame 1 done, the block wraps around to the front and the bytes skipped at the end go to this frame
+    ring.Retire(1);
+    CHECK(ring.GetFramesInFlight() == 1);
+    CHECK(ring.Allocate(200, 16) == 0);
+    CHECK(ring.GetUsedSize() == 556 + 112 + 200);
+    ring.EndFrame(3);
+
+    // an older fence completing again changes nothing
+    ring.Retire(1);
+    CHECK(ring.GetFramesInFlight() == 2);
+
+    ring.Retire(3);
+    CHECK(ring.GetUsedSize() == 0);
+    CHECK(ring.GetFramesInFlight() == 0);
+
+    // empty again, so a block as large as the ring starts at 0 instead of wrapping
+    CHECK(ring.Allocate(1024, 256) == 0);
+    CHECK(ring.Allocate(1, 1) == UploadRing::INVALID_OFFSET);
+    CHECK(ring.Allocate(2048, 256) == UploadRing::INVALID_OFFSET);
+}
+
+TEST_CASE(UploadRingNeverOverwritesFramesInFlight)
+{
+    // a byte array stands in for the GPU buffer, every frame fills its blocks with its own pattern
+    // and the "GPU" finishes frames a few behind the CPU, checking the pattern is intact when it does
+    constexpr size_t CAPACITY = 32 * 1024;
+    UploadRing ring(CAPACITY);
+    std::vector<std::uint8_t> memory(CAPACITY, 0);
+    std::deque<FrameBlocks> inFlight;
+
+    std::mt19937 random(9);
+    std::uniform_int_distribution<size_t> blockSize(1, 4096);
+    std::uniform_int_distribution<int> blockCount(1, 6);
+    std::uniform_int_distribution<int> gpuLag(0, 3);
+
+    size_t lastOffset = 0;
+    size_t wraps = 0;
+    size_t stalls = 0;
+    bool isIntact = true;
+    bool isInside = true;
+    for (std::uint64_t fence = 1; fence <= 2000; ++fence)
+    {
+        FrameBlocks frame{fence, {}};
+        int count = blockCount(random);
+        for (int i = 0; i < count; ++i)
+        {
+            size_t size = blockSize(random);
+            size_t offset = ring.Allocate(size, 256);
+
+            // full, wait for the GPU the way RenderPipelineManager does, oldest frame first
+            while (offset == UploadRing::INVALID_OFFSET && !inFlight.empty())
+            {
+                isIntact = isIntact && HoldsPattern(memory, inFlight.front());
+                ring.Retire(inFlight.front().fence);
+                inFlight.pop_front();
+                ++stalls;
+                offset = ring.Allocate(size, 256);
+            }
+
+            if (offset == UploadRing::INVALID_OFFSET)
+                continue;
+
+            isInside = isInside && offset % 256 == 0 && offset + size <= CAPACITY;
+            wraps += offset < lastOffset ? 1 : 0;
+            lastOffset = offset;
+
+            std::memset(memory.data() + offset, static_cast<std::uint8_t>(fence), size);
+            frame.blocks.emplace_back(offset, size);
+        }
+
+        ring.EndFrame(fence);
+        inFlight.push_back(frame);
+
+        // the GPU catches up to somewhere between zero and three frames behind
+        size_t behind = static_cast<size_t>(gpuLag(random));
+        while (inFlight.size() > behind)
+        {
+            isIntact = isIntact && HoldsPattern(memory, inFlight.front());
+            ring.Retire(inFlight.front().fence);
+            inFlight.pop_front();
+        }
+    }
+
+    CHECK(isIntact);
+    CHECK(isInside);
+    CHECK(wraps > 0);
+    CHECK(stalls > 0);
+    CHECK(ring.GetFramesInFlight() == inFlight.size());
+}
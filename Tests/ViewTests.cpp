@@ -0,0 +1,92 @@
+#include "TestFramework.h"
+#include "TestComponents.h"
+#include "ECS/Registry.h"
+#include <algorithm>
+
+namespace
+{
+    // every entity has a Position, every other one a Velocity, every fourth a Tag
+    void Populate(Registry &registry, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            EntityID entity = registry.CreateEntity();
+            registry.AddComponent<Position>(entity, static_cast<float>(i % 13), 0.0f, 0.0f);
+            if (i % 2 == 0)
+                registry.AddComponent<Velocity>(entity, 1.0f, 2.0f, 3.0f);
+            if (i % 4 == 0)
+                registry.AddComponent<Tag>(entity)->value = static_cast<std::uint32_t>(i);
+        }
+    }
+}
+
+TEST_CASE(ViewOnlyYieldsEntitiesWithEveryComponent)
+{
+    Registry registry;
+    Populate(registry, 100);
+
+    size_t count = 0;
+    for (auto [entity, position, velocity, tag] : registry.View<Position, Velocity, Tag>())
+    {
+        CHECK(registry.HasComponent<Position>(entity));
+        CHECK(registry.HasComponent<Velocity>(entity));
+        CHECK(&tag == registry.GetComponent<Tag>(entity));
+        CHECK(tag.value % 4 == 0);
+        ++count;
+    }
+    CHECK(count == 25);
+
+    size_t eachCount = 0;
+    registry.View<Position, Velocity>().Each([&](EntityID, Position &, Velocity &velocity)
+                                             {
+                                                 CHECK(velocity.y == 2.0f);
+                                                 ++eachCount;
+                                             });
+    CHECK(eachCount == 50);
+
+    // a type nobody added makes the view empty instead of crashing
+    class Unused : public Component
+    {
+    };
+    CHECK(registry.View<Position, Unused>().SizeHint() == 0);
+}
+
+BENCHMARK(ViewVersusPerEntityLookups)
+{
+    for (size_t baseCount : {10000, 100000, 1000000})
+    {
+        size_t count = BenchmarkSize(baseCount);
+        Registry registry;
+        Populate(registry, count);
+
+        // the render loop before views: a vector of every entity with the first component, then a lookup per component
+        float lookupSum = 0.0f;
+        double lookupTime = MeasureMilliseconds([&]()
+                                                {
+                                                    lookupSum = 0.0f;
+                                                    for (EntityID entity : registry.GetEntitiesWith<Position>())
+                                                    {
+                                                        auto *position = registry.GetComponent<Position>(entity);
+                                                        auto *velocity = registry.GetComponent<Velocity>(entity);
+                                                        auto *tag = registry.GetComponent<Tag>(entity);
+                                                        if (!position || !velocity || !tag)
+                                                            continue;
+
+                                                        lookupSum += position->x + velocity->z;
+                                                    }
+                                                });
+
+        float viewSum = 0.0f;
+        double viewTime = MeasureMilliseconds([&]()
+                                              {
+                                                  viewSum = 0.0f;
+                                                  for (auto [entity, position, velocity, tag] : registry.View<Position, Velocity, Tag>())
+                                                      viewSum += position.x + velocity.z;
+                                              });
+
+        CHECK(lookupSum == viewSum);
+
+        PrintBenchmarkResult("GetEntitiesWith + 3x GetComponent", count, lookupTime);
+        PrintBenchmarkResult("View<Position, Velocity, Tag>", count, viewTime);
+    }
+}